@@ -8,14 +8,22 @@
 #include "Common.hlsli" // Shaders can also use include files - note the extension
 
 
+//--------------------------------------------------------------------------------------
+// Polygons
+//--------------------------------------------------------------------------------------
+
+// Four points for each polygon in 2D viewport space, matrix transformations already done on the C++ side. Several polygons
+// can be drawn by one instanced draw call, one instance per polygon
+StructuredBuffer<float4> gPolygon2DPoints : register(t0);
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
 
-// This post-processing vertex shader expects that the C++ side will have already done all the matrix transformations for a four
-// point polygon and passed the resultant four points via a constant buffer (rather than via the usual vertex buffer).
-// A more flexible polygon post-procssing system would have vertex and index buffers etc. However for one-off effects (e.g. a frosted window), this is sufficient.
-PostProcessingInput main(uint vertexId : SV_VertexID)
+// This post-processing vertex shader expects that the C++ side will have already done all the matrix transformations for each four
+// point polygon and passed the resultant points via a structured buffer (rather than via the usual vertex buffer).
+PostProcessingInput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
 {
 	PostProcessingInput output; // Defined in Common.hlsi
 
@@ -28,7 +36,7 @@ PostProcessingInput main(uint vertexId : SV_VertexID)
 	// The post-processing shaders expect the points of the polygon (came from C++), the UVs for the area to affect (in the array above)...
 	// ... and the UVs of which part of the scene texture is getting affected. We don't have that yet but it can be caclulated from the...
 	// ... x and y coordinates of the polygon points
-	output.projectedPosition = gPolygon2DPoints[vertexId];
+	output.projectedPosition = gPolygon2DPoints[instanceId * 4 + vertexId];
 	output.areaUV = polygonUVs[vertexId];
 	output.sceneUV = (output.projectedPosition.xy / output.projectedPosition.w + 1.0f) * 0.5f;
 	output.sceneUV.y = 1.0f - output.sceneUV.y;
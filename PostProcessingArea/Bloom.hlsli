@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------------------
+// Settings and helpers for the bloom post-process
+//--------------------------------------------------------------------------------------
+// Shared by the shaders that build the bloom pyramid (Bloom_pp.hlsl, BloomDownsample_pp.hlsl, BloomUpsample_pp.hlsl)
+// and the one that adds it over the image (BloomComposite_pp.hlsl). See PostProcessing/Bloom.h for the CPU version
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Must match BloomConstants in Common.h
+cbuffer BloomConstants : register(b2)
+{
+    float gBloomThreshold;  // Brightness (0->1) above which colours glow
+    float gBloomGlowScale;  // Intensity divided by the number of levels, so more levels spread the glow without brightening it
+    float2 paddingBL;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The image (or pyramid level) being read
+Texture2D SceneTexture : register(t0);
+
+// The pyramid is read between pixels so each sample averages four of them. Clamped so the edges of the screen don't
+// pick up pixels from the other side
+SamplerState BilinearClamp : register(s1);
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Part of a colour bright enough to glow. Colours fade in above the threshold rather than switching on
+float3 BloomThreshold(float3 colour)
+{
+    float brightness = (colour.r + colour.g + colour.b) / 3;
+    return colour * max(brightness - gBloomThreshold, 0) / max(brightness, 0.0001f);
+}
+
+// Shrink the texture to half size, averaging four bilinear samples around the pixel - a 4x4 box filter. The first
+// level of the pyramid also picks out the bright parts of each sample
+float3 BloomDownsample(float2 uv, bool applyThreshold)
+{
+    float width, height;
+    SceneTexture.GetDimensions(width, height);
+    float2 texel = 1.0f / float2(width, height);
+
+    float3 samples[4] = { SceneTexture.Sample(BilinearClamp, uv + float2(-texel.x, -texel.y)).rgb,
+                          SceneTexture.Sample(BilinearClamp, uv + float2( texel.x, -texel.y)).rgb,
+                          SceneTexture.Sample(BilinearClamp, uv + float2(-texel.x,  texel.y)).rgb,
+                          SceneTexture.Sample(BilinearClamp, uv + float2( texel.x,  texel.y)).rgb };
+
+    float3 colour = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        colour += applyThreshold ? BloomThreshold(samples[i]) : samples[i];
+    }
+    return colour * 0.25f;
+}
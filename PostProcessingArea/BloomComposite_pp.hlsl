@@ -0,0 +1,31 @@
+//--------------------------------------------------------------------------------------
+// Bloom - composite
+//--------------------------------------------------------------------------------------
+// Adds the top of the bloom pyramid (all its levels summed, see BloomUpsample_pp.hlsl) over the image
+
+#include "Bloom.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+SamplerState PointSample : register(s0); // The image itself is read without filtering
+
+// First level of the bloom pyramid, half the size of the image, so it is read with the bilinear sampler
+Texture2D BloomTexture : register(t1);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    float4 colour = SceneTexture.Sample(PointSample, input.sceneUV);
+    colour.rgb += BloomTexture.Sample(BilinearClamp, input.sceneUV).rgb * gBloomGlowScale;
+
+    // Set alpha to 1 for final output, like most post-processes bloom doesn't fade out at the edges of an area
+    colour.a = 1.0f;
+    return colour;
+}
@@ -0,0 +1,16 @@
+//--------------------------------------------------------------------------------------
+// Bloom - downsample
+//--------------------------------------------------------------------------------------
+// The other levels of the bloom pyramid, each half the size of the one above
+
+#include "Bloom.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    return float4(BloomDownsample(input.sceneUV, false), 1.0f);
+}
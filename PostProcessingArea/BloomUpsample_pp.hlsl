@@ -0,0 +1,30 @@
+//--------------------------------------------------------------------------------------
+// Bloom - upsample
+//--------------------------------------------------------------------------------------
+// Enlarges a level of the bloom pyramid with a 3x3 tent filter. Drawn with additive blending onto the level above,
+// so working up from the smallest level each level ends up holding itself plus all the levels below
+
+#include "Bloom.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    float width, height;
+    SceneTexture.GetDimensions(width, height);
+    float2 texel = 1.0f / float2(width, height);
+
+    static const float weights[3] = { 0.25f, 0.5f, 0.25f };
+    float3 colour = 0;
+    for (int y = 0; y < 3; y++)
+    {
+        for (int x = 0; x < 3; x++)
+        {
+            colour += SceneTexture.Sample(BilinearClamp, input.sceneUV + float2(x - 1, y - 1) * texel).rgb * weights[x] * weights[y];
+        }
+    }
+    return float4(colour, 1.0f);
+}
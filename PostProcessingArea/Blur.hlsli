@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------------
+// Settings for the blur post-processes
+//--------------------------------------------------------------------------------------
+// Shared by the vertical (Blur_pp.hlsl) and horizontal (SecondBlur.hlsl) passes
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_BLUR_TAPS in Common.h
+static const int MAX_BLUR_TAPS = 40;
+
+// Merged taps of the Gaussian kernel (see PostProcessing/GaussianKernel.h), must match BlurConstants in Common.h
+cbuffer BlurConstants : register(b2)
+{
+    int    gBlurTapCount;  // Taps used, tap 0 is the centre and the others are sampled on both sides
+    float  gBlurStepScale; // Size of a pixel of the render target in full size pixels - the blur's downscale (see PostProcessEffect::Downscale)
+    float2 paddingBS;
+
+    float4 gBlurTaps[MAX_BLUR_TAPS / 2]; // Offset (in pixels) and weight pairs, two taps to a float4
+}
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The scene has been rendered to a texture, these variables allow access to that texture
+Texture2D SceneTexture : register(t0);
+
+// Each tap after the centre falls between two pixels, linear filtering reads both in one sample. Clamped so the
+// edges of the screen don't pick up pixels from the other side
+SamplerState BilinearClamp : register(s1);
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Offset (in pixels) and weight of a tap, 0 is the centre
+float2 BlurTap(int i)
+{
+    float4 pair = gBlurTaps[i / 2];
+    return (i % 2 == 0) ? pair.xy : pair.zw;
+}
+
+// Blur the scene texture along one direction, step is the size of one pixel in that direction in UVs
+float3 BlurAlong(float2 sceneUV, float2 step)
+{
+    float2 tap = BlurTap(0);
+    float3 colour = SceneTexture.Sample(BilinearClamp, sceneUV).rgb * tap.y;
+    for (int i = 1; i < gBlurTapCount; i++)
+    {
+        tap = BlurTap(i);
+        colour += (SceneTexture.Sample(BilinearClamp, sceneUV + step * tap.x).rgb +
+                   SceneTexture.Sample(BilinearClamp, sceneUV - step * tap.x).rgb) * tap.y;
+    }
+    return colour;
+}
@@ -20,6 +20,18 @@ Texture2D    BurnMap      : register(t1);
 SamplerState TrilinearWrap : register(s1);
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match BurnConstants in Common.h
+cbuffer BurnConstants : register(b2)
+{
+    float  gBurnHeight;
+    float3 paddingB;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
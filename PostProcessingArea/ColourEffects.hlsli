@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------------------
+// Colour post-process functions for fused shaders
+//--------------------------------------------------------------------------------------
+// Runs of colour post-processes (effects that only read the pixel they write) are drawn in a single pass
+// with a shader generated at run-time by GenerateColourShader (PostProcessing/ColourEffects.cpp). Each
+// generated shader includes this file and calls the functions below in sequence. The functions match
+// the original post-process shaders and the CPU versions in ColourEffects.cpp
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_FUSED_EFFECTS in PostProcessGraph.h
+static const int MAX_COLOUR_STAGES = 8;
+
+// Settings for each effect in the fused pass, two float4s each (see MakeColourStage)
+cbuffer ColourEffectConstants : register(b2)
+{
+    float4 gColourStageParams[MAX_COLOUR_STAGES * 2];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+// All effects take the same parameters so the generator doesn't need to know which ones are used
+
+// Top to bottom gradient tint. TintHue also uses this, its hue shifted colours are worked out on the CPU
+float3 TintStage(float3 colour, float2 areaUV, float4 top, float4 bottom)
+{
+    return colour.rbg * lerp(top.rgb, bottom.rgb, areaUV.y);
+}
+
+float3 InverseStage(float3 colour, float2 areaUV, float4 params0, float4 params1)
+{
+    return 1.0f - colour;
+}
+
+float3 BlackAndWhiteStage(float3 colour, float2 areaUV, float4 params0, float4 params1)
+{
+    float average = colour.r + colour.g + colour.b / 3.0;
+    return (average <= 0.5) ? 0.0f : 1.0f;
+}
+
+float CubicCurve(float value)
+{
+    if (value < 0.5)
+    {
+        return value * value * value * value * value * 16.0;
+    }
+    value -= 1.0;
+    return value * value * value * value * value * 16.0 + 1.0;
+}
+
+// params0.x is the gamma
+float3 SigmoidStage(float3 colour, float2 areaUV, float4 params0, float4 params1)
+{
+    float3 curve = float3(CubicCurve(colour.r), CubicCurve(colour.g), CubicCurve(colour.b));
+    return colour * pow(curve, params0.x);
+}
+
+float3 NightVisionStage(float3 colour, float2 areaUV, float4 params0, float4 params1)
+{
+    float3 boosted = colour * 4;
+    if (boosted.r + boosted.g + boosted.b > 1.2f)
+    {
+        boosted /= 4;
+    }
+    boosted += 0.1f;
+    float green = (boosted.g + boosted.b) / 3;
+    return float3(0.0f, colour.g * green, 0.0f);
+}
@@ -7,6 +7,9 @@
 #include "CVector2.h"
 #include "CVector3.h"
 #include "CMatrix4x4.h"
+#include "PostProcessGraph.h"
+#include "SeeingWorlds.h"
+#include "Noise.h"
 
 #include <d3d11.h>
 #include <string>
@@ -108,69 +111,161 @@ extern ID3D11Buffer*     gPerModelConstantBuffer; // This variable controls the
 
 //**************************
 
-// Settings used by post-processes - must match the similar structure in the Common.hlsli shader file
+// Settings used by all post-processes - must match the similar structure in the Common.hlsli shader file
+// This only holds where on screen the post-process goes, the settings for each effect are in the structures below
 struct PostProcessingConstants
 {
 	CVector2 area2DTopLeft; // Top-left of post-process area on screen, provided as coordinate from 0.0->1.0 not as a pixel coordinate
 	CVector2 area2DSize;    // Size of post-process area on screen, provided as sizes from 0.0->1.0 (1 = full screen) not as a size in pixels
 	float    area2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
 	CVector3 paddingA;      // Pad things to collections of 4 floats (see notes in earlier labs to read about padding)
+};
 
-	CVector4 polygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
 
-	// Tint post-process settings
-	CVector4 WeightArray[301];
+//**************************
+// Settings for individual post-processes. Each effect has its own small constant buffer (register b2) holding only
+// what its shader reads, and it is only sent to the GPU when the values change (see CachedConstantBuffer in
+// GraphicsHelpers.h). Each structure must match the cbuffer of the same name in the effect's shader file
 
-	CVector3 tintColour1;
-	float    paddingB1;
+// Tint_pp.hlsl
+struct TintConstants
+{
+	CVector3 tintColour1; // Colour at the top of the area
+	float    padding1;
+	CVector3 tintColour2; // Colour at the bottom
+	float    padding2;
+};
 
+// TintHue.hlsl
+struct TintHueConstants
+{
+	CVector3 tintColour1;
+	float    hueLevel;    // Timer used to rotate the hue
 	CVector3 tintColour2;
-	float    paddingB2;
+	float    padding;
+};
 
-	float HueLevel;
-	CVector3 paddingHL;
+// Predator_pp.hlsl (scanlines)
+struct ScanlinesConstants
+{
+	float    flicker;  // The frame's flicker, including the 1/3 that averages the channels (see Scanlines.h)
+	uint32_t noiseKey; // Key for the frame's noise (see Noise.h)
+	CVector2 padding;
+};
 
-	float ITime;
-	CVector3 paddingIT;
+// SeeingWorlds1_pp.hlsl
+struct SeeingWorldsConstants
+{
+	float    time;
+	float    offset;
+	CVector2 padding;
+};
 
-	float OffSet;
-	CVector3 paddingOS;
+// SeeingWorlds2_pp.hlsl. The swirl's taps for the frame, worked out once on the CPU (see MakeSeeingWorldsTaps)
+struct SeeingWorldsTapConstants
+{
+	float    time;
+	int      tapCount;
+	float    tapWeight; // Red of each tap is multiplied by this
+	float    padding;
+	CVector4 taps[SEEING_WORLDS_TAPS]; // offset * (cos a, sin a, cos(a + 0.1), sin(a + 0.1)), turned by psd in the shader
+};
+
+// Sigmoid_pp.hlsl
+struct SigmoidConstants
+{
+	float    gamma;
+	CVector3 padding;
+};
 
-	float Gamma;
-	CVector3 paddingGamma;
+// Blur.hlsli (both blur directions). Merged taps of the kernel from GaussianKernel.h, only changes when the blur settings do
+static const int MAX_BLUR_TAPS = 40; // Largest kernel (strength slider goes to 151) has 39 taps, rounded up to a whole float4 of pairs
+struct BlurConstants
+{
+	int      tapCount;  // Taps used, tap 0 is the centre and the others are sampled on both sides
+	float    stepScale; // Size of a pixel of the render target in full size pixels (the pass's downscale)
+	CVector2 padding;
+	CVector4 taps[MAX_BLUR_TAPS / 2]; // Tap offset (in pixels) and weight pairs, two taps to a float4
+};
 
-	int blurStrength;
-	CVector3 paddingBS;
+// Bloom.hlsli (all the bloom shaders)
+struct BloomConstants
+{
+	float    threshold; // Brightness (0->1) above which colours glow
+	float    glowScale; // Intensity divided by the number of pyramid levels
+	CVector2 padding;
+};
 
-    // Burn post-process settings
+// VariableBlur.hlsli (the summed-area table shaders and VariableBlur_pp.hlsl)
+struct VariableBlurConstants
+{
+	float innerRadius; // Blur radius in full size pixels in the middle of the area, out to the focus distance
+	float outerRadius; // Blur radius at the edge of the area's circle
+	float focus;       // Distance from the middle (0->1) where the radius starts to grow
+	int   boxes;       // Boxes stacked for each pixel
+	int   tableWidth;  // Size of the image the summed-area table is built from, in pixels
+	int   tableHeight;
+	int   stepX;       // Building the table: offset of the sum added to each entry, along a row or down a column
+	int   stepY;
+};
+
+// Pixelation.hlsli (PixelationReduce_pp.hlsl and PixelationShader_pp.hlsl)
+struct PixelationConstants
+{
+	int blockWidth;  // Size of each block in full size pixels
+	int blockHeight;
+	int levels;      // Levels each colour channel is posterised to
+	int padding;
+};
+
+// Burn_pp.hlsl
+struct BurnConstants
+{
 	float    burnHeight;
-	CVector3 paddingC;
+	CVector3 padding;
+};
 
-	// Distort post-process settings
+// Distort_pp.hlsl
+struct DistortConstants
+{
 	float    distortLevel;
-	CVector3 paddingD;
+	CVector3 padding;
+};
 
-	// Spiral post-process settings
+// Spiral_pp.hlsl
+struct SpiralConstants
+{
 	float    spiralLevel;
-	CVector3 paddingE;
+	CVector3 padding;
+};
 
-	// Heat haze post-process settings
+// HeatHaze_pp.hlsl
+struct HeatHazeConstants
+{
 	float    heatHazeTimer;
-	CVector3 paddingF;
-
-	float WaterLevel;
-	CVector3 paddingG;
+	CVector3 padding;
+};
 
-	// Grey noise post-process settings
-    CVector2 noiseScale;
-	CVector2 PaddingScale;
+// Underwater_pp.hlsl
+struct UnderwaterConstants
+{
+	float    waterLevel;
+	CVector3 padding;
+};
 
-	CVector2 noiseOffset;
-	CVector2 PaddingOffset;
+// GreyNoise_pp.hlsl
+struct GreyNoiseConstants
+{
+	float    grainCell; // Size of the noise cells in pixels of the render target, at least 1
+	uint32_t noiseKey;  // Key for the frame's noise (see Noise.h)
+	CVector2 padding;
+};
 
+// Settings for each effect in a fused colour post-process pass - must match the structure in the ColourEffects.hlsli shader file
+struct ColourEffectConstants
+{
+	CVector4 stageParams[MAX_FUSED_EFFECTS * 2]; // Two float4s per effect, packed by MakeColourStage (see ColourEffects.h)
 };
-extern PostProcessingConstants gPostProcessingConstants;      // This variable holds the CPU-side constant buffer described above
-extern ID3D11Buffer*           gPostProcessingConstantBuffer; // This variable controls the GPU-side constant buffer related to the above structure
 
 //**************************
 
@@ -120,66 +120,14 @@ cbuffer PerModelConstants : register(b1) // The b1 gives this constant buffer th
 // This is where we receive post-processing settings from the C++ side
 // These variables must match exactly the gPostProcessingConstants structure in Scene.cpp
 // Note that this buffer reuses the same index (register) as the per-model buffer above since they won't be used together
+// Only the position of the post-process is here, the settings for each effect are in their own buffer (register b2)
+// declared in the effect's shader file
 cbuffer PostProcessingConstants : register(b1) 
 {
 	float2 gArea2DTopLeft; // Top-left of post-process area on screen, provided as coordinate from 0.0->1.0 not as a pixel coordinate
 	float2 gArea2DSize;    // Size of post-process area on screen, provided as sizes from 0.0->1.0 (1 = full screen) not as a size in pixels
 	float  gArea2DDepth;   // Depth buffer value for area (0.0 nearest to 1.0 furthest). Full screen post-processing uses 0.0f
 	float3 paddingA;       // Pad things to collections of 4 floats (see notes in earlier labs to read about padding)
-
-  	float4 gPolygon2DPoints[4]; // Four points of a polygon in 2D viewport space for polygon post-processing. Matrix transformations already done on C++ side
-
-    float4 gWeightArray[301];
-
-	// Tint post-process settings
-	float3 gTintColour1;
-    float paddingB1;
-    // Tint post-process settings
-    float3 gTintColour2;
-    float paddingB2;
-    // Tint post-process settings
-
-    float gHueLevel;
-    float3 paddingHL;
-    
-    float gITime;
-    float3 gpaddingIT;
-    
-    float gOffSet;
-    float3 gpaddingOS;
-    
-    float gGamma;
-    float3 gpaddingGamma;
-
-    int gblurStrength;
-    float3 paddingBS;
-    
-    // Burn post-process settings
-    float gBurnHeight;
-    float3 paddingC;
-
-	// Distort post-process settings
-    float gDistortLevel;
-    float3 paddingD;
-
-	// Spiral post-process settings
-    float gSpiralLevel;
-    float3 paddingE;
-
-	// Heat haze post-process settings
-    float gHeatHazeTimer;
-    float3 paddingF;
-    
-    float gWaterLevel;
-    float3 paddingG;
-    
-	// Grey noise post-process settings
-    float2 gNoiseScale;
-    float2 PaddingScale;
-    
-    float2 gNoiseOffset;
-    float2 PaddingOffset;
-    
 }
 
 //**************************
@@ -21,6 +21,18 @@ SamplerState TrilinearWrap : register(s1);
 
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match DistortConstants in Common.h
+cbuffer DistortConstants : register(b2)
+{
+    float  gDistortLevel;
+    float3 paddingD;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -4,6 +4,7 @@
 // Just samples a pixel from the scene texture and multiplies it by a fixed colour to tint the scene
 
 #include "Common.hlsli"
+#include "Noise.hlsli"
 
 
 //--------------------------------------------------------------------------------------
@@ -15,9 +16,18 @@ Texture2D    SceneTexture : register(t0);
 SamplerState PointSample  : register(s0); // We don't usually want to filter (bilinear, trilinear etc.) the scene texture when
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
-// This shader also uses a texture filled with noise
-Texture2D    NoiseMap      : register(t1);
-SamplerState TrilinearWrap : register(s1);
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match GreyNoiseConstants in Common.h
+cbuffer GreyNoiseConstants : register(b2)
+{
+    float gGrainCell; // Size of the noise cells in pixels of the render target, at least 1
+    uint  gNoiseKey;  // Key for this frame's noise, so it changes every frame (like tv static)
+    float2 paddingN;
+}
 
 
 //--------------------------------------------------------------------------------------
@@ -33,10 +43,9 @@ float4 main(PostProcessingInput input) : SV_Target
 	float3 sceneColour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;
 	float grey = (sceneColour.r + sceneColour.g + sceneColour.b) / 3.0f;
 
-	// Get noise UV by scaling and offseting scene texture UV. Scaling adjusts how fine the noise is.
-	// The offset is randomised every frame (in C++) to give a constantly changing noise effect (like tv static)
-	float2 noiseUV = input.sceneUV * gNoiseScale + gNoiseOffset;
-	grey += NoiseStrength * (NoiseMap.Sample(TrilinearWrap, noiseUV).r - 0.5f); // Noise can increase or decrease grey value hence the -0.5f
+	// Noise for this pixel of the render target, the grain cell size adjusts how fine the noise is
+	float noise = GrainNoise(int2(input.projectedPosition.xy), gGrainCell, gNoiseKey);
+	grey += NoiseStrength * (noise - 0.5f); // Noise can increase or decrease grey value hence the -0.5f
 
 	// Calculate alpha to display the effect in a softened circle, could use a texture rather than calculations for the same task.
 	// Uses the second set of area texture coordinates, which range from (0,0) to (1,1) over the area being processed
@@ -16,6 +16,18 @@ SamplerState PointSample  : register(s0); // We don't usually want to filter (bi
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match HeatHazeConstants in Common.h
+cbuffer HeatHazeConstants : register(b2)
+{
+    float  gHeatHazeTimer;
+    float3 paddingH;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+//--------------------------------------------------------------------------------------
+// Stateless noise for the GreyNoise and Scanlines post-processes
+//--------------------------------------------------------------------------------------
+// A hash of the pixel's position and a key for the frame (worked out in C++ with NoiseKey). See
+// PostProcessing/Noise.h for the CPU version, whose hashes are exactly the same
+
+
+// PCG hash of a value (Jarzynski and Olano, "Hash Functions for GPU Rendering")
+uint PcgHash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Noise value (0->1) of a pixel of the render target
+float PixelNoise(int2 pixel, uint key)
+{
+    uint hash = PcgHash(uint(pixel.x) + PcgHash(uint(pixel.y) + key));
+    return float(hash >> 8) * (1.0f / 16777216.0f);
+}
+
+// Noise value (0->1) of a pixel with cells of the given size in pixels, blended between the values of the nearest four
+float GrainNoise(int2 pixel, float cellPixels, uint key)
+{
+    if (cellPixels <= 1.0f)  return PixelNoise(pixel, key);
+
+    float2 cell = (float2(pixel) + 0.5f) / cellPixels - 0.5f;
+    int2 topLeft = int2(floor(cell));
+    float2 blend = cell - float2(topLeft);
+
+    float upper = lerp(PixelNoise(topLeft,               key), PixelNoise(topLeft + int2(1, 0), key), blend.x);
+    float lower = lerp(PixelNoise(topLeft + int2(0, 1), key), PixelNoise(topLeft + int2(1, 1), key), blend.x);
+    return lerp(upper, lower, blend.y);
+}
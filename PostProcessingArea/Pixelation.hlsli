@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// Settings and helpers for the pixelation post-process
+//--------------------------------------------------------------------------------------
+// Shared by the shader that reduces the image to one pixel per block (PixelationReduce_pp.hlsl) and the one
+// that draws the blocks (PixelationShader_pp.hlsl). See PostProcessing/Pixelation.h for the CPU version
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_PIXELATION_BLOCK and MAX_PIXELATION_LEVELS in Pixelation.h
+static const int MAX_PIXELATION_BLOCK = 64;
+static const int MAX_PIXELATION_LEVELS = 255;
+
+// Must match PixelationConstants in Common.h
+cbuffer PixelationConstants : register(b2)
+{
+    int2 gBlockSize;       // Size of each block in full size pixels
+    int  gPosteriseLevels; // Levels each colour channel is posterised to
+    int  paddingPX;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Blocks across and down the viewport, the last ones may be cut short
+int2 PixelationBlockCount()
+{
+    int2 viewport = int2(gViewportWidth, gViewportHeight);
+    return max((viewport + gBlockSize - 1) / gBlockSize, 1);
+}
+
+// The block a point on the screen lies in
+int2 PixelationBlock(float2 uv)
+{
+    float2 viewport = float2(gViewportWidth, gViewportHeight);
+    return clamp(int2(floor(uv * viewport / gBlockSize)), 0, PixelationBlockCount() - 1);
+}
+
+// Colour posterised to the levels in the settings, rounding down
+float3 Posterise(float3 colour)
+{
+    return floor(saturate(colour) * gPosteriseLevels) / gPosteriseLevels;
+}
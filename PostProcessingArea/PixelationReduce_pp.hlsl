@@ -0,0 +1,62 @@
+//--------------------------------------------------------------------------------------
+// Pixelation - reduce
+//--------------------------------------------------------------------------------------
+// Draws one pixel per block: the average of the image's pixels in the block, posterised once for the whole
+// block. The pixels of a block are those whose centres lie in it, so an image drawn at a reduced resolution
+// averages its own pixels over the same blocks
+
+#include "Pixelation.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The image being pixelated, its pixels are read directly
+Texture2D SceneTexture : register(t0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    int2 block = int2(input.projectedPosition.xy);
+
+    uint width, height;
+    SceneTexture.GetDimensions(width, height);
+    int2 sourceSize = int2(width, height);
+    float2 viewport = float2(gViewportWidth, gViewportHeight);
+
+    // Pixels that may be in the block with one to spare each side, each is tested with the same sums as the CPU version
+    int2 first = max(int2(floor(block * gBlockSize / viewport * sourceSize)) - 1, 0);
+    int2 last  = min(int2(ceil((block + 1) * gBlockSize / viewport * sourceSize)) + 1, sourceSize);
+
+    float3 sum = 0;
+    int count = 0;
+    [loop] for (int y = first.y; y < last.y; y++)
+    {
+        if (PixelationBlock(float2(0, (y + 0.5f) / sourceSize.y)).y != block.y)  continue;
+
+        [loop] for (int x = first.x; x < last.x; x++)
+        {
+            if (PixelationBlock(float2((x + 0.5f) / sourceSize.x, 0)).x != block.x)  continue;
+            sum += SceneTexture.Load(int3(x, y, 0)).rgb;
+            count++;
+        }
+    }
+
+    // No pixel has its centre in a block smaller than the image's pixels, take the one at the block's centre
+    float3 colour;
+    if (count > 0)
+    {
+        colour = sum / count;
+    }
+    else
+    {
+        int2 centre = min(int2(floor((block + 0.5f) * gBlockSize / viewport * sourceSize)), sourceSize - 1);
+        colour = SceneTexture.Load(int3(centre, 0)).rgb;
+    }
+    return float4(Posterise(colour), 1.0f);
+}
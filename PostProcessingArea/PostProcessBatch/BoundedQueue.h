@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------------------
+// Queue passing work between threads, holding a limited number of items
+//--------------------------------------------------------------------------------------
+// Push waits while the queue is full and Pop waits while it is empty, so a fast stage can only get
+// a few items ahead of a slow one and memory use stays bounded however long the sequence is.
+// Closing the queue tells the reader no more items are coming: Pop returns false once the queue is
+// empty, and Push returns false straight away (e.g. a later stage failed and nothing is reading).
+
+#ifndef _BOUNDED_QUEUE_H_INCLUDED_
+#define _BOUNDED_QUEUE_H_INCLUDED_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(int capacity) : mCapacity(capacity < 1 ? 1 : capacity) {}
+
+	// Add an item, waiting for room. Returns false (dropping the item) if the queue has been closed
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotFull.wait(lock, [this]() { return mClosed || static_cast<int>(mItems.size()) < mCapacity; });
+		if (mClosed)  return false;
+		mItems.push_back(std::move(item));
+		mNotEmpty.notify_one();
+		return true;
+	}
+
+	// Take the oldest item, waiting for one. Returns false if the queue is closed and empty
+	bool Pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotEmpty.wait(lock, [this]() { return mClosed || !mItems.empty(); });
+		if (mItems.empty())  return false;
+		item = std::move(mItems.front());
+		mItems.pop_front();
+		mNotFull.notify_one();
+		return true;
+	}
+
+	// No more items will be pushed. Items already queued can still be popped
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mClosed = true;
+		mNotEmpty.notify_all();
+		mNotFull.notify_all();
+	}
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	int                     mCapacity;
+	bool                    mClosed = false;
+	std::deque<T>           mItems;
+	std::mutex              mMutex;
+	std::condition_variable mNotEmpty;
+	std::condition_variable mNotFull;
+};
+
+
+#endif //_BOUNDED_QUEUE_H_INCLUDED_
@@ -0,0 +1,418 @@
+//--------------------------------------------------------------------------------------
+// Offline batch tool - runs a saved post-process chain over a sequence of frames
+//--------------------------------------------------------------------------------------
+// Reads a chain file (saved from the app with "Save Chain", see PostProcessing/ChainFile.h) and a
+// directory of PPM/PNG frames, or a stream of them on stdin, runs every frame through the chain on the
+// CPU backend and writes the results to a directory or stdout. Frames are decoded, processed and encoded
+// on three threads joined by short queues, so file work overlaps the processing, and each frame is
+// drawn by a pool of threads (see CpuPostProcessBackend.h). The frame rate and
+// time spent in each stage are reported at the end.
+//
+// Only the PostProcessing code and the standard library are used - no Windows, Direct3D or ImGui - so
+// this builds anywhere with CMake (see CMakeLists.txt in the folder above).
+//
+// Example, processing video frames piped through ffmpeg:
+//   ffmpeg -i in.mp4 -f image2pipe -c:v ppm - | PostProcessBatch --chain chain.txt --input - --output out
+
+#include "ChainFile.h"
+#include "ImageFile.h"
+#include "CpuPostProcessBackend.h"
+#include "BoundedQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <dirent.h>
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Options
+//--------------------------------------------------------------------------------------
+
+struct BatchOptions
+{
+	std::string ChainFile;
+	std::string Input;           // Directory of frames, or "-" for a stream on stdin
+	std::string Output;          // Directory for results, or "-" for a stream on stdout
+	std::string Format = "png";  // png or ppm
+	std::string MapsFolder = "."; // Where Burn.png and Distort.png are
+	float       FramesPerSecond = 60; // Rate the animated effects move at
+	int         QueueSize = 4;
+	int         Threads = 0;         // Threads drawing each frame, 0 for one for each core
+	unsigned    Seed = 0;        // Picks the GreyNoise and Scanlines noise, runs with the same seed repeat
+	int         RecursiveBlurRadius = DEFAULT_RECURSIVE_BLUR_RADIUS;
+	int         ColourLutSize = 0;   // Colour effects baked into lookup tables this size, 0 to run them exactly
+	bool        Quantise = true;
+};
+
+void PrintUsage()
+{
+	std::cerr <<
+		"Usage: PostProcessBatch --chain <file> --input <folder|-> --output <folder|-> [options]\n"
+		"  --chain <file>     Post-process chain saved from the app\n"
+		"  --input <folder>   Folder of .png/.ppm frames, processed in name order. - reads a stream of frames from stdin\n"
+		"  --output <folder>  Folder for the results (must exist). - writes a stream of frames to stdout\n"
+		"  --format png|ppm   Output format (default png)\n"
+		"  --maps <folder>    Folder holding Burn.png and Distort.png (default .)\n"
+		"  --fps <rate>       Frame rate for animated effects (default 60)\n"
+		"  --queue <frames>   Frames each stage may get ahead of the next (default 4)\n"
+		"  --threads <count>  Threads processing each frame (default 0, one for each core)\n"
+		"  --seed <number>    Seed for the GreyNoise and Scanlines noise (default 0)\n"
+		"  --recursive-blur <radius>  Blurs wider than this use the recursive approximation (default 24)\n"
+		"  --colour-lut <size>  Bake colour effects into lookup tables of this size, e.g. 32 (default 0, run them exactly)\n"
+		"  --no-quantise      Keep full precision between passes rather than rounding to 8 bits as the GPU does\n";
+}
+
+// Returns false if the command line can't be used
+bool ReadOptions(int argc, char* argv[], BatchOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if (option == "--no-quantise")
+		{
+			options.Quantise = false;
+			continue;
+		}
+		if (i + 1 == argc)
+		{
+			std::cerr << "No value after " << option << "\n";
+			return false;
+		}
+		std::string value = argv[++i];
+		if      (option == "--chain")   options.ChainFile = value;
+		else if (option == "--input")   options.Input = value;
+		else if (option == "--output")  options.Output = value;
+		else if (option == "--format")  options.Format = value;
+		else if (option == "--maps")    options.MapsFolder = value;
+		else if (option == "--fps")     options.FramesPerSecond = static_cast<float>(std::atof(value.c_str()));
+		else if (option == "--queue")   options.QueueSize = std::atoi(value.c_str());
+		else if (option == "--threads") options.Threads = std::atoi(value.c_str());
+		else if (option == "--seed")    options.Seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+		else if (option == "--recursive-blur")  options.RecursiveBlurRadius = std::atoi(value.c_str());
+		else if (option == "--colour-lut")      options.ColourLutSize = std::atoi(value.c_str());
+		else
+		{
+			std::cerr << "Unknown option " << option << "\n";
+			return false;
+		}
+	}
+
+	if (options.ChainFile.empty() || options.Input.empty() || options.Output.empty())
+	{
+		std::cerr << "--chain, --input and --output are needed\n";
+		return false;
+	}
+	if (options.Format != "png" && options.Format != "ppm")
+	{
+		std::cerr << "Unknown format " << options.Format << "\n";
+		return false;
+	}
+	if (options.FramesPerSecond <= 0 || options.QueueSize < 1 || options.Threads < 0)
+	{
+		std::cerr << "--fps and --queue must be positive, --threads can't be negative\n";
+		return false;
+	}
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Image files in a folder, sorted by name. Returns false if the folder can't be read
+bool ListImageFiles(const std::string& folder, std::vector<std::string>& names)
+{
+#ifdef _WIN32
+	_finddata_t found;
+	intptr_t search = _findfirst((folder + "/*").c_str(), &found);
+	if (search == -1)  return false;
+	do
+	{
+		if (!(found.attrib & _A_SUBDIR) && IsImageFileName(found.name))  names.push_back(found.name);
+	} while (_findnext(search, &found) == 0);
+	_findclose(search);
+#else
+	DIR* dir = opendir(folder.c_str());
+	if (dir == nullptr)  return false;
+	while (dirent* entry = readdir(dir))
+	{
+		if (IsImageFileName(entry->d_name))  names.push_back(entry->d_name);
+	}
+	closedir(dir);
+#endif
+	std::sort(names.begin(), names.end());
+	return true;
+}
+
+// File name with the extension replaced
+std::string ChangeExtension(const std::string& fileName, const std::string& extension)
+{
+	size_t dot = fileName.find_last_of('.');
+	return (dot == std::string::npos ? fileName : fileName.substr(0, dot)) + "." + extension;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pipeline
+//--------------------------------------------------------------------------------------
+
+// A frame passing between the stages
+struct BatchFrame
+{
+	int         Index = 0;
+	std::string Name;   // File name to write the result to when writing to a folder
+	Image       Pixels;
+};
+
+using FrameQueue = BoundedQueue<std::unique_ptr<BatchFrame>>;
+
+// State shared by the stage threads. The first stage to fail records the error and closes both queues to stop the others
+struct BatchPipeline
+{
+	BatchPipeline(int queueSize) : Decoded(queueSize), Processed(queueSize) {}
+
+	FrameQueue Decoded;
+	FrameQueue Processed;
+
+	std::mutex  ErrorMutex;
+	std::string Error;
+
+	// Time each stage spent working rather than waiting on the queues
+	double DecodeSeconds  = 0;
+	double ProcessSeconds = 0;
+	double EncodeSeconds  = 0;
+	int    FramesWritten  = 0;
+
+	void Fail(const std::string& error)
+	{
+		{
+			std::lock_guard<std::mutex> lock(ErrorMutex);
+			if (Error.empty())  Error = error;
+		}
+		Decoded.Close();
+		Processed.Close();
+	}
+};
+
+
+// Decode stage: read frames from the input folder or stdin
+void DecodeFrames(const BatchOptions& options, BatchPipeline& pipeline)
+{
+	std::string error;
+	if (options.Input == "-")
+	{
+		for (int index = 0; ; ++index)
+		{
+			auto start = std::chrono::steady_clock::now();
+			std::unique_ptr<BatchFrame> frame(new BatchFrame);
+			if (!ReadImage(std::cin, frame->Pixels, error))
+			{
+				if (!error.empty())  pipeline.Fail("Frame " + std::to_string(index) + " of input stream: " + error);
+				break;
+			}
+			frame->Index = index;
+			char name[32];
+			std::snprintf(name, sizeof(name), "frame%06d", index);
+			frame->Name = name;
+			pipeline.DecodeSeconds += SecondsSince(start);
+			if (!pipeline.Decoded.Push(std::move(frame)))  break;
+		}
+	}
+	else
+	{
+		std::vector<std::string> names;
+		if (!ListImageFiles(options.Input, names))
+		{
+			pipeline.Fail("Can't read folder " + options.Input);
+			return;
+		}
+		for (int index = 0; index < static_cast<int>(names.size()); ++index)
+		{
+			auto start = std::chrono::steady_clock::now();
+			std::unique_ptr<BatchFrame> frame(new BatchFrame);
+			if (!LoadImageFile(options.Input + "/" + names[index], frame->Pixels, error))
+			{
+				pipeline.Fail(error);
+				break;
+			}
+			frame->Index = index;
+			frame->Name = names[index];
+			pipeline.DecodeSeconds += SecondsSince(start);
+			if (!pipeline.Decoded.Push(std::move(frame)))  break;
+		}
+	}
+	pipeline.Decoded.Close();
+}
+
+
+// Process stage: run each frame through the chain. The backend is created for the size of the first frame, later frames
+// of a different size are scaled to it
+void ProcessFrames(const BatchOptions& options, PostProcessGraph& graph, BatchPipeline& pipeline)
+{
+	std::unique_ptr<CpuPostProcessBackend> backend;
+	PostProcessAnimation animation;
+	animation.NoiseSeed = options.Seed;
+	float frameTime = 1.0f / options.FramesPerSecond;
+
+	std::unique_ptr<BatchFrame> frame;
+	while (pipeline.Decoded.Pop(frame))
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (!backend)
+		{
+			backend.reset(new CpuPostProcessBackend(frame->Pixels.Width(), frame->Pixels.Height()));
+			backend->SetQuantise(options.Quantise);
+			backend->SetThreadCount(options.Threads);
+			backend->SetRecursiveBlurRadius(options.RecursiveBlurRadius);
+			backend->SetColourLutSize(options.ColourLutSize);
+
+			// Textures the effects read, missing ones read as mid-grey
+			const char* mapNames[] = { "Burn.png", "Distort.png" };
+			for (int map = 0; map < 2; ++map)
+			{
+				Image image;
+				std::string error;
+				if (!LoadImageFile(options.MapsFolder + "/" + mapNames[map], image, error))
+				{
+					std::cerr << "Warning: " << error << "\n";
+					continue;
+				}
+				if (map == 0)  backend->SetBurnMap(image);
+				else           backend->SetDistortMap(image);
+			}
+		}
+
+		AdvancePostProcessAnimation(animation, graph, frameTime);
+		backend->SetAnimation(animation);
+		backend->SetScene(frame->Pixels);
+		if (!RunPostProcessGraph(graph, *backend))
+		{
+			pipeline.Fail("Chain can't be run: " + graph.Compile().Error);
+			break;
+		}
+		frame->Pixels = backend->Output();
+		pipeline.ProcessSeconds += SecondsSince(start);
+
+		if (!pipeline.Processed.Push(std::move(frame)))  break;
+	}
+	pipeline.Processed.Close();
+}
+
+
+// Encode stage: write frames to the output folder or stdout
+void EncodeFrames(const BatchOptions& options, BatchPipeline& pipeline)
+{
+	std::unique_ptr<BatchFrame> frame;
+	while (pipeline.Processed.Pop(frame))
+	{
+		auto start = std::chrono::steady_clock::now();
+		if (options.Output == "-")
+		{
+			if (options.Format == "png")  WritePng(std::cout, frame->Pixels);
+			else                          WritePpm(std::cout, frame->Pixels);
+			if (!std::cout)
+			{
+				pipeline.Fail("Error writing to output stream");
+				break;
+			}
+		}
+		else
+		{
+			std::string error;
+			if (!SaveImageFile(options.Output + "/" + ChangeExtension(frame->Name, options.Format), frame->Pixels, error))
+			{
+				pipeline.Fail(error);
+				break;
+			}
+		}
+		pipeline.EncodeSeconds += SecondsSince(start);
+		++pipeline.FramesWritten;
+	}
+	if (options.Output == "-")  std::cout.flush();
+}
+
+
+//--------------------------------------------------------------------------------------
+// Main
+//--------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	BatchOptions options;
+	if (!ReadOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// Frames are binary data, stop Windows translating line endings on the standard streams. The streams aren't mixed
+	// with C stdio so don't need to be synchronised with it, which makes them much quicker
+	std::ios::sync_with_stdio(false);
+#ifdef _WIN32
+	if (options.Input == "-")   _setmode(_fileno(stdin), _O_BINARY);
+	if (options.Output == "-")  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	PostProcessGraph graph;
+	std::string error;
+	if (!LoadPostProcessChain(options.ChainFile, graph, error))
+	{
+		std::cerr << error << "\n";
+		return 1;
+	}
+	const CompiledPostProcessGraph& compiled = graph.Compile();
+	if (!compiled.Valid)
+	{
+		std::cerr << options.ChainFile << ": " << compiled.Error << "\n";
+		return 1;
+	}
+	std::cerr << options.ChainFile << ": " << graph.EffectCount() << " effects in " << compiled.Passes.size() << " passes\n";
+
+	// Run the three stages, each on its own thread
+	auto start = std::chrono::steady_clock::now();
+	BatchPipeline pipeline(options.QueueSize);
+	std::thread decoder(DecodeFrames, std::cref(options), std::ref(pipeline));
+	std::thread processor(ProcessFrames, std::cref(options), std::ref(graph), std::ref(pipeline));
+	EncodeFrames(options, pipeline);
+	decoder.join();
+	processor.join();
+	double seconds = SecondsSince(start);
+
+	if (!pipeline.Error.empty())
+	{
+		std::cerr << pipeline.Error << "\n";
+		return 1;
+	}
+
+	// Report. The slowest stage sets the frame rate, the others overlap with it
+	int frames = pipeline.FramesWritten;
+	double perFrame = (frames > 0) ? 1000.0 / frames : 0;
+	char report[256];
+	std::snprintf(report, sizeof(report), "%d frames in %.2fs, %.1f fps\n"
+	                                      "Per frame: decode %.2fms, process %.2fms, encode %.2fms\n",
+	              frames, seconds, (seconds > 0) ? frames / seconds : 0.0,
+	              pipeline.DecodeSeconds * perFrame, pipeline.ProcessSeconds * perFrame, pipeline.EncodeSeconds * perFrame);
+	std::cerr << report;
+	return 0;
+}
@@ -0,0 +1,767 @@
+//--------------------------------------------------------------------------------------
+// Benchmarks of the CPU backend at common screen sizes
+//--------------------------------------------------------------------------------------
+// Runs a chain (a chain file, or a typical full-screen chain built in) through the CPU backend at
+// 1280x960, 1920x1080 and 3840x2160 with 1, 2, 4... threads up to the number of cores, with and
+// without fusing full-screen passes into tiles. Prints the time per frame and the speed up over one
+// thread without fusion, and checks every run gives exactly the same image as that one.
+//
+// With --blur, times the vectorised blur (SeparableBlur.h) on one thread instead: both directions at
+// the default Blur(5), Blur(61) and Blur(151), with each instruction set the processor has, against
+// the scalar version, blurring pixel by pixel with the merged taps as the shaders do and the recursive
+// blur (RecursiveGaussian.h). Then reports how far the recursive blur is from each kernel.
+//
+// With --lut, times runs of colour effects on one thread instead: applied exactly, then baked into 32
+// and 64 point lookup tables (ColourLut.h), with the time to bake the tables and how far they are from
+// the exact result.
+//
+// With --warp, times Distort, Spiral, Underwater and HeatHaze full-screen on one thread instead: shaded
+// pixel by pixel, then a row at a time (UvWarp.h) with each instruction set the processor has. Reports
+// how many pixels differ from those shaded one at a time.
+//
+// With --march, times SeeingWorlds on one thread instead: the port of the shader a pixel at a time, then
+// marching packets of rays (SeeingWorlds.h) with each instruction set, for the shader's 100 steps and
+// fewer. Reports how many pixels differ from the shader's result.
+//
+// With --swirl, times SeeingWorlds' swirl (the second node) on one thread instead, with the shader's 100
+// taps and fewer (SeeingWorldsTaps in SeeingWorlds.h). Reports how far the colours are from 100 taps,
+// for one frame with the same taps each frame and averaged over 8 frames of stochastic taps.
+//
+// With --burn, times Burn over a full-screen area on one thread instead, at several burn heights: drawn
+// pixel by pixel, then from the area's cached burn map samples a band at a time (BurnBands.h). Reads
+// Burn.png from the current directory if it is there, otherwise makes a map of value noise. Reports the
+// share of the map in the band, whether the two give the same image and the time to sample the map. Times
+// are for the whole chain, including copying the scene to the output the area is drawn over.
+//
+// With --bloom, times Bloom on one thread instead: the pyramid (Bloom.h) built to each number of levels on its
+// own and with the glow added over the image, against the path it replaced - a bright pass, the Blur(30) the
+// Bloom button used to add in both directions, and a merge - at full size.
+//
+// With --pool, runs the chain's render targets through the pool (RenderTargetPool.h) without a GPU instead,
+// for two frames at each size. Reports the memory the app used to create at start up against the most the
+// pool has in use at once and what it holds between frames, and checks the second frame creates nothing.
+//
+//   PostProcessBench [--blur | --lut | --warp | --march | --swirl | --burn | --bloom | --pool] [--chain chain.txt] [--threads max] [--frames count] [--tile width height] [--size width height]
+
+#include "ChainFile.h"
+#include "ImageFile.h"
+#include "CpuPostProcessBackend.h"
+#include "SeparableBlur.h"
+#include "RecursiveGaussian.h"
+#include "ColourLut.h"
+#include "UvWarp.h"
+#include "SeeingWorlds.h"
+#include "Bloom.h"
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+	// Scene to process, smooth gradients with some hard edges so every effect has something to work on
+	Image TestScene(int width, int height)
+	{
+		Image scene(width, height);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				float u = static_cast<float>(x) / width;
+				float v = static_cast<float>(y) / height;
+				bool  check = ((x / 64) + (y / 64)) % 2 == 0;
+				scene.Pixel(x, y) = ColourRGBA(u, v, check ? 0.8f : 0.2f, 1);
+			}
+		}
+		return scene;
+	}
+
+	// Chain used when no file is given: a tint, a blur (its two passes), a distortion and noise, all full-screen
+	void DefaultChain(PostProcessGraph& graph)
+	{
+		const PostProcess effects[] = { PostProcess::Tint, PostProcess::Blur, PostProcess::Underwater, PostProcess::GreyNoise };
+		for (PostProcess effect : effects)
+		{
+			graph.AddEffect(effect, PostProcessMode::Fullscreen, 0, PPNames[static_cast<int>(effect)], DefaultPostProcessData(effect));
+		}
+	}
+
+	// Milliseconds per call of a function, averaged over the given number of calls
+	template <typename Function>
+	double TimeCalls(int calls, Function function)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int call = 0; call < calls; ++call)  function();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / calls;
+	}
+
+	// Time each form of the blur at each size
+	void BlurBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		std::printf("Blur, one thread, %d runs each. Best instruction set: %s\n\n", frames, SimdLevelNames[static_cast<int>(BestSimdLevel())]);
+		std::printf("%-10s %6s %4s %12s", "Size", "Radius", "Dir", "Taps ms");
+		for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)  std::printf(" %9s ms %7s", SimdLevelNames[level], "Speed up");
+		std::printf(" %12s %7s\n", "Recursive ms", "vs best");
+
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			Image blurred;
+			for (int blur : { 5, 61, 151 })
+			{
+				// Radius from the Blur setting as SelectPostProcessShaderAndTextures works it out, sigma a third of that
+				int radius = (blur - 1) / 2 + 1;
+				GaussianKernel kernel = MakeGaussianKernel(radius, radius / 3.0f);
+				RecursiveGaussian filter = MakeRecursiveGaussian(kernel);
+				for (int horizontal = 0; horizontal < 2; ++horizontal)
+				{
+					double taps = TimeCalls(frames, [&]() { GaussianBlurImage(scene, blurred, kernel, horizontal != 0, true); });
+					std::printf("%4dx%-5d %6d %4s %12.1f", size.first, size.second, kernel.Radius, horizontal ? "H" : "V", taps);
+
+					double scalar = 0, best = 0;
+					for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)
+					{
+						best = TimeCalls(frames, [&]() { SeparableBlurImage(scene, blurred, kernel, horizontal != 0, static_cast<SimdLevel>(level)); });
+						if (level == 0)  scalar = best;
+						std::printf(" %12.1f %6.2fx", best, scalar / best);
+					}
+
+					double recursive = TimeCalls(frames, [&]() { RecursiveBlurImage(scene, blurred, filter, horizontal != 0); });
+					std::printf(" %12.1f %6.2fx\n", recursive, best / recursive);
+				}
+			}
+		}
+
+		// How far the recursive filter is from each kernel. The Blur effect's default sigma (40) cuts most kernels short
+		std::printf("\nRecursive blur against the kernel, differences in 8-bit levels on a %dx%d scene\n\n", sizes[0].first, sizes[0].second);
+		std::printf("%6s %6s %8s %14s %10s %10s %6s\n", "Radius", "Sigma", "Spread", "Kernel max %", "Image max", "Image RMS", "Used");
+		Image scene = TestScene(sizes[0].first, sizes[0].second);
+		for (int radius : { 3, 8, 16, 31, 76 })
+		{
+			for (float sigma : { radius / 3.0f, radius / 2.5f, radius / 2.0f, 40.0f })
+			{
+				GaussianKernel kernel = MakeGaussianKernel(radius, sigma);
+				RecursiveGaussianError error = MeasureRecursiveGaussian(kernel, scene);
+				std::printf("%6d %6.1f %8.2f %14.1f %10.2f %10.3f %6s\n", radius, sigma, MakeRecursiveGaussian(kernel).Sigma,
+				            100 * error.KernelMax / error.KernelPeak, error.ImageMax * 255, error.ImageRms * 255,
+				            RecursiveGaussianFits(kernel) ? "yes" : "no");
+			}
+		}
+	}
+
+	// Time runs of colour effects applied exactly and from lookup tables of each size
+	void LutBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		const std::vector<std::vector<PostProcess>> runs =
+		{
+			{ PostProcess::Sigmoid },
+			{ PostProcess::Sigmoid, PostProcess::Inverse },
+			{ PostProcess::Sigmoid, PostProcess::NightVision },
+			{ PostProcess::TintHue, PostProcess::Sigmoid, PostProcess::BlackAndWhite },
+		};
+
+		std::printf("Colour effects, one thread, %d runs each. Differences in 8-bit levels\n\n", frames);
+		std::printf("%-10s %-28s %9s %5s %9s %9s %8s %9s %9s\n", "Size", "Effects", "Exact ms", "Table", "Bake ms", "Table ms",
+		            "Speed up", "Max diff", "RMS diff");
+
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			Image exact, baked;
+			for (const std::vector<PostProcess>& run : runs)
+			{
+				ColourStage stages[MAX_FUSED_EFFECTS];
+				const int count = static_cast<int>(run.size());
+				for (int s = 0; s < count; ++s)  stages[s] = MakeColourStage(run[s], DefaultPostProcessData(run[s]), 0.5f);
+				std::string name = ColourShaderKey(stages, count);
+
+				double exactTime = TimeCalls(frames, [&]() { RunColourStages(scene, exact, stages, count); });
+				for (int tableSize : { DEFAULT_COLOUR_LUT_SIZE, MAX_COLOUR_LUT_SIZE })
+				{
+					BakedColourStages tables;
+					double bakeTime  = TimeCalls(1, [&]() { tables.Build(stages, count, tableSize); });
+					double tableTime = TimeCalls(frames, [&]() { tables.Run(stages, scene, baked); });
+
+					double maxDifference = 0, sumSquares = 0;
+					for (int y = 0; y < scene.Height(); ++y)
+					{
+						const ColourRGBA* a = exact.Row(y);
+						const ColourRGBA* b = baked.Row(y);
+						for (int x = 0; x < scene.Width(); ++x)
+						{
+							for (float difference : { a[x].r - b[x].r, a[x].g - b[x].g, a[x].b - b[x].b })
+							{
+								maxDifference = std::max(maxDifference, static_cast<double>(std::abs(difference)));
+								sumSquares += static_cast<double>(difference) * difference;
+							}
+						}
+					}
+					double rms = std::sqrt(sumSquares / (3.0 * scene.Width() * scene.Height()));
+					std::printf("%4dx%-5d %-28s %9.1f %5d %9.1f %9.1f %7.2fx %9.1f %9.2f\n", size.first, size.second, name.c_str(),
+					            exactTime, tableSize, bakeTime, tableTime, exactTime / tableTime, maxDifference * 255, rms * 255);
+				}
+			}
+		}
+	}
+
+	// Time the warp effects shaded pixel by pixel and a row at a time
+	void WarpBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		const PostProcess effects[] = { PostProcess::Distort, PostProcess::Spiral, PostProcess::Underwater, PostProcess::HeatHaze };
+
+		// A distort map with ripples across and down it, and the animation part way through
+		Image ripples(256, 256);
+		for (int y = 0; y < ripples.Height(); ++y)
+		{
+			for (int x = 0; x < ripples.Width(); ++x)
+			{
+				ripples.Pixel(x, y) = ColourRGBA(0.5f, 0.5f + 0.4f * std::sin(x * 0.1f), 0.5f + 0.4f * std::cos(y * 0.13f), 1);
+			}
+		}
+		MipMappedImage distortMap;
+		distortMap.Set(ripples);
+		PostProcessAnimation animation;
+		animation.SpiralLevel   = 5.3f;
+		animation.WaterLevel    = 1.3f;
+		animation.HeatHazeTimer = 2.1f;
+
+		std::printf("Warp effects, one thread, %d runs each. Best instruction set: %s\n\n", frames, SimdLevelNames[static_cast<int>(BestSimdLevel())]);
+		std::printf("%-10s %-10s %9s", "Size", "Effect", "Pixel ms");
+		for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)  std::printf(" %9s ms %7s", SimdLevelNames[level], "Speed up");
+		std::printf(" %9s\n", "Differ");
+
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			Image exact(size.first, size.second), rows(size.first, size.second);
+			for (PostProcess effect : effects)
+			{
+				PostProcessData data = DefaultPostProcessData(effect);
+				CpuEffectInputs inputs;
+				inputs.Sources[0] = &scene;
+				inputs.Data       = &data;
+				inputs.Animation  = &animation;
+				inputs.DistortMap = &distortMap;
+				inputs.ViewportWidth  = size.first;
+				inputs.ViewportHeight = size.second;
+				inputs.ScenePixels[0] = inputs.AreaPixels[0] = static_cast<float>(size.first);
+				inputs.ScenePixels[1] = inputs.AreaPixels[1] = static_cast<float>(size.second);
+
+				double pixelTime = TimeCalls(frames, [&]()
+				{
+					for (int y = 0; y < exact.Height(); ++y)
+					{
+						for (int x = 0; x < exact.Width(); ++x)
+						{
+							CpuEffectPixel pixel = { exact.U(x), exact.V(y), exact.U(x), exact.V(y) };
+							exact.Pixel(x, y) = ShadeEffectPixel(effect, inputs, pixel);
+						}
+					}
+				});
+				std::printf("%4dx%-5d %-10s %9.1f", size.first, size.second, PPNames[static_cast<int>(effect)], pixelTime);
+
+				for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)
+				{
+					double rowTime = TimeCalls(frames, [&]()
+					{
+						UvWarp warp;
+						warp.Begin(effect, inputs, rows, 0, rows.Width(), 0, 1, static_cast<SimdLevel>(level));
+						for (int y = 0; y < rows.Height(); ++y)  warp.ShadeRow(rows.V(y), rows.V(y), rows.Row(y));
+					});
+					std::printf(" %12.1f %6.2fx", rowTime, pixelTime / rowTime);
+				}
+
+				// Every level gives the same image, compare the last
+				int differ = 0;
+				for (int y = 0; y < rows.Height(); ++y)
+				{
+					for (int x = 0; x < rows.Width(); ++x)
+					{
+						differ += (std::memcmp(&exact.Pixel(x, y), &rows.Pixel(x, y), sizeof(ColourRGBA)) != 0) ? 1 : 0;
+					}
+				}
+				std::printf(" %9d\n", differ);
+			}
+		}
+	}
+
+	// Time SeeingWorlds shaded a pixel at a time and in packets, with the full number of steps and fewer
+	void MarchBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		const float time = 3.7f;
+		std::printf("SeeingWorlds, one thread, %d runs each. Best instruction set: %s\n\n", frames, SimdLevelNames[static_cast<int>(BestSimdLevel())]);
+		std::printf("%-10s %5s %9s", "Size", "Steps", "Pixel ms");
+		for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)  std::printf(" %9s ms %7s", SimdLevelNames[level], "Speed up");
+		std::printf(" %9s\n", "Differ");
+
+		for (const auto& size : sizes)
+		{
+			Image exact(size.first, size.second), packets(size.first, size.second);
+			std::vector<float> sceneU(size.first);
+			for (int x = 0; x < size.first; ++x)  sceneU[x] = exact.U(x);
+
+			// The shader's result, which every run is compared with
+			double pixelTime = TimeCalls(frames, [&]()
+			{
+				for (int y = 0; y < exact.Height(); ++y)
+				{
+					for (int x = 0; x < exact.Width(); ++x)  exact.Pixel(x, y) = SeeingWorldsPixel(exact.U(x), exact.V(y), time);
+				}
+			});
+
+			for (int iterations : { SEEING_WORLDS_ITERATIONS, 8, 2 })
+			{
+				std::printf("%4dx%-5d %5d %9.1f", size.first, size.second, iterations, pixelTime);
+				for (int level = 0; level <= static_cast<int>(BestSimdLevel()); ++level)
+				{
+					double packetTime = TimeCalls(frames, [&]()
+					{
+						for (int y = 0; y < packets.Height(); ++y)
+						{
+							MarchSeeingWorlds(sceneU.data(), packets.V(y), time, iterations, packets.Row(y), packets.Width(), static_cast<SimdLevel>(level));
+						}
+					});
+					std::printf(" %12.1f %6.2fx", packetTime, pixelTime / packetTime);
+				}
+
+				// Every level gives the same image, compare the last
+				int differ = 0;
+				for (int y = 0; y < packets.Height(); ++y)
+				{
+					for (int x = 0; x < packets.Width(); ++x)
+					{
+						differ += (std::memcmp(&exact.Pixel(x, y), &packets.Pixel(x, y), sizeof(ColourRGBA)) != 0) ? 1 : 0;
+					}
+				}
+				std::printf(" %9d\n", differ);
+			}
+		}
+	}
+
+	// Time the SeeingWorlds swirl with fewer taps, and how far it moves from the shader's 100
+	void SwirlBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		const float time = 3.7f, offset = 0.05f;
+		const int stochasticFrames = 8;
+		std::printf("SeeingWorlds swirl, one thread, %d runs each\n\n", frames);
+		std::printf("%-10s %5s %9s %8s %10s %10s\n", "Size", "Taps", "ms", "Speed up", "Fixed err", "Stoch err");
+
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			Image full(size.first, size.second), fewer(size.first, size.second);
+			std::vector<ColourRGBA> average(size.first * size.second);
+			auto drawSwirl = [&](Image& image, const SeeingWorldsTaps& taps)
+			{
+				for (int y = 0; y < image.Height(); ++y)
+				{
+					for (int x = 0; x < image.Width(); ++x)  image.Pixel(x, y) = SeeingWorldsSwirlPixel(scene, image.U(x), image.V(y), time, taps);
+				}
+			};
+
+			// Mean difference of a channel from the 100 tap image
+			auto meanError = [&](const ColourRGBA* pixels, int rowStride)
+			{
+				double total = 0;
+				for (int y = 0; y < full.Height(); ++y)
+				{
+					for (int x = 0; x < full.Width(); ++x)
+					{
+						const ColourRGBA& a = pixels[y * rowStride + x];
+						const ColourRGBA& b = full.Pixel(x, y);
+						total += std::fabs(a.r - b.r) + std::fabs(a.g - b.g) + std::fabs(a.b - b.b);
+					}
+				}
+				return total / (3.0 * full.Width() * full.Height());
+			};
+
+			SeeingWorldsTaps taps;
+			MakeSeeingWorldsTaps(time, offset, SEEING_WORLDS_TAPS, false, 0, taps);
+			double fullTime = TimeCalls(frames, [&]() { drawSwirl(full, taps); });
+
+			for (int tapCount : { SEEING_WORLDS_TAPS, 50, 25, 10 })
+			{
+				MakeSeeingWorldsTaps(time, offset, tapCount, false, 0, taps);
+				double tapTime = TimeCalls(frames, [&]() { drawSwirl(fewer, taps); });
+				double fixedError = meanError(fewer.Row(0), fewer.Width());
+
+				// What the eye sees over a few frames of stochastic taps (the time held still so only the taps change)
+				std::fill(average.begin(), average.end(), ColourRGBA(0, 0, 0, 0));
+				for (int frame = 1; frame <= stochasticFrames; ++frame)
+				{
+					MakeSeeingWorldsTaps(time, offset, tapCount, true, frame, taps);
+					drawSwirl(fewer, taps);
+					for (int y = 0; y < fewer.Height(); ++y)
+					{
+						for (int x = 0; x < fewer.Width(); ++x)
+						{
+							ColourRGBA& sum = average[y * fewer.Width() + x];
+							const ColourRGBA& colour = fewer.Pixel(x, y);
+							sum = ColourRGBA(sum.r + colour.r / stochasticFrames, sum.g + colour.g / stochasticFrames, sum.b + colour.b / stochasticFrames, 1);
+						}
+					}
+				}
+				double stochasticError = meanError(average.data(), fewer.Width());
+
+				std::printf("%4dx%-5d %5d %9.1f %7.2fx %10.4f %10.4f\n", size.first, size.second, tapCount, tapTime, fullTime / tapTime,
+				            fixedError, stochasticError);
+			}
+		}
+	}
+
+	// Time Burn drawn pixel by pixel and a band at a time, returns false if they give different images
+	bool BurnBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		// The app's burn map, or value noise with cells of 32 texels in its place
+		Image burnMap;
+		std::string error;
+		bool appMap = LoadImageFile("Burn.png", burnMap, error);
+		if (!appMap)
+		{
+			burnMap.Resize(256, 256);
+			for (int y = 0; y < burnMap.Height(); ++y)
+			{
+				for (int x = 0; x < burnMap.Width(); ++x)
+				{
+					burnMap.Pixel(x, y) = ColourRGBA(GrainNoise(x, y, 32, 1), PixelNoise(x, y, 2), PixelNoise(x, y, 3), 1);
+				}
+			}
+		}
+
+		PostProcessGraph graph;
+		graph.AddEffect(PostProcess::Burn, PostProcessMode::Area, 0, "Burn", DefaultPostProcessData(PostProcess::Burn));
+		auto wholeScreen = [](const PostProcessGraph&, const PostProcessPass&)
+		{
+			PostProcessPlacement placement;
+			placement.AreaTopLeft[0] = placement.AreaTopLeft[1] = 0;
+			placement.AreaSize[0] = placement.AreaSize[1] = 1;
+			return placement;
+		};
+
+		std::printf("Burn over the whole screen, one thread, %d runs each, %s burn map\n\n", frames, appMap ? "Burn.png" : "noise");
+		std::printf("%-10s %6s %7s %10s %9s %8s\n", "Size", "Height", "Band %", "Pixels ms", "Bands ms", "Speed up");
+
+		bool allSame = true;
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			CpuPostProcessBackend pixels(size.first, size.second), bands(size.first, size.second);
+			for (CpuPostProcessBackend* backend : { &pixels, &bands })
+			{
+				backend->SetScene(scene);
+				backend->SetBurnMap(burnMap);
+				backend->SetPlacer(wholeScreen);
+			}
+			pixels.SetBurnBands(false);
+
+			// The first run with bands samples the map for the area
+			double firstTime = TimeCalls(1, [&]() { RunPostProcessGraph(graph, bands); });
+
+			for (float height : { 0.0f, 0.25f, 0.5f, 0.75f, 0.95f })
+			{
+				PostProcessAnimation animation;
+				animation.BurnHeight = height;
+				pixels.SetAnimation(animation);
+				bands.SetAnimation(animation);
+
+				int inBand = 0;
+				for (int y = 0; y < burnMap.Height(); ++y)
+				{
+					for (int x = 0; x < burnMap.Width(); ++x)
+					{
+						float burn = burnMap.Pixel(x, y).r;
+						if (burn > height && burn < height + BURN_GLOW_AMOUNT)  ++inBand;
+					}
+				}
+
+				double pixelTime = TimeCalls(frames, [&]() { RunPostProcessGraph(graph, pixels); });
+				double bandTime  = TimeCalls(frames, [&]() { RunPostProcessGraph(graph, bands); });
+				bool same = SameImage(pixels.Output(), bands.Output());
+				allSame = allSame && same;
+
+				std::printf("%4dx%-5d %6.2f %7.1f %10.1f %9.1f %7.2fx%s\n", size.first, size.second, height,
+				            100.0 * inBand / (burnMap.Width() * burnMap.Height()), pixelTime, bandTime, pixelTime / bandTime,
+				            same ? "" : "  DIFFERENT RESULT");
+			}
+			std::printf("%4dx%-5d first run with bands, sampling the map: %.1f ms\n\n", size.first, size.second, firstTime);
+		}
+		return allSame;
+	}
+
+	// Time the bloom pyramid at each number of levels against the full size bright pass, blur and merge it replaced
+	void BloomBenchmark(const std::vector<std::pair<int, int>>& sizes, int frames)
+	{
+		const PostProcessData settings = DefaultPostProcessData(PostProcess::Bloom);
+		const float threshold = settings.Bloom.threshold;
+		const float intensity = settings.Bloom.intensity;
+
+		// The old chain's Blur(30) at the Blur effect's default sigma, radius worked out as SelectPostProcessShaderAndTextures does
+		const PostProcessData blurSettings = DefaultPostProcessData(PostProcess::Blur);
+		GaussianKernel kernel = MakeGaussianKernel((30 - 1) / 2 + 1, blurSettings.Blur.sigma);
+
+		std::printf("Bloom, one thread, %d runs each, threshold %g\n\n", frames, threshold);
+		std::printf("%-10s %6s %11s %9s %8s\n", "Size", "Levels", "Pyramid ms", "Bloom ms", "Speed up");
+
+		for (const auto& size : sizes)
+		{
+			Image scene = TestScene(size.first, size.second);
+			Image bright(size.first, size.second), blurred, merged(size.first, size.second);
+
+			// Bright pass, blur down then across, and the glow added to the scene
+			double fullSize = TimeCalls(frames, [&]()
+			{
+				for (int y = 0; y < scene.Height(); ++y)
+				{
+					for (int x = 0; x < scene.Width(); ++x)  bright.Pixel(x, y) = BloomThreshold(scene.Pixel(x, y), threshold);
+				}
+				GaussianBlurImage(bright, blurred, kernel, false, true);
+				GaussianBlurImage(blurred, bright, kernel, true, true);
+				for (int y = 0; y < scene.Height(); ++y)
+				{
+					for (int x = 0; x < scene.Width(); ++x)
+					{
+						const ColourRGBA& colour = scene.Pixel(x, y);
+						const ColourRGBA& glow = bright.Pixel(x, y);
+						merged.Pixel(x, y) = ColourRGBA(colour.r + glow.r, colour.g + glow.g, colour.b + glow.b, 1);
+					}
+				}
+			});
+			std::printf("%4dx%-5d %6s %11s %9.1f %7.2fx  (bright pass, %d tap blur and merge)\n", size.first, size.second, "-", "-",
+			            fullSize, 1.0, 2 * kernel.Radius + 1);
+
+			BloomPyramid pyramid;
+			Image bloomed;
+			for (int levels = 1; levels <= MAX_BLOOM_LEVELS; ++levels)
+			{
+				// A run first so the pyramid's images are allocated
+				BloomImage(scene, bloomed, threshold, intensity, levels, pyramid);
+				double pyramidTime = TimeCalls(frames, [&]() { BuildBloomPyramid(scene, threshold, levels, pyramid); });
+				double bloomTime   = TimeCalls(frames, [&]() { BloomImage(scene, bloomed, threshold, intensity, levels, pyramid); });
+				std::printf("%4dx%-5d %6d %11.1f %9.1f %7.2fx\n", size.first, size.second, levels, pyramidTime, bloomTime, fullSize / bloomTime);
+			}
+			std::printf("\n");
+		}
+	}
+
+	// Render target memory the app created at start up for the chain: the scene, back and extra textures, the bloom pyramid,
+	// two summed-area tables and the pixelation blocks, all full size, and a texture for each reduced resolution target
+	size_t FixedTargetBytes(const CompiledPostProcessGraph& compiled, int width, int height)
+	{
+		auto bytes = [](int w, int h, RenderTargetFormat format) { return RenderTargetBytes({ w, h, format, RENDER_TARGET_BIND_BOTH }); };
+		size_t total = 4 * bytes(width, height, RenderTargetFormat::RGBA8) + 2 * bytes(width, height, RenderTargetFormat::RGBA32Uint);
+		for (int level = 1; level <= MAX_BLOOM_LEVELS; ++level)
+		{
+			total += bytes(BloomLevelSize(width, level), BloomLevelSize(height, level), RenderTargetFormat::RGBA16Float);
+		}
+		for (int downscale : compiled.TargetDownscales)
+		{
+			if (downscale > 1)  total += bytes(DownscaledSize(width, downscale), DownscaledSize(height, downscale), RenderTargetFormat::RGBA8);
+		}
+		return total;
+	}
+
+	// Run the chain's targets through a pool for two frames at each size, returns false if the second frame created any
+	bool PoolBenchmark(PostProcessGraph& graph, const std::vector<std::pair<int, int>>& sizes)
+	{
+		const CompiledPostProcessGraph& compiled = graph.Compile();
+		std::printf("Render targets for %d effects in %d passes, in MB including the scene's texture\n\n", graph.EffectCount(),
+		            static_cast<int>(compiled.Passes.size()));
+		std::printf("%-10s %9s %9s %9s %8s %8s\n", "Size", "Fixed", "Peak", "Held", "Textures", "Created");
+
+		bool steady = true;
+		for (const auto& size : sizes)
+		{
+			NullRenderTargetDevice device;
+			RenderTargetPool pool(device);
+			PostProcessTargetSchedule schedule;
+			int firstFrameCreated = 0;
+			for (int frame = 0; frame < 2; ++frame)
+			{
+				schedule.Begin(compiled, size.first, size.second, nullptr);
+				for (int pass = 0; pass < static_cast<int>(compiled.Passes.size()); ++pass)
+				{
+					schedule.BeforePass(graph, pass, pool);
+					schedule.AfterPass(pass, pool);
+				}
+				schedule.End(pool);
+				pool.EndFrame();
+				if (frame == 0)  firstFrameCreated = pool.TargetsCreated();
+			}
+			const bool same = pool.TargetsCreated() == firstFrameCreated;
+			steady = steady && same;
+
+			const double megabyte = 1024.0 * 1024.0;
+			const size_t scene = RenderTargetBytes({ size.first, size.second, RenderTargetFormat::RGBA8, RENDER_TARGET_BIND_BOTH });
+			std::printf("%4dx%-5d %9.1f %9.1f %9.1f %8d %8d%s\n", size.first, size.second,
+			            FixedTargetBytes(compiled, size.first, size.second) / megabyte, (scene + pool.PeakBytes()) / megabyte,
+			            (scene + pool.HeldBytes()) / megabyte, pool.TargetsHeld(), pool.TargetsCreated(),
+			            same ? "" : "  CREATED TARGETS IN THE SECOND FRAME");
+		}
+		return steady;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::string chainFile;
+	bool blurOnly = false;
+	bool lutOnly = false;
+	bool warpOnly = false;
+	bool marchOnly = false;
+	bool swirlOnly = false;
+	bool burnOnly = false;
+	bool bloomOnly = false;
+	bool poolOnly = false;
+	int maxThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	int frames = 5;
+	int tileWidth = 128, tileHeight = 64;
+	std::vector<std::pair<int, int>> sizes = { { 1280, 960 }, { 1920, 1080 }, { 3840, 2160 } };
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if      (option == "--blur")                     blurOnly = true;
+		else if (option == "--lut")                      lutOnly = true;
+		else if (option == "--warp")                     warpOnly = true;
+		else if (option == "--march")                    marchOnly = true;
+		else if (option == "--swirl")                    swirlOnly = true;
+		else if (option == "--burn")                     burnOnly = true;
+		else if (option == "--bloom")                    bloomOnly = true;
+		else if (option == "--pool")                     poolOnly = true;
+		else if (option == "--chain"   && i + 1 < argc)  chainFile = argv[++i];
+		else if (option == "--threads" && i + 1 < argc)  maxThreads = std::max(std::atoi(argv[++i]), 1);
+		else if (option == "--frames"  && i + 1 < argc)  frames = std::max(std::atoi(argv[++i]), 1);
+		else if (option == "--tile"    && i + 2 < argc)
+		{
+			tileWidth  = std::atoi(argv[++i]);
+			tileHeight = std::atoi(argv[++i]);
+		}
+		else if (option == "--size" && i + 2 < argc)
+		{
+			int width  = std::atoi(argv[++i]);
+			int height = std::atoi(argv[++i]);
+			sizes = { { std::max(width, 1), std::max(height, 1) } };
+		}
+		else
+		{
+			std::cerr << "Usage: PostProcessBench [--blur | --lut | --warp | --march | --swirl | --burn | --bloom | --pool] [--chain chain.txt] [--threads max] [--frames count] [--tile width height] [--size width height]\n";
+			return 1;
+		}
+	}
+
+	if (blurOnly)
+	{
+		BlurBenchmark(sizes, frames);
+		return 0;
+	}
+	if (lutOnly)
+	{
+		LutBenchmark(sizes, frames);
+		return 0;
+	}
+	if (warpOnly)
+	{
+		WarpBenchmark(sizes, frames);
+		return 0;
+	}
+	if (marchOnly)
+	{
+		MarchBenchmark(sizes, frames);
+		return 0;
+	}
+	if (swirlOnly)
+	{
+		SwirlBenchmark(sizes, frames);
+		return 0;
+	}
+	if (burnOnly)
+	{
+		return BurnBenchmark(sizes, frames) ? 0 : 1;
+	}
+	if (bloomOnly)
+	{
+		BloomBenchmark(sizes, frames);
+		return 0;
+	}
+
+	PostProcessGraph graph;
+	std::string error;
+	if (chainFile.empty())  DefaultChain(graph);
+	else if (!LoadPostProcessChain(chainFile, graph, error))
+	{
+		std::cerr << error << "\n";
+		return 1;
+	}
+	if (!graph.Compile().Valid)
+	{
+		std::cerr << graph.Compile().Error << "\n";
+		return 1;
+	}
+	if (poolOnly)
+	{
+		return PoolBenchmark(graph, sizes) ? 0 : 1;
+	}
+
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2)  threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	std::printf("%d effects in %d passes, %d frames per run, %dx%d tiles\n\n", graph.EffectCount(),
+	            static_cast<int>(graph.Compile().Passes.size()), frames, tileWidth, tileHeight);
+	std::printf("%-10s %7s %6s %12s %8s\n", "Size", "Threads", "Fused", "ms/frame", "Speed up");
+
+	bool allSame = true;
+	for (const auto& size : sizes)
+	{
+		const int width = size.first, height = size.second;
+		Image scene = TestScene(width, height);
+		Image reference;
+		double referenceTime = 0;
+
+		for (int threads : threadCounts)
+		{
+			for (int fused = 0; fused < 2; ++fused)
+			{
+				CpuPostProcessBackend backend(width, height);
+				backend.SetThreadCount(threads);
+				backend.SetFusion(fused != 0);
+				backend.SetTileSize(tileWidth, tileHeight);
+				backend.SetScene(scene);
+
+				// A run to warm up, then the timed frames
+				RunPostProcessGraph(graph, backend);
+				auto start = std::chrono::steady_clock::now();
+				for (int frame = 0; frame < frames; ++frame)  RunPostProcessGraph(graph, backend);
+				double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+				bool same = true;
+				if (reference.Width() == 0)
+				{
+					reference = backend.Output();
+					referenceTime = time;
+				}
+				else
+				{
+					same = SameImage(reference, backend.Output());
+					allSame = allSame && same;
+				}
+
+				std::printf("%4dx%-5d %7d %6s %12.1f %7.2fx%s\n", width, height, threads, fused ? "yes" : "no", time,
+				            referenceTime / time, same ? "" : "  DIFFERENT RESULT");
+			}
+		}
+		std::printf("\n");
+	}
+
+	return allSame ? 0 : 1;
+}
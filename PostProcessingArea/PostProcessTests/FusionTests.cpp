@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------------
+// Tests of fused colour effects on the CPU backend
+//--------------------------------------------------------------------------------------
+// Runs the same chains through the CPU backend with runs of colour effects fused into one pass
+// (PostProcessCompileOptions::FuseColourEffects) and without, and with full-screen passes drawn
+// together tile by tile (CpuPostProcessBackend::SetFusion) and a pass at a time, and checks the
+// images match. At full precision the only differences are float rounding. With 8-bit render targets
+// the unfused chain also rounds between passes, so it can be a few steps of 1/255 away - or all the
+// way if BlackAndWhite's threshold falls between the two, so chains with it are only compared at full
+// precision. Only colour is compared: full-screen passes don't blend, and a lone tint writes its soft
+// circle's alpha where a fused pass writes 1
+
+#include "CpuPostProcessBackend.h"
+#include "TestCheck.h"
+
+
+namespace
+{
+	const int WIDTH  = 96;
+	const int HEIGHT = 64;
+
+	// Smooth gradients in every channel with a few saturated pixels, so each effect has something to work on
+	Image TestScene()
+	{
+		Image scene(WIDTH, HEIGHT);
+		for (int y = 0; y < HEIGHT; ++y)
+		{
+			for (int x = 0; x < WIDTH; ++x)
+			{
+				float u = (x + 0.5f) / WIDTH;
+				float v = (y + 0.5f) / HEIGHT;
+				scene.Pixel(x, y) = ColourRGBA(u, v, (x % 7 == 0) ? 1.0f : 0.5f * (u + v), 1);
+			}
+		}
+		return scene;
+	}
+
+	int AddEffect(PostProcessGraph& graph, PostProcess process)
+	{
+		return graph.AddEffect(process, PostProcessMode::Fullscreen, 0, PPNames[static_cast<int>(process)], DefaultPostProcessData(process));
+	}
+
+	// Run the chain over the test scene with the given fusion, returns the output. passes is set to the passes run
+	Image RunChain(PostProcessGraph& graph, bool fuseColours, bool fuseTiles, bool quantise, int& passes)
+	{
+		PostProcessCompileOptions options = graph.CompileOptions();
+		options.FuseColourEffects = fuseColours;
+		graph.SetCompileOptions(options);
+
+		CpuPostProcessBackend backend(WIDTH, HEIGHT);
+		backend.SetFusion(fuseTiles);
+		backend.SetQuantise(quantise);
+		backend.SetTileSize(32, 16);
+		backend.SetScene(TestScene());
+		CHECK(RunPostProcessGraph(graph, backend));
+		passes = backend.Stats().Passes;
+		return backend.Output();
+	}
+
+	// Compare the chain run every way against a pass at a time, unfused. At 8 bits too if quantised is set
+	void CheckChain(PostProcessGraph& graph, int unfusedPasses, int fusedPasses, bool quantised)
+	{
+		for (int quantise = 0; quantise < (quantised ? 2 : 1); ++quantise)
+		{
+			const float tolerance = quantise ? 3.0f / 255.0f : 1e-5f;
+
+			int passes = 0;
+			Image reference = RunChain(graph, false, false, quantise != 0, passes);
+			CHECK(passes == unfusedPasses);
+
+			Image fused = RunChain(graph, true, false, quantise != 0, passes);
+			CHECK(passes == fusedPasses);
+			CHECK(fused.Width() == WIDTH && fused.Height() == HEIGHT);
+			CHECK(LargestDifference(reference, fused, false) <= tolerance);
+
+			// Drawing tile by tile gives exactly the image drawn a pass at a time
+			Image tiled = RunChain(graph, false, true, quantise != 0, passes);
+			CHECK(LargestDifference(reference, tiled, false) == 0);
+			Image both = RunChain(graph, true, true, quantise != 0, passes);
+			CHECK(LargestDifference(fused, both, false) == 0);
+		}
+	}
+
+
+	void TestColourRun()
+	{
+		// Every colour effect in one run, fused into a single pass
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Tint);
+		AddEffect(graph, PostProcess::TintHue);
+		AddEffect(graph, PostProcess::Sigmoid);
+		AddEffect(graph, PostProcess::Inverse);
+		AddEffect(graph, PostProcess::NightVision);
+		AddEffect(graph, PostProcess::BlackAndWhite);
+		CheckChain(graph, 6, 1, false);
+
+		// The same without the threshold, at 8 bits as well
+		PostProcessGraph smooth;
+		AddEffect(smooth, PostProcess::Tint);
+		AddEffect(smooth, PostProcess::TintHue);
+		AddEffect(smooth, PostProcess::Sigmoid);
+		AddEffect(smooth, PostProcess::Inverse);
+		AddEffect(smooth, PostProcess::NightVision);
+		CheckChain(smooth, 5, 1, true);
+	}
+
+	void TestRunsSplitByBlur()
+	{
+		// A blur between two runs of colour effects, each run is fused on its own
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Tint);
+		AddEffect(graph, PostProcess::Sigmoid);
+		AddEffect(graph, PostProcess::Blur);
+		AddEffect(graph, PostProcess::Inverse);
+		AddEffect(graph, PostProcess::TintHue);
+		AddEffect(graph, PostProcess::Tint);
+		CheckChain(graph, 7, 4, true);
+	}
+}
+
+
+int main()
+{
+	TestColourRun();
+	TestRunsSplitByBlur();
+	return TestResult();
+}
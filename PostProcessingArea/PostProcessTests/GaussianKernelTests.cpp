@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------------
+// Tests of the Gaussian blur kernels
+//--------------------------------------------------------------------------------------
+// Blurs with the merged taps read by the GPU and with every pixel of the discrete kernel, over
+// every blur strength the app's slider gives (1 to 151) at a range of sigmas, in both directions,
+// and checks they match to within float rounding. The image is smaller than the widest kernels so
+// the taps run off both edges and are clamped
+
+#include "GaussianKernel.h"
+#include "TestCheck.h"
+
+#include <cstdio>
+
+
+namespace
+{
+	// Smallest and largest BlurStrength in the app and the sigmas tried
+	const int   MIN_STRENGTH = 1;
+	const int   MAX_STRENGTH = 151;
+	const float SIGMAS[] = { 0.5f, 3.0f, 10.0f, 40.0f };
+
+	// Colours and alpha differ by up to 1, so rounding in sums of a few hundred weights stays well within this
+	const float TOLERANCE = 1e-4f;
+
+	// Hard edges in every channel, brightest at the image edges so clamping shows
+	Image TestImage(int width, int height)
+	{
+		Image image(width, height);
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				bool edge = (x == 0 || y == 0 || x == width - 1 || y == height - 1);
+				image.Pixel(x, y) = ColourRGBA(edge ? 1.0f : 0.0f, ((x / 3 + y / 2) % 2) ? 1.0f : 0.0f,
+				                               ((x * 7 + y * 13) % 11) / 10.0f, (x % 5 == 0) ? 0.25f : 1.0f);
+			}
+		}
+		return image;
+	}
+
+
+	void TestKernelWeights()
+	{
+		// Both forms add up to 1 over the whole kernel, and the merged taps lie between the pixels they merge
+		for (int strength = MIN_STRENGTH; strength <= MAX_STRENGTH; ++strength)
+		{
+			for (float sigma : SIGMAS)
+			{
+				// Radius from the strength, as in SelectPostProcessShaderAndTextures
+				GaussianKernel kernel = MakeGaussianKernel((strength - 1) / 2 + 1, sigma);
+				CHECK(static_cast<int>(kernel.Weights.size()) == kernel.Radius + 1);
+				CHECK(static_cast<int>(kernel.TapWeights.size()) == (kernel.Radius + 1) / 2 + 1);
+
+				float discrete = kernel.Weights[0];
+				for (size_t i = 1; i < kernel.Weights.size(); ++i)  discrete += 2 * kernel.Weights[i];
+				float merged = kernel.TapWeights[0];
+				for (size_t i = 1; i < kernel.TapWeights.size(); ++i)  merged += 2 * kernel.TapWeights[i];
+				CHECK_NEAR(discrete, 1.0f, TOLERANCE);
+				CHECK_NEAR(merged, 1.0f, TOLERANCE);
+
+				CHECK(kernel.TapOffsets[0] == 0);
+				for (size_t i = 1; i < kernel.TapOffsets.size(); ++i)
+				{
+					const float first = static_cast<float>(2 * i - 1);
+					CHECK(kernel.TapOffsets[i] >= first && kernel.TapOffsets[i] <= first + 1);
+				}
+			}
+		}
+	}
+
+	void TestMergedTapsMatchDiscrete()
+	{
+		// 40x24 is narrower than the widest kernel (76 pixels each side) in both directions
+		const Image source = TestImage(40, 24);
+		Image merged, discrete;
+		for (int strength = MIN_STRENGTH; strength <= MAX_STRENGTH; ++strength)
+		{
+			for (float sigma : SIGMAS)
+			{
+				GaussianKernel kernel = MakeGaussianKernel((strength - 1) / 2 + 1, sigma);
+				for (int horizontal = 0; horizontal < 2; ++horizontal)
+				{
+					GaussianBlurImage(source, merged,   kernel, horizontal != 0, true);
+					GaussianBlurImage(source, discrete, kernel, horizontal != 0, false);
+					if (!CHECK(LargestDifference(merged, discrete) <= TOLERANCE))
+					{
+						std::printf("  strength %d, sigma %g, %s\n", strength, sigma, horizontal ? "horizontal" : "vertical");
+					}
+				}
+			}
+		}
+	}
+
+	void TestClampedEdges()
+	{
+		// An image of one colour stays that colour however far past the edges the taps read
+		Image flat(7, 5);
+		for (int y = 0; y < flat.Height(); ++y)
+		{
+			for (int x = 0; x < flat.Width(); ++x)  flat.Pixel(x, y) = ColourRGBA(0.2f, 0.4f, 0.6f, 0.8f);
+		}
+
+		Image blurred;
+		for (float sigma : SIGMAS)
+		{
+			GaussianKernel kernel = MakeGaussianKernel((MAX_STRENGTH - 1) / 2 + 1, sigma);
+			for (int merged = 0; merged < 2; ++merged)
+			{
+				for (int horizontal = 0; horizontal < 2; ++horizontal)
+				{
+					GaussianBlurImage(flat, blurred, kernel, horizontal != 0, merged != 0);
+					CHECK(blurred.Width() == flat.Width() && blurred.Height() == flat.Height());
+					CHECK(LargestDifference(blurred, flat) <= TOLERANCE);
+				}
+			}
+		}
+	}
+}
+
+
+int main()
+{
+	TestKernelWeights();
+	TestMergedTapsMatchDiscrete();
+	TestClampedEdges();
+	return TestResult();
+}
@@ -0,0 +1,340 @@
+//--------------------------------------------------------------------------------------
+// Tests of the post-process graph compiler, through the null backend
+//--------------------------------------------------------------------------------------
+// Compiles typical chains - full-screen effects, area and polygon regions, bloom and merges with the
+// scene - and checks the passes run, the render targets used against MaxTargets and that a chain
+// needing more targets than there are fails to compile without running anything. Also checks the
+// passes and pixels of region chains with RegionsInPlace on and off, and that only model polygons with
+// the same settings are batched - batched and unbatched chains drawing the same image on the CPU
+
+#include "PostProcessGraph.h"
+#include "CpuPostProcessBackend.h"
+#include "TestCheck.h"
+
+#include <algorithm>
+
+
+namespace
+{
+	int AddEffect(PostProcessGraph& graph, PostProcess process, PostProcessMode mode = PostProcessMode::Fullscreen, int region = 0)
+	{
+		return graph.AddEffect(process, mode, region, PPNames[static_cast<int>(process)], DefaultPostProcessData(process));
+	}
+
+	// Add a merge of the previous image with the unprocessed scene
+	void AddSceneMerge(PostProcessGraph& graph)
+	{
+		int merge = AddEffect(graph, PostProcess::Merge);
+		graph.Effect(merge).Nodes[0].Inputs = { "", PostProcessSceneImage };
+	}
+
+	// Run the chain and check its targets stay within MaxTargets if set, every target written is one the chain says it uses and
+	// the final image is written to the output by exactly one pass
+	void CheckChain(PostProcessGraph& graph, NullPostProcessBackend& backend)
+	{
+		CHECK(RunPostProcessGraph(graph, backend));
+		const CompiledPostProcessGraph& compiled = graph.Compile();
+		const int fullSize = static_cast<int>(std::count(compiled.TargetDownscales.begin(), compiled.TargetDownscales.end(), 1));
+		CHECK(graph.CompileOptions().MaxTargets == 0 || fullSize <= graph.CompileOptions().MaxTargets);
+		CHECK(backend.TargetCount() == compiled.TargetCount);
+		CHECK(backend.PassCount() == static_cast<int>(compiled.Passes.size()));
+
+		int outputPasses = 0;
+		for (const PostProcessPass& pass : backend.Passes())
+		{
+			CHECK(pass.Target == OUTPUT_TARGET || (pass.Target >= 0 && pass.Target < compiled.TargetCount));
+			for (int i = 0; i < pass.InputCount; ++i)  CHECK(pass.Sources[i] >= 0 && pass.Sources[i] < compiled.TargetCount);
+			if (pass.Target == OUTPUT_TARGET)  ++outputPasses;
+		}
+		CHECK(outputPasses == 1);
+		CHECK(backend.TargetWrites(OUTPUT_TARGET) == 1);
+	}
+
+
+	void TestFullScreenChain()
+	{
+		// Tint and Underwater are one pass each, Blur two. Ping-pongs between the scene's target and one other
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Tint);
+		AddEffect(graph, PostProcess::Blur);
+		AddEffect(graph, PostProcess::Underwater);
+
+		NullPostProcessBackend backend(100, 100);
+		CheckChain(graph, backend);
+		CHECK(backend.PassCount() == 4);
+		CHECK(backend.TargetCount() == 2);
+		CHECK(backend.Passes().back().Process == PostProcess::Underwater);
+
+		// Compiled once, running again doesn't recompile
+		CHECK(RunPostProcessGraph(graph, backend));
+		CHECK(graph.CompileCount() == 1 && backend.ChainsRun() == 2);
+	}
+
+	void TestRegionChain()
+	{
+		// The area and polygon effects work in place on the blur's output with the other target as scratch
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Blur);
+		AddEffect(graph, PostProcess::Burn,   PostProcessMode::Area,    1);
+		AddEffect(graph, PostProcess::Spiral, PostProcessMode::Polygon, 2);
+		AddEffect(graph, PostProcess::Underwater);
+
+		NullPostProcessBackend backend(100, 100, 0.1f);
+		CheckChain(graph, backend);
+		CHECK(backend.PassCount() == 5);
+		CHECK(backend.TargetCount() == 2);
+		for (const PostProcessPass& pass : backend.Passes())
+		{
+			if (pass.Mode == PostProcessMode::Area || pass.Mode == PostProcessMode::Polygon)
+			{
+				CHECK(pass.Scratch >= 0 && pass.Scratch != pass.Target && pass.Target == pass.Sources[0]);
+			}
+		}
+	}
+
+	// Blur then an area and a polygon, with or without a full-screen effect after them
+	void AddRegions(PostProcessGraph& graph, bool inPlace, bool fullScreenLast)
+	{
+		AddEffect(graph, PostProcess::Blur);
+		AddEffect(graph, PostProcess::Burn,   PostProcessMode::Area,    1);
+		AddEffect(graph, PostProcess::Spiral, PostProcessMode::Polygon, 2);
+		if (fullScreenLast)  AddEffect(graph, PostProcess::Underwater);
+
+		PostProcessCompileOptions options = graph.CompileOptions();
+		options.RegionsInPlace = inPlace;
+		graph.SetCompileOptions(options);
+	}
+
+	void TestRegionsInPlace()
+	{
+		// At 100x100 a full-screen pass fills 10000 pixels and each region 1000. In place, each region is copied to the scratch
+		// target and back. Otherwise each is drawn over a full-screen copy of its input
+		PostProcessGraph inPlace;
+		AddRegions(inPlace, true, true);
+		NullPostProcessBackend inPlaceBackend(100, 100, 0.1f);
+		CheckChain(inPlace, inPlaceBackend);
+		CHECK(inPlaceBackend.PassCount() == 5);
+		CHECK_NEAR(inPlaceBackend.Stats().PixelsFilled, 32000, 1);
+		CHECK_NEAR(inPlaceBackend.Stats().PixelsCopied, 4000, 1);
+		for (const PostProcessPass& pass : inPlaceBackend.Passes())  CHECK(pass.Process != PostProcess::Copy);
+
+		PostProcessGraph copied;
+		AddRegions(copied, false, true);
+		NullPostProcessBackend copiedBackend(100, 100, 0.1f);
+		CheckChain(copied, copiedBackend);
+		CHECK(copiedBackend.PassCount() == 7);
+		CHECK_NEAR(copiedBackend.Stats().PixelsFilled, 52000, 1);
+		CHECK_NEAR(copiedBackend.Stats().PixelsCopied, 0, 1);
+		for (const PostProcessPass& pass : copiedBackend.Passes())  CHECK(pass.Scratch < 0);
+		CHECK(copiedBackend.TargetCount() == inPlaceBackend.TargetCount());
+
+		// Ending in a region, the output gets a copy of the input then the region drawn over it either way. Only the area before
+		// it is done in place
+		PostProcessGraph regionLast;
+		AddRegions(regionLast, true, false);
+		NullPostProcessBackend regionLastBackend(100, 100, 0.1f);
+		CHECK(RunPostProcessGraph(regionLast, regionLastBackend));
+		CHECK(regionLastBackend.PassCount() == 5);
+		CHECK(regionLastBackend.TargetWrites(OUTPUT_TARGET) == 2);
+		CHECK_NEAR(regionLastBackend.Stats().PixelsFilled, 32000, 1);
+		CHECK_NEAR(regionLastBackend.Stats().PixelsCopied, 2000, 1);
+		CHECK(regionLastBackend.Passes().back().Target == OUTPUT_TARGET && regionLastBackend.Passes().back().Scratch < 0);
+
+		PostProcessGraph regionLastCopied;
+		AddRegions(regionLastCopied, false, false);
+		NullPostProcessBackend regionLastCopiedBackend(100, 100, 0.1f);
+		CHECK(RunPostProcessGraph(regionLastCopied, regionLastCopiedBackend));
+		CHECK(regionLastCopiedBackend.PassCount() == 6);
+		CHECK(regionLastCopiedBackend.TargetWrites(OUTPUT_TARGET) == 2);
+		CHECK_NEAR(regionLastCopiedBackend.Stats().PixelsFilled, 42000, 1);
+	}
+
+	// Three windows tinted the default colours then a full-screen effect. The windows given are tinted red at the top instead
+	void AddWindows(PostProcessGraph& graph, bool batch, std::initializer_list<int> redWindows = {})
+	{
+		for (int window = 0; window < 3; ++window)  AddEffect(graph, PostProcess::Tint, PostProcessMode::ModelPolygon, window);
+		for (int window : redWindows)
+		{
+			float* top = graph.Effect(window).Data.tint.rgbTop;
+			top[0] = 1;  top[1] = 0;  top[2] = 0;
+		}
+		AddEffect(graph, PostProcess::Underwater);
+
+		PostProcessCompileOptions options = graph.CompileOptions();
+		options.BatchModelPolygons = batch;
+		graph.SetCompileOptions(options);
+	}
+
+	// Effects batched into each ModelPolygon pass run
+	std::vector<std::vector<int>> Batches(const NullPostProcessBackend& backend)
+	{
+		std::vector<std::vector<int>> batches;
+		for (const PostProcessPass& pass : backend.Passes())
+		{
+			if (pass.Mode == PostProcessMode::ModelPolygon)  batches.push_back(pass.BatchedEffects);
+		}
+		return batches;
+	}
+
+	// Each window's polygon in its own place, whether drawn in a batch or alone
+	PostProcessPlacement PlaceWindows(const PostProcessGraph& graph, const PostProcessPass& pass)
+	{
+		PostProcessPlacement placement;
+		for (int effect : pass.BatchedEffects)
+		{
+			const float centreX = -0.6f + 0.6f * graph.Effect(effect).Region;
+			const float corners[4][2] = { { -1, 1 }, { -1, -1 }, { 1, 1 }, { 1, -1 } };
+			for (const auto& corner : corners)
+			{
+				placement.PolygonPoints.insert(placement.PolygonPoints.end(), { centreX + corner[0] * 0.25f, corner[1] * 0.5f, 0.5f, 1.0f });
+			}
+		}
+		return placement;
+	}
+
+	// Run the chain on the CPU over a gradient, returns the output
+	Image DrawWindows(PostProcessGraph& graph)
+	{
+		Image scene(64, 32);
+		for (int y = 0; y < scene.Height(); ++y)
+		{
+			for (int x = 0; x < scene.Width(); ++x)  scene.Pixel(x, y) = ColourRGBA(scene.U(x), scene.V(y), 0.5f, 1);
+		}
+
+		CpuPostProcessBackend backend(scene.Width(), scene.Height());
+		backend.SetPlacer(PlaceWindows);
+		backend.SetScene(scene);
+		CHECK(RunPostProcessGraph(graph, backend));
+		return backend.Output();
+	}
+
+	void TestModelPolygonBatching()
+	{
+		// Windows with the same settings are drawn in one pass, the same pixels as a pass each
+		PostProcessGraph batched;
+		AddWindows(batched, true);
+		NullPostProcessBackend batchedBackend(100, 100, 0.1f);
+		CheckChain(batched, batchedBackend);
+		CHECK(batchedBackend.PassCount() == 2);
+		CHECK(Batches(batchedBackend) == std::vector<std::vector<int>>({ { 0, 1, 2 } }));
+
+		PostProcessGraph unbatched;
+		AddWindows(unbatched, false);
+		NullPostProcessBackend unbatchedBackend(100, 100, 0.1f);
+		CheckChain(unbatched, unbatchedBackend);
+		CHECK(unbatchedBackend.PassCount() == 4);
+		CHECK(Batches(unbatchedBackend) == std::vector<std::vector<int>>({ { 0 }, { 1 }, { 2 } }));
+		CHECK(batchedBackend.Stats().Draws < unbatchedBackend.Stats().Draws);
+		CHECK_NEAR(batchedBackend.Stats().PixelsFilled, unbatchedBackend.Stats().PixelsFilled, 1);
+		CHECK_NEAR(batchedBackend.Stats().PixelsCopied, unbatchedBackend.Stats().PixelsCopied, 1);
+		CHECK(SameImage(DrawWindows(batched), DrawWindows(unbatched)));
+
+		// A window tinted differently isn't batched with its neighbours
+		PostProcessGraph middleRed;
+		AddWindows(middleRed, true, { 1 });
+		NullPostProcessBackend middleRedBackend(100, 100, 0.1f);
+		CheckChain(middleRed, middleRedBackend);
+		CHECK(Batches(middleRedBackend) == std::vector<std::vector<int>>({ { 0 }, { 1 }, { 2 } }));
+
+		PostProcessGraph lastRed;
+		AddWindows(lastRed, true, { 2 });
+		NullPostProcessBackend lastRedBackend(100, 100, 0.1f);
+		CheckChain(lastRed, lastRedBackend);
+		CHECK(Batches(lastRedBackend) == std::vector<std::vector<int>>({ { 0, 1 }, { 2 } }));
+
+		PostProcessGraph lastRedUnbatched;
+		AddWindows(lastRedUnbatched, false, { 2 });
+		CHECK(SameImage(DrawWindows(lastRed), DrawWindows(lastRedUnbatched)));
+
+		// Settings are edited without recompiling, but a batch whose settings no longer match is split up
+		PostProcessGraph edited;
+		AddWindows(edited, true);
+		NullPostProcessBackend editedBackend(100, 100, 0.1f);
+		CHECK(RunPostProcessGraph(edited, editedBackend));
+		CHECK(edited.CompileCount() == 1 && editedBackend.PassCount() == 2);
+		edited.Effect(1).Data.tint.rgbMid[2] = 0.25f;
+		NullPostProcessBackend splitBackend(100, 100, 0.1f);
+		CHECK(RunPostProcessGraph(edited, splitBackend));
+		CHECK(edited.CompileCount() == 2);
+		CHECK(Batches(splitBackend) == std::vector<std::vector<int>>({ { 0 }, { 1 }, { 2 } }));
+	}
+
+	void TestSameSettings()
+	{
+		// Only the settings an effect uses are compared
+		PostProcessData a = DefaultPostProcessData(PostProcess::Tint);
+		PostProcessData b = a;
+		b.tint.padding = 5;
+		CHECK(SamePostProcessSettings(PostProcess::Tint, a, b));
+		b.tint.rgbMid[1] = 0;
+		CHECK(!SamePostProcessSettings(PostProcess::Tint, a, b));
+		CHECK(SamePostProcessSettings(PostProcess::Spiral, a, b));
+
+		PostProcessData blur = DefaultPostProcessData(PostProcess::Blur);
+		PostProcessData wider = blur;
+		wider.Blur.blur += 2;
+		CHECK(!SamePostProcessSettings(PostProcess::Blur, blur, wider));
+	}
+
+	void TestBloomAndMerge()
+	{
+		// Bloom keeps its pyramid to itself, so is one pass to the chain. Merge reads the scene as well as the bloomed image
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Bloom);
+		AddSceneMerge(graph);
+
+		NullPostProcessBackend backend(100, 100);
+		CheckChain(graph, backend);
+		CHECK(backend.PassCount() == 2);
+		CHECK(backend.Passes()[1].InputCount == 2 && backend.Passes()[1].Sources[1] == 0);
+		CHECK(backend.TargetReads(0) == 2);
+	}
+
+	void TestTooManyTargets()
+	{
+		// The blur's two passes can't write to the scene's target while the merge still needs the scene, so the chain needs three
+		PostProcessGraph graph;
+		AddEffect(graph, PostProcess::Blur);
+		AddSceneMerge(graph);
+
+		NullPostProcessBackend backend(100, 100);
+		CheckChain(graph, backend);
+		CHECK(backend.TargetCount() == 3);
+
+		PostProcessCompileOptions options = graph.CompileOptions();
+		options.MaxTargets = 2;
+		graph.SetCompileOptions(options);
+		NullPostProcessBackend limited(100, 100);
+		CHECK(!RunPostProcessGraph(graph, limited));
+		CHECK(!graph.Compile().Valid && !graph.Compile().Error.empty());
+		CHECK(limited.ChainsRun() == 0 && limited.PassCount() == 0);
+
+		// Targets are created as needed by default, so there is no limit unless a backend sets one
+		CHECK(PostProcessCompileOptions().MaxTargets == 0);
+		options.MaxTargets = 0;
+		graph.SetCompileOptions(options);
+		CHECK(RunPostProcessGraph(graph, limited));
+	}
+
+	void TestEmptyChain()
+	{
+		PostProcessGraph graph;
+		NullPostProcessBackend backend(100, 100);
+		CHECK(RunPostProcessGraph(graph, backend));
+		CHECK(backend.PassCount() == 0);
+	}
+}
+
+
+int main()
+{
+	TestFullScreenChain();
+	TestRegionChain();
+	TestRegionsInPlace();
+	TestModelPolygonBatching();
+	TestSameSettings();
+	TestBloomAndMerge();
+	TestTooManyTargets();
+	TestEmptyChain();
+	return TestResult();
+}
@@ -0,0 +1,199 @@
+//--------------------------------------------------------------------------------------
+// Tests of the render target pool, through the null device
+//--------------------------------------------------------------------------------------
+// Checks released targets are handed out again for the same description, that EndFrame only
+// destroys targets not used during the frame, that Clear destroys everything created, and that a
+// chain's schedule never holds more than its compiled targets plus the current pass's working textures
+
+#include "RenderTargetPool.h"
+#include "TestCheck.h"
+
+
+namespace
+{
+	const RenderTargetDesc FULL_SIZE = { 100, 80, RenderTargetFormat::RGBA8,       RENDER_TARGET_BIND_BOTH };
+	const RenderTargetDesc HALF_SIZE = { 50,  40, RenderTargetFormat::RGBA8,       RENDER_TARGET_BIND_BOTH };
+	const RenderTargetDesc FLOAT     = { 100, 80, RenderTargetFormat::RGBA16Float, RENDER_TARGET_BIND_BOTH };
+
+	void TestReuse()
+	{
+		NullRenderTargetDevice device;
+		RenderTargetPool pool(device);
+
+		void* first = pool.Acquire(FULL_SIZE);
+		CHECK(first != nullptr && NullRenderTargetDevice::Desc(first) == FULL_SIZE);
+		CHECK(pool.BytesInUse() == RenderTargetBytes(FULL_SIZE));
+
+		// While it is in use another target is created, even of the same description
+		void* second = pool.Acquire(FULL_SIZE);
+		CHECK(second != nullptr && second != first);
+		CHECK(device.Created() == 2);
+
+		// Once released it is handed out again for the same description only
+		pool.Release(first);
+		CHECK(pool.BytesInUse() == RenderTargetBytes(FULL_SIZE));
+		void* other = pool.Acquire(FLOAT);
+		CHECK(other != first && NullRenderTargetDevice::Desc(other) == FLOAT);
+		CHECK(pool.Acquire(FULL_SIZE) == first);
+		CHECK(device.Created() == 3 && pool.TargetsCreated() == 3);
+
+		// Releasing twice doesn't count twice
+		pool.Release(second);
+		pool.Release(second);
+		CHECK(pool.BytesInUse() == RenderTargetBytes(FULL_SIZE) + RenderTargetBytes(FLOAT));
+	}
+
+	void TestEndFrame()
+	{
+		NullRenderTargetDevice device;
+		RenderTargetPool pool(device);
+
+		// Frame 1 uses all three
+		void* full  = pool.Acquire(FULL_SIZE);
+		void* half  = pool.Acquire(HALF_SIZE);
+		void* held  = pool.Acquire(FLOAT);
+		pool.Release(full);
+		pool.Release(half);
+		pool.EndFrame();
+		CHECK(device.Released() == 0 && pool.TargetsHeld() == 3);
+		CHECK(pool.PeakBytes() == RenderTargetBytes(FULL_SIZE) + RenderTargetBytes(HALF_SIZE) + RenderTargetBytes(FLOAT));
+
+		// Frame 2 only the full size target. The half size one goes, the float one is still acquired from frame 1 so stays
+		CHECK(pool.Acquire(FULL_SIZE) == full);
+		pool.Release(full);
+		pool.EndFrame();
+		CHECK(device.Released() == 1 && pool.TargetsHeld() == 2);
+		CHECK(pool.HeldBytes() == RenderTargetBytes(FULL_SIZE) + RenderTargetBytes(FLOAT));
+		CHECK(pool.PeakBytes() == RenderTargetBytes(FULL_SIZE) + RenderTargetBytes(FLOAT));
+
+		// Frame 3 nothing is acquired, so the full size target goes. The float one was held until released during the frame,
+		// so goes at the end of the next
+		pool.Release(held);
+		pool.EndFrame();
+		CHECK(device.Released() == 2 && pool.TargetsHeld() == 1);
+		CHECK(pool.HeldBytes() == RenderTargetBytes(FLOAT));
+
+		pool.EndFrame();
+		CHECK(device.Released() == 3 && pool.TargetsHeld() == 0 && pool.HeldBytes() == 0);
+		CHECK(pool.Acquire(HALF_SIZE) != nullptr && device.Created() == 4);
+	}
+
+	void TestClear()
+	{
+		NullRenderTargetDevice device;
+		{
+			RenderTargetPool pool(device);
+			void* full = pool.Acquire(FULL_SIZE);
+			pool.Acquire(HALF_SIZE);
+			pool.Release(full);
+			pool.Acquire(FLOAT);
+
+			// Targets still acquired are destroyed too
+			pool.Clear();
+			CHECK(device.Created() == 3 && device.Released() == 3);
+			CHECK(pool.TargetsHeld() == 0 && pool.BytesInUse() == 0 && pool.HeldBytes() == 0);
+
+			// The pool is destroyed holding one
+			pool.Acquire(FULL_SIZE);
+		}
+		CHECK(device.Created() == 4 && device.Released() == 4);
+	}
+
+
+	// Bloom, a half resolution blur, the variable blur, pixelation, an area and bloom again, merged with the scene at the end
+	void AddWorkingTargetChain(PostProcessGraph& graph)
+	{
+		auto add = [&](PostProcess process, PostProcessMode mode = PostProcessMode::Fullscreen, int region = 0)
+		{
+			return graph.AddEffect(process, mode, region, PPNames[static_cast<int>(process)], DefaultPostProcessData(process));
+		};
+		add(PostProcess::Tint);
+		add(PostProcess::Bloom);
+		int blur = add(PostProcess::Blur);
+		graph.Effect(blur).Data.Blur.Blur(21);
+		graph.SetEffectDownscale(blur, 2);
+		add(PostProcess::VariableBlur);
+		int pixelation = add(PostProcess::Pixelation);
+		graph.Effect(pixelation).Data.Pixelation.Pixelation(8, 8, 20);
+		add(PostProcess::Burn, PostProcessMode::Area, 3);
+		add(PostProcess::Bloom);
+		int merge = add(PostProcess::Merge);
+		graph.Effect(merge).Nodes[0].Inputs = { "", PostProcessSceneImage };
+	}
+
+	void TestSchedule()
+	{
+		const int width = 160, height = 96;
+		PostProcessGraph graph;
+		AddWorkingTargetChain(graph);
+		const CompiledPostProcessGraph& compiled = graph.Compile();
+		CHECK(compiled.Valid);
+
+		NullRenderTargetDevice device;
+		RenderTargetPool pool(device);
+		PostProcessTargetSchedule schedule;
+		std::vector<RenderTargetDesc> working;
+		int sceneTarget = 0; // Stands in for the scene's target, which isn't pooled
+		int firstFrameCreated = 0;
+		for (int frame = 0; frame < 2; ++frame)
+		{
+			schedule.Begin(compiled, width, height, &sceneTarget);
+			CHECK(schedule.Target(0) == &sceneTarget);
+			for (int pass = 0; pass < static_cast<int>(compiled.Passes.size()); ++pass)
+			{
+				CHECK(schedule.BeforePass(graph, pass, pool));
+
+				// Every target the pass uses is held, at the size the compiler gave it
+				const PostProcessPass& p = compiled.Passes[pass];
+				for (int i = 0; i < p.InputCount; ++i)  CHECK(schedule.Target(p.Sources[i]) != nullptr);
+				if (p.Target != OUTPUT_TARGET)  CHECK(schedule.Target(p.Target) != nullptr);
+				if (p.Scratch >= 0)             CHECK(schedule.Target(p.Scratch) != nullptr);
+				for (int target = 1; target < compiled.TargetCount; ++target)
+				{
+					if (schedule.Target(target))  CHECK(NullRenderTargetDevice::Desc(schedule.Target(target)) == schedule.Desc(target));
+				}
+
+				// No more than the compiled targets (bar the scene's) and this pass's working textures
+				PassWorkingTargets(graph, compiled, p, width, height, working);
+				CHECK(schedule.WorkingTargetCount() == static_cast<int>(working.size()));
+				size_t mostBytes = 0;
+				for (int target = 1; target < compiled.TargetCount; ++target)  mostBytes += RenderTargetBytes(schedule.Desc(target));
+				for (const RenderTargetDesc& desc : working)  mostBytes += RenderTargetBytes(desc);
+				CHECK(pool.BytesInUse() <= mostBytes);
+				int held = schedule.WorkingTargetCount();
+				for (int target = 1; target < compiled.TargetCount; ++target)  held += (schedule.Target(target) != nullptr) ? 1 : 0;
+				CHECK(held <= compiled.TargetCount - 1 + static_cast<int>(working.size()));
+
+				schedule.AfterPass(pass, pool);
+			}
+			schedule.End(pool);
+			CHECK(pool.BytesInUse() == 0);
+			pool.EndFrame();
+			if (frame == 0)  firstFrameCreated = pool.TargetsCreated();
+		}
+
+		// The chain had bloom, summed-area table and pixelation textures, and the second frame reused them all
+		CHECK(firstFrameCreated > compiled.TargetCount - 1);
+		CHECK(pool.TargetsCreated() == firstFrameCreated && device.Released() == 0);
+
+		// Targets used at different times share textures - the second bloom's pyramid is the first's - so fewer are made than
+		// were acquired
+		int acquired = compiled.TargetCount - 1;
+		for (const PostProcessPass& p : compiled.Passes)
+		{
+			PassWorkingTargets(graph, compiled, p, width, height, working);
+			acquired += static_cast<int>(working.size());
+		}
+		CHECK(firstFrameCreated < acquired);
+	}
+}
+
+
+int main()
+{
+	TestReuse();
+	TestEndFrame();
+	TestClear();
+	TestSchedule();
+	return TestResult();
+}
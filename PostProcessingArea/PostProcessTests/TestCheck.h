@@ -0,0 +1,47 @@
+//--------------------------------------------------------------------------------------
+// Checks shared by the tests
+//--------------------------------------------------------------------------------------
+// Each test is a small program run by CTest (see CMakeLists.txt in the folder above). CHECK prints the
+// file, line and condition of a failed check and carries on, so one run reports every failure. Each
+// test's main returns TestResult(), non-zero if any check failed
+
+#ifndef _TEST_CHECK_H_INCLUDED_
+#define _TEST_CHECK_H_INCLUDED_
+
+#include <cmath>
+#include <cstdio>
+
+
+// Checks failed so far
+inline int& TestFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+// Record a failed check, returns the condition
+inline bool TestCheck(bool condition, const char* text, const char* file, int line)
+{
+	if (!condition)
+	{
+		std::printf("%s(%d): check failed: %s\n", file, line, text);
+		++TestFailures();
+	}
+	return condition;
+}
+
+#define CHECK(condition)  TestCheck((condition), #condition, __FILE__, __LINE__)
+
+// Check two numbers are within the given distance of each other
+#define CHECK_NEAR(a, b, tolerance)  TestCheck(std::abs((a) - (b)) <= (tolerance), #a " near " #b, __FILE__, __LINE__)
+
+// Return from main with this, prints a summary
+inline int TestResult()
+{
+	if (TestFailures() == 0)  std::printf("All checks passed\n");
+	else                      std::printf("%d checks failed\n", TestFailures());
+	return TestFailures() == 0 ? 0 : 1;
+}
+
+
+#endif //_TEST_CHECK_H_INCLUDED_
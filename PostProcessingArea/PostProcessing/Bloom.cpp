@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------------------
+// Bloom post-process
+//--------------------------------------------------------------------------------------
+
+#include "Bloom.h"
+
+#include <algorithm>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	void AddScaled(ColourRGBA& sum, const ColourRGBA& colour, float weight)
+	{
+		sum.r += colour.r * weight;
+		sum.g += colour.g * weight;
+		sum.b += colour.b * weight;
+		sum.a += colour.a * weight;
+	}
+}
+
+
+// Width or height of a pyramid level given the size of the image, never less than one pixel
+int BloomLevelSize(int imageSize, int level)
+{
+	return std::max(imageSize >> level, 1);
+}
+
+// Part of a colour bright enough to glow. Colours fade in above the threshold rather than switching on
+ColourRGBA BloomThreshold(const ColourRGBA& colour, float threshold)
+{
+	float brightness = (colour.r + colour.g + colour.b) / 3;
+	float scale = std::max(brightness - threshold, 0.0f) / std::max(brightness, 0.0001f);
+	return ColourRGBA(colour.r * scale, colour.g * scale, colour.b * scale, 1);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pyramid
+//--------------------------------------------------------------------------------------
+
+// Shrink source into target (already sized), averaging four bilinear samples around each target pixel - a 4x4 box filter
+// for an exact halving. The first level of the pyramid also applies the threshold to each sample (threshold >= 0)
+void BloomDownsample(const Image& source, Image& target, float threshold /*= -1*/)
+{
+	const float du = 1.0f / source.Width();
+	const float dv = 1.0f / source.Height();
+	for (int y = 0; y < target.Height(); ++y)
+	{
+		ColourRGBA* out = target.Row(y);
+		for (int x = 0; x < target.Width(); ++x)
+		{
+			float u = target.U(x);
+			float v = target.V(y);
+			ColourRGBA samples[4] = { source.Sample(u - du, v - dv), source.Sample(u + du, v - dv),
+			                          source.Sample(u - du, v + dv), source.Sample(u + du, v + dv) };
+
+			ColourRGBA sum(0, 0, 0, 0);
+			for (const ColourRGBA& sample : samples)
+			{
+				AddScaled(sum, (threshold >= 0) ? BloomThreshold(sample, threshold) : sample, 0.25f);
+			}
+			out[x] = sum;
+		}
+	}
+}
+
+
+// Enlarge source (the level below) with a 3x3 tent filter and add it to target (the level above)
+void BloomUpsampleAdd(const Image& source, Image& target)
+{
+	static const float weights[3] = { 1.0f / 4, 2.0f / 4, 1.0f / 4 };
+
+	const float du = 1.0f / source.Width();
+	const float dv = 1.0f / source.Height();
+	for (int y = 0; y < target.Height(); ++y)
+	{
+		ColourRGBA* out = target.Row(y);
+		for (int x = 0; x < target.Width(); ++x)
+		{
+			float u = target.U(x);
+			float v = target.V(y);
+			for (int j = 0; j < 3; ++j)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					AddScaled(out[x], source.Sample(u + (i - 1) * du, v + (j - 1) * dv), weights[i] * weights[j]);
+				}
+			}
+		}
+	}
+}
+
+
+// Build the pyramid from source: the bright parts shrunk down to the given number of levels (1 -> MAX_BLOOM_LEVELS) then added
+// back up, so Levels[0] ends up holding the glow from all of them
+void BuildBloomPyramid(const Image& source, float threshold, int levels, BloomPyramid& pyramid)
+{
+	levels = std::min(std::max(levels, 1), MAX_BLOOM_LEVELS);
+
+	// Down the pyramid, thresholding on the way into the first level
+	for (int level = 0; level < levels; ++level)
+	{
+		Image& image = pyramid.Levels[level];
+		int width  = BloomLevelSize(source.Width(),  level + 1);
+		int height = BloomLevelSize(source.Height(), level + 1);
+		if (image.Width() != width || image.Height() != height)  image.Resize(width, height);
+
+		if (level == 0)  BloomDownsample(source, image, threshold);
+		else             BloomDownsample(pyramid.Levels[level - 1], image);
+	}
+
+	// Back up, each level ends up holding the sum of itself and all the levels below
+	for (int level = levels - 2; level >= 0; --level)
+	{
+		BloomUpsampleAdd(pyramid.Levels[level + 1], pyramid.Levels[level]);
+	}
+}
+
+
+// The whole post-process: add the glow from the bright parts of source to it, writing to target (resized to match).
+// Intensity scales the glow, levels (1 -> MAX_BLOOM_LEVELS) sets how far it spreads
+void BloomImage(const Image& source, Image& target, float threshold, float intensity, int levels, BloomPyramid& pyramid)
+{
+	levels = std::min(std::max(levels, 1), MAX_BLOOM_LEVELS);
+	BuildBloomPyramid(source, threshold, levels, pyramid);
+
+	// Add the glow over the image, averaged over the levels so adding levels widens it without brightening it
+	target.Resize(source.Width(), source.Height());
+	const Image& glow = pyramid.Levels[0];
+	const float scale = intensity / levels;
+	for (int y = 0; y < source.Height(); ++y)
+	{
+		const ColourRGBA* in  = source.Row(y);
+		ColourRGBA*       out = target.Row(y);
+		for (int x = 0; x < source.Width(); ++x)
+		{
+			out[x] = in[x];
+			AddScaled(out[x], glow.Sample(source.U(x), source.V(y)), scale);
+			out[x].a = in[x].a;
+		}
+	}
+}
@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------------------------
+// Bloom post-process
+//--------------------------------------------------------------------------------------
+// The bright parts of the image are picked out and shrunk into a pyramid of half, quarter, eighth... size
+// images, each filtered a little on the way down. The pyramid is then added back up from the smallest level,
+// each level smoothly enlarged and added to the one above, and the result added over the image. Small
+// filters on small images give a wide glow for a fraction of the cost of a wide blur at full size, and
+// each extra level doubles the radius while adding very little work.
+//
+// This file has the CPU version, the GPU version is Bloom.hlsli and the shaders that include it. Both
+// read the levels with bilinear filtering so give the same results
+
+#ifndef _BLOOM_H_INCLUDED_
+#define _BLOOM_H_INCLUDED_
+
+#include "Image.h"
+
+
+// Largest number of levels in the pyramid. Level 1 is half the size of the image, level 6 is 1/64th
+const int MAX_BLOOM_LEVELS = 6;
+
+// Width or height of a pyramid level given the size of the image, never less than one pixel
+int BloomLevelSize(int imageSize, int level);
+
+// Part of a colour bright enough to glow. Colours fade in above the threshold rather than switching on
+ColourRGBA BloomThreshold(const ColourRGBA& colour, float threshold);
+
+
+// Working images for the CPU bloom, kept between calls so they are only allocated once. Levels[0] is level 1
+struct BloomPyramid
+{
+	Image Levels[MAX_BLOOM_LEVELS];
+};
+
+// Shrink source into target (already sized), averaging four bilinear samples around each target pixel - a 4x4 box filter
+// for an exact halving. The first level of the pyramid also applies the threshold to each sample (threshold >= 0)
+void BloomDownsample(const Image& source, Image& target, float threshold = -1);
+
+// Enlarge source (the level below) with a 3x3 tent filter and add it to target (the level above)
+void BloomUpsampleAdd(const Image& source, Image& target);
+
+// Build the pyramid from source: the bright parts shrunk down to the given number of levels (1 -> MAX_BLOOM_LEVELS) then added
+// back up, so Levels[0] ends up holding the glow from all of them
+void BuildBloomPyramid(const Image& source, float threshold, int levels, BloomPyramid& pyramid);
+
+// The whole post-process: add the glow from the bright parts of source to it, writing to target (resized to match).
+// Intensity scales the glow, levels (1 -> MAX_BLOOM_LEVELS) sets how far it spreads
+void BloomImage(const Image& source, Image& target, float threshold, float intensity, int levels, BloomPyramid& pyramid);
+
+
+#endif //_BLOOM_H_INCLUDED_
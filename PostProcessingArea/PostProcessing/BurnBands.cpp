@@ -0,0 +1,116 @@
+//--------------------------------------------------------------------------------------
+// Burn post-process drawn a band at a time
+//--------------------------------------------------------------------------------------
+
+#include "BurnBands.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+
+
+namespace
+{
+	// Rows sampled by each task when building on several threads
+	const int ROWS_PER_TASK = 16;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Bands
+//--------------------------------------------------------------------------------------
+
+// Sample the burn map for the pixels of the rectangle, then find the range of heights in each block
+void BurnBands::Build(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+                      float areaLeft, float areaTop, float areaWidth, float areaHeight, TaskPool* pool)
+{
+	mMap = inputs.BurnMap;
+	mTargetWidth  = target.Width();
+	mTargetHeight = target.Height();
+	mArea[0] = areaLeft;  mArea[1] = areaTop;  mArea[2] = areaWidth;  mArea[3] = areaHeight;
+	mAreaPixels[0] = inputs.AreaPixels[0];
+	mAreaPixels[1] = inputs.AreaPixels[1];
+
+	mLeft   = left;
+	mTop    = top;
+	mWidth  = std::max(right - left, 0);
+	mHeight = std::max(bottom - top, 0);
+	mBlocksPerRow = (mWidth + BURN_BLOCK_PIXELS - 1) / BURN_BLOCK_PIXELS;
+	mTexels.resize(static_cast<size_t>(mWidth) * mHeight);
+	mBlocks.resize(static_cast<size_t>(mBlocksPerRow) * mHeight);
+
+	// Area UVs worked out as the backend's DrawPixels does
+	const int tasks = (mHeight + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	auto sampleRows = [&](int task)
+	{
+		const int lastRow = std::min((task + 1) * ROWS_PER_TASK, mHeight);
+		for (int row = task * ROWS_PER_TASK; row < lastRow; ++row)
+		{
+			float areaV = (target.V(top + row) - areaTop) / areaHeight;
+			Texel* texels = &mTexels[static_cast<size_t>(row) * mWidth];
+			for (int column = 0; column < mWidth; ++column)
+			{
+				float areaU = (target.U(left + column) - areaLeft) / areaWidth;
+				ColourRGBA burn = SampleBurnMap(inputs, areaU, areaV);
+				texels[column] = { burn.r, burn.g, burn.b, SoftCircleAlpha(areaU, areaV, 0.2f) };
+			}
+
+			Block* blocks = &mBlocks[static_cast<size_t>(row) * mBlocksPerRow];
+			for (int block = 0; block < mBlocksPerRow; ++block)
+			{
+				const int end = std::min((block + 1) * BURN_BLOCK_PIXELS, mWidth);
+				Block range = { texels[block * BURN_BLOCK_PIXELS].Height, texels[block * BURN_BLOCK_PIXELS].Height, true };
+				for (int column = block * BURN_BLOCK_PIXELS; column < end; ++column)
+				{
+					range.MinHeight = std::min(range.MinHeight, texels[column].Height);
+					range.MaxHeight = std::max(range.MaxHeight, texels[column].Height);
+					range.Opaque = range.Opaque && texels[column].Alpha == 1;
+				}
+				blocks[block] = range;
+			}
+		}
+	};
+	if (pool)  pool->ParallelFor(tasks, sampleRows);
+	else       for (int task = 0; task < tasks; ++task)  sampleRows(task);
+}
+
+
+// Returns true if built with the same map, area and pixels
+bool BurnBands::Matches(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+                        float areaLeft, float areaTop, float areaWidth, float areaHeight) const
+{
+	return mMap == inputs.BurnMap && mTargetWidth == target.Width() && mTargetHeight == target.Height() &&
+	       mAreaPixels[0] == inputs.AreaPixels[0] && mAreaPixels[1] == inputs.AreaPixels[1] &&
+	       mArea[0] == areaLeft && mArea[1] == areaTop && mArea[2] == areaWidth && mArea[3] == areaHeight &&
+	       mLeft == left && mTop == top && mWidth == std::max(right - left, 0) && mHeight == std::max(bottom - top, 0);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Cache
+//--------------------------------------------------------------------------------------
+
+// Return the bands for the given area, building them on first use
+const BurnBands& BurnBandsCache::Get(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+                                     float areaLeft, float areaTop, float areaWidth, float areaHeight, TaskPool* pool)
+{
+	for (Entry& entry : mAreas)
+	{
+		if (entry.Bands->Matches(inputs, target, left, top, right, bottom, areaLeft, areaTop, areaWidth, areaHeight))
+		{
+			entry.Used = true;
+			return *entry.Bands;
+		}
+	}
+
+	mAreas.push_back({ std::unique_ptr<BurnBands>(new BurnBands()), true });
+	mAreas.back().Bands->Build(inputs, target, left, top, right, bottom, areaLeft, areaTop, areaWidth, areaHeight, pool);
+	return *mAreas.back().Bands;
+}
+
+
+// Drop the bands that Get hasn't returned since the last call
+void BurnBandsCache::DropUnused()
+{
+	mAreas.erase(std::remove_if(mAreas.begin(), mAreas.end(), [](const Entry& entry) { return !entry.Used; }), mAreas.end());
+	for (Entry& entry : mAreas)  entry.Used = false;
+}
@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------------
+// Burn post-process drawn a band at a time
+//--------------------------------------------------------------------------------------
+// Burn_pp.hlsl reads the burn map and the scene for every pixel of its area every frame, but only pixels
+// whose height in the map (its red) is within BURN_GLOW_AMOUNT above the burn height need the real work.
+// Those at or below it are black, those above the band are the scene as it was. The map and the area
+// don't change from frame to frame, only the height does.
+//
+// So the CPU backend samples the map for each pixel of an area once, keeping the sample and the soft
+// circle's alpha, and buckets each row into blocks of BURN_BLOCK_PIXELS with the lowest and highest height
+// in each. Each frame a block entirely at or below the burn height is burnt and one entirely above the band
+// is untouched, so its pixels are the cached alpha over black or over the scene - no map read, square root
+// or test of each pixel, and burnt blocks inside the circle are just filled with black. Only blocks the band
+// crosses look at each pixel's height, and only pixels in the band are shaded in full - the crinkled scene
+// read and the glow. The shading done each frame then grows with the number of pixels in the band rather
+// than the size of the area, and results are exactly those of drawing every pixel in full.
+//
+// Keeping the band's pixels in one list sorted by height finds them with two binary searches, but they are
+// then scattered over the whole area and read and written out of order. Once the band covers a third of
+// the area that is slower than drawing every pixel, so the blocks keep them in row order instead.
+//
+// The samples are kept for each area (position, size and the render target's size) in a cache like the
+// colour lookup tables'. A polygon's area UVs move whenever the camera does, so Burn polygons are still
+// drawn pixel by pixel, as is Burn on the GPU - Direct3D 11 has no depth bounds test to cull pixels by a
+// stored height, and the shader's branch already skips the band's work elsewhere
+
+#ifndef _BURN_BANDS_H_INCLUDED_
+#define _BURN_BANDS_H_INCLUDED_
+
+#include "CpuEffects.h"
+#include "Image.h"
+
+#include <memory>
+#include <vector>
+
+class TaskPool;
+
+
+// Pixels in each block of a row. Blocks start at the left of the area
+const int BURN_BLOCK_PIXELS = 32;
+
+// Burn's map sampled for each pixel of a rectangle of a render target, see above
+class BurnBands
+{
+public:
+	// What is kept for each pixel
+	struct Texel
+	{
+		float Height; // Red of the burn map sample
+		float Green;  // Green and blue, the crinkle
+		float Blue;
+		float Alpha;  // Of the soft circle
+	};
+
+	// And for each block of a row
+	struct Block
+	{
+		float MinHeight;
+		float MaxHeight;
+		bool  Opaque; // Every pixel has an alpha of 1
+	};
+
+	// Sample the burn map for the pixels from (left, top) up to (right, bottom) of the target, with area UVs running 0->1
+	// across the rectangle given in 0->1 coordinates of the whole target. Rows are shared out to the pool's threads if one
+	// is given
+	void Build(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+	           float areaLeft, float areaTop, float areaWidth, float areaHeight, TaskPool* pool = nullptr);
+
+	// Returns true if built with the same map, area and pixels
+	bool Matches(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+	             float areaLeft, float areaTop, float areaWidth, float areaHeight) const;
+
+	int Left() const    { return mLeft; }
+	int Top() const     { return mTop; }
+	int Width() const   { return mWidth; }
+	int Height() const  { return mHeight; }
+
+	// Texels and blocks of row y of the target, the first of each is at Left()
+	const Texel* Row(int y) const        { return &mTexels[static_cast<size_t>(y - mTop) * mWidth]; }
+	const Block* RowBlocks(int y) const  { return &mBlocks[static_cast<size_t>(y - mTop) * mBlocksPerRow]; }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	// The key: map, area and the size of the target and the area in its pixels
+	const MipMappedImage* mMap = nullptr;
+	int   mTargetWidth = 0, mTargetHeight = 0;
+	float mArea[4] = {};
+	float mAreaPixels[2] = {};
+
+	int mLeft = 0, mTop = 0, mWidth = 0, mHeight = 0;
+	int mBlocksPerRow = 0;
+
+	std::vector<Texel> mTexels; // Row by row
+	std::vector<Block> mBlocks;
+};
+
+
+// Burn bands for each area drawn, built the first time each is seen. Areas not drawn between two calls to DropUnused are
+// dropped, so those left behind as areas move don't build up
+class BurnBandsCache
+{
+public:
+	// Return the bands for the given area (see BurnBands::Build), building them on first use. Stay valid until DropUnused
+	// drops them
+	const BurnBands& Get(const CpuEffectInputs& inputs, const Image& target, int left, int top, int right, int bottom,
+	                     float areaLeft, float areaTop, float areaWidth, float areaHeight, TaskPool* pool = nullptr);
+
+	// Drop the bands that Get hasn't returned since the last call, e.g. at the start of each chain run
+	void DropUnused();
+
+	int  Size() const  { return static_cast<int>(mAreas.size()); }
+	void Clear()       { mAreas.clear(); }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	struct Entry
+	{
+		std::unique_ptr<BurnBands> Bands; // Held by pointer so they stay in place as entries are added
+		bool                       Used;
+	};
+	std::vector<Entry> mAreas;
+};
+
+
+#endif //_BURN_BANDS_H_INCLUDED_
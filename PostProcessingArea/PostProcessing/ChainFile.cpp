@@ -0,0 +1,288 @@
+//--------------------------------------------------------------------------------------
+// Post-process chain files
+//--------------------------------------------------------------------------------------
+
+#include "ChainFile.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	const int PostProcessCount     = static_cast<int>(PostProcess::Upsample) + 1;
+	const int PostProcessModeCount = static_cast<int>(PostProcessMode::ModelPolygon) + 1;
+
+	bool SameName(const std::string& a, const char* b)
+	{
+		size_t i = 0;
+		for (; i < a.size() && b[i] != '\0'; ++i)
+		{
+			if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))  return false;
+		}
+		return i == a.size() && b[i] == '\0';
+	}
+
+	// Read a comma separated list of exactly count numbers
+	bool ReadFloats(const std::string& text, float* values, int count)
+	{
+		std::istringstream in(text);
+		for (int i = 0; i < count; ++i)
+		{
+			if (i > 0 && in.get() != ',')  return false;
+			if (!(in >> values[i]))  return false;
+		}
+		return in.peek() == std::char_traits<char>::eof();
+	}
+
+	bool ReadFloat(const std::string& text, float& value)  { return ReadFloats(text, &value, 1); }
+
+	bool ReadInt(const std::string& text, int& value)
+	{
+		std::istringstream in(text);
+		return (in >> value) && in.peek() == std::char_traits<char>::eof();
+	}
+
+	// 0 or 1
+	bool ReadBool(const std::string& text, bool& value)
+	{
+		int number;
+		if (!ReadInt(text, number) || (number != 0 && number != 1))  return false;
+		value = (number == 1);
+		return true;
+	}
+
+	// Apply one key=value setting to an effect. Returns false if the key doesn't belong to the effect or the value is bad
+	bool ReadSetting(PostProcessEffect& effect, const std::string& key, const std::string& value)
+	{
+		PostProcessData& data = effect.Data;
+		switch (effect.Process)
+		{
+		case PostProcess::Tint:
+			if (key == "top")  return ReadFloats(value, data.tint.rgbTop, 3);
+			if (key == "mid")  return ReadFloats(value, data.tint.rgbMid, 3);
+			break;
+		case PostProcess::TintHue:
+			if (key == "top")  return ReadFloats(value, data.Hue.Hue1, 3);
+			if (key == "mid")  return ReadFloats(value, data.Hue.Hue2, 3);
+			break;
+		case PostProcess::GreyNoise:
+			if (key == "grain")  return ReadFloat(value, data.Noise.grainSize) && data.Noise.grainSize > 0;
+			break;
+		case PostProcess::Burn:
+			if (key == "speed")  return ReadFloat(value, data.Burn.burnSpeed);
+			break;
+		case PostProcess::Underwater:
+			if (key == "speed")  return ReadFloat(value, data.Water.waterSpeed);
+			break;
+		case PostProcess::Blur:
+		case PostProcess::SecondBlur:
+			if (key == "blur")   return ReadInt(value, data.Blur.blur) && data.Blur.blur > 0;
+			if (key == "sigma")  return ReadFloat(value, data.Blur.sigma) && data.Blur.sigma > 0;
+			break;
+		case PostProcess::Bloom:
+			if (key == "threshold")  return ReadFloat(value, data.Bloom.threshold);
+			if (key == "intensity")  return ReadFloat(value, data.Bloom.intensity);
+			if (key == "levels")     return ReadInt(value, data.Bloom.levels);
+			break;
+		case PostProcess::Pixelation:
+			if (key == "width")   return ReadInt(value, data.Pixelation.blockWidth) && data.Pixelation.blockWidth > 0;
+			if (key == "height")  return ReadInt(value, data.Pixelation.blockHeight) && data.Pixelation.blockHeight > 0;
+			if (key == "levels")  return ReadInt(value, data.Pixelation.levels) && data.Pixelation.levels > 0;
+			break;
+		case PostProcess::Sigmoid:
+			if (key == "gamma")  return ReadFloat(value, data.Sigmoid.Gamma);
+			break;
+		case PostProcess::VariableBlur:
+			if (key == "inner")  return ReadFloat(value, data.VariableBlur.innerRadius) && data.VariableBlur.innerRadius >= 0;
+			if (key == "outer")  return ReadFloat(value, data.VariableBlur.outerRadius) && data.VariableBlur.outerRadius >= 0;
+			if (key == "focus")  return ReadFloat(value, data.VariableBlur.focus);
+			if (key == "boxes")  return ReadInt(value, data.VariableBlur.boxes) && data.VariableBlur.boxes > 0;
+			break;
+		case PostProcess::SeeingWorlds:
+		case PostProcess::SecondSeeingWorlds:
+			if (key == "offset")      return ReadFloat(value, data.SeeingWorlds.offset);
+			if (key == "taps")        return ReadInt(value, data.SeeingWorlds.taps) && data.SeeingWorlds.taps > 0;
+			if (key == "stochastic")  return ReadBool(value, data.SeeingWorlds.stochastic);
+			break;
+		default:
+			break;
+		}
+		return false;
+	}
+
+	void WriteFloats(std::ostream& out, const char* key, const float* values, int count)
+	{
+		out << ' ' << key << '=';
+		for (int i = 0; i < count; ++i)  out << (i > 0 ? "," : "") << values[i];
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reading and writing
+//--------------------------------------------------------------------------------------
+
+// Add the effects from a chain file to the end of the graph. Returns false on a line that can't be read
+bool ReadPostProcessChain(std::istream& in, PostProcessGraph& graph, std::string& error)
+{
+	std::string line;
+	for (int lineNumber = 1; std::getline(in, line); ++lineNumber)
+	{
+		std::istringstream words(line);
+		std::string effectName, modeName;
+		if (!(words >> effectName) || effectName[0] == '#')  continue;
+
+		auto fail = [&](const std::string& problem)
+		{
+			error = "Line " + std::to_string(lineNumber) + ": " + problem;
+			return false;
+		};
+
+		// Effect and mode
+		int process = 0;
+		while (process < PostProcessCount && !SameName(effectName, PPNames[process]))  ++process;
+		if (process == PostProcessCount || process == static_cast<int>(PostProcess::None) || process == static_cast<int>(PostProcess::Upsample))
+		{
+			return fail("unknown effect '" + effectName + "'");
+		}
+		if (!(words >> modeName))  return fail("no mode after '" + effectName + "'");
+		int mode = 0;
+		while (mode < PostProcessModeCount && !SameName(modeName, ModeNames[mode]))  ++mode;
+		if (mode == PostProcessModeCount)  return fail("unknown mode '" + modeName + "'");
+
+		PostProcessEffect effect;
+		effect.Process = static_cast<PostProcess>(process);
+		effect.Mode    = static_cast<PostProcessMode>(mode);
+		effect.Region  = 0;
+		effect.Data    = DefaultPostProcessData(effect.Process);
+
+		// Settings
+		int downscale = 1;
+		std::string setting;
+		while (words >> setting)
+		{
+			if (setting[0] == '#')  break;
+			size_t equals = setting.find('=');
+			if (equals == std::string::npos)  return fail("expected key=value, found '" + setting + "'");
+			std::string key   = setting.substr(0, equals);
+			std::string value = setting.substr(equals + 1);
+
+			bool ok = true;
+			if      (key == "region")     ok = ReadInt(value, effect.Region);
+			else if (key == "name")       effect.Name = value;
+			else if (key == "downscale")  ok = ReadInt(value, downscale);
+			else                          ok = ReadSetting(effect, key, value);
+			if (!ok)  return fail("bad setting '" + setting + "' for " + PPNames[process]);
+		}
+
+		int index = graph.AddEffect(effect.Process, effect.Mode, effect.Region, effect.Name, effect.Data);
+		if (!graph.SetEffectDownscale(index, downscale))
+		{
+			graph.RemoveEffect(index);
+			return fail("downscale must be 1, 2 or 4, and only full-screen effects can be reduced");
+		}
+	}
+	return true;
+}
+
+
+// Write the effects of the graph in the format above, every setting included
+void WritePostProcessChain(std::ostream& out, const PostProcessGraph& graph)
+{
+	out << "# Post-process chain, one effect per line - see PostProcessing/ChainFile.h\n";
+	for (int i = 0; i < graph.EffectCount(); ++i)
+	{
+		const PostProcessEffect& effect = graph.Effect(i);
+		const PostProcessData&   data = effect.Data;
+		out << PPNames[static_cast<int>(effect.Process)] << ' ' << ModeNames[static_cast<int>(effect.Mode)];
+
+		switch (effect.Process)
+		{
+		case PostProcess::Tint:
+			WriteFloats(out, "top", data.tint.rgbTop, 3);
+			WriteFloats(out, "mid", data.tint.rgbMid, 3);
+			break;
+		case PostProcess::TintHue:
+			WriteFloats(out, "top", data.Hue.Hue1, 3);
+			WriteFloats(out, "mid", data.Hue.Hue2, 3);
+			break;
+		case PostProcess::GreyNoise:   WriteFloats(out, "grain", &data.Noise.grainSize, 1);  break;
+		case PostProcess::Burn:        WriteFloats(out, "speed", &data.Burn.burnSpeed, 1);   break;
+		case PostProcess::Underwater:  WriteFloats(out, "speed", &data.Water.waterSpeed, 1); break;
+		case PostProcess::Sigmoid:     WriteFloats(out, "gamma", &data.Sigmoid.Gamma, 1);    break;
+		case PostProcess::Blur:
+		case PostProcess::SecondBlur:
+			out << " blur=" << data.Blur.blur;
+			WriteFloats(out, "sigma", &data.Blur.sigma, 1);
+			break;
+		case PostProcess::Bloom:
+			WriteFloats(out, "threshold", &data.Bloom.threshold, 1);
+			WriteFloats(out, "intensity", &data.Bloom.intensity, 1);
+			out << " levels=" << data.Bloom.levels;
+			break;
+		case PostProcess::Pixelation:
+			out << " width=" << data.Pixelation.blockWidth << " height=" << data.Pixelation.blockHeight;
+			out << " levels=" << data.Pixelation.levels;
+			break;
+		case PostProcess::VariableBlur:
+			WriteFloats(out, "inner", &data.VariableBlur.innerRadius, 1);
+			WriteFloats(out, "outer", &data.VariableBlur.outerRadius, 1);
+			WriteFloats(out, "focus", &data.VariableBlur.focus, 1);
+			out << " boxes=" << data.VariableBlur.boxes;
+			break;
+		case PostProcess::SeeingWorlds:
+		case PostProcess::SecondSeeingWorlds:
+			WriteFloats(out, "offset", &data.SeeingWorlds.offset, 1);
+			out << " taps=" << data.SeeingWorlds.taps << " stochastic=" << (data.SeeingWorlds.stochastic ? 1 : 0);
+			break;
+		default:
+			break;
+		}
+
+		if (effect.Mode != PostProcessMode::Fullscreen)  out << " region=" << effect.Region;
+		if (!effect.Name.empty() && effect.Name.find_first_of(" \t") == std::string::npos)  out << " name=" << effect.Name;
+		if (effect.Downscale != 1)  out << " downscale=" << effect.Downscale;
+		out << '\n';
+	}
+}
+
+
+// As above, for files. Returns false if the file can't be opened or read (with the reason in error)
+bool LoadPostProcessChain(const std::string& fileName, PostProcessGraph& graph, std::string& error)
+{
+	std::ifstream file(fileName);
+	if (!file)
+	{
+		error = "Can't open " + fileName;
+		return false;
+	}
+	if (!ReadPostProcessChain(file, graph, error))
+	{
+		error = fileName + ": " + error;
+		return false;
+	}
+	return true;
+}
+
+bool SavePostProcessChain(const std::string& fileName, const PostProcessGraph& graph, std::string& error)
+{
+	std::ofstream file(fileName);
+	if (!file)
+	{
+		error = "Can't create " + fileName;
+		return false;
+	}
+	WritePostProcessChain(file, graph);
+	if (!file)
+	{
+		error = "Error writing " + fileName;
+		return false;
+	}
+	return true;
+}
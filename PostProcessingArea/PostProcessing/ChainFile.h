@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Post-process chain files
+//--------------------------------------------------------------------------------------
+// A chain saved from the app (or written by hand) so it can be run again elsewhere, e.g. by the
+// batch tool over recorded frames. Plain text, one effect per line in chain order:
+//
+//   # Comment
+//   Tint       FullScreen top=0.3,0.8,0 mid=0.1,0.5,1
+//   Blur       FullScreen blur=21 sigma=6 downscale=2
+//   Burn       Area       region=3 name=Cube speed=1
+//
+// Effect and mode names are those shown in the app (PPNames and ModeNames), in any case. Settings
+// left out keep the values the menu gives a new effect (DefaultPostProcessData). The settings are:
+//   Tint, TintHue: top=r,g,b mid=r,g,b     Blur: blur=pixels sigma=pixels
+//   GreyNoise: grain=size                  Bloom: threshold= intensity= levels=
+//   Burn, Underwater: speed=               Sigmoid: gamma=
+//   SeeingWorlds: offset= taps= stochastic=0|1   Pixelation: width=pixels height=pixels levels=
+//   VariableBlur: inner=pixels outer=pixels focus= boxes=
+//   Any effect: region=index name=text downscale=1|2|4
+
+#ifndef _CHAIN_FILE_H_INCLUDED_
+#define _CHAIN_FILE_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+
+#include <iosfwd>
+#include <string>
+
+
+// Add the effects from a chain file to the end of the graph. Returns false on a line that can't be read, with the line
+// number and problem in error. Effects before the bad line have been added
+bool ReadPostProcessChain(std::istream& in, PostProcessGraph& graph, std::string& error);
+
+// Write the effects of the graph in the format above, every setting included
+void WritePostProcessChain(std::ostream& out, const PostProcessGraph& graph);
+
+// As above, for files. Returns false if the file can't be opened or read (with the reason in error)
+bool LoadPostProcessChain(const std::string& fileName, PostProcessGraph& graph, std::string& error);
+bool SavePostProcessChain(const std::string& fileName, const PostProcessGraph& graph, std::string& error);
+
+
+#endif //_CHAIN_FILE_H_INCLUDED_
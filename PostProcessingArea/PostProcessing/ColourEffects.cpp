@@ -0,0 +1,221 @@
+//--------------------------------------------------------------------------------------
+// Colour (point-wise) post-processes
+//--------------------------------------------------------------------------------------
+// The CPU code here follows the original pixel shaders line for line (including their quirks, e.g. the
+// .rbg swizzle in the tint shaders) so the CPU and GPU results match
+
+#include "ColourEffects.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	const float HSL_EPSILON = 1e-10f;
+
+	float Lerp(float a, float b, float t)  { return a + t * (b - a); }
+
+	// HSL conversion from TintHue.hlsl - based on work by Sam Hocevar and Emil Persson
+	void RGBtoHCV(const float rgb[3], float hcv[3])
+	{
+		float P[4], Q[4];
+		if (rgb[1] < rgb[2]) { P[0] = rgb[2]; P[1] = rgb[1]; P[2] = -1.0f; P[3] =  2.0f / 3.0f; }
+		else                 { P[0] = rgb[1]; P[1] = rgb[2]; P[2] =  0.0f; P[3] = -1.0f / 3.0f; }
+		if (rgb[0] < P[0])   { Q[0] = P[0];   Q[1] = P[1];   Q[2] = P[3];  Q[3] = rgb[0]; }
+		else                 { Q[0] = rgb[0]; Q[1] = P[1];   Q[2] = P[2];  Q[3] = P[0]; }
+		float C = Q[0] - std::min(Q[3], Q[1]);
+		hcv[0] = std::abs((Q[3] - Q[1]) / (6 * C + HSL_EPSILON) + Q[2]);
+		hcv[1] = C;
+		hcv[2] = Q[0];
+	}
+
+	void RGBtoHSL(const float rgb[3], float hsl[3])
+	{
+		float hcv[3];
+		RGBtoHCV(rgb, hcv);
+		float L = hcv[2] - hcv[1] * 0.5f;
+		hsl[0] = hcv[0];
+		hsl[1] = hcv[1] / (1 - std::abs(L * 2 - 1) + HSL_EPSILON);
+		hsl[2] = L;
+	}
+
+	void HSLtoRGB(const float hsl[3], float rgb[3])
+	{
+		float H = hsl[0];
+		float hue[3] = { Saturate(std::abs(H * 6 - 3) - 1), Saturate(2 - std::abs(H * 6 - 2)), Saturate(2 - std::abs(H * 6 - 4)) };
+		float C = (1 - std::abs(2 * hsl[2] - 1)) * hsl[1];
+		for (int i = 0; i < 3; ++i)  rgb[i] = (hue[i] - 0.5f) * C + hsl[2];
+	}
+
+	// Rotate the hue of a colour as TintHue does, hueLevel is the animation timer
+	void ShiftHue(const float in[3], float hueLevel, float out[3])
+	{
+		float hsl[3];
+		RGBtoHSL(in, hsl);
+		hsl[0] += 0.314f * std::sin(hueLevel * 0.3f);
+		if (hsl[0] >= 1)  hsl[0] = 0;
+		HSLtoRGB(hsl, out);
+	}
+
+	// Sigmoid-like curve from Sigmoid_pp.hlsl
+	float Cubic(float value)
+	{
+		if (value < 0.5f)  return value * value * value * value * value * 16.0f;
+		value -= 1.0f;
+		return value * value * value * value * value * 16.0f + 1.0f;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+
+// Returns true for post-processes whose output pixel depends only on the same input pixel
+bool IsColourEffect(PostProcess process)
+{
+	return process == PostProcess::Tint          || process == PostProcess::TintHue ||
+	       process == PostProcess::Inverse       || process == PostProcess::BlackAndWhite ||
+	       process == PostProcess::Sigmoid       || process == PostProcess::NightVision;
+}
+
+
+// Pack the settings for one colour effect. hueLevel is the animation timer used by TintHue
+ColourStage MakeColourStage(PostProcess process, const PostProcessData& data, float hueLevel)
+{
+	ColourStage stage = {};
+	stage.Process = process;
+	if (process == PostProcess::Tint)
+	{
+		std::copy(data.tint.rgbTop, data.tint.rgbTop + 3, stage.Params);
+		std::copy(data.tint.rgbMid, data.tint.rgbMid + 3, stage.Params + 4);
+	}
+	else if (process == PostProcess::TintHue)
+	{
+		// The hue shifted colours don't depend on the pixel, so work them out once here and run it as a tint
+		stage.Process = PostProcess::Tint;
+		ShiftHue(data.Hue.Hue1, hueLevel, stage.Params);
+		ShiftHue(data.Hue.Hue2, hueLevel, stage.Params + 4);
+	}
+	else if (process == PostProcess::Sigmoid)
+	{
+		stage.Params[0] = data.Sigmoid.Gamma;
+	}
+	return stage;
+}
+
+
+// Apply one colour effect to one pixel. uv is the position of the pixel within the processed area (0->1)
+ColourRGBA ApplyColourStage(const ColourStage& stage, const ColourRGBA& c, float /*u*/, float v)
+{
+	const float* p = stage.Params;
+	if (stage.Process == PostProcess::Tint)
+	{
+		// Tint gradient top to bottom, note the shader samples the scene as .rbg
+		return ColourRGBA(c.r * Lerp(p[0], p[4], v), c.b * Lerp(p[1], p[5], v), c.g * Lerp(p[2], p[6], v));
+	}
+	else if (stage.Process == PostProcess::Inverse)
+	{
+		return ColourRGBA(1 - c.r, 1 - c.g, 1 - c.b);
+	}
+	else if (stage.Process == PostProcess::BlackAndWhite)
+	{
+		float average = c.r + c.g + c.b / 3.0f; // Precedence as in the shader
+		float bw = (average <= 0.5f) ? 0.0f : 1.0f;
+		return ColourRGBA(bw, bw, bw);
+	}
+	else if (stage.Process == PostProcess::Sigmoid)
+	{
+		float gamma = p[0];
+		return ColourRGBA(c.r * std::pow(Cubic(c.r), gamma), c.g * std::pow(Cubic(c.g), gamma), c.b * std::pow(Cubic(c.b), gamma));
+	}
+	else if (stage.Process == PostProcess::NightVision)
+	{
+		// Four samples of the same pixel, brightness limited, then only green is kept
+		float r = c.r * 4, g = c.g * 4, b = c.b * 4;
+		if (r + g + b > 1.2f)
+		{
+			g /= 4;
+			b /= 4;
+		}
+		float green = (0.0f + (g + 0.1f) + (b + 0.1f)) / 3;
+		return ColourRGBA(0, c.g * green, 0);
+	}
+	return c;
+}
+
+
+// Apply a sequence of colour effects to every pixel of source, writing to target (resized to match)
+void RunColourStages(const Image& source, Image& target, const ColourStage* stages, int count)
+{
+	if (target.Width() != source.Width() || target.Height() != source.Height())
+	{
+		target.Resize(source.Width(), source.Height());
+	}
+
+	for (int y = 0; y < source.Height(); ++y)
+	{
+		const ColourRGBA* in  = source.Row(y);
+		ColourRGBA*       out = target.Row(y);
+		float v = source.V(y);
+		for (int x = 0; x < source.Width(); ++x)
+		{
+			float u = source.U(x);
+			ColourRGBA colour = in[x];
+			for (int s = 0; s < count; ++s)
+			{
+				colour = ApplyColourStage(stages[s], colour, u, v);
+				colour = ColourRGBA(Saturate(colour.r), Saturate(colour.g), Saturate(colour.b));
+			}
+			out[x] = colour;
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// GPU shader generation
+//--------------------------------------------------------------------------------------
+
+// Name of the GPU shader permutation for a sequence of effects, e.g. "Tint+Inverse"
+std::string ColourShaderKey(const ColourStage* stages, int count)
+{
+	std::string key;
+	for (int s = 0; s < count; ++s)
+	{
+		if (s > 0)  key += "+";
+		key += PPNames[(int)stages[s].Process];
+	}
+	return key;
+}
+
+// HLSL source of a pixel shader applying the given sequence of effects
+std::string GenerateColourShader(const ColourStage* stages, int count)
+{
+	std::ostringstream hlsl;
+	hlsl << "// Fused colour post-process: " << ColourShaderKey(stages, count) << "\n"
+	     << "#include \"ColourEffects.hlsli\"\n"
+	     << "\n"
+	     << "Texture2D    SceneTexture : register(t0);\n"
+	     << "SamplerState PointSample  : register(s0);\n"
+	     << "\n"
+	     << "float4 main(PostProcessingInput input) : SV_Target\n"
+	     << "{\n"
+	     << "\tfloat3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rgb;\n";
+
+	for (int s = 0; s < count; ++s)
+	{
+		std::string params = "gColourStageParams[" + std::to_string(s * 2) + "], gColourStageParams[" + std::to_string(s * 2 + 1) + "]";
+		hlsl << "\tcolour = saturate(" << PPNames[(int)stages[s].Process] << "Stage(colour, input.areaUV, " << params << "));\n";
+	}
+
+	hlsl << "\treturn float4(colour, 1.0f);\n"
+	     << "}\n";
+	return hlsl.str();
+}
@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------------------------
+// Colour (point-wise) post-processes
+//--------------------------------------------------------------------------------------
+// Tint, TintHue, Inverse, BlackAndWhite, Sigmoid and NightVision only read the pixel they are writing,
+// so a run of them can be done in a single pass - read each pixel once, apply every effect in turn,
+// write it once. The graph merges such runs into one fused pass (see PostProcessGraph.cpp).
+//
+// This file has the CPU version of each effect and of the fused pass, plus the generator for the
+// matching GPU pixel shader (one permutation per sequence of effects, see ColourEffects.hlsli)
+
+#ifndef _COLOUR_EFFECTS_H_INCLUDED_
+#define _COLOUR_EFFECTS_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+#include "Image.h"
+
+#include <string>
+
+
+// Returns true for post-processes whose output pixel depends only on the same input pixel
+bool IsColourEffect(PostProcess process);
+
+
+// One effect in a fused run with its settings packed into two float4s - the same layout as
+// the gColourStageParams constant buffer array used by the generated shaders
+struct ColourStage
+{
+	PostProcess Process;   // TintHue becomes Tint - the hue shift is the same for every pixel so is done when packing
+	float       Params[8];
+};
+
+// Pack the settings for one colour effect. hueLevel is the animation timer used by TintHue
+ColourStage MakeColourStage(PostProcess process, const PostProcessData& data, float hueLevel);
+
+
+// Apply one colour effect to one pixel. uv is the position of the pixel within the processed area (0->1)
+// The result isn't clamped, the caller saturates it like writing to an 8-bit render target would
+ColourRGBA ApplyColourStage(const ColourStage& stage, const ColourRGBA& colour, float u, float v);
+
+// Apply a sequence of colour effects to every pixel of source, writing to target (resized to match)
+// The colour is saturated after every effect so the result matches running the effects as separate passes
+void RunColourStages(const Image& source, Image& target, const ColourStage* stages, int count);
+
+
+// Name of the GPU shader permutation for a sequence of effects, e.g. "Tint+Inverse". Use to cache compiled shaders
+std::string ColourShaderKey(const ColourStage* stages, int count);
+
+// HLSL source of a pixel shader applying the given sequence of effects. The shader includes ColourEffects.hlsli,
+// so compile it from the folder the other shaders are in
+std::string GenerateColourShader(const ColourStage* stages, int count);
+
+
+#endif //_COLOUR_EFFECTS_H_INCLUDED_
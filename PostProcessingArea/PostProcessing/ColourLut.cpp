@@ -0,0 +1,224 @@
+//--------------------------------------------------------------------------------------
+// Colour effects baked into 3D lookup tables
+//--------------------------------------------------------------------------------------
+
+#include "ColourLut.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Tints are compared by position only, see BakedColourStages::Matches
+	bool SameStage(const ColourStage& a, const ColourStage& b)
+	{
+		if (a.Process != b.Process)  return false;
+		return !IsBakeableColourStage(a) || std::memcmp(a.Params, b.Params, sizeof(a.Params)) == 0;
+	}
+
+	// Grid point below a 0->1 channel and how far past it the channel is. The last cell includes 1
+	void GridCell(float channel, int size, int& index, float& fraction)
+	{
+		float position = Saturate(channel) * (size - 1);
+		index = std::min(static_cast<int>(position), size - 2);
+		fraction = position - index;
+	}
+}
+
+
+// Returns true for stages that can go in a table
+bool IsBakeableColourStage(const ColourStage& stage)
+{
+	return stage.Process != PostProcess::Tint && stage.Process != PostProcess::BlackAndWhite;
+}
+
+// Returns true if baking the stages into tables makes them quicker to apply
+bool WorthBakingColourStages(const ColourStage* stages, int count)
+{
+	return std::any_of(stages, stages + count, [](const ColourStage& stage) { return stage.Process == PostProcess::Sigmoid; });
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tables
+//--------------------------------------------------------------------------------------
+
+// Work out the stages at every grid point, saturating after each as RunColourStages does
+void ColourLut::Build(const ColourStage* stages, int count, int size)
+{
+	mSize = std::min(std::max(size, 2), MAX_COLOUR_LUT_SIZE);
+	mEntries.resize(static_cast<size_t>(mSize) * mSize * mSize * 4);
+
+	const float step = 1.0f / (mSize - 1);
+	float* entry = mEntries.data();
+	for (int b = 0; b < mSize; ++b)
+	{
+		for (int g = 0; g < mSize; ++g)
+		{
+			for (int r = 0; r < mSize; ++r, entry += 4)
+			{
+				// Bakeable stages ignore the position
+				ColourRGBA colour(r * step, g * step, b * step);
+				for (int s = 0; s < count; ++s)
+				{
+					colour = ApplyColourStage(stages[s], colour, 0.5f, 0.5f);
+					colour = ColourRGBA(Saturate(colour.r), Saturate(colour.g), Saturate(colour.b));
+				}
+				entry[0] = colour.r;
+				entry[1] = colour.g;
+				entry[2] = colour.b;
+				entry[3] = 0;
+			}
+		}
+	}
+}
+
+
+// Colour from the table, blended between the eight grid points around it
+ColourRGBA ColourLut::Apply(const ColourRGBA& colour) const
+{
+	int   r, g, b;
+	float fr, fg, fb;
+	GridCell(colour.r, mSize, r, fr);
+	GridCell(colour.g, mSize, g, fg);
+	GridCell(colour.b, mSize, b, fb);
+
+	// Blend along red on each of the four edges of the cell, then along green, then blue. Grid points are padded to four
+	// floats so each is one 16-byte load the compiler can blend all channels of at once
+	const size_t strideG = static_cast<size_t>(mSize) * 4;
+	const size_t strideB = strideG * mSize;
+	const float* corner = &mEntries[b * strideB + g * strideG + r * 4];
+	float result[4];
+	for (int channel = 0; channel < 4; ++channel)
+	{
+		const float* p = corner + channel;
+		float c00 = p[0]                 + (p[4]                     - p[0])                 * fr;
+		float c10 = p[strideG]           + (p[strideG + 4]           - p[strideG])           * fr;
+		float c01 = p[strideB]           + (p[strideB + 4]           - p[strideB])           * fr;
+		float c11 = p[strideB + strideG] + (p[strideB + strideG + 4] - p[strideB + strideG]) * fr;
+		float c0 = c00 + (c10 - c00) * fg;
+		float c1 = c01 + (c11 - c01) * fg;
+		result[channel] = c0 + (c1 - c0) * fb;
+	}
+	return ColourRGBA(result[0], result[1], result[2]);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Baked runs
+//--------------------------------------------------------------------------------------
+
+// Bake the stages into tables of the given size
+void BakedColourStages::Build(const ColourStage* stages, int count, int size)
+{
+	mStages.assign(stages, stages + count);
+	mSize = size;
+	mSteps.clear();
+	mTables.clear();
+
+	for (int s = 0; s < count; )
+	{
+		if (!IsBakeableColourStage(stages[s]))
+		{
+			mSteps.push_back({ s, -1 });
+			++s;
+			continue;
+		}
+
+		// The whole run of bakeable stages from here goes in one table
+		int end = s + 1;
+		while (end < count && IsBakeableColourStage(stages[end]))  ++end;
+		mTables.emplace_back();
+		mTables.back().Build(stages + s, end - s, size);
+		mSteps.push_back({ s, static_cast<int>(mTables.size()) - 1 });
+		s = end;
+	}
+}
+
+
+// Whether this was built from the same stages and size, with the same settings for the baked ones
+bool BakedColourStages::Matches(const ColourStage* stages, int count, int size) const
+{
+	if (size != mSize || count != static_cast<int>(mStages.size()))  return false;
+	for (int s = 0; s < count; ++s)
+	{
+		if (!SameStage(stages[s], mStages[s]))  return false;
+	}
+	return true;
+}
+
+
+// Apply the run to one pixel
+ColourRGBA BakedColourStages::Apply(const ColourStage* stages, const ColourRGBA& colour, float u, float v) const
+{
+	ColourRGBA result = colour;
+	for (const Step& step : mSteps)
+	{
+		if (step.Table >= 0)
+		{
+			result = mTables[step.Table].Apply(result);
+		}
+		else
+		{
+			result = ApplyColourStage(stages[step.Stage], result, u, v);
+			result = ColourRGBA(Saturate(result.r), Saturate(result.g), Saturate(result.b));
+		}
+	}
+	return result;
+}
+
+
+// Apply the run to every pixel of source, writing to target (resized to match)
+void BakedColourStages::Run(const ColourStage* stages, const Image& source, Image& target) const
+{
+	if (target.Width() != source.Width() || target.Height() != source.Height())
+	{
+		target.Resize(source.Width(), source.Height());
+	}
+
+	for (int y = 0; y < source.Height(); ++y)
+	{
+		const ColourRGBA* in  = source.Row(y);
+		ColourRGBA*       out = target.Row(y);
+		float v = source.V(y);
+		for (int x = 0; x < source.Width(); ++x)
+		{
+			out[x] = Apply(stages, in[x], source.U(x), v);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Cache
+//--------------------------------------------------------------------------------------
+
+// Return the run baked with the given table size, building it on first use
+const BakedColourStages& ColourLutCache::Get(const ColourStage* stages, int count, int size)
+{
+	for (Entry& entry : mRuns)
+	{
+		if (entry.Run->Matches(stages, count, size))
+		{
+			entry.Used = true;
+			return *entry.Run;
+		}
+	}
+
+	mRuns.push_back({ std::unique_ptr<BakedColourStages>(new BakedColourStages()), true });
+	mRuns.back().Run->Build(stages, count, size);
+	return *mRuns.back().Run;
+}
+
+
+// Drop the runs that Get hasn't returned since the last call
+void ColourLutCache::DropUnused()
+{
+	mRuns.erase(std::remove_if(mRuns.begin(), mRuns.end(), [](const Entry& entry) { return !entry.Used; }), mRuns.end());
+	for (Entry& entry : mRuns)  entry.Used = false;
+}
@@ -0,0 +1,132 @@
+//--------------------------------------------------------------------------------------
+// Colour effects baked into 3D lookup tables
+//--------------------------------------------------------------------------------------
+// Inverse, Sigmoid and NightVision give a colour that depends only on the colour they are given, so a
+// run of them is a fixed function of RGB. Working that function out at the corners of a 32x32x32 (or
+// 64x64x64) grid of colours once, whenever the settings change, turns the run into one trilinear lookup
+// per pixel however many effects it has - no pow for Sigmoid.
+//
+// The table is only an approximation: between grid points the colour is blended, so a step becomes a
+// ramp a grid cell wide. BlackAndWhite is nothing but a step, so is never baked. NightVision's brightness
+// limit is a small one, near it the table is out by up to about 14 levels (of 255), elsewhere well
+// under one. Any difference can also tip a pixel near the BlackAndWhite threshold the other way.
+// PostProcessBench --lut reports how far each size is from the exact effects and how much quicker it is.
+//
+// Tint (and TintHue, which becomes a tint, see ColourStage) depends on the pixel's height in the area,
+// so it can't go in a table of RGB either. Stages not baked are applied as they are between the tables
+// either side, a tint with the settings it has at the time - TintHue's change every frame without the
+// tables being rebuilt.
+//
+// The CPU backend uses the tables when given a size (SetColourLutSize) and the run has a Sigmoid, the
+// only colour effect costing more per pixel than a lookup. Otherwise it runs the effects exactly as the
+// GPU does
+
+#ifndef _COLOUR_LUT_H_INCLUDED_
+#define _COLOUR_LUT_H_INCLUDED_
+
+#include "ColourEffects.h"
+#include "Image.h"
+
+#include <memory>
+#include <vector>
+
+
+// Table sizes (points along each side). 32 is close for smooth effects, 64 halves the width of the ramps at eight times the
+// memory (3MB) and time to build
+const int DEFAULT_COLOUR_LUT_SIZE = 32;
+const int MAX_COLOUR_LUT_SIZE     = 64;
+
+// Returns true for stages that can go in a table: those whose result depends only on the colour, bar BlackAndWhite
+bool IsBakeableColourStage(const ColourStage& stage);
+
+// Returns true if baking the stages into tables makes them quicker to apply
+bool WorthBakingColourStages(const ColourStage* stages, int count);
+
+
+// A run of bakeable stages worked out over a grid of colours
+class ColourLut
+{
+public:
+	// Work out the stages at every grid point, saturating after each as RunColourStages does. Size is clamped to 2->MAX_COLOUR_LUT_SIZE
+	void Build(const ColourStage* stages, int count, int size);
+
+	int Size() const  { return mSize; }
+
+	// Colour from the table, blended between the eight grid points around it. The colour is clamped to 0->1 first, alpha is 1
+	ColourRGBA Apply(const ColourRGBA& colour) const;
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	int                mSize = 0;
+	std::vector<float> mEntries; // RGB and a padding float for each grid point, red changing fastest then green then blue
+};
+
+
+// A run of colour stages with each run of bakeable stages in it replaced by a table
+class BakedColourStages
+{
+public:
+	// Bake the stages into tables of the given size
+	void Build(const ColourStage* stages, int count, int size);
+
+	// Whether this was built from the same stages and size, with the same settings for the baked ones. Tints only need to
+	// be in the same places, their settings are those given to Apply
+	bool Matches(const ColourStage* stages, int count, int size) const;
+
+	// Apply the run to one pixel, as the loop over ApplyColourStage in RunColourStages does. The stages are those it was
+	// built from (or that match), for the tints' settings. u, v is the position of the pixel within the processed area (0->1)
+	ColourRGBA Apply(const ColourStage* stages, const ColourRGBA& colour, float u, float v) const;
+
+	// Apply the run to every pixel of source, writing to target (resized to match) - RunColourStages using the tables
+	void Run(const ColourStage* stages, const Image& source, Image& target) const;
+
+	int TableCount() const  { return static_cast<int>(mTables.size()); }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	// A tint applied as it is, or a table
+	struct Step
+	{
+		int Stage; // Index of the tint in the stages
+		int Table; // Index in mTables, -1 for a tint
+	};
+
+	std::vector<ColourStage> mStages; // As given, to compare in Matches
+	int                      mSize = 0;
+	std::vector<Step>        mSteps;
+	std::vector<ColourLut>   mTables;
+};
+
+
+// Baked runs of stages, built the first time each run (with its settings) is seen. Runs not used between two calls to
+// DropUnused are dropped, so runs left behind as settings change don't build up
+class ColourLutCache
+{
+public:
+	// Return the run baked with the given table size, building it on first use. Stays valid until DropUnused drops it
+	const BakedColourStages& Get(const ColourStage* stages, int count, int size);
+
+	// Drop the runs that Get hasn't returned since the last call, e.g. at the start of each chain run
+	void DropUnused();
+
+	int  Size() const  { return static_cast<int>(mRuns.size()); }
+	void Clear()       { mRuns.clear(); }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	struct Entry
+	{
+		std::unique_ptr<BakedColourStages> Run; // Held by pointer so it stays in place as entries are added
+		bool                               Used;
+	};
+	std::vector<Entry> mRuns;
+};
+
+
+#endif //_COLOUR_LUT_H_INCLUDED_
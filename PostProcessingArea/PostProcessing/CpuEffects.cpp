@@ -0,0 +1,384 @@
+//--------------------------------------------------------------------------------------
+// CPU versions of the post-process pixel shaders
+//--------------------------------------------------------------------------------------
+// Each effect follows its shader line by line, constants included, so differences are easy to spot
+
+#include "CpuEffects.h"
+#include "Bloom.h"
+#include "ColourLut.h"
+#include "Pixelation.h"
+#include "Scanlines.h"
+#include "Upsample.h"
+#include "VariableBlur.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	const float PI = 3.14159265358979323846f;
+
+	float Lerp(float a, float b, float t)  { return a + (b - a) * t; }
+
+	// Colour read from a trilinear sampled texture, mid-grey if the texture isn't there
+	ColourRGBA SampleMap(const MipMappedImage* map, float u, float v, float texelsPerPixel)
+	{
+		if (map == nullptr || map->Empty())  return ColourRGBA(0.5f, 0.5f, 0.5f, 1);
+		return map->Sample(u, v, texelsPerPixel);
+	}
+
+	// Texels of level 0 of the map crossed from one pixel to the next when its UVs span the given number of pixels
+	float TexelsPerPixel(const MipMappedImage* map, const float pixels[2])
+	{
+		if (map == nullptr || map->Empty())  return 1;
+		return std::max(map->Level(0).Width()  / std::max(pixels[0], 1.0f),
+		                map->Level(0).Height() / std::max(pixels[1], 1.0f));
+	}
+}
+
+
+// Alpha for the circle inside an area: 1 inside, fading to 0 at the edge over softEdge (0 for a hard edge)
+float SoftCircleAlpha(float areaU, float areaV, float softEdge)
+{
+	float x = areaU - 0.5f;
+	float y = areaV - 0.5f;
+	float centreLengthSq = x * x + y * y;
+
+	// The shaders divide by a softEdge of 0 for a hard edge, the infinity (or NaN exactly on the edge) saturates to 1 or 0
+	if (softEdge <= 0)  return (centreLengthSq <= 0.25f) ? 1.0f : 0.0f;
+	return 1.0f - Saturate((centreLengthSq - 0.25f + softEdge) / softEdge);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Noise effects
+//--------------------------------------------------------------------------------------
+
+// Size of the noise cells in pixels of the render target. The grain setting is the size of NOISE_GRAIN_CELLS of them in
+// full size pixels, so the grain looks the same at reduced resolution
+float EffectNoiseCell(PostProcess process, const CpuEffectInputs& inputs)
+{
+	if (process != PostProcess::GreyNoise)  return 1;
+	float cell = inputs.Data->Noise.grainSize / NOISE_GRAIN_CELLS * inputs.ScenePixels[0] / inputs.ViewportWidth;
+	return std::max(cell, 1.0f);
+}
+
+// Colour GreyNoise or Scanlines writes given the pixel's noise
+ColourRGBA ShadeNoisePixel(PostProcess process, const CpuEffectInputs& inputs, const CpuEffectPixel& pixel, float noise)
+{
+	ColourRGBA colour = inputs.Sources[0]->SamplePoint(pixel.SceneU, pixel.SceneV);
+	if (process == PostProcess::GreyNoise)
+	{
+		float grey = (colour.r + colour.g + colour.b) / 3.0f;
+		grey += 0.5f * (noise - 0.5f);
+		return ColourRGBA(grey, grey, grey, SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.2f));
+	}
+
+	// Scanlines
+	ScanlineWeights weights = ScanlineRowWeights(pixel.SceneV, inputs.ViewportHeight);
+	float grey = ScanlinesGrey(colour, weights, ScanlinesFlicker(inputs.Animation->HueLevel), noise);
+	return ColourRGBA(grey, grey, grey, 1);
+}
+
+
+// Burn map at the given area UVs, as Burn reads it
+ColourRGBA SampleBurnMap(const CpuEffectInputs& inputs, float areaU, float areaV)
+{
+	return SampleMap(inputs.BurnMap, areaU, areaV, TexelsPerPixel(inputs.BurnMap, inputs.AreaPixels));
+}
+
+// Colour Burn writes given the pixel's sample of the burn map
+ColourRGBA ShadeBurnPixel(const CpuEffectInputs& inputs, const CpuEffectPixel& pixel, const ColourRGBA& burn)
+{
+	const float crinkle = 0.15f;
+	const Image& scene = *inputs.Sources[0];
+	float height = inputs.Animation->BurnHeight;
+
+	ColourRGBA colour(0, 0, 0);
+	if (burn.r >= height + BURN_GLOW_AMOUNT)
+	{
+		colour = scene.SamplePoint(pixel.SceneU, pixel.SceneV);
+	}
+	else if (burn.r > height)
+	{
+		// Burning edges
+		float glowLevel = 1.0f - (burn.r - height) / BURN_GLOW_AMOUNT;
+		ColourRGBA tex = scene.SamplePoint(pixel.SceneU - glowLevel * crinkle * (burn.g - 0.5f), pixel.SceneV - glowLevel * crinkle * (burn.b - 0.5f));
+		ColourRGBA burnt(0.8f * tex.r, 0.4f * tex.g, 0.0f);
+		glowLevel *= 2.0f;
+		if (glowLevel < 1.0f)
+		{
+			colour = ColourRGBA(Lerp(tex.r, burnt.r, glowLevel), Lerp(tex.g, burnt.g, glowLevel), Lerp(tex.b, burnt.b, glowLevel));
+		}
+		else
+		{
+			colour = ColourRGBA(Lerp(burnt.r, 1.0f, glowLevel - 1), Lerp(burnt.g, 0.8f, glowLevel - 1), Lerp(burnt.b, 0.0f, glowLevel - 1));
+		}
+	}
+	colour.a = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.2f);
+	return colour;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+
+// Returns the colour the pixel shader for the given post-process writes at this pixel
+ColourRGBA ShadeEffectPixel(PostProcess process, const CpuEffectInputs& inputs, const CpuEffectPixel& pixel)
+{
+	const Image&                scene = *inputs.Sources[0];
+	const PostProcessAnimation& animation = *inputs.Animation;
+	const float u = pixel.SceneU;
+	const float v = pixel.SceneV;
+
+	// Colour effects, alone or fused. Only the tints fade out at the edge of an area
+	if (inputs.ColourStageCount > 0)
+	{
+		ColourRGBA colour = scene.SamplePoint(u, v);
+		if (inputs.ColourLut)
+		{
+			colour = inputs.ColourLut->Apply(inputs.ColourStages, colour, pixel.AreaU, pixel.AreaV);
+		}
+		else
+		{
+			for (int s = 0; s < inputs.ColourStageCount; ++s)
+			{
+				colour = ApplyColourStage(inputs.ColourStages[s], colour, pixel.AreaU, pixel.AreaV);
+				colour = ColourRGBA(Saturate(colour.r), Saturate(colour.g), Saturate(colour.b));
+			}
+		}
+		bool tint = inputs.ColourStageCount == 1 && (process == PostProcess::Tint || process == PostProcess::TintHue);
+		colour.a = tint ? SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0) : 1.0f;
+		return colour;
+	}
+
+	switch (process)
+	{
+	case PostProcess::GreyNoise:
+	case PostProcess::Scanlines:
+	{
+		// Pixel of the render target, the shaders' SV_Position
+		int x = static_cast<int>(u * inputs.ScenePixels[0]);
+		int y = static_cast<int>(v * inputs.ScenePixels[1]);
+		return ShadeNoisePixel(process, inputs, pixel, GrainNoise(x, y, EffectNoiseCell(process, inputs), inputs.NoiseKey));
+	}
+
+	case PostProcess::Burn:
+		return ShadeBurnPixel(inputs, pixel, SampleBurnMap(inputs, pixel.AreaU, pixel.AreaV));
+
+	case PostProcess::Distort:
+	{
+		ColourRGBA distort = SampleMap(inputs.DistortMap, pixel.AreaU, pixel.AreaV, TexelsPerPixel(inputs.DistortMap, inputs.AreaPixels));
+		float vectorU = distort.g - 0.5f;
+		float vectorV = distort.b - 0.5f;
+		float length = std::sqrt(vectorU * vectorU + vectorV * vectorV);
+		float light = (length > 0) ? (vectorU + vectorV) / length * 0.707f * 0.015f : 0.0f;
+		ColourRGBA colour = scene.SamplePoint(u + animation.DistortLevel * vectorU, v + animation.DistortLevel * vectorV);
+		return ColourRGBA(light + colour.r * 0.8f, light + colour.g * 0.8f, light + colour.b * 0.8f,
+		                  SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.2f));
+	}
+
+	case PostProcess::Spiral:
+	{
+		float centreU = inputs.AreaTopLeft[0] + inputs.AreaSize[0] * 0.5f;
+		float centreV = inputs.AreaTopLeft[1] + inputs.AreaSize[1] * 0.5f;
+		float offsetU = u - centreU;
+		float offsetV = v - centreV;
+		float angle = std::sqrt(offsetU * offsetU + offsetV * offsetV) * animation.SpiralLevel * animation.SpiralLevel;
+		float s = std::sin(angle);
+		float c = std::cos(angle);
+
+		// Row vector times the shader's { c, s, -s, c } matrix
+		ColourRGBA colour = scene.SamplePoint(centreU + offsetU * c - offsetV * s, centreV + offsetU * s + offsetV * c);
+		colour.a = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.1f);
+		return colour;
+	}
+
+	case PostProcess::Underwater:
+	{
+		float alpha = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.15f);
+		float sinX = std::sin(pixel.AreaU * 2 * PI + animation.WaterLevel);
+		float sinY = std::sin(pixel.AreaV * 2 * PI + animation.WaterLevel * 0.7f);
+		ColourRGBA colour = scene.SamplePoint(u + sinY * 0.01f * alpha, v + sinX * 0.01f * alpha);
+		return ColourRGBA(0.0f, colour.b * 0.3f, colour.g, alpha); // .rbg * (0, 0.3, 1)
+	}
+
+	case PostProcess::HeatHaze:
+	{
+		float alpha = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0.15f);
+		float sinX = std::sin(pixel.AreaU * 8 * PI  + animation.HeatHazeTimer * 3.0f);
+		float sinY = std::sin(pixel.AreaV * 20 * PI + animation.HeatHazeTimer * 3.7f);
+		ColourRGBA colour = scene.SamplePoint(u + sinY * 0.01f * alpha * inputs.AreaSize[0], v + sinX * 0.01f * alpha * inputs.AreaSize[1]);
+		colour.a = alpha * Saturate(sinX * sinY * 0.33f + 0.66f);
+		return colour;
+	}
+
+	case PostProcess::Pixelation:
+	{
+		// The blocks are already averaged and posterised, read the one the pixel is in
+		const PostProcessData& data = *inputs.Data;
+		int x = PixelationBlock(u, inputs.ViewportWidth,  data.Pixelation.blockWidth);
+		int y = PixelationBlock(v, inputs.ViewportHeight, data.Pixelation.blockHeight);
+		return inputs.PixelationBlocks->Pixel(x, y);
+	}
+
+	case PostProcess::Blur:
+	case PostProcess::SecondBlur:
+	{
+		// BlurAlong in Blur.hlsli
+		const GaussianKernel& kernel = *inputs.BlurKernel;
+		float stepU = (process == PostProcess::SecondBlur) ? inputs.BlurStepScale / inputs.ViewportWidth  : 0.0f;
+		float stepV = (process == PostProcess::Blur)       ? inputs.BlurStepScale / inputs.ViewportHeight : 0.0f;
+		ColourRGBA centre = scene.Sample(u, v);
+		float weight = kernel.TapWeights[0];
+		ColourRGBA colour(centre.r * weight, centre.g * weight, centre.b * weight);
+		for (size_t i = 1; i < kernel.TapWeights.size(); i++)
+		{
+			float offset = kernel.TapOffsets[i];
+			ColourRGBA a = scene.Sample(u + stepU * offset, v + stepV * offset);
+			ColourRGBA b = scene.Sample(u - stepU * offset, v - stepV * offset);
+			weight = kernel.TapWeights[i];
+			colour.r += (a.r + b.r) * weight;
+			colour.g += (a.g + b.g) * weight;
+			colour.b += (a.b + b.b) * weight;
+		}
+		colour.a = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0);
+		return colour;
+	}
+
+	case PostProcess::Bloom:
+	{
+		const PostProcessData& data = *inputs.Data;
+		float glowScale = data.Bloom.intensity / std::min(std::max(data.Bloom.levels, 1), MAX_BLOOM_LEVELS);
+		ColourRGBA colour = scene.SamplePoint(u, v);
+		ColourRGBA glow = inputs.BloomGlow->Sample(u, v);
+		return ColourRGBA(colour.r + glow.r * glowScale, colour.g + glow.g * glowScale, colour.b + glow.b * glowScale, 1);
+	}
+
+	case PostProcess::VariableBlur:
+	{
+		// Radius in full size pixels, scaled to the table's
+		const SummedAreaTable& table = *inputs.SummedAreas;
+		float radius = VariableBlurRadius(*inputs.Data, pixel.AreaU, pixel.AreaV) * table.Width() / inputs.ViewportWidth;
+		int x = std::min(static_cast<int>(u * table.Width()),  table.Width() - 1);
+		int y = std::min(static_cast<int>(v * table.Height()), table.Height() - 1);
+		ColourRGBA colour = StackedBoxBlur(table, x, y, radius, inputs.Data->VariableBlur.boxes);
+		colour.a = SoftCircleAlpha(pixel.AreaU, pixel.AreaV, 0);
+		return colour;
+	}
+
+	case PostProcess::Merge:
+	{
+		// A chain that doesn't give the merge a second image reads nothing from t1, an unbound texture reads as black
+		ColourRGBA first = scene.SamplePoint(u, v);
+		ColourRGBA second = inputs.Sources[1] ? inputs.Sources[1]->SamplePoint(u, v) : ColourRGBA(0, 0, 0, 0);
+		return ColourRGBA(first.r + second.r * 2.5f, first.g + second.g * 2.5f, first.b + second.b * 2.5f, 1);
+	}
+
+	case PostProcess::Upsample:
+	{
+		ColourRGBA colour = EdgeAwareUpsamplePixel(scene, *inputs.Sources[1], u, v);
+		colour.a = 1;
+		return colour;
+	}
+
+	case PostProcess::SeeingWorlds:
+		return SeeingWorldsPixel(pixel.SceneU, pixel.SceneV, animation.SeeingWorldsTime, inputs.MarchIterations);
+
+	case PostProcess::SecondSeeingWorlds:
+		return SeeingWorldsSwirlPixel(scene, pixel.SceneU, pixel.SceneV, animation.SeeingWorldsTime, *inputs.SwirlTaps);
+
+	default: // Copy
+	{
+		ColourRGBA colour = scene.SamplePoint(u, v);
+		colour.a = 1;
+		return colour;
+	}
+	}
+}
+
+
+// How far from a pixel the shader for the post-process may read its image t0, in pixels of a render target of the given size.
+// Returns false if the shader can read anywhere in t0. Each distance is the largest texture coordinate offset the shader
+// above can add, plus a pixel for rounding and bilinear filtering. Shaders reading only their own pixel need no border
+bool EffectFootprint(PostProcess process, const CpuEffectInputs& inputs, int width, int height, int& borderX, int& borderY)
+{
+	auto border = [&](float offsetU, float offsetV)
+	{
+		borderX = (offsetU > 0) ? static_cast<int>(std::ceil(offsetU * width))  + 1 : 0;
+		borderY = (offsetV > 0) ? static_cast<int>(std::ceil(offsetV * height)) + 1 : 0;
+		return true;
+	};
+
+	// Colour effects only read their own pixel
+	if (inputs.ColourStageCount > 0)  return border(0, 0);
+
+	switch (process)
+	{
+	case PostProcess::Burn:       return border(0.15f * 0.5f, 0.15f * 0.5f); // crinkle * (burn - 0.5) at most
+	case PostProcess::Distort:    return border(0.5f * inputs.Animation->DistortLevel, 0.5f * inputs.Animation->DistortLevel);
+	case PostProcess::Underwater: return border(0.01f, 0.01f);
+	case PostProcess::HeatHaze:   return border(0.01f * inputs.AreaSize[0], 0.01f * inputs.AreaSize[1]);
+
+	case PostProcess::Blur:
+	case PostProcess::SecondBlur:
+	{
+		float reach = inputs.BlurKernel->TapOffsets.back() * inputs.BlurStepScale;
+		if (process == PostProcess::Blur)  return border(0, reach / inputs.ViewportHeight);
+		else                               return border(reach / inputs.ViewportWidth, 0);
+	}
+
+	// These read anywhere, or an image other than t0 as well
+	case PostProcess::Spiral:
+	case PostProcess::SecondSeeingWorlds:
+	case PostProcess::Bloom:
+	case PostProcess::VariableBlur:
+	case PostProcess::Pixelation:
+	case PostProcess::Merge:
+	case PostProcess::Upsample:
+		return false;
+
+	default: // GreyNoise, Scanlines, SeeingWorlds, Copy
+		return border(0, 0);
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Animation
+//--------------------------------------------------------------------------------------
+
+// Move the animation on by one frame as UpdateScene and the Direct3D backend do
+void AdvancePostProcessAnimation(PostProcessAnimation& animation, const PostProcessGraph& graph, float frameTime)
+{
+	// The app keeps the speeds of the last Burn and Underwater effects drawn, and advances SeeingWorlds time as each
+	// SeeingWorlds effect is drawn
+	float burnSpeed  = 2.0f;
+	float waterSpeed = 1.0f;
+	for (int i = 0; i < graph.EffectCount(); ++i)
+	{
+		const PostProcessEffect& effect = graph.Effect(i);
+		if      (effect.Process == PostProcess::Burn)          burnSpeed  = effect.Data.Burn.burnSpeed;
+		else if (effect.Process == PostProcess::Underwater)    waterSpeed = effect.Data.Water.waterSpeed;
+		else if (effect.Process == PostProcess::SeeingWorlds)
+		{
+			animation.SeeingWorldsTime += frameTime;
+			++animation.SeeingWorldsFrame;
+		}
+	}
+
+	++animation.NoiseFrame;
+	animation.BurnHeight = std::fmod(animation.BurnHeight + burnSpeed * frameTime, 1.0f);
+	animation.HueLevel   += frameTime;
+	animation.WaterLevel += waterSpeed * frameTime;
+	animation.DistortLevel = 0.03f;
+	animation.SpiralLevel  = (1.0f - std::cos(animation.SpiralWiggle)) * 4.0f;
+	animation.SpiralWiggle += frameTime;
+	animation.HeatHazeTimer += frameTime;
+}
@@ -0,0 +1,115 @@
+//--------------------------------------------------------------------------------------
+// CPU versions of the post-process pixel shaders
+//--------------------------------------------------------------------------------------
+// Each post-process is a pixel shader run for every pixel of a full-screen quad, an area quad or a polygon.
+// ShadeEffectPixel below does the same work as the shader for one pixel, given the same inputs: the
+// images bound to t0/t1 (read with the same point/bilinear/trilinear sampling), the effect settings and
+// the pixel's sceneUV and areaUV. The returned alpha is the shader's too (e.g. the soft circle around
+// area effects) - it only matters where the draw is alpha blended.
+//
+// Used by the CPU backend (CpuPostProcessBackend.h) to run the whole chain without a GPU. The colour
+// effects, blurs, bloom and upsample reuse the CPU code from their own files
+
+#ifndef _CPU_EFFECTS_H_INCLUDED_
+#define _CPU_EFFECTS_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+#include "ColourEffects.h"
+#include "GaussianKernel.h"
+#include "SeeingWorlds.h"
+#include "Noise.h"
+#include "Image.h"
+
+class SummedAreaTable;
+class BakedColourStages;
+
+
+// Values the app animates each frame that some effects read. The Direct3D backend keeps these in its own globals
+// and constant buffers (see UpdateScene in Scene.cpp), the CPU backend is given them so runs can be repeated exactly
+struct PostProcessAnimation
+{
+	float HueLevel         = 0;     // TintHue and Scanlines
+	float BurnHeight       = 0;     // Burn, 0->1
+	float WaterLevel       = 0;     // Underwater
+	float SpiralLevel      = 0;     // Spiral
+	float SpiralWiggle     = 0;     // Spiral, the angle SpiralLevel is made from
+	float DistortLevel     = 0.03f; // Distort
+	float HeatHazeTimer    = 0;     // HeatHaze
+	float SeeingWorldsTime = 0;     // SeeingWorlds and SecondSeeingWorlds
+	int   SeeingWorldsFrame = 0;    // SecondSeeingWorlds with stochastic taps, counts the SeeingWorlds effects drawn
+	uint32_t NoiseSeed     = 0;     // GreyNoise and Scanlines: frames with the same seed and number have the same noise
+	uint32_t NoiseFrame    = 0;     // GreyNoise and Scanlines: frames drawn, moves the noise on
+};
+
+// Move the animation on by one frame as UpdateScene and the Direct3D backend do. Burn and Underwater use the speed of
+// the last such effect in the graph, as the app does
+void AdvancePostProcessAnimation(PostProcessAnimation& animation, const PostProcessGraph& graph, float frameTime);
+
+
+// Everything a pass's pixel shader reads apart from the position of the pixel
+struct CpuEffectInputs
+{
+	const Image*                Sources[MAX_PASS_INPUTS] = {}; // Images bound to t0, t1
+	const PostProcessData*      Data      = nullptr;
+	const PostProcessAnimation* Animation = nullptr;
+
+	// Textures read with the trilinear sampler. Missing ones read as mid-grey, i.e. no effect for the distort map
+	const MipMappedImage* BurnMap    = nullptr;
+	const MipMappedImage* DistortMap = nullptr;
+
+	// Colour effects: the stage for each effect of the pass, more than one for a fused pass (see ColourEffects.h)
+	ColourStage ColourStages[MAX_FUSED_EFFECTS];
+	int         ColourStageCount = 0;
+	const BakedColourStages* ColourLut = nullptr; // The same stages baked into lookup tables, used in their place if set (see ColourLut.h)
+
+	const GaussianKernel* BlurKernel = nullptr; // Blurs: kernel already scaled for the pass resolution
+	float                 BlurStepScale = 1;    // Blurs: the pass's downscale, see Blur.hlsli
+	const Image*          BloomGlow = nullptr;  // Bloom: first level of the bloom pyramid built from t0
+	const SummedAreaTable* SummedAreas = nullptr; // VariableBlur: summed-area table built from t0
+	const Image*          PixelationBlocks = nullptr; // Pixelation: the blocks reduced from t0 (see Pixelation.h)
+	int                   MarchIterations = SEEING_WORLDS_ITERATIONS; // SeeingWorlds: most steps along each ray
+	const SeeingWorldsTaps* SwirlTaps = nullptr; // SecondSeeingWorlds: the frame's taps
+	uint32_t              NoiseKey = 0; // GreyNoise, Scanlines: the key for the effect's noise this frame (Noise.h)
+
+	int   ViewportWidth  = 1; // Full size viewport, as the gViewportWidth/Height shader constants
+	int   ViewportHeight = 1;
+	float AreaTopLeft[2] = { 0, 0 }; // As the gArea2DTopLeft/Size shader constants, 0->1 screen coordinates
+	float AreaSize[2]    = { 1, 1 };
+	float AreaPixels[2]  = { 1, 1 }; // Size of the area in pixels of the render target, to choose mip-maps for textures read with areaUV
+	float ScenePixels[2] = { 1, 1 }; // Size of the render target, to choose mip-maps for textures read with sceneUV
+};
+
+// The position of one pixel, as the vertex shader outputs it
+struct CpuEffectPixel
+{
+	float SceneU, SceneV; // Position on screen (0->1)
+	float AreaU,  AreaV;  // Position within the area or polygon (0->1)
+};
+
+
+// Alpha for the circle inside an area: 1 inside, fading to 0 at the edge over softEdge (0 for a hard edge)
+float SoftCircleAlpha(float areaU, float areaV, float softEdge);
+
+// Returns the colour the pixel shader for the given post-process writes at this pixel
+ColourRGBA ShadeEffectPixel(PostProcess process, const CpuEffectInputs& inputs, const CpuEffectPixel& pixel);
+
+// GreyNoise and Scanlines read noise for the pixel's position in the render target (GrainNoise in Noise.h) with cells of this
+// many pixels, 1 for Scanlines. ShadeNoisePixel returns what ShadeEffectPixel does given the pixel's noise, so a row's noise
+// can be worked out in one go
+float      EffectNoiseCell(PostProcess process, const CpuEffectInputs& inputs);
+ColourRGBA ShadeNoisePixel(PostProcess process, const CpuEffectInputs& inputs, const CpuEffectPixel& pixel, float noise);
+
+// Burn blacks out pixels whose height in the burn map (its red) is at or below the animation's BurnHeight, leaves those this
+// far above it as they are and glows in between. ShadeBurnPixel returns what ShadeEffectPixel does given the pixel's sample
+// of the map, so the samples can be kept from frame to frame (BurnBands.h)
+const float BURN_GLOW_AMOUNT = 0.25f;
+ColourRGBA SampleBurnMap(const CpuEffectInputs& inputs, float areaU, float areaV);
+ColourRGBA ShadeBurnPixel(const CpuEffectInputs& inputs, const CpuEffectPixel& pixel, const ColourRGBA& burn);
+
+// How far from a pixel the shader for the post-process may read its image t0, in pixels of a render target of the given
+// size (the same size as t0). Returns false if the shader can read anywhere in t0 (e.g. Spiral, whose rotation grows
+// with the distance from the centre). Lets a tile be drawn from a window onto t0 with borders this wide
+bool EffectFootprint(PostProcess process, const CpuEffectInputs& inputs, int width, int height, int& borderX, int& borderY);
+
+
+#endif //_CPU_EFFECTS_H_INCLUDED_
@@ -0,0 +1,55 @@
+//--------------------------------------------------------------------------------------
+// Vector instructions the processor supports
+//--------------------------------------------------------------------------------------
+
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && defined(POST_PROCESS_X86)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+const char* SimdLevelNames[] = { "Scalar", "SSE2", "AVX2" };
+
+
+namespace
+{
+	SimdLevel DetectSimdLevel()
+	{
+#if !defined(POST_PROCESS_X86)
+		return SimdLevel::Scalar;
+#elif defined(_MSC_VER)
+		// AVX2 is leaf 7 EBX bit 5, and the OS must save the AVX registers (OSXSAVE, then XCR0 bits 1 and 2)
+		int info[4];
+		__cpuid(info, 0);
+		bool avx2 = false;
+		if (info[0] >= 7)
+		{
+			__cpuid(info, 1);
+			bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+			__cpuidex(info, 7, 0);
+			avx2 = osSavesAvx && (info[1] & (1 << 5)) != 0;
+		}
+		return avx2 ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))  return SimdLevel::AVX2;
+		return __builtin_cpu_supports("sse2") ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#endif
+	}
+}
+
+
+// The best level this processor supports
+SimdLevel BestSimdLevel()
+{
+	static const SimdLevel best = DetectSimdLevel();
+	return best;
+}
+
+// The given level, or the best supported if the processor doesn't have it
+SimdLevel SupportedSimdLevel(SimdLevel level)
+{
+	return (level > BestSimdLevel()) ? BestSimdLevel() : level;
+}
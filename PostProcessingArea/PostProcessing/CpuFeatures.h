@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------------------
+// Vector instructions the processor supports
+//--------------------------------------------------------------------------------------
+// CPU post-processing code with hand-vectorised loops has a version for each instruction set, chosen
+// when it runs so one build works on any x86 processor. The app and tools are built for the baseline
+// (SSE2 on x64), AVX2 versions are compiled for that instruction set alone and only called after
+// checking the processor has it. Other processors (e.g. ARM) use the plain C++ versions.
+
+#ifndef _CPU_FEATURES_H_INCLUDED_
+#define _CPU_FEATURES_H_INCLUDED_
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define POST_PROCESS_X86 1
+#endif
+
+// Marks a function to be compiled for AVX2 whatever the build settings. Visual C++ needs nothing, it always allows the intrinsics
+#if defined(POST_PROCESS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+
+// Instruction sets the vectorised loops are written for, each includes the ones before
+enum class SimdLevel
+{
+	Scalar, // Plain C++
+	SSE2,   // 4 floats per instruction
+	AVX2,   // 8 floats per instruction
+};
+
+extern const char* SimdLevelNames[];
+
+// The best level this processor supports
+SimdLevel BestSimdLevel();
+
+// The given level, or the best supported if the processor doesn't have it
+SimdLevel SupportedSimdLevel(SimdLevel level);
+
+
+#endif //_CPU_FEATURES_H_INCLUDED_
@@ -0,0 +1,867 @@
+//--------------------------------------------------------------------------------------
+// CPU post-processing backend
+//--------------------------------------------------------------------------------------
+
+#include "CpuPostProcessBackend.h"
+#include "ColourEffects.h"
+#include "Pixelation.h"
+#include "Scanlines.h"
+#include "SeparableBlur.h"
+#include "RecursiveGaussian.h"
+#include "VariableBlur.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Longest blur kernel, must match MAX_BLUR_TAPS in Common.h (the size of the blur constant buffer)
+	const int MAX_BLUR_TAPS = 40;
+
+	// Value as stored in an 8-bit UNORM render target
+	float Quantise(float x)  { return std::round(Saturate(x) * 255.0f) / 255.0f; }
+
+	// Area UVs at the four points of a polygon, as in 2DPolygon_pp.hlsl
+	const float PolygonUVs[4][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 } };
+
+	// Copy the pixels from (left, top) up to (right, bottom) to the same place in another image of the same size
+	void CopyPixels(const Image& from, Image& to, int left, int top, int right, int bottom)
+	{
+		for (int y = top; y < bottom; ++y)  std::copy(from.Row(y) + left, from.Row(y) + right, to.Row(y) + left);
+	}
+}
+
+
+// Default placement: areas in the middle half of the screen, a polygon pass (or each model of a batch) as a square in the middle
+PostProcessPlacement DefaultPostProcessPlacement(const PostProcessGraph& /*graph*/, const PostProcessPass& pass)
+{
+	PostProcessPlacement placement;
+	if (pass.Mode == PostProcessMode::Polygon || pass.Mode == PostProcessMode::ModelPolygon)
+	{
+		// Batched model polygons are spread in a row across the screen
+		int count = std::max(static_cast<int>(pass.BatchedEffects.size()), 1);
+		float halfSize = 0.5f / count;
+		for (int i = 0; i < count; ++i)
+		{
+			float centreX = -1.0f + (2 * i + 1.0f) / count;
+			const float corners[4][2] = { { -1, 1 }, { -1, -1 }, { 1, 1 }, { 1, -1 } }; // Top-left, bottom-left, top-right, bottom-right
+			for (const auto& corner : corners)
+			{
+				placement.PolygonPoints.insert(placement.PolygonPoints.end(), { centreX + corner[0] * halfSize, corner[1] * halfSize, 0.5f, 1.0f });
+			}
+		}
+	}
+	return placement;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Setup
+//--------------------------------------------------------------------------------------
+
+CpuPostProcessBackend::CpuPostProcessBackend(int viewportWidth, int viewportHeight)
+	: mViewportWidth(viewportWidth), mViewportHeight(viewportHeight)
+{
+	mScene.Resize(viewportWidth, viewportHeight);
+	mOutput.Resize(viewportWidth, viewportHeight);
+}
+
+
+// The rendered scene the chain starts from, scaled to the viewport if it isn't already that size
+void CpuPostProcessBackend::SetScene(const Image& scene)
+{
+	if (scene.Width() == mViewportWidth && scene.Height() == mViewportHeight)
+	{
+		mScene = scene;
+		return;
+	}
+
+	for (int y = 0; y < mViewportHeight; ++y)
+	{
+		for (int x = 0; x < mViewportWidth; ++x)
+		{
+			mScene.Pixel(x, y) = scene.Sample(mScene.U(x), mScene.V(y));
+		}
+	}
+}
+
+
+// Threads to draw with, including the calling thread. 1 draws everything on the calling thread, 0 uses one thread for each core
+void CpuPostProcessBackend::SetThreadCount(int threadCount)
+{
+	if (threadCount == ThreadCount())  return;
+	mTaskPool.reset(threadCount == 1 ? nullptr : new TaskPool(threadCount));
+}
+
+
+//--------------------------------------------------------------------------------------
+// Running
+//--------------------------------------------------------------------------------------
+
+void CpuPostProcessBackend::BeginChain(const CompiledPostProcessGraph& compiled)
+{
+	// Targets keep their contents between chains like the GPU's, they are only resized when the chain changes their size
+	mTargets.resize(compiled.TargetCount);
+	for (int target = 0; target < compiled.TargetCount; ++target)
+	{
+		int width  = DownscaledSize(mViewportWidth,  compiled.TargetDownscales[target]);
+		int height = DownscaledSize(mViewportHeight, compiled.TargetDownscales[target]);
+		if (mTargets[target].Width() != width || mTargets[target].Height() != height)  mTargets[target].Resize(width, height);
+	}
+
+	// Target 0 holds the rendered scene
+	if (!mTargets.empty())  mTargets[0] = mScene;
+	mOutputWritten = false;
+
+	mCompiled = &compiled;
+	mNextPass = 0;
+	mFusedUntil = -1;
+
+	// Colour lookup tables the last chain didn't use have had their settings changed (or their effects removed)
+	mColourLuts.DropUnused();
+
+	// As have Burn areas that have moved
+	mBurnBands.DropUnused();
+}
+
+
+void CpuPostProcessBackend::EndChain()
+{
+	// An empty chain shows the scene as it is
+	if (!mOutputWritten)  mOutput = mScene;
+}
+
+
+void CpuPostProcessBackend::RunPass(const PostProcessGraph& graph, const PostProcessPass& pass)
+{
+	++mStats.Passes;
+
+	// Passes are given in the order they were compiled. Those drawn with an earlier pass in a fused run are done already
+	const int passIndex = mNextPass++;
+	if (passIndex <= mFusedUntil)  return;
+
+	if (pass.Mode != PostProcessMode::Fullscreen)  mPlacement = mPlacer(graph, pass);
+
+	// Bloom reads the glow built from the whole of its input before the pass draws
+	if (pass.Process == PostProcess::Bloom)
+	{
+		const PostProcessData& data = graph.Effect(pass.Effect).Data;
+		BuildBloomPyramid(TargetImage(pass.Sources[0]), data.Bloom.threshold, data.Bloom.levels, mBloomPyramid);
+		for (int level = 0; level < std::min(std::max(data.Bloom.levels, 1), MAX_BLOOM_LEVELS); ++level)
+		{
+			CountDraw(INTERNAL_TARGET, static_cast<double>(mBloomPyramid.Levels[level].Width()) * mBloomPyramid.Levels[level].Height());
+		}
+	}
+
+	// As does the variable blur, reading the summed-area table of its input. Counted as a pass along rows and one down columns
+	if (pass.Process == PostProcess::VariableBlur)
+	{
+		mSummedAreaTable.Build(TargetImage(pass.Sources[0]), mTaskPool.get());
+		CountDraw(INTERNAL_TARGET, 2.0 * mSummedAreaTable.Width() * mSummedAreaTable.Height());
+	}
+
+	// And pixelation, reading the blocks averaged from its input
+	if (pass.Process == PostProcess::Pixelation)
+	{
+		const PostProcessData& data = graph.Effect(pass.Effect).Data;
+		PixelationReduce(TargetImage(pass.Sources[0]), mViewportWidth, mViewportHeight, data.Pixelation.blockWidth,
+		                 data.Pixelation.blockHeight, data.Pixelation.levels, mPixelationBlocks, mTaskPool.get());
+		CountDraw(INTERNAL_TARGET, static_cast<double>(mPixelationBlocks.Width()) * mPixelationBlocks.Height());
+	}
+
+	// Draw a run of full-screen passes together where they can be
+	bool compiledPass = mCompiled != nullptr && passIndex < static_cast<int>(mCompiled->Passes.size()) && &mCompiled->Passes[passIndex] == &pass;
+	int fusedCount = (mFusion && compiledPass) ? FusablePassCount(graph, passIndex) : 1;
+	if (fusedCount > 1)
+	{
+		DrawFusedPasses(graph, passIndex, fusedCount);
+		mFusedUntil = passIndex + fusedCount - 1;
+		return;
+	}
+
+	// Working in place - as the GPU, copy the pixels around each region to the scratch target, draw them there and copy them back.
+	// The rest of the target already holds the input so is left alone
+	if (pass.Scratch >= 0)
+	{
+		Image& target  = TargetImage(pass.Target);
+		Image& scratch = TargetImage(pass.Scratch);
+		PlaceRegions(pass, target);
+		double copied = 0;
+		for (const PixelRectangle& region : mRegions)
+		{
+			CopyPixels(target, scratch, region.Left, region.Top, region.Right, region.Bottom);
+			copied += region.Pixels();
+		}
+		double pixels = DrawPass(graph, pass, scratch);
+		for (const PixelRectangle& region : mRegions)  CopyPixels(scratch, target, region.Left, region.Top, region.Right, region.Bottom);
+		CountCopy(2 * copied);
+		CountDraw(pass.Scratch, pixels);
+		return;
+	}
+
+	CountDraw(pass.Target, DrawPass(graph, pass, TargetImage(pass.Target)));
+	if (pass.Target == OUTPUT_TARGET)  mOutputWritten = true;
+
+	// Only when comparing against the original behaviour of drawing everything to the screen twice
+	if (pass.DrawToOutput)
+	{
+		CountDraw(OUTPUT_TARGET, DrawPass(graph, pass, mOutput));
+		mOutputWritten = true;
+	}
+}
+
+
+// Draw a pass from the images it reads to the given image, returns the number of pixels drawn
+double CpuPostProcessBackend::DrawPass(const PostProcessGraph& graph, const PostProcessPass& pass, Image& target)
+{
+	PrepareInputs(graph, pass, target, mInputs);
+
+	if (UsesSeparableBlur(pass, target))
+	{
+		return DrawSeparableBlur(pass, target);
+	}
+	else if (pass.Mode == PostProcessMode::Fullscreen)
+	{
+		return DrawRectangle(pass, target, 0, 0, 1, 1);
+	}
+	else if (pass.Mode == PostProcessMode::Area)
+	{
+		return DrawRectangle(pass, target, mPlacement.AreaTopLeft[0], mPlacement.AreaTopLeft[1], mPlacement.AreaSize[0], mPlacement.AreaSize[1]);
+	}
+
+	double pixels = 0;
+	for (size_t point = 0; point + 16 <= mPlacement.PolygonPoints.size(); point += 16)
+	{
+		pixels += DrawPolygon(pass, target, &mPlacement.PolygonPoints[point]);
+	}
+	return pixels;
+}
+
+
+// Set up the shader inputs for a pass drawn to an image of the given size
+void CpuPostProcessBackend::PrepareInputs(const PostProcessGraph& graph, const PostProcessPass& pass, const Image& target,
+                                          CpuEffectInputs& inputs)
+{
+	const PostProcessEffect& effect = graph.Effect(pass.Effect);
+	const int downscale = std::max(mViewportWidth / target.Width(), 1);
+
+	inputs = CpuEffectInputs();
+	for (int i = 0; i < pass.InputCount; ++i)  inputs.Sources[i] = &TargetImage(pass.Sources[i]);
+	inputs.Data       = &effect.Data;
+	inputs.Animation  = &mAnimation;
+	inputs.BurnMap    = &mBurnMap;
+	inputs.DistortMap = &mDistortMap;
+
+	// Colour effects, one stage each. A fused pass has the effects of the whole run
+	if (pass.FusedCount > 1)
+	{
+		for (int i = 0; i < pass.FusedCount; ++i)
+		{
+			const PostProcessEffect& fused = graph.Effect(pass.FusedEffects[i]);
+			inputs.ColourStages[i] = MakeColourStage(fused.Process, fused.Data, mAnimation.HueLevel);
+		}
+		inputs.ColourStageCount = pass.FusedCount;
+	}
+	else if (IsColourEffect(pass.Process))
+	{
+		inputs.ColourStages[0] = MakeColourStage(pass.Process, effect.Data, mAnimation.HueLevel);
+		inputs.ColourStageCount = 1;
+	}
+
+	// Baked into lookup tables if asked for and they are quicker
+	if (mColourLutSize > 0 && WorthBakingColourStages(inputs.ColourStages, inputs.ColourStageCount))
+	{
+		inputs.ColourLut = &mColourLuts.Get(inputs.ColourStages, inputs.ColourStageCount, mColourLutSize);
+	}
+
+	// The blur kernel shrinks with the resolution it is drawn at, as in SelectPostProcessShaderAndTextures
+	if (pass.Process == PostProcess::Blur || pass.Process == PostProcess::SecondBlur)
+	{
+		int radius = std::max(((effect.Data.Blur.blur - 1) / 2 + 1) / downscale, 1);
+		inputs.BlurKernel = &mBlurKernels.Get(std::min(radius, (MAX_BLUR_TAPS - 1) * 2), effect.Data.Blur.sigma / downscale);
+		inputs.BlurStepScale = static_cast<float>(downscale);
+	}
+	inputs.BloomGlow = &mBloomPyramid.Levels[0];
+	inputs.SummedAreas = &mSummedAreaTable;
+	inputs.PixelationBlocks = &mPixelationBlocks;
+	inputs.MarchIterations = mSeeingWorldsIterations;
+	if (pass.Process == PostProcess::GreyNoise || pass.Process == PostProcess::Scanlines)
+	{
+		NoiseStream stream = (pass.Process == PostProcess::GreyNoise) ? NoiseStream::GreyNoise : NoiseStream::Scanlines;
+		inputs.NoiseKey = NoiseKey(mAnimation.NoiseSeed, mAnimation.NoiseFrame, stream);
+	}
+
+	// The swirl's taps are the same for every pixel, as the Direct3D backend sends them in its constants
+	if (pass.Process == PostProcess::SecondSeeingWorlds)
+	{
+		MakeSeeingWorldsTaps(mAnimation.SeeingWorldsTime, effect.Data.SeeingWorlds.offset, effect.Data.SeeingWorlds.taps,
+		                     effect.Data.SeeingWorlds.stochastic, mAnimation.SeeingWorldsFrame, mSeeingWorldsTaps);
+		inputs.SwirlTaps = &mSeeingWorldsTaps;
+	}
+
+	inputs.ViewportWidth  = mViewportWidth;
+	inputs.ViewportHeight = mViewportHeight;
+	inputs.ScenePixels[0] = inputs.AreaPixels[0] = static_cast<float>(target.Width());
+	inputs.ScenePixels[1] = inputs.AreaPixels[1] = static_cast<float>(target.Height());
+
+	// Polygons leave the area constants as full-screen (on the GPU they keep whatever was last set)
+	if (pass.Mode == PostProcessMode::Area)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			inputs.AreaTopLeft[i] = mPlacement.AreaTopLeft[i];
+			inputs.AreaSize[i]    = mPlacement.AreaSize[i];
+			inputs.AreaPixels[i]  = mPlacement.AreaSize[i] * inputs.ScenePixels[i];
+		}
+	}
+}
+
+
+// Shade the pixel and write it to the target, blending when drawing an area. The position is in pixels of the target
+void CpuPostProcessBackend::WritePixel(const CpuEffectInputs& inputs, const PostProcessPass& pass, Image& target,
+                                       int x, int y, float areaU, float areaV)
+{
+	CpuEffectPixel pixel = { target.U(x), target.V(y), areaU, areaV };
+	StorePixel(pass, target, x, y, ShadeEffectPixel(pass.Process, inputs, pixel));
+}
+
+// Write a shaded colour to the target as WritePixel does
+void CpuPostProcessBackend::StorePixel(const PostProcessPass& pass, Image& target, int x, int y, ColourRGBA colour)
+{
+	// Area effects fade out at the edges with alpha blending (see AreaPostProcess), the alpha written is the effect's own
+	ColourRGBA& out = target.Pixel(x, y);
+	if (pass.Mode == PostProcessMode::Area)
+	{
+		float alpha = Saturate(colour.a);
+		colour = ColourRGBA(colour.r * alpha + out.r * (1 - alpha), colour.g * alpha + out.g * (1 - alpha),
+		                    colour.b * alpha + out.b * (1 - alpha), colour.a);
+	}
+
+	if (mQuantise)  out = ColourRGBA(Quantise(colour.r), Quantise(colour.g), Quantise(colour.b), Quantise(colour.a));
+	else            out = colour;
+}
+
+
+// Shade and write the pixels from (left, top) up to (right, bottom) of the target, with area UVs running 0->1 across the given
+// rectangle. Warps work out everything depending only on the column once, then draw each row in one go. SeeingWorlds marches
+// the rays of a row in packets, and the noise effects work out the noise for a row at a time. Scanlines shades the row in one go
+void CpuPostProcessBackend::DrawPixels(const CpuEffectInputs& inputs, const PostProcessPass& pass, Image& target,
+                                       int left, int top, int right, int bottom, float areaLeft, float areaTop, float areaWidth, float areaHeight)
+{
+	if (mUvWarp && IsUvWarpEffect(pass.Process))
+	{
+		UvWarp warp;
+		std::vector<ColourRGBA> colours(std::max(right - left, 0));
+		warp.Begin(pass.Process, inputs, target, left, right - left, areaLeft, areaWidth, mSimdLevel);
+		for (int y = top; y < bottom; ++y)
+		{
+			warp.ShadeRow(target.V(y), (target.V(y) - areaTop) / areaHeight, colours.data());
+			for (int x = left; x < right; ++x)  StorePixel(pass, target, x, y, colours[x - left]);
+		}
+		return;
+	}
+
+	if (pass.Process == PostProcess::SeeingWorlds)
+	{
+		std::vector<float> sceneU(std::max(right - left, 0));
+		std::vector<ColourRGBA> colours(sceneU.size());
+		for (int x = left; x < right; ++x)  sceneU[x - left] = target.U(x);
+		for (int y = top; y < bottom; ++y)
+		{
+			MarchSeeingWorlds(sceneU.data(), target.V(y), inputs.Animation->SeeingWorldsTime, inputs.MarchIterations,
+			                  colours.data(), right - left, mSimdLevel);
+			for (int x = left; x < right; ++x)  StorePixel(pass, target, x, y, colours[x - left]);
+		}
+		return;
+	}
+
+	if (pass.Process == PostProcess::Scanlines)
+	{
+		// The flicker is the same for the whole frame and the weights for the whole row. The pixels the point sampler reads for
+		// the row are gathered first, unless they are the same row of the scene. The noise is for the pixel's position in the
+		// whole target, the target may be a window onto part of it
+		const Image& scene = *inputs.Sources[0];
+		const int count = std::max(right - left, 0);
+		const bool sceneRows = scene.FullWidth() == target.FullWidth() && scene.FullHeight() == target.FullHeight() &&
+		                       target.OriginX() + left >= scene.OriginX() && target.OriginX() + right <= scene.OriginX() + scene.Width() &&
+		                       target.OriginY() + top >= scene.OriginY() && target.OriginY() + bottom <= scene.OriginY() + scene.Height();
+		const float flicker = ScanlinesFlicker(inputs.Animation->HueLevel);
+		std::vector<float> noise(count), greys(count);
+		std::vector<ColourRGBA> colours(sceneRows ? 0 : count);
+		for (int y = top; y < bottom; ++y)
+		{
+			const ColourRGBA* sceneRow;
+			if (sceneRows)
+			{
+				sceneRow = scene.Row(target.OriginY() + y - scene.OriginY()) + (target.OriginX() + left - scene.OriginX());
+			}
+			else
+			{
+				for (int x = left; x < right; ++x)  colours[x - left] = scene.SamplePoint(target.U(x), target.V(y));
+				sceneRow = colours.data();
+			}
+			PixelNoiseRow(target.OriginX() + left, target.OriginY() + y, count, inputs.NoiseKey, noise.data(), mSimdLevel);
+			ScanlinesRow(sceneRow, noise.data(), count, ScanlineRowWeights(target.V(y), inputs.ViewportHeight), flicker,
+			             greys.data(), mSimdLevel);
+			for (int x = left; x < right; ++x)
+			{
+				float grey = greys[x - left];
+				StorePixel(pass, target, x, y, ColourRGBA(grey, grey, grey, 1));
+			}
+		}
+		return;
+	}
+
+	if (pass.Process == PostProcess::GreyNoise)
+	{
+		// The noise is for the pixel's position in the whole target, the target may be a window onto part of it
+		std::vector<float> noise(std::max(right - left, 0));
+		float cell = EffectNoiseCell(pass.Process, inputs);
+		for (int y = top; y < bottom; ++y)
+		{
+			GrainNoiseRow(target.OriginX() + left, target.OriginY() + y, right - left, cell, inputs.NoiseKey, noise.data(), mSimdLevel);
+			float areaV = (target.V(y) - areaTop) / areaHeight;
+			for (int x = left; x < right; ++x)
+			{
+				CpuEffectPixel pixel = { target.U(x), target.V(y), (target.U(x) - areaLeft) / areaWidth, areaV };
+				StorePixel(pass, target, x, y, ShadeNoisePixel(pass.Process, inputs, pixel, noise[x - left]));
+			}
+		}
+		return;
+	}
+
+	for (int y = top; y < bottom; ++y)
+	{
+		float areaV = (target.V(y) - areaTop) / areaHeight;
+		for (int x = left; x < right; ++x)
+		{
+			WritePixel(inputs, pass, target, x, y, (target.U(x) - areaLeft) / areaWidth, areaV);
+		}
+	}
+}
+
+
+// Draw the pixels whose centres fall within a rectangle given in 0->1 screen coordinates. Area UVs run 0->1 across it
+double CpuPostProcessBackend::DrawRectangle(const PostProcessPass& pass, Image& target, float left, float top, float width, float height)
+{
+	if (width <= 0 || height <= 0)  return 0;
+
+	const PixelRectangle pixels = RectanglePixels(target, left, top, width, height);
+	const int minX = pixels.Left, minY = pixels.Top, maxX = pixels.Right, maxY = pixels.Bottom;
+
+	if (pass.Process == PostProcess::Burn && mUseBurnBands)
+	{
+		DrawBurnBands(pass, target, minX, minY, maxX, maxY, left, top, width, height);
+	}
+	else
+	{
+		ForEachTile(minX, minY, maxX, maxY, [&](int tileLeft, int tileTop, int tileRight, int tileBottom)
+		{
+			DrawPixels(mInputs, pass, target, tileLeft, tileTop, tileRight, tileBottom, left, top, width, height);
+		});
+	}
+	return pixels.Pixels();
+}
+
+
+// The pixels whose centres fall within a rectangle given in 0->1 coordinates
+CpuPostProcessBackend::PixelRectangle CpuPostProcessBackend::RectanglePixels(const Image& target, float left, float top, float width, float height)
+{
+	// Pixel centres from the left/top edge up to but not including the right/bottom edge, as the GPU's fill rules
+	PixelRectangle pixels;
+	pixels.Left   = std::max(static_cast<int>(std::ceil(left * target.Width() - 0.5f)), 0);
+	pixels.Top    = std::max(static_cast<int>(std::ceil(top * target.Height() - 0.5f)), 0);
+	pixels.Right  = std::min(static_cast<int>(std::ceil((left + width)  * target.Width()  - 0.5f)), target.Width());
+	pixels.Bottom = std::min(static_cast<int>(std::ceil((top  + height) * target.Height() - 0.5f)), target.Height());
+	return pixels;
+}
+
+
+// The pixels around a polygon from its four clip space points, none if a point is behind the camera
+CpuPostProcessBackend::PixelRectangle CpuPostProcessBackend::PolygonPixels(const Image& target, const float* points)
+{
+	float minX = static_cast<float>(target.Width()),  maxX = 0;
+	float minY = static_cast<float>(target.Height()), maxY = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		const float* point = points + i * 4;
+		if (point[3] <= 0)  return { 0, 0, 0, 0 };
+		float inverseW = 1 / point[3];
+		float screenX = (point[0] * inverseW + 1) * 0.5f * target.Width();
+		float screenY = (1 - point[1] * inverseW) * 0.5f * target.Height();
+		minX = std::min(minX, screenX);  maxX = std::max(maxX, screenX);
+		minY = std::min(minY, screenY);  maxY = std::max(maxY, screenY);
+	}
+
+	PixelRectangle pixels;
+	pixels.Left   = std::max(static_cast<int>(std::floor(minX)), 0);
+	pixels.Top    = std::max(static_cast<int>(std::floor(minY)), 0);
+	pixels.Right  = std::min(static_cast<int>(std::ceil(maxX)), target.Width());
+	pixels.Bottom = std::min(static_cast<int>(std::ceil(maxY)), target.Height());
+	return pixels;
+}
+
+
+// Fill in mRegions with the pixels around each area or polygon of the pass, as drawn to the given target
+void CpuPostProcessBackend::PlaceRegions(const PostProcessPass& pass, const Image& target)
+{
+	mRegions.clear();
+	if (pass.Mode == PostProcessMode::Fullscreen)
+	{
+		mRegions.push_back({ 0, 0, target.Width(), target.Height() });
+	}
+	else if (pass.Mode == PostProcessMode::Area)
+	{
+		if (mPlacement.AreaSize[0] <= 0 || mPlacement.AreaSize[1] <= 0)  return;
+		mRegions.push_back(RectanglePixels(target, mPlacement.AreaTopLeft[0], mPlacement.AreaTopLeft[1], mPlacement.AreaSize[0], mPlacement.AreaSize[1]));
+	}
+	else
+	{
+		for (size_t point = 0; point + 16 <= mPlacement.PolygonPoints.size(); point += 16)
+		{
+			mRegions.push_back(PolygonPixels(target, &mPlacement.PolygonPoints[point]));
+		}
+	}
+
+	// Regions off the target are left out
+	mRegions.erase(std::remove_if(mRegions.begin(), mRegions.end(), [](const PixelRectangle& region) { return region.Pixels() <= 0; }),
+	               mRegions.end());
+}
+
+
+// Burn from the area's cached burn map samples. Blocks of pixels all burnt or all above the band are the cached alpha over black or
+// the scene, and only pixels in the band are shaded in full (see BurnBands.h)
+void CpuPostProcessBackend::DrawBurnBands(const PostProcessPass& pass, Image& target, int left, int top, int right, int bottom,
+                                          float areaLeft, float areaTop, float areaWidth, float areaHeight)
+{
+	if (right <= left || bottom <= top)  return;
+
+	const BurnBands& bands = mBurnBands.Get(mInputs, target, left, top, right, bottom, areaLeft, areaTop, areaWidth, areaHeight,
+	                                        mTaskPool.get());
+	const Image& scene = *mInputs.Sources[0];
+	const float burnHeight = mInputs.Animation->BurnHeight;
+	const float glowHeight = burnHeight + BURN_GLOW_AMOUNT;
+
+	// Where the scene is the size of the target, the pixel SamplePoint reads at a pixel's centre is the one in the same place
+	const bool sceneRows = scene.Width() == target.Width() && scene.Height() == target.Height() &&
+	                       scene.FullWidth() == scene.Width() && scene.FullHeight() == scene.Height() &&
+	                       target.FullWidth() == target.Width() && target.FullHeight() == target.Height();
+	auto scenePixel = [&](int x, int y) { return sceneRows ? scene.Row(y)[x] : scene.SamplePoint(target.U(x), target.V(y)); };
+
+	ForEachTile(left, top, right, bottom, [&](int tileLeft, int tileTop, int tileRight, int tileBottom)
+	{
+		for (int y = tileTop; y < tileBottom; ++y)
+		{
+			const BurnBands::Texel* texels = bands.Row(y);
+			const BurnBands::Block* blocks = bands.RowBlocks(y);
+			for (int x = tileLeft; x < tileRight; )
+			{
+				// The part of the block within the tile
+				const int column = x - bands.Left();
+				const BurnBands::Block& block = blocks[column / BURN_BLOCK_PIXELS];
+				const int end = std::min(x + BURN_BLOCK_PIXELS - column % BURN_BLOCK_PIXELS, tileRight);
+
+				if (block.MaxHeight <= burnHeight && block.Opaque)
+				{
+					// Black with an alpha of 1 blends to black whatever was there
+					std::fill(&target.Pixel(x, y), &target.Pixel(x, y) + (end - x), ColourRGBA(0, 0, 0, 1));
+				}
+				else if (block.MaxHeight <= burnHeight)
+				{
+					for (; x < end; ++x)  StorePixel(pass, target, x, y, ColourRGBA(0, 0, 0, texels[x - bands.Left()].Alpha));
+				}
+				else if (block.MinHeight >= glowHeight)
+				{
+					for (; x < end; ++x)
+					{
+						ColourRGBA colour = scenePixel(x, y);
+						colour.a = texels[x - bands.Left()].Alpha;
+						StorePixel(pass, target, x, y, colour);
+					}
+				}
+				else
+				{
+					// The band crosses the block
+					for (; x < end; ++x)
+					{
+						const BurnBands::Texel& texel = texels[x - bands.Left()];
+						ColourRGBA colour;
+						if (texel.Height <= burnHeight)
+						{
+							colour = ColourRGBA(0, 0, 0, texel.Alpha);
+						}
+						else if (texel.Height >= glowHeight)
+						{
+							colour = scenePixel(x, y);
+							colour.a = texel.Alpha;
+						}
+						else
+						{
+							CpuEffectPixel pixel = { target.U(x), target.V(y), (target.U(x) - areaLeft) / areaWidth, (target.V(y) - areaTop) / areaHeight };
+							colour = ShadeBurnPixel(mInputs, pixel, ColourRGBA(texel.Height, texel.Green, texel.Blue));
+						}
+						StorePixel(pass, target, x, y, colour);
+					}
+				}
+				x = end;
+			}
+		}
+	});
+}
+
+
+// Full-screen blurs whose source is the size of the target are drawn with the vectorised blur rather than pixel by pixel. Each
+// tap must then step one pixel of the source, so the viewport must divide exactly by the pass's downscale
+bool CpuPostProcessBackend::UsesSeparableBlur(const PostProcessPass& pass, const Image& target) const
+{
+	if (pass.Mode != PostProcessMode::Fullscreen || (pass.Process != PostProcess::Blur && pass.Process != PostProcess::SecondBlur))  return false;
+
+	const Image& source = TargetImage(pass.Sources[0]);
+	const int downscale = std::max(mViewportWidth / target.Width(), 1);
+	return &source != &target && source.Width() == target.Width() && source.Height() == target.Height() &&
+	       target.Width() * downscale == mViewportWidth && target.Height() * downscale == mViewportHeight;
+}
+
+double CpuPostProcessBackend::DrawSeparableBlur(const PostProcessPass& pass, Image& target)
+{
+	const Image& source = TargetImage(pass.Sources[0]);
+	const GaussianKernel& kernel = *mInputs.BlurKernel;
+	const bool horizontal = (pass.Process == PostProcess::SecondBlur);
+	if (kernel.Radius > mRecursiveBlurRadius && RecursiveGaussianFits(kernel))
+	{
+		RecursiveBlurImage(source, target, MakeRecursiveGaussian(kernel), horizontal, mSimdLevel, mTaskPool.get());
+	}
+	else
+	{
+		SeparableBlurImage(source, target, kernel, horizontal, mSimdLevel, mTaskPool.get());
+	}
+
+	// The shaders write the alpha of the soft circle (with a hard edge), and the target rounds to 8 bits
+	ForEachTile(0, 0, target.Width(), target.Height(), [&](int tileLeft, int tileTop, int tileRight, int tileBottom)
+	{
+		for (int y = tileTop; y < tileBottom; ++y)
+		{
+			for (int x = tileLeft; x < tileRight; ++x)
+			{
+				ColourRGBA& pixel = target.Pixel(x, y);
+				pixel.a = SoftCircleAlpha(target.U(x), target.V(y), 0);
+				if (mQuantise)  pixel = ColourRGBA(Quantise(pixel.r), Quantise(pixel.g), Quantise(pixel.b), Quantise(pixel.a));
+			}
+		}
+	});
+	return static_cast<double>(target.Width()) * target.Height();
+}
+
+
+// Draw one polygon from its four clip space points as a triangle strip. Scene UVs are the pixel's screen position (noperspective
+// in the shader), area UVs are interpolated with perspective correction. Polygons with a point behind the camera are clipped by the
+// GPU, they are skipped here
+double CpuPostProcessBackend::DrawPolygon(const PostProcessPass& pass, Image& target, const float* points)
+{
+	// Points in target pixels
+	float screenX[4], screenY[4], inverseW[4];
+	float minX = static_cast<float>(target.Width()),  maxX = 0;
+	float minY = static_cast<float>(target.Height()), maxY = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		const float* point = points + i * 4;
+		if (point[3] <= 0)  return 0;
+		inverseW[i] = 1 / point[3];
+		screenX[i] = (point[0] * inverseW[i] + 1) * 0.5f * target.Width();
+		screenY[i] = (1 - point[1] * inverseW[i]) * 0.5f * target.Height();
+		minX = std::min(minX, screenX[i]);  maxX = std::max(maxX, screenX[i]);
+		minY = std::min(minY, screenY[i]);  maxY = std::max(maxY, screenY[i]);
+	}
+
+	// Textures read with area UVs choose their mip-maps from the polygon's size on screen
+	mInputs.AreaPixels[0] = maxX - minX;
+	mInputs.AreaPixels[1] = maxY - minY;
+
+	int startX = std::max(static_cast<int>(std::floor(minX)), 0);
+	int startY = std::max(static_cast<int>(std::floor(minY)), 0);
+	int endX   = std::min(static_cast<int>(std::ceil(maxX)), target.Width());
+	int endY   = std::min(static_cast<int>(std::ceil(maxY)), target.Height());
+
+	// The strip's two triangles share the edge from point 1 to point 2, pixels exactly on it only belong to the first
+	const int triangles[2][3] = { { 0, 1, 2 }, { 2, 1, 3 } };
+	std::atomic<long long> pixels(0);
+	ForEachTile(startX, startY, endX, endY, [&](int tileLeft, int tileTop, int tileRight, int tileBottom)
+	{
+		long long tilePixels = 0;
+		for (int t = 0; t < 2; ++t)
+		{
+			const int a = triangles[t][0], b = triangles[t][1], c = triangles[t][2];
+			float area = (screenX[b] - screenX[a]) * (screenY[c] - screenY[a]) - (screenY[b] - screenY[a]) * (screenX[c] - screenX[a]);
+			if (area == 0)  continue;
+
+			for (int y = tileTop; y < tileBottom; ++y)
+			{
+				float py = y + 0.5f;
+				for (int x = tileLeft; x < tileRight; ++x)
+				{
+					// Barycentric weights from the edge functions, either winding is drawn (culling is off)
+					float px = x + 0.5f;
+					float wa = ((screenX[c] - screenX[b]) * (py - screenY[b]) - (screenY[c] - screenY[b]) * (px - screenX[b])) / area;
+					float wb = ((screenX[a] - screenX[c]) * (py - screenY[c]) - (screenY[a] - screenY[c]) * (px - screenX[c])) / area;
+					float wc = 1 - wa - wb;
+					if (wa < 0 || wb < 0 || wc < 0)  continue;
+					if (t == 1 && wb + wa >= 1)  continue; // On the shared edge (wc is 0)
+
+					float pa = wa * inverseW[a], pb = wb * inverseW[b], pc = wc * inverseW[c];
+					float sum = pa + pb + pc;
+					float areaU = (pa * PolygonUVs[a][0] + pb * PolygonUVs[b][0] + pc * PolygonUVs[c][0]) / sum;
+					float areaV = (pa * PolygonUVs[a][1] + pb * PolygonUVs[b][1] + pc * PolygonUVs[c][1]) / sum;
+					WritePixel(mInputs, pass, target, x, y, areaU, areaV);
+					++tilePixels;
+				}
+			}
+		}
+		pixels += tilePixels;
+	});
+	return static_cast<double>(pixels);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tiles
+//--------------------------------------------------------------------------------------
+
+// Call draw(left, top, right, bottom) for each tile of the given pixel rectangle, on the pool's threads if there is one
+void CpuPostProcessBackend::ForEachTile(int left, int top, int right, int bottom, const std::function<void(int, int, int, int)>& draw)
+{
+	if (right <= left || bottom <= top)  return;
+
+	const int across = (right - left + mTileWidth - 1) / mTileWidth;
+	const int down   = (bottom - top + mTileHeight - 1) / mTileHeight;
+	auto drawTile = [&](int tile)
+	{
+		int tileLeft = left + (tile % across) * mTileWidth;
+		int tileTop  = top  + (tile / across) * mTileHeight;
+		draw(tileLeft, tileTop, std::min(tileLeft + mTileWidth, right), std::min(tileTop + mTileHeight, bottom));
+	};
+
+	if (mTaskPool)  mTaskPool->ParallelFor(across * down, drawTile);
+	else            for (int tile = 0; tile < across * down; ++tile)  drawTile(tile);
+}
+
+
+// Number of passes from the given one in the compiled graph that can be drawn together tile by tile, 1 if none can join it.
+// The run is full-screen passes drawing straight to their targets, each after the first reading only the one before. All
+// targets are the same size, and none is an image the first pass reads (other tiles may still be reading it). The borders
+// are drawn more than once, so the run stops before they add up to a quarter of the tile - the effects are costly enough
+// that drawing more pixels soon loses more than keeping them in cache saves
+int CpuPostProcessBackend::FusablePassCount(const PostProcessGraph& graph, int first)
+{
+	const std::vector<PostProcessPass>& passes = mCompiled->Passes;
+	auto drawnStraight = [](const PostProcessPass& pass)
+	{
+		return pass.Mode == PostProcessMode::Fullscreen && pass.Scratch < 0 && !pass.DrawToOutput;
+	};
+
+	const PostProcessPass& firstPass = passes[first];
+	if (!drawnStraight(firstPass) || UsesSeparableBlur(firstPass, TargetImage(firstPass.Target)))  return 1;
+	const Image& firstTarget = TargetImage(firstPass.Target);
+
+	int count = 1;
+	int totalBorderX = 0, totalBorderY = 0;
+	CpuEffectInputs inputs;
+	for (int next = first + 1; next < static_cast<int>(passes.size()); ++next, ++count)
+	{
+		const PostProcessPass& pass = passes[next];
+		if (!drawnStraight(pass) || pass.InputCount != 1 || pass.Sources[0] != passes[next - 1].Target)  break;
+
+		const Image& target = TargetImage(pass.Target);
+		if (target.Width() != firstTarget.Width() || target.Height() != firstTarget.Height())  break;
+		if (UsesSeparableBlur(pass, target))  break;
+
+		bool overwritesInput = false;
+		for (int i = 0; i < firstPass.InputCount; ++i)  overwritesInput |= (pass.Target == firstPass.Sources[i]);
+		if (overwritesInput)  break;
+
+		int borderX, borderY;
+		PrepareInputs(graph, pass, target, inputs);
+		if (!EffectFootprint(pass.Process, inputs, target.Width(), target.Height(), borderX, borderY))  break;
+		totalBorderX += borderX;
+		totalBorderY += borderY;
+		if (totalBorderX * 4 > mTileWidth || totalBorderY * 4 > mTileHeight)  break;
+	}
+	return count;
+}
+
+
+// Draw the given run of passes tile by tile. Each tile is drawn through every pass, from a window onto the previous pass's
+// result held by the tile, so the images between passes stay in cache. A pass's window is the tile plus borders wide enough
+// for what the later passes read. Only the last pass writing each target copies its tile to the target
+void CpuPostProcessBackend::DrawFusedPasses(const PostProcessGraph& graph, int first, int count)
+{
+	const std::vector<PostProcessPass>& passes = mCompiled->Passes;
+	const int width  = TargetImage(passes[first].Target).Width();
+	const int height = TargetImage(passes[first].Target).Height();
+
+	// Inputs, borders and whether each pass leaves its target's final contents
+	mFusedInputs.resize(count);
+	std::vector<int>  borderX(count, 0), borderY(count, 0);
+	std::vector<bool> lastWrite(count, true);
+	for (int i = 0; i < count; ++i)
+	{
+		const PostProcessPass& pass = passes[first + i];
+		PrepareInputs(graph, pass, TargetImage(pass.Target), mFusedInputs[i]);
+		if (i > 0)  EffectFootprint(pass.Process, mFusedInputs[i], width, height, borderX[i], borderY[i]);
+		for (int later = i + 1; later < count; ++later)  lastWrite[i] = lastWrite[i] && passes[first + later].Target != pass.Target;
+
+		CountDraw(pass.Target, static_cast<double>(width) * height);
+		if (pass.Target == OUTPUT_TARGET)  mOutputWritten = true;
+	}
+
+	ForEachTile(0, 0, width, height, [&](int tileLeft, int tileTop, int tileRight, int tileBottom)
+	{
+		// Pixels each pass draws for this tile, working back from the last pass (just the tile)
+		std::vector<int> left(count), top(count), right(count), bottom(count);
+		left[count - 1] = tileLeft;  top[count - 1] = tileTop;  right[count - 1] = tileRight;  bottom[count - 1] = tileBottom;
+		for (int i = count - 1; i > 0; --i)
+		{
+			left[i - 1]   = std::max(left[i]   - borderX[i], 0);
+			top[i - 1]    = std::max(top[i]    - borderY[i], 0);
+			right[i - 1]  = std::min(right[i]  + borderX[i], width);
+			bottom[i - 1] = std::min(bottom[i] + borderY[i], height);
+		}
+
+		Image windows[2]; // The results of the previous pass and of this one
+		for (int i = 0; i < count; ++i)
+		{
+			const PostProcessPass& pass = passes[first + i];
+			Image& target = TargetImage(pass.Target);
+			Image& window = windows[i % 2];
+
+			CpuEffectInputs inputs = mFusedInputs[i];
+			if (i > 0)  inputs.Sources[0] = &windows[(i - 1) % 2];
+
+			// The last pass draws straight to its target, the others to a window holding what the next pass reads
+			if (i == count - 1)
+			{
+				DrawPixels(inputs, pass, target, left[i], top[i], right[i], bottom[i], 0, 0, 1, 1);
+				break;
+			}
+
+			window.Resize(right[i] - left[i], bottom[i] - top[i]);
+			window.SetWindow(left[i], top[i], width, height);
+			DrawPixels(inputs, pass, window, 0, 0, window.Width(), window.Height(), 0, 0, 1, 1);
+
+			// Copy the tile itself to the target if no later pass writes over it
+			if (lastWrite[i])
+			{
+				for (int y = tileTop; y < tileBottom; ++y)
+				{
+					std::copy(window.Row(y - top[i]) + (tileLeft - left[i]), window.Row(y - top[i]) + (tileRight - left[i]), target.Row(y) + tileLeft);
+				}
+			}
+		}
+	});
+}
@@ -0,0 +1,259 @@
+//--------------------------------------------------------------------------------------
+// CPU post-processing backend
+//--------------------------------------------------------------------------------------
+// Runs a compiled chain entirely in main memory, as a reference for the Direct3D backend and so
+// chains can be run where there is no GPU (or no Windows). Each render target is an Image of the
+// same size as the one the Direct3D backend would use. Every pass is drawn the way the GPU draws it:
+// full-screen passes cover the whole target, area passes a rectangle alpha blended over it and
+// polygon passes are rasterised from their four projected points as a triangle strip - with the
+// same sceneUV/areaUV for each pixel, then shaded by the CPU version of the effect (CpuEffects.h).
+//
+// The scene is given as an image rather than rendered and there is no depth buffer, so area effects
+// aren't hidden behind nearer geometry. Where areas and polygons go is decided by a placement
+// function, as only the app knows where its models and camera are.
+//
+// Passes can be drawn on several threads (SetThreadCount). Each pass is split into tiles shared out by
+// a work-stealing pool (TaskPool.h). A run of full-screen passes, each reading only the one before, is
+// also fused: each tile goes through the whole run before the next tile starts, so the images between
+// the passes never leave the cache. A tile of an earlier pass is drawn with borders as wide as the
+// later passes read around a pixel (EffectFootprint in CpuEffects.h) - e.g. the blur radius - so a
+// tile never needs pixels another thread is drawing. Pixels in the borders are drawn by both tiles
+// they fall in. Results are the same whatever the threads and tiles.
+//
+// Full-screen blurs reading an image the size of their target are drawn a row at a time with vector
+// instructions (SeparableBlur.h) rather than pixel by pixel. Those wider than a given radius use the
+// recursive approximation (RecursiveGaussian.h) instead, which costs the same whatever the radius.
+// The warps - Distort, Spiral, Underwater and HeatHaze - are drawn a row at a time too (UvWarp.h), and
+// SeeingWorlds marches a packet of rays side by side (SeeingWorlds.h). Burn areas keep their samples of
+// the burn map from frame to frame and only shade the band of pixels that is burning (BurnBands.h).
+
+#ifndef _CPU_POST_PROCESS_BACKEND_H_INCLUDED_
+#define _CPU_POST_PROCESS_BACKEND_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+#include "CpuEffects.h"
+#include "Bloom.h"
+#include "ColourLut.h"
+#include "VariableBlur.h"
+#include "UvWarp.h"
+#include "BurnBands.h"
+#include "GaussianKernel.h"
+#include "Image.h"
+#include "TaskPool.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+// Where an area or polygon pass is drawn on screen
+struct PostProcessPlacement
+{
+	// Area passes: top-left and size of the area in 0->1 screen coordinates, as the gArea2DTopLeft/Size shader constants
+	float AreaTopLeft[2] = { 0.25f, 0.25f };
+	float AreaSize[2]    = { 0.5f, 0.5f };
+
+	// Polygon passes: four clip space points (x, y, z, w) for each polygon, drawn as a triangle strip - as the
+	// gPolygonPoints shader constants. Area UVs are (0,0) (0,1) (1,0) (1,1) at the four points
+	std::vector<float> PolygonPoints;
+};
+
+// Function placing each area or polygon pass
+using PostProcessPlacer = std::function<PostProcessPlacement(const PostProcessGraph& graph, const PostProcessPass& pass)>;
+
+// Default placement: areas in the middle half of the screen, a polygon pass (or each model of a batch) as a square in the middle
+PostProcessPlacement DefaultPostProcessPlacement(const PostProcessGraph& graph, const PostProcessPass& pass);
+
+
+// Radius above which full-screen blurs use the recursive approximation by default. Around here it starts to be quicker
+// than the vectorised kernel (with AVX2), and its lead grows with the radius
+const int DEFAULT_RECURSIVE_BLUR_RADIUS = 24;
+
+
+class CpuPostProcessBackend : public PostProcessBackend
+{
+public:
+	CpuPostProcessBackend(int viewportWidth, int viewportHeight);
+
+	//-------------------------------------
+	// Setup
+	//-------------------------------------
+
+	// The rendered scene the chain starts from, scaled to the viewport if it isn't already that size
+	void SetScene(const Image& scene);
+
+	// Textures read by Burn and Distort. Missing textures read as mid-grey
+	void SetBurnMap(const Image& image)     { mBurnMap.Set(image);  mBurnBands.Clear(); }
+	void SetDistortMap(const Image& image)  { mDistortMap.Set(image); }
+
+	// Animated values the effects read, the app's own values can be copied in each frame to match the GPU
+	void SetAnimation(const PostProcessAnimation& animation)  { mAnimation = animation; }
+	const PostProcessAnimation& Animation() const  { return mAnimation; }
+
+	void SetPlacer(const PostProcessPlacer& placer)  { mPlacer = placer; }
+
+	// Round every pixel written to 8 bits as R8G8B8A8_UNORM render targets do (the default). Switch off to see the full
+	// precision result, e.g. to tell rounding from real differences when comparing with the GPU
+	void SetQuantise(bool quantise)  { mQuantise = quantise; }
+
+	// Threads to draw with, including the calling thread. 1 (the default) draws everything on the calling thread, 0 uses
+	// one thread for each core
+	void SetThreadCount(int threadCount);
+	int  ThreadCount() const  { return mTaskPool ? mTaskPool->ThreadCount() : 1; }
+
+	// Size in pixels of the tiles passes are split into. Small enough that a tile of each image in a fused run of passes
+	// fits in the L2 cache, big enough that the borders aren't much extra work
+	void SetTileSize(int width, int height)  { mTileWidth = std::max(width, 1);  mTileHeight = std::max(height, 1); }
+
+	// Draw runs of full-screen passes together tile by tile (the default), or each pass over the whole target in turn
+	void SetFusion(bool fuse)  { mFusion = fuse; }
+
+	// Instruction set for the vectorised blur, warps and ray-marcher, the best the processor has by default. Scalar to compare against
+	void SetSimdLevel(SimdLevel level)  { mSimdLevel = level; }
+
+	// Full-screen blurs with a larger radius than this use the recursive approximation, where it is close to the kernel
+	// (RecursiveGaussianFits). A negative radius uses it wherever it fits, a very large one never
+	void SetRecursiveBlurRadius(int radius)  { mRecursiveBlurRadius = radius; }
+
+	// Bake runs of colour effects with a Sigmoid into lookup tables of this size (see ColourLut.h), rebuilt when their settings
+	// change. 0 (the default) runs them exactly as the GPU does - the tables are quicker but only close
+	void SetColourLutSize(int size)  { mColourLutSize = std::max(size, 0); }
+
+	// Draw the warp effects a row at a time (the default, see UvWarp.h), or pixel by pixel as the other effects
+	void SetUvWarp(bool rows)  { mUvWarp = rows; }
+
+	// Most steps SeeingWorlds marches each ray, SEEING_WORLDS_ITERATIONS (the shader's) by default. Fewer is quicker, but
+	// rays that needed more stop short
+	void SetSeeingWorldsIterations(int iterations)  { mSeeingWorldsIterations = std::max(iterations, 1); }
+
+	// Draw Burn areas from their cached burn map samples, shading only the band that is burning (the default, see BurnBands.h),
+	// or pixel by pixel as the other effects
+	void SetBurnBands(bool bands)  { mUseBurnBands = bands; }
+
+
+	//-------------------------------------
+	// Running
+	//-------------------------------------
+
+	void BeginChain(const CompiledPostProcessGraph& compiled) override;
+	void EndChain() override;
+	void RunPass(const PostProcessGraph& graph, const PostProcessPass& pass) override;
+
+	// Result of the last chain run, the scene unchanged if the chain was empty
+	const Image& Output() const  { return mOutput; }
+
+	// Render target contents after the last chain run, sized for their downscale
+	int          TargetCount() const       { return static_cast<int>(mTargets.size()); }
+	const Image& Target(int target) const  { return mTargets[target]; }
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	Image&       TargetImage(int target)        { return (target == OUTPUT_TARGET) ? mOutput : mTargets[target]; }
+	const Image& TargetImage(int target) const  { return (target == OUTPUT_TARGET) ? mOutput : mTargets[target]; }
+
+	// Draw a pass from the images it reads to the given image, returns the number of pixels drawn
+	double DrawPass(const PostProcessGraph& graph, const PostProcessPass& pass, Image& target);
+
+	// Set up the shader inputs for a pass drawn to an image of the given size
+	void PrepareInputs(const PostProcessGraph& graph, const PostProcessPass& pass, const Image& target, CpuEffectInputs& inputs);
+
+	// Shade the pixel and write it to the target, blending when drawing an area. The position is in pixels of the target
+	void WritePixel(const CpuEffectInputs& inputs, const PostProcessPass& pass, Image& target, int x, int y, float areaU, float areaV);
+
+	// Write a shaded colour to the target as WritePixel does
+	void StorePixel(const PostProcessPass& pass, Image& target, int x, int y, ColourRGBA colour);
+
+	// Shade and write the pixels from (left, top) up to (right, bottom) of the target, with area UVs running 0->1 across the
+	// rectangle given in 0->1 coordinates of the whole target. Warps and SeeingWorlds are drawn a row at a time
+	void DrawPixels(const CpuEffectInputs& inputs, const PostProcessPass& pass, Image& target, int left, int top, int right, int bottom,
+	                float areaLeft, float areaTop, float areaWidth, float areaHeight);
+
+	double DrawRectangle(const PostProcessPass& pass, Image& target, float left, float top, float width, float height);
+
+	// Pixels from (Left, Top) up to (Right, Bottom) of a target
+	struct PixelRectangle
+	{
+		int Left, Top, Right, Bottom;
+
+		double Pixels() const  { return static_cast<double>(std::max(Right - Left, 0)) * std::max(Bottom - Top, 0); }
+	};
+
+	// The pixels whose centres fall within a rectangle given in 0->1 coordinates, and the pixels around a polygon from its four
+	// clip space points (none if a point is behind the camera) - those DrawRectangle and DrawPolygon can touch
+	static PixelRectangle RectanglePixels(const Image& target, float left, float top, float width, float height);
+	static PixelRectangle PolygonPixels(const Image& target, const float* points);
+
+	// Fill in mRegions with the pixels around each area or polygon of the pass, as drawn to the given target
+	void PlaceRegions(const PostProcessPass& pass, const Image& target);
+
+	// Burn over the pixels from (left, top) up to (right, bottom) from the area's cached burn map samples, as DrawPixels would
+	void DrawBurnBands(const PostProcessPass& pass, Image& target, int left, int top, int right, int bottom,
+	                   float areaLeft, float areaTop, float areaWidth, float areaHeight);
+
+	// Full-screen blurs whose source is the size of the target are drawn with the vectorised or recursive blur rather than
+	// pixel by pixel
+	bool   UsesSeparableBlur(const PostProcessPass& pass, const Image& target) const;
+	double DrawSeparableBlur(const PostProcessPass& pass, Image& target);
+	double DrawPolygon(const PostProcessPass& pass, Image& target, const float* points);
+
+	// Number of passes from the given one in the compiled graph that can be drawn together tile by tile, 1 if none can join it
+	int FusablePassCount(const PostProcessGraph& graph, int first);
+
+	// Draw the given run of passes tile by tile
+	void DrawFusedPasses(const PostProcessGraph& graph, int first, int count);
+
+	// Call draw(left, top, right, bottom) for each tile of the given pixel rectangle, on the pool's threads if there is one
+	void ForEachTile(int left, int top, int right, int bottom, const std::function<void(int, int, int, int)>& draw);
+
+	int mViewportWidth;
+	int mViewportHeight;
+
+	Image              mScene;
+	Image              mOutput;
+	std::vector<Image> mTargets;
+	bool               mOutputWritten = false;
+
+	MipMappedImage       mBurnMap;
+	MipMappedImage       mDistortMap;
+	PostProcessAnimation mAnimation;
+	PostProcessPlacer    mPlacer = DefaultPostProcessPlacement;
+	bool                 mQuantise = true;
+
+	// Threads and tiles
+	std::unique_ptr<TaskPool> mTaskPool;
+	int                       mTileWidth  = 128;
+	int                       mTileHeight = 64;
+	bool                      mFusion = true;
+	SimdLevel                 mSimdLevel = BestSimdLevel();
+	int                       mRecursiveBlurRadius = DEFAULT_RECURSIVE_BLUR_RADIUS;
+	int                       mColourLutSize = 0;
+	bool                      mUvWarp = true;
+	int                       mSeeingWorldsIterations = SEEING_WORLDS_ITERATIONS;
+	bool                      mUseBurnBands = true;
+
+	// Working state for the pass being drawn
+	CpuEffectInputs      mInputs;
+	PostProcessPlacement mPlacement;
+	std::vector<PixelRectangle> mRegions;
+	BloomPyramid         mBloomPyramid;
+	SummedAreaTable      mSummedAreaTable;
+	Image                mPixelationBlocks;
+	GaussianKernelCache  mBlurKernels;
+	ColourLutCache       mColourLuts;
+	SeeingWorldsTaps     mSeeingWorldsTaps;
+	BurnBandsCache       mBurnBands;
+
+	// The chain being run. Passes up to mFusedUntil have already been drawn as part of a fused run
+	const CompiledPostProcessGraph* mCompiled = nullptr;
+	int                             mNextPass = 0;
+	int                             mFusedUntil = -1;
+	std::vector<CpuEffectInputs>    mFusedInputs;
+};
+
+
+#endif //_CPU_POST_PROCESS_BACKEND_H_INCLUDED_
@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------------------
+// Gaussian blur kernels
+//--------------------------------------------------------------------------------------
+
+#include "GaussianKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+//--------------------------------------------------------------------------------------
+// Kernels
+//--------------------------------------------------------------------------------------
+
+// Work out the kernel for the given radius and sigma (both clamped to sensible minimums)
+GaussianKernel MakeGaussianKernel(int radius, float sigma)
+{
+	GaussianKernel kernel;
+	kernel.Radius = std::max(radius, 0);
+	kernel.Sigma  = std::max(sigma, 0.01f);
+
+	// Discrete weights, normalised over both sides of the kernel
+	const double twoSigmaSq = 2.0 * kernel.Sigma * kernel.Sigma;
+	std::vector<double> weights(kernel.Radius + 1);
+	double sum = 0;
+	for (int x = 0; x <= kernel.Radius; ++x)
+	{
+		weights[x] = std::exp(-(x * x) / twoSigmaSq);
+		sum += (x == 0) ? weights[x] : 2 * weights[x];
+	}
+	kernel.Weights.resize(kernel.Radius + 1);
+	for (int x = 0; x <= kernel.Radius; ++x)
+	{
+		kernel.Weights[x] = static_cast<float>(weights[x] / sum);
+	}
+
+	// Centre on its own, then pixels 1&2, 3&4... merged into one tap each. A linear sample at offset
+	// o1 + w2/(w1+w2) returns (w1*p1 + w2*p2)/(w1+w2), so weighting it by w1+w2 gives the same sum.
+	// An odd pixel left at the edge is a tap of its own at a whole pixel offset
+	kernel.TapOffsets.push_back(0.0f);
+	kernel.TapWeights.push_back(kernel.Weights[0]);
+	for (int x = 1; x <= kernel.Radius; x += 2)
+	{
+		double w1 = weights[x] / sum;
+		double w2 = (x + 1 <= kernel.Radius) ? weights[x + 1] / sum : 0.0;
+		double w  = w1 + w2;
+		kernel.TapOffsets.push_back(static_cast<float>((w > 0) ? x + w2 / w : x));
+		kernel.TapWeights.push_back(static_cast<float>(w));
+	}
+
+	return kernel;
+}
+
+
+// Return the kernel for the given radius and sigma, working it out on first use
+const GaussianKernel& GaussianKernelCache::Get(int radius, float sigma)
+{
+	auto key = std::make_pair(radius, sigma);
+	auto found = mKernels.find(key);
+	if (found == mKernels.end())
+	{
+		found = mKernels.emplace(key, MakeGaussianKernel(radius, sigma)).first;
+	}
+	return found->second;
+}
+
+
+//--------------------------------------------------------------------------------------
+// CPU blur
+//--------------------------------------------------------------------------------------
+
+// Blur source in one direction, writing to target (resized to match). Edges are clamped like the clamp sampler
+// the blur shaders use. With mergedTaps the merged taps are read with linear filtering as the GPU does,
+// otherwise every pixel of the discrete kernel is read - the results should match to within rounding
+void GaussianBlurImage(const Image& source, Image& target, const GaussianKernel& kernel, bool horizontal, bool mergedTaps)
+{
+	target.Resize(source.Width(), source.Height());
+
+	// Read the source at a (possibly fractional) pixel offset along the blur direction, linearly filtered
+	auto sample = [&](int x, int y, float offset, ColourRGBA& sum, float weight)
+	{
+		int   whole = static_cast<int>(std::floor(offset));
+		float t     = offset - whole;
+		const ColourRGBA& p0 = horizontal ? source.ClampedPixel(x + whole, y)     : source.ClampedPixel(x, y + whole);
+		const ColourRGBA& p1 = horizontal ? source.ClampedPixel(x + whole + 1, y) : source.ClampedPixel(x, y + whole + 1);
+		float w0 = weight * (1 - t);
+		float w1 = weight * t;
+		sum.r += p0.r * w0 + p1.r * w1;
+		sum.g += p0.g * w0 + p1.g * w1;
+		sum.b += p0.b * w0 + p1.b * w1;
+		sum.a += p0.a * w0 + p1.a * w1;
+	};
+
+	const std::vector<float>& weights = mergedTaps ? kernel.TapWeights : kernel.Weights;
+	const int taps = static_cast<int>(weights.size());
+	for (int y = 0; y < source.Height(); ++y)
+	{
+		for (int x = 0; x < source.Width(); ++x)
+		{
+			ColourRGBA sum(0, 0, 0, 0);
+			sample(x, y, 0.0f, sum, weights[0]);
+			for (int i = 1; i < taps; ++i)
+			{
+				float offset = mergedTaps ? kernel.TapOffsets[i] : static_cast<float>(i);
+				sample(x, y,  offset, sum, weights[i]);
+				sample(x, y, -offset, sum, weights[i]);
+			}
+			target.Pixel(x, y) = sum;
+		}
+	}
+}
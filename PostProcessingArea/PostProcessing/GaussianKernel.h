@@ -0,0 +1,66 @@
+//--------------------------------------------------------------------------------------
+// Gaussian blur kernels
+//--------------------------------------------------------------------------------------
+// The blur is separable - a vertical pass then a horizontal pass, each a 1D Gaussian. With a linear
+// filtering sampler one texture sample can read two neighbouring pixels at once: sampling between them
+// at an offset chosen from their weights returns their weighted sum (scaled). So each pair of taps
+// on each side of the centre becomes one sample, roughly halving the samples per pass.
+//
+// Kernels are only worked out once for each radius and sigma and kept in a cache. The CPU blur
+// below runs either form of the kernel, so the merged taps can be checked against the discrete one
+
+#ifndef _GAUSSIAN_KERNEL_H_INCLUDED_
+#define _GAUSSIAN_KERNEL_H_INCLUDED_
+
+#include "Image.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+
+// One side of a symmetric 1D Gaussian kernel, in both forms
+struct GaussianKernel
+{
+	int   Radius; // Pixels each side of the centre
+	float Sigma;  // Standard deviation in pixels
+
+	// Discrete weight of each pixel from the centre (0) to the edge (Radius). Normalised so the
+	// whole kernel, -Radius to +Radius, adds up to 1
+	std::vector<float> Weights;
+
+	// Merged taps for a linear filtering sampler. Tap 0 is the centre pixel on its own, the others are
+	// used at +offset and -offset. Offsets are in pixels and fall between the two pixels a tap merges
+	std::vector<float> TapOffsets;
+	std::vector<float> TapWeights;
+};
+
+// Work out the kernel for the given radius and sigma (both clamped to sensible minimums)
+GaussianKernel MakeGaussianKernel(int radius, float sigma);
+
+
+// Kernels already worked out, keyed by radius and sigma
+class GaussianKernelCache
+{
+public:
+	// Return the kernel for the given radius and sigma, working it out on first use
+	const GaussianKernel& Get(int radius, float sigma);
+
+	int  Size() const  { return static_cast<int>(mKernels.size()); }
+	void Clear()       { mKernels.clear(); }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	std::map<std::pair<int, float>, GaussianKernel> mKernels;
+};
+
+
+// Blur source in one direction, writing to target (resized to match). Edges are clamped like the clamp sampler
+// the blur shaders use. With mergedTaps the merged taps are read with linear filtering as the GPU does,
+// otherwise every pixel of the discrete kernel is read - the results should match to within rounding
+void GaussianBlurImage(const Image& source, Image& target, const GaussianKernel& kernel, bool horizontal, bool mergedTaps);
+
+
+#endif //_GAUSSIAN_KERNEL_H_INCLUDED_
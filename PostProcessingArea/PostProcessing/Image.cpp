@@ -0,0 +1,195 @@
+//--------------------------------------------------------------------------------------
+// Image class, a floating point RGBA image in main memory
+//--------------------------------------------------------------------------------------
+
+#include "Image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+// Image of the given size, all pixels transparent black
+Image::Image(int width, int height)
+{
+	Resize(width, height);
+}
+
+// Change the size of the image, the content is lost
+void Image::Resize(int width, int height)
+{
+	mWidth  = width;
+	mHeight = height;
+	mPixels.assign(static_cast<size_t>(width) * height, ColourRGBA(0, 0, 0, 0));
+	SetWindow(0, 0, width, height);
+}
+
+// Make this image a window onto part of a larger one, holding only the pixels from the given origin
+void Image::SetWindow(int originX, int originY, int fullWidth, int fullHeight)
+{
+	mOriginX    = originX;
+	mOriginY    = originY;
+	mFullWidth  = fullWidth;
+	mFullHeight = fullHeight;
+}
+
+
+// Pixel with coordinates clamped to the edge of the image (like a clamp sampler)
+const ColourRGBA& Image::ClampedPixel(int x, int y) const
+{
+	x = std::min(std::max(x - mOriginX, 0), mWidth - 1);
+	y = std::min(std::max(y - mOriginY, 0), mHeight - 1);
+	return mPixels[y * mWidth + x];
+}
+
+
+// Nearest pixel to a texture coordinate (0->1), clamped at the edges - like a point clamp sampler
+const ColourRGBA& Image::SamplePoint(float u, float v) const
+{
+	return ClampedPixel(static_cast<int>(std::floor(u * mFullWidth)), static_cast<int>(std::floor(v * mFullHeight)));
+}
+
+
+// Bilinear filtered colour at a texture coordinate (0->1), clamped at the edges - like a linear clamp sampler
+ColourRGBA Image::Sample(float u, float v) const
+{
+	// Pixel centres are at half-pixel coordinates
+	float x = u * mFullWidth  - 0.5f;
+	float y = v * mFullHeight - 0.5f;
+	int   x0 = static_cast<int>(std::floor(x));
+	int   y0 = static_cast<int>(std::floor(y));
+	float tx = x - x0;
+	float ty = y - y0;
+
+	const ColourRGBA& p00 = ClampedPixel(x0,     y0);
+	const ColourRGBA& p10 = ClampedPixel(x0 + 1, y0);
+	const ColourRGBA& p01 = ClampedPixel(x0,     y0 + 1);
+	const ColourRGBA& p11 = ClampedPixel(x0 + 1, y0 + 1);
+	float w00 = (1 - tx) * (1 - ty);
+	float w10 = tx * (1 - ty);
+	float w01 = (1 - tx) * ty;
+	float w11 = tx * ty;
+	return ColourRGBA(p00.r * w00 + p10.r * w10 + p01.r * w01 + p11.r * w11,
+	                  p00.g * w00 + p10.g * w10 + p01.g * w01 + p11.g * w11,
+	                  p00.b * w00 + p10.b * w10 + p01.b * w01 + p11.b * w11,
+	                  p00.a * w00 + p10.a * w10 + p01.a * w01 + p11.a * w11);
+}
+
+
+// Bilinear filtered colour at a texture coordinate, repeating outside 0->1 - like a linear wrap sampler
+ColourRGBA Image::SampleWrapped(float u, float v) const
+{
+	float x = u * mWidth  - 0.5f;
+	float y = v * mHeight - 0.5f;
+	int   x0 = static_cast<int>(std::floor(x));
+	int   y0 = static_cast<int>(std::floor(y));
+	float tx = x - x0;
+	float ty = y - y0;
+
+	// Wrap the pixel coordinates rather than clamping them, taking care with negative values
+	auto wrap = [](int i, int size) { i %= size;  return (i < 0) ? i + size : i; };
+	int x1 = wrap(x0 + 1, mWidth);
+	int y1 = wrap(y0 + 1, mHeight);
+	x0 = wrap(x0, mWidth);
+	y0 = wrap(y0, mHeight);
+
+	const ColourRGBA& p00 = Pixel(x0, y0);
+	const ColourRGBA& p10 = Pixel(x1, y0);
+	const ColourRGBA& p01 = Pixel(x0, y1);
+	const ColourRGBA& p11 = Pixel(x1, y1);
+	float w00 = (1 - tx) * (1 - ty);
+	float w10 = tx * (1 - ty);
+	float w01 = (1 - tx) * ty;
+	float w11 = tx * ty;
+	return ColourRGBA(p00.r * w00 + p10.r * w10 + p01.r * w01 + p11.r * w11,
+	                  p00.g * w00 + p10.g * w10 + p01.g * w01 + p11.g * w11,
+	                  p00.b * w00 + p10.b * w10 + p01.b * w01 + p11.b * w11,
+	                  p00.a * w00 + p10.a * w10 + p01.a * w01 + p11.a * w11);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Comparison
+//--------------------------------------------------------------------------------------
+
+// Largest difference in any channel between two images of the same size, colour only if includeAlpha is false
+float LargestDifference(const Image& a, const Image& b, bool includeAlpha)
+{
+	float largest = 0;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		const ColourRGBA* p = a.Row(y);
+		const ColourRGBA* q = b.Row(y);
+		for (int x = 0; x < a.Width(); ++x)
+		{
+			largest = std::max({ largest, std::abs(p[x].r - q[x].r), std::abs(p[x].g - q[x].g), std::abs(p[x].b - q[x].b) });
+			if (includeAlpha)  largest = std::max(largest, std::abs(p[x].a - q[x].a));
+		}
+	}
+	return largest;
+}
+
+// True if the images are the same size with exactly the same pixels
+bool SameImage(const Image& a, const Image& b)
+{
+	if (a.Width() != b.Width() || a.Height() != b.Height())  return false;
+	for (int y = 0; y < a.Height(); ++y)
+	{
+		if (std::memcmp(a.Row(y), b.Row(y), sizeof(ColourRGBA) * a.Width()) != 0)  return false;
+	}
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Mip-mapped image
+//--------------------------------------------------------------------------------------
+
+// Copy the image to level 0 and build the other levels from it by averaging 2x2 blocks
+void MipMappedImage::Set(const Image& image)
+{
+	mLevels.clear();
+	if (image.Width() == 0 || image.Height() == 0)  return;
+
+	mLevels.push_back(image);
+	while (mLevels.back().Width() > 1 || mLevels.back().Height() > 1)
+	{
+		const Image& above = mLevels.back();
+		Image level(std::max(above.Width() / 2, 1), std::max(above.Height() / 2, 1));
+		for (int y = 0; y < level.Height(); ++y)
+		{
+			for (int x = 0; x < level.Width(); ++x)
+			{
+				const ColourRGBA& p00 = above.ClampedPixel(x * 2,     y * 2);
+				const ColourRGBA& p10 = above.ClampedPixel(x * 2 + 1, y * 2);
+				const ColourRGBA& p01 = above.ClampedPixel(x * 2,     y * 2 + 1);
+				const ColourRGBA& p11 = above.ClampedPixel(x * 2 + 1, y * 2 + 1);
+				level.Pixel(x, y) = ColourRGBA((p00.r + p10.r + p01.r + p11.r) * 0.25f, (p00.g + p10.g + p01.g + p11.g) * 0.25f,
+				                               (p00.b + p10.b + p01.b + p11.b) * 0.25f, (p00.a + p10.a + p01.a + p11.a) * 0.25f);
+			}
+		}
+		mLevels.push_back(std::move(level));
+	}
+}
+
+
+// Trilinear filtered colour at a texture coordinate, repeating outside 0->1 - like the trilinear (wrap) sampler
+ColourRGBA MipMappedImage::Sample(float u, float v, float texelsPerPixel) const
+{
+	if (mLevels.empty())  return ColourRGBA(0, 0, 0, 0);
+
+	// Blend the two mip-maps either side of the level of detail
+	float lod = (texelsPerPixel > 1) ? std::log2(texelsPerPixel) : 0.0f;
+	lod = std::min(lod, static_cast<float>(mLevels.size() - 1));
+	int   level = static_cast<int>(lod);
+	float blend = lod - level;
+
+	ColourRGBA colour = mLevels[level].SampleWrapped(u, v);
+	if (blend > 0 && level + 1 < static_cast<int>(mLevels.size()))
+	{
+		ColourRGBA next = mLevels[level + 1].SampleWrapped(u, v);
+		colour = ColourRGBA(colour.r + (next.r - colour.r) * blend, colour.g + (next.g - colour.g) * blend,
+		                    colour.b + (next.b - colour.b) * blend, colour.a + (next.a - colour.a) * blend);
+	}
+	return colour;
+}
@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------------
+// Image class, a floating point RGBA image in main memory
+//--------------------------------------------------------------------------------------
+// Used by the CPU versions of the post-processes. Pixels are stored row by row, top row first,
+// as ColourRGBA (four floats) - the same layout as a R32G32B32A32_FLOAT texture
+
+#ifndef _IMAGE_H_INCLUDED_
+#define _IMAGE_H_INCLUDED_
+
+#include "ColourRGBA.h"
+#include <algorithm>
+#include <vector>
+
+
+// Clamp a value to 0->1, as saturate does in the shaders the CPU post-processes follow
+inline float Saturate(float x)  { return std::min(std::max(x, 0.0f), 1.0f); }
+
+
+class Image
+{
+public:
+	/*-----------------------------------------------------------------------------------------
+	   Construction
+	-----------------------------------------------------------------------------------------*/
+
+	// Empty image
+	Image() {}
+
+	// Image of the given size, all pixels transparent black
+	Image(int width, int height);
+
+	// Change the size of the image, the content is lost. The image is then whole rather than a window (see below)
+	void Resize(int width, int height);
+
+	// Make this image a window onto part of a larger one, holding only the pixels from the given origin. Pixel and Row
+	// still index the pixels held, but texture coordinates (U/V and the sampling functions) are those of the larger
+	// image, with sampling clamped to the pixels held. Used to process a tile with its borders (CpuPostProcessBackend)
+	void SetWindow(int originX, int originY, int fullWidth, int fullHeight);
+
+
+	/*-----------------------------------------------------------------------------------------
+	   Access
+	-----------------------------------------------------------------------------------------*/
+
+	int Width() const   { return mWidth; }
+	int Height() const  { return mHeight; }
+
+	ColourRGBA&       Pixel(int x, int y)        { return mPixels[y * mWidth + x]; }
+	const ColourRGBA& Pixel(int x, int y) const  { return mPixels[y * mWidth + x]; }
+
+	// Pointer to the first pixel of a row, rows are Width() pixels long with no padding
+	ColourRGBA*       Row(int y)        { return &mPixels[y * mWidth]; }
+	const ColourRGBA* Row(int y) const  { return &mPixels[y * mWidth]; }
+
+	// Pixel with coordinates clamped to the edge of the image (like a clamp sampler). The coordinates are in the larger image
+	// for a window
+	const ColourRGBA& ClampedPixel(int x, int y) const;
+
+	// Nearest pixel to a texture coordinate (0->1), clamped at the edges - like a point clamp sampler
+	const ColourRGBA& SamplePoint(float u, float v) const;
+
+	// Bilinear filtered colour at a texture coordinate (0->1), clamped at the edges - like a linear clamp sampler
+	ColourRGBA Sample(float u, float v) const;
+
+	// Bilinear filtered colour at a texture coordinate, repeating outside 0->1 - like a linear wrap sampler
+	ColourRGBA SampleWrapped(float u, float v) const;
+
+	// Texture coordinate (0->1) of the centre of a pixel, as the pixel shaders see it
+	float U(int x) const  { return (x + mOriginX + 0.5f) / mFullWidth; }
+	float V(int y) const  { return (y + mOriginY + 0.5f) / mFullHeight; }
+
+	// Position of the pixels held within the larger image and its size, for code working out pixel positions itself. The
+	// origin is 0 and the size the image's own unless SetWindow is used
+	int OriginX() const     { return mOriginX; }
+	int OriginY() const     { return mOriginY; }
+	int FullWidth() const   { return mFullWidth; }
+	int FullHeight() const  { return mFullHeight; }
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	int mWidth  = 0;
+	int mHeight = 0;
+	std::vector<ColourRGBA> mPixels;
+
+	// Position of the pixels held within the larger image and its size. The whole image unless SetWindow is used
+	int mOriginX    = 0;
+	int mOriginY    = 0;
+	int mFullWidth  = 0;
+	int mFullHeight = 0;
+};
+
+
+// Largest difference in any channel between two images of the same size, colour only if includeAlpha is false. Used to
+// check the forms of an effect (fused, vectorised...) against each other
+float LargestDifference(const Image& a, const Image& b, bool includeAlpha = true);
+
+// True if the images are the same size with exactly the same pixels
+bool SameImage(const Image& a, const Image& b);
+
+
+// An image with its mip-maps, each level half the size of the one before down to 1x1 - like a texture
+// loaded with a full mip chain. Used for the CPU versions of effects reading textures with the trilinear sampler
+class MipMappedImage
+{
+public:
+	// Copy the image to level 0 and build the other levels from it by averaging 2x2 blocks
+	void Set(const Image& image);
+
+	bool Empty() const       { return mLevels.empty(); }
+	int  LevelCount() const  { return static_cast<int>(mLevels.size()); }
+	const Image& Level(int level) const  { return mLevels[level]; }
+
+	// Trilinear filtered colour at a texture coordinate, repeating outside 0->1 - like the trilinear (wrap) sampler.
+	// texelsPerPixel is how many level 0 pixels the texture coordinate moves across from one screen pixel to the next,
+	// the GPU works this out from the screen-space derivatives of the texture coordinate to choose the mip-map
+	ColourRGBA Sample(float u, float v, float texelsPerPixel) const;
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	std::vector<Image> mLevels;
+};
+
+
+#endif //_IMAGE_H_INCLUDED_
@@ -0,0 +1,684 @@
+//--------------------------------------------------------------------------------------
+// Reading and writing images as PPM and PNG files
+//--------------------------------------------------------------------------------------
+
+#include "ImageFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Largest image read: the largest Direct3D 11 texture a side, and no more pixels than a 8192x8192 image (1GB as an
+	// Image). Headers are checked against these before anything is allocated for the pixels
+	const uint32_t MAX_IMAGE_SIDE   = 16384;
+	const uint64_t MAX_IMAGE_PIXELS = uint64_t(8192) * 8192;
+
+	bool ImageSizeAllowed(uint32_t width, uint32_t height)
+	{
+		return width > 0 && height > 0 && width <= MAX_IMAGE_SIDE && height <= MAX_IMAGE_SIDE &&
+		       uint64_t(width) * height <= MAX_IMAGE_PIXELS;
+	}
+
+	// Pixel value as an 8-bit byte, as written to a R8G8B8A8_UNORM texture
+	uint8_t ToByte(float value)
+	{
+		return static_cast<uint8_t>(std::lround(Saturate(value) * 255.0f));
+	}
+
+	uint32_t ReadBigEndian(const uint8_t* bytes)
+	{
+		return (uint32_t(bytes[0]) << 24) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 8) | bytes[3];
+	}
+
+	void WriteBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(uint8_t(value >> 24));
+		out.push_back(uint8_t(value >> 16));
+		out.push_back(uint8_t(value >> 8));
+		out.push_back(uint8_t(value));
+	}
+
+
+	//-------------------------------------
+	// PPM
+	//-------------------------------------
+
+	// Read a number from a PPM header, skipping white space and # comments
+	bool ReadPpmNumber(std::istream& in, int& value)
+	{
+		int c = in.get();
+		while (c == '#' || std::isspace(c))
+		{
+			if (c == '#')  while (c != '\n' && c != EOF)  c = in.get();
+			c = in.get();
+		}
+		if (!std::isdigit(c))  return false;
+		value = 0;
+		while (std::isdigit(c))
+		{
+			value = value * 10 + (c - '0');
+			if (value > 1 << 24)  return false;
+			c = in.get();
+		}
+		// One white space character ends the number (and the header before binary data)
+		return std::isspace(c) != 0 || (c == EOF && in.eof());
+	}
+
+	bool ReadPpm(std::istream& in, Image& image, std::string& error)
+	{
+		char magic[2];
+		in.read(magic, 2);
+		bool binary = (magic[1] == '6');
+		int width, height, maxValue;
+		if (!in || magic[0] != 'P' || (magic[1] != '3' && magic[1] != '6') ||
+		    !ReadPpmNumber(in, width) || !ReadPpmNumber(in, height) || !ReadPpmNumber(in, maxValue) ||
+		    width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535)
+		{
+			error = "Not a PPM image (only P3 and P6 are supported)";
+			return false;
+		}
+		if (!ImageSizeAllowed(width, height))
+		{
+			error = "PPM image is too large";
+			return false;
+		}
+
+		image.Resize(width, height);
+		const float scale = 1.0f / maxValue;
+		const int bytesPerValue = (maxValue > 255) ? 2 : 1;
+		std::vector<uint8_t> row(static_cast<size_t>(width) * 3 * bytesPerValue);
+		for (int y = 0; y < height; ++y)
+		{
+			ColourRGBA* out = image.Row(y);
+			if (binary)
+			{
+				if (!in.read(reinterpret_cast<char*>(row.data()), row.size()))
+				{
+					error = "PPM image is cut short";
+					return false;
+				}
+			}
+			for (int x = 0; x < width; ++x)
+			{
+				int values[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					if (!binary)
+					{
+						if (!ReadPpmNumber(in, values[c]))
+						{
+							error = "PPM image is cut short";
+							return false;
+						}
+					}
+					else if (bytesPerValue == 2)  values[c] = (row[(x * 3 + c) * 2] << 8) | row[(x * 3 + c) * 2 + 1];
+					else                          values[c] = row[x * 3 + c];
+				}
+				out[x] = ColourRGBA(values[0] * scale, values[1] * scale, values[2] * scale, 1.0f);
+			}
+		}
+		return true;
+	}
+
+
+	//-------------------------------------
+	// Inflate (zlib data in PNGs)
+	//-------------------------------------
+	// The decoder follows the deflate specification (RFC 1951) directly: canonical Huffman codes decoded a bit at a time
+
+	class Inflater
+	{
+	public:
+		// Output beyond maxSize bytes is an error, so a small damaged stream can't expand without limit
+		Inflater(const std::vector<uint8_t>& data, size_t maxSize) : mData(data), mMaxSize(maxSize) {}
+
+		// Decompress a zlib stream (2 byte header, deflate blocks, checksum) to out. Returns false if the data is bad
+		bool Inflate(std::vector<uint8_t>& out)
+		{
+			if (mData.size() < 2 || (mData[0] & 0x0f) != 8 || ((mData[0] << 8) | mData[1]) % 31 != 0 || (mData[1] & 0x20))  return false;
+			mPosition = 2;
+
+			bool last = false;
+			while (!last)
+			{
+				last = Bits(1) != 0;
+				int type = Bits(2);
+				bool ok = (type == 0) ? Stored(out) : (type == 1) ? Fixed(out) : (type == 2) ? Dynamic(out) : false;
+				if (!ok || mOverrun)  return false;
+			}
+			return true;
+		}
+
+	private:
+		struct Huffman
+		{
+			uint16_t Counts[16];   // Number of codes of each length
+			uint16_t Symbols[320]; // Symbols in code order
+		};
+
+		int Bits(int count)
+		{
+			int value = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				if (mBitCount == 0)
+				{
+					if (mPosition >= mData.size())
+					{
+						mOverrun = true;
+						return 0;
+					}
+					mBitBuffer = mData[mPosition++];
+					mBitCount = 8;
+				}
+				value |= (mBitBuffer & 1) << i;
+				mBitBuffer >>= 1;
+				--mBitCount;
+			}
+			return value;
+		}
+
+		static void Build(Huffman& huffman, const uint8_t* lengths, int count)
+		{
+			std::fill(std::begin(huffman.Counts), std::end(huffman.Counts), uint16_t(0));
+			for (int i = 0; i < count; ++i)  huffman.Counts[lengths[i]]++;
+			huffman.Counts[0] = 0;
+
+			uint16_t offsets[16] = {};
+			for (int length = 1; length < 16; ++length)  offsets[length] = offsets[length - 1] + huffman.Counts[length - 1];
+			for (int i = 0; i < count; ++i)
+			{
+				if (lengths[i] != 0)  huffman.Symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+			}
+		}
+
+		int Decode(const Huffman& huffman)
+		{
+			int code = 0, first = 0, index = 0;
+			for (int length = 1; length < 16; ++length)
+			{
+				code |= Bits(1);
+				int count = huffman.Counts[length];
+				if (code - first < count)  return huffman.Symbols[index + code - first];
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+				if (mOverrun)  break;
+			}
+			return -1;
+		}
+
+		bool Stored(std::vector<uint8_t>& out)
+		{
+			mBitCount = 0; // Skip to the byte boundary
+			if (mPosition + 4 > mData.size())  return false;
+			unsigned length  = mData[mPosition] | (mData[mPosition + 1] << 8);
+			unsigned nLength = mData[mPosition + 2] | (mData[mPosition + 3] << 8);
+			mPosition += 4;
+			if (length != (~nLength & 0xffff) || mPosition + length > mData.size() || out.size() + length > mMaxSize)  return false;
+			out.insert(out.end(), mData.begin() + mPosition, mData.begin() + mPosition + length);
+			mPosition += length;
+			return true;
+		}
+
+		bool Fixed(std::vector<uint8_t>& out)
+		{
+			uint8_t lengths[288 + 30];
+			std::fill(lengths,       lengths + 144, uint8_t(8));
+			std::fill(lengths + 144, lengths + 256, uint8_t(9));
+			std::fill(lengths + 256, lengths + 280, uint8_t(7));
+			std::fill(lengths + 280, lengths + 288, uint8_t(8));
+			std::fill(lengths + 288, lengths + 318, uint8_t(5));
+			Huffman literals, distances;
+			Build(literals, lengths, 288);
+			Build(distances, lengths + 288, 30);
+			return Codes(out, literals, distances);
+		}
+
+		bool Dynamic(std::vector<uint8_t>& out)
+		{
+			static const int order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+			int literalCount  = Bits(5) + 257;
+			int distanceCount = Bits(5) + 1;
+			int codeCount     = Bits(4) + 4;
+			if (literalCount > 286 || distanceCount > 30)  return false;
+
+			uint8_t lengths[320] = {};
+			for (int i = 0; i < codeCount; ++i)  lengths[order[i]] = static_cast<uint8_t>(Bits(3));
+			Huffman lengthCodes;
+			Build(lengthCodes, lengths, 19);
+
+			// Code lengths for both tables, with runs
+			int index = 0;
+			std::fill(std::begin(lengths), std::end(lengths), uint8_t(0));
+			while (index < literalCount + distanceCount)
+			{
+				int symbol = Decode(lengthCodes);
+				if (symbol < 0)  return false;
+				if (symbol < 16)
+				{
+					lengths[index++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+				uint8_t repeat = 0;
+				int count;
+				if (symbol == 16)
+				{
+					if (index == 0)  return false;
+					repeat = lengths[index - 1];
+					count = 3 + Bits(2);
+				}
+				else if (symbol == 17)  count = 3 + Bits(3);
+				else                    count = 11 + Bits(7);
+				if (index + count > literalCount + distanceCount)  return false;
+				while (count-- > 0)  lengths[index++] = repeat;
+			}
+			if (lengths[256] == 0)  return false;
+
+			Huffman literals, distances;
+			Build(literals, lengths, literalCount);
+			Build(distances, lengths + literalCount, distanceCount);
+			return Codes(out, literals, distances);
+		}
+
+		bool Codes(std::vector<uint8_t>& out, const Huffman& literals, const Huffman& distances)
+		{
+			static const uint16_t lengthBase[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const uint8_t  lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const uint16_t distanceBase[30]  = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+			                                            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static const uint8_t  distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			for (;;)
+			{
+				int symbol = Decode(literals);
+				if (symbol < 0)  return false;
+				if (symbol < 256)
+				{
+					if (out.size() >= mMaxSize)  return false;
+					out.push_back(static_cast<uint8_t>(symbol));
+				}
+				else if (symbol == 256)
+				{
+					return true;
+				}
+				else
+				{
+					symbol -= 257;
+					if (symbol >= 29)  return false;
+					int length = lengthBase[symbol] + Bits(lengthExtra[symbol]);
+					int distanceSymbol = Decode(distances);
+					if (distanceSymbol < 0 || distanceSymbol >= 30)  return false;
+					size_t distance = distanceBase[distanceSymbol] + Bits(distanceExtra[distanceSymbol]);
+					if (distance > out.size() || out.size() + length > mMaxSize)  return false;
+					size_t from = out.size() - distance;
+					for (int i = 0; i < length; ++i)  out.push_back(out[from + i]); // Copies can overlap what they write
+				}
+				if (mOverrun)  return false;
+			}
+		}
+
+		const std::vector<uint8_t>& mData;
+		size_t   mMaxSize;
+		size_t   mPosition  = 0;
+		unsigned mBitBuffer = 0;
+		int      mBitCount  = 0;
+		bool     mOverrun   = false;
+	};
+
+
+	//-------------------------------------
+	// PNG
+	//-------------------------------------
+
+	const uint8_t PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+	uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		// Built on first use, the initialisation of a local static is thread safe
+		struct Table
+		{
+			uint32_t Entries[256];
+			Table()
+			{
+				for (uint32_t n = 0; n < 256; ++n)
+				{
+					uint32_t c = n;
+					for (int k = 0; k < 8; ++k)  c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					Entries[n] = c;
+				}
+			}
+		};
+		static const Table table;
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i)  crc = table.Entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	uint8_t Paeth(int a, int b, int c)
+	{
+		int p = a + b - c;
+		int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return static_cast<uint8_t>((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+	}
+
+	bool ReadPng(std::istream& in, Image& image, std::string& error)
+	{
+		uint8_t signature[8];
+		if (!in.read(reinterpret_cast<char*>(signature), 8) || !std::equal(signature, signature + 8, PngSignature))
+		{
+			error = "Not a PNG image";
+			return false;
+		}
+
+		// Gather the header, palette and image data chunks
+		uint32_t width = 0, height = 0;
+		int depth = 0, colourType = -1, interlace = 0;
+		std::vector<uint8_t> palette, transparency, compressed;
+		for (;;)
+		{
+			uint8_t header[8];
+			if (!in.read(reinterpret_cast<char*>(header), 8))
+			{
+				error = "PNG image is cut short";
+				return false;
+			}
+			uint32_t length = ReadBigEndian(header);
+			std::string type(reinterpret_cast<char*>(header) + 4, 4);
+			if (length > (1u << 30))
+			{
+				error = "PNG chunk too large";
+				return false;
+			}
+			std::vector<uint8_t> data(length + 4);
+			if (!in.read(reinterpret_cast<char*>(data.data()), data.size()))
+			{
+				error = "PNG image is cut short";
+				return false;
+			}
+			data.resize(length); // Drop the CRC, damaged files fail to decompress anyway
+
+			if (type == "IHDR" && length >= 13)
+			{
+				width = ReadBigEndian(&data[0]);
+				height = ReadBigEndian(&data[4]);
+				depth = data[8];
+				colourType = data[9];
+				interlace = data[12];
+			}
+			else if (type == "PLTE")  palette = data;
+			else if (type == "tRNS")  transparency = data;
+			else if (type == "IDAT")  compressed.insert(compressed.end(), data.begin(), data.end());
+			else if (type == "IEND")  break;
+		}
+
+		static const int channelCounts[7] = { 1, 0, 3, 1, 2, 0, 4 };
+		if (width == 0 || height == 0 || colourType < 0 || colourType > 6 || channelCounts[colourType] == 0)
+		{
+			error = "PNG image has a bad header";
+			return false;
+		}
+		if (!ImageSizeAllowed(width, height))
+		{
+			error = "PNG image is too large";
+			return false;
+		}
+
+		// Bit depths the PNG specification allows for each colour type: grey any, palette up to 8, the others 8 or 16
+		const bool anyDepth = (depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16);
+		const bool depthAllowed = (colourType == 0) ? anyDepth : (colourType == 3) ? (anyDepth && depth != 16) : (depth == 8 || depth == 16);
+		if (interlace != 0 || !depthAllowed)
+		{
+			error = "PNG image is interlaced or has an unsupported bit depth";
+			return false;
+		}
+
+		// Each row is a filter byte then the packed pixels, and nothing more is read
+		const int    channels = channelCounts[colourType];
+		const size_t rowBytes = (static_cast<size_t>(width) * channels * depth + 7) / 8;
+		const int    pixelBytes = std::max(channels * depth / 8, 1);
+		const size_t rawBytes = (rowBytes + 1) * height;
+		std::vector<uint8_t> raw;
+		raw.reserve(rawBytes);
+		if (!Inflater(compressed, rawBytes).Inflate(raw))
+		{
+			error = "PNG image data is damaged or too long";
+			return false;
+		}
+
+		// Undo the filter on each row. Filters work on bytes, comparing with the byte one pixel to the left (or the byte before)
+		if (raw.size() < rawBytes)
+		{
+			error = "PNG image data is cut short";
+			return false;
+		}
+		std::vector<uint8_t> previous(rowBytes, 0);
+		image.Resize(width, height);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			uint8_t  filter = raw[y * (rowBytes + 1)];
+			uint8_t* row = &raw[y * (rowBytes + 1) + 1];
+			for (size_t i = 0; i < rowBytes; ++i)
+			{
+				int left = (i >= static_cast<size_t>(pixelBytes)) ? row[i - pixelBytes] : 0;
+				int up = previous[i];
+				int upLeft = (i >= static_cast<size_t>(pixelBytes)) ? previous[i - pixelBytes] : 0;
+				switch (filter)
+				{
+				case 1: row[i] = static_cast<uint8_t>(row[i] + left);              break;
+				case 2: row[i] = static_cast<uint8_t>(row[i] + up);                break;
+				case 3: row[i] = static_cast<uint8_t>(row[i] + (left + up) / 2);   break;
+				case 4: row[i] = static_cast<uint8_t>(row[i] + Paeth(left, up, upLeft)); break;
+				default: break;
+				}
+			}
+			std::copy(row, row + rowBytes, previous.begin());
+
+			// Unpack the samples, scaling them to 0->1
+			const float maxValue = static_cast<float>((1 << depth) - 1);
+			auto sample = [&](uint32_t x, int channel) -> int
+			{
+				size_t index = static_cast<size_t>(x) * channels + channel;
+				if (depth == 16)  return (row[index * 2] << 8) | row[index * 2 + 1];
+				if (depth == 8)   return row[index];
+				size_t bit = index * depth;
+				return (row[bit / 8] >> (8 - depth - bit % 8)) & ((1 << depth) - 1);
+			};
+			ColourRGBA* out = image.Row(y);
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				if (colourType == 3)
+				{
+					size_t entry = static_cast<size_t>(sample(x, 0));
+					if (entry * 3 + 2 >= palette.size())
+					{
+						error = "PNG palette index out of range";
+						return false;
+					}
+					float alpha = (entry < transparency.size()) ? transparency[entry] / 255.0f : 1.0f;
+					out[x] = ColourRGBA(palette[entry * 3] / 255.0f, palette[entry * 3 + 1] / 255.0f, palette[entry * 3 + 2] / 255.0f, alpha);
+				}
+				else if (colourType == 0 || colourType == 4)
+				{
+					float grey = sample(x, 0) / maxValue;
+					out[x] = ColourRGBA(grey, grey, grey, (colourType == 4) ? sample(x, 1) / maxValue : 1.0f);
+				}
+				else
+				{
+					out[x] = ColourRGBA(sample(x, 0) / maxValue, sample(x, 1) / maxValue, sample(x, 2) / maxValue,
+					                    (colourType == 6) ? sample(x, 3) / maxValue : 1.0f);
+				}
+			}
+		}
+		return true;
+	}
+
+	void WritePngChunk(std::ostream& out, const char* type, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		chunk.reserve(data.size() + 12);
+		WriteBigEndian(chunk, static_cast<uint32_t>(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		WriteBigEndian(chunk, Crc32(&chunk[4], chunk.size() - 4));
+		out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Streams
+//--------------------------------------------------------------------------------------
+
+// Read the next image from a binary stream, PPM or PNG depending on its first bytes
+bool ReadImage(std::istream& in, Image& image, std::string& error)
+{
+	error.clear();
+
+	// Allow white space between PPMs in a stream
+	int first = in.peek();
+	while (first != EOF && std::isspace(first))
+	{
+		in.get();
+		first = in.peek();
+	}
+	if (first == EOF)  return false;
+
+	if (first == 'P')   return ReadPpm(in, image, error);
+	if (first == 0x89)  return ReadPng(in, image, error);
+	error = "Unknown image format (only PPM and PNG are supported)";
+	return false;
+}
+
+
+// Write an image to a binary stream, values are clamped to 0->1 and rounded to 8 bits
+void WritePpm(std::ostream& out, const Image& image)
+{
+	out << "P6\n" << image.Width() << ' ' << image.Height() << "\n255\n";
+	std::vector<uint8_t> row(static_cast<size_t>(image.Width()) * 3);
+	for (int y = 0; y < image.Height(); ++y)
+	{
+		const ColourRGBA* in = image.Row(y);
+		for (int x = 0; x < image.Width(); ++x)
+		{
+			row[x * 3]     = ToByte(in[x].r);
+			row[x * 3 + 1] = ToByte(in[x].g);
+			row[x * 3 + 2] = ToByte(in[x].b);
+		}
+		out.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+}
+
+void WritePng(std::ostream& out, const Image& image)
+{
+	out.write(reinterpret_cast<const char*>(PngSignature), 8);
+
+	std::vector<uint8_t> header;
+	WriteBigEndian(header, image.Width());
+	WriteBigEndian(header, image.Height());
+	header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8-bit RGBA, not interlaced
+	WritePngChunk(out, "IHDR", header);
+
+	// Rows with no filter, in stored (uncompressed) deflate blocks of up to 64K each
+	std::vector<uint8_t> raw;
+	raw.reserve(static_cast<size_t>(image.Height()) * (image.Width() * 4 + 1));
+	for (int y = 0; y < image.Height(); ++y)
+	{
+		raw.push_back(0);
+		const ColourRGBA* in = image.Row(y);
+		for (int x = 0; x < image.Width(); ++x)
+		{
+			raw.insert(raw.end(), { ToByte(in[x].r), ToByte(in[x].g), ToByte(in[x].b), ToByte(in[x].a) });
+		}
+	}
+
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	size_t position = 0;
+	do
+	{
+		size_t length = std::min(raw.size() - position, size_t(65535));
+		bool last = (position + length == raw.size());
+		zlib.insert(zlib.end(), { uint8_t(last ? 1 : 0), uint8_t(length), uint8_t(length >> 8), uint8_t(~length), uint8_t(~length >> 8) });
+		zlib.insert(zlib.end(), raw.begin() + position, raw.begin() + position + length);
+		position += length;
+	} while (position < raw.size());
+
+	uint32_t a = 1, b = 0; // Adler-32 of the uncompressed data
+	for (uint8_t byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	WriteBigEndian(zlib, (b << 16) | a);
+
+	WritePngChunk(out, "IDAT", zlib);
+	WritePngChunk(out, "IEND", {});
+}
+
+
+//--------------------------------------------------------------------------------------
+// Files
+//--------------------------------------------------------------------------------------
+
+bool LoadImageFile(const std::string& fileName, Image& image, std::string& error)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		error = "Can't open " + fileName;
+		return false;
+	}
+	if (!ReadImage(file, image, error))
+	{
+		error = fileName + ": " + (error.empty() ? "empty file" : error);
+		return false;
+	}
+	return true;
+}
+
+bool SaveImageFile(const std::string& fileName, const Image& image, std::string& error)
+{
+	std::ofstream file(fileName, std::ios::binary);
+	if (!file)
+	{
+		error = "Can't create " + fileName;
+		return false;
+	}
+
+	std::string extension = fileName.substr(std::min(fileName.size(), fileName.find_last_of('.')));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == ".png")  WritePng(file, image);
+	else                      WritePpm(file, image);
+
+	if (!file)
+	{
+		error = "Error writing " + fileName;
+		return false;
+	}
+	return true;
+}
+
+// True if the file name ends with an extension LoadImageFile understands (.ppm, .pnm or .png, any case)
+bool IsImageFileName(const std::string& fileName)
+{
+	size_t dot = fileName.find_last_of('.');
+	if (dot == std::string::npos)  return false;
+	std::string extension = fileName.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == ".ppm" || extension == ".pnm" || extension == ".png";
+}
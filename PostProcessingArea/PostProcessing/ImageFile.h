@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// Reading and writing images as PPM and PNG files
+//--------------------------------------------------------------------------------------
+// For running chains outside the app (see the batch tool), where there is no Direct3D or WIC to load
+// textures. No libraries are needed: PPM is trivial and PNG uses a small inflate written here.
+//
+// Reading: PPM as P3 (text) or P6 (binary) with any maximum value, PNG in any colour type and bit
+//          depth the specification allows, but not interlaced. Images are up to 16384 pixels a side and
+//          8192x8192 pixels in all. Pixel values are scaled to 0->1, alpha is 1 unless the file has it.
+// Writing: 8-bit binary PPM (P6, alpha dropped) or 8-bit RGBA PNG. The PNG data is stored without
+//          compression - quick to write, but files are as large as the pixels.
+//
+// Several PPMs or PNGs can follow each other in a stream (e.g. a pipe from a video decoder), ReadImage
+// reads one at a time.
+
+#ifndef _IMAGE_FILE_H_INCLUDED_
+#define _IMAGE_FILE_H_INCLUDED_
+
+#include "Image.h"
+
+#include <iosfwd>
+#include <string>
+
+
+// Read the next image from a binary stream, PPM or PNG depending on its first bytes. Returns false with an empty error at the
+// end of the stream, or false with the problem in error if the data isn't a readable image
+bool ReadImage(std::istream& in, Image& image, std::string& error);
+
+// Write an image to a binary stream, values are clamped to 0->1 and rounded to 8 bits
+void WritePpm(std::ostream& out, const Image& image);
+void WritePng(std::ostream& out, const Image& image);
+
+
+// As above, for files. Saving picks the format from the extension, .png or anything else for PPM
+bool LoadImageFile(const std::string& fileName, Image& image, std::string& error);
+bool SaveImageFile(const std::string& fileName, const Image& image, std::string& error);
+
+// True if the file name ends with an extension LoadImageFile understands (.ppm, .pnm or .png, any case)
+bool IsImageFileName(const std::string& fileName);
+
+
+#endif //_IMAGE_FILE_H_INCLUDED_
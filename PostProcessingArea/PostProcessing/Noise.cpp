@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------------------
+// Stateless noise for the GreyNoise and Scanlines post-processes
+//--------------------------------------------------------------------------------------
+
+#include "Noise.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+// Key for an effect's noise in one frame
+uint32_t NoiseKey(uint32_t seed, uint32_t frame, NoiseStream stream)
+{
+	return PcgHash(seed + PcgHash(frame * static_cast<uint32_t>(NoiseStream::Count) + static_cast<uint32_t>(stream)));
+}
+
+
+// Noise value of a pixel with cells of the given size in pixels
+float GrainNoise(int x, int y, float cellPixels, uint32_t key)
+{
+	if (cellPixels <= 1)  return PixelNoise(x, y, key);
+
+	// Position in cells, 0 at the centre of the first
+	float cellX = (x + 0.5f) / cellPixels - 0.5f;
+	float cellY = (y + 0.5f) / cellPixels - 0.5f;
+	int left = static_cast<int>(std::floor(cellX));
+	int top  = static_cast<int>(std::floor(cellY));
+	float blendX = cellX - left;
+	float blendY = cellY - top;
+
+	float topLeft     = PixelNoise(left,     top,     key);
+	float topRight    = PixelNoise(left + 1, top,     key);
+	float bottomLeft  = PixelNoise(left,     top + 1, key);
+	float bottomRight = PixelNoise(left + 1, top + 1, key);
+	float upper = topLeft    + (topRight    - topLeft)    * blendX;
+	float lower = bottomLeft + (bottomRight - bottomLeft) * blendX;
+	return upper + (lower - upper) * blendY;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rows
+//--------------------------------------------------------------------------------------
+// The hash of the row is the same for the whole row, so only the hash of x plus it is vectorised
+
+namespace
+{
+#if defined(POST_PROCESS_X86)
+	// The low 32 bits of each product, SSE2 only multiplies lanes 0 and 2 to 64 bits
+	__m128i MultiplySSE2(__m128i a, __m128i b)
+	{
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd  = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// Each lane of value shifted right by the amount in the same lane of shift (1->31). SSE2 has no shift by lane, so value is
+	// multiplied by 2^(32 - shift) and the high 32 bits of the product kept. The power of two is made as a float then converted
+	__m128i ShiftRightSSE2(__m128i value, __m128i shift)
+	{
+		__m128i exponent = _mm_sub_epi32(_mm_set1_epi32(32 + 127), shift);
+		__m128i power = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(exponent, 23)));
+		__m128i even = _mm_srli_epi64(_mm_mul_epu32(value, power), 32);
+		__m128i odd  = _mm_mul_epu32(_mm_srli_epi64(value, 32), _mm_srli_epi64(power, 32));
+		return _mm_or_si128(even, _mm_and_si128(odd, _mm_set_epi32(-1, 0, -1, 0)));
+	}
+
+	void PixelNoiseRowSSE2(int firstX, int count, uint32_t rowHash, float* out)
+	{
+		const __m128i step = _mm_set1_epi32(4);
+		__m128i x = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(firstX + rowHash)), _mm_set_epi32(3, 2, 1, 0));
+		for (int i = 0; i + 4 <= count; i += 4)
+		{
+			__m128i state = _mm_add_epi32(MultiplySSE2(x, _mm_set1_epi32(747796405)), _mm_set1_epi32(static_cast<int>(2891336453u)));
+			__m128i shift = _mm_add_epi32(_mm_srli_epi32(state, 28), _mm_set1_epi32(4));
+			__m128i word = MultiplySSE2(_mm_xor_si128(ShiftRightSSE2(state, shift), state), _mm_set1_epi32(277803737));
+			__m128i hash = _mm_xor_si128(_mm_srli_epi32(word, 22), word);
+			_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(hash, 8)), _mm_set1_ps(1.0f / 16777216.0f)));
+			x = _mm_add_epi32(x, step);
+		}
+	}
+
+	AVX2_FUNCTION void PixelNoiseRowAVX2(int firstX, int count, uint32_t rowHash, float* out)
+	{
+		const __m256i step = _mm256_set1_epi32(8);
+		__m256i x = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstX + rowHash)), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+		for (int i = 0; i + 8 <= count; i += 8)
+		{
+			__m256i state = _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(747796405)), _mm256_set1_epi32(static_cast<int>(2891336453u)));
+			__m256i shift = _mm256_add_epi32(_mm256_srli_epi32(state, 28), _mm256_set1_epi32(4));
+			__m256i word = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srlv_epi32(state, shift), state), _mm256_set1_epi32(277803737));
+			__m256i hash = _mm256_xor_si256(_mm256_srli_epi32(word, 22), word);
+			_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(hash, 8)), _mm256_set1_ps(1.0f / 16777216.0f)));
+			x = _mm256_add_epi32(x, step);
+		}
+	}
+#endif
+}
+
+
+// PixelNoise for count pixels of a row
+void PixelNoiseRow(int firstX, int y, int count, uint32_t key, float* out, SimdLevel level)
+{
+	uint32_t rowHash = PcgHash(static_cast<uint32_t>(y) + key);
+	int done = 0;
+#if defined(POST_PROCESS_X86)
+	switch (SupportedSimdLevel(level))
+	{
+	case SimdLevel::AVX2:
+		done = count & ~7;
+		PixelNoiseRowAVX2(firstX, done, rowHash, out);
+		break;
+	case SimdLevel::SSE2:
+		done = count & ~3;
+		PixelNoiseRowSSE2(firstX, done, rowHash, out);
+		break;
+	default:
+		break;
+	}
+#endif
+
+	// What's left of the row, all of it for plain C++
+	for (int i = done; i < count; ++i)
+	{
+		out[i] = (PcgHash(static_cast<uint32_t>(firstX + i) + rowHash) >> 8) * (1.0f / 16777216.0f);
+	}
+}
+
+
+// GrainNoise for count pixels of a row. The values of the two rows of cells the pixels lie between are worked out with
+// PixelNoiseRow, a chunk of pixels at a time, then blended for each pixel as GrainNoise does
+void GrainNoiseRow(int firstX, int y, int count, float cellPixels, uint32_t key, float* out, SimdLevel level)
+{
+	if (cellPixels <= 1)
+	{
+		PixelNoiseRow(firstX, y, count, key, out, level);
+		return;
+	}
+
+	const int CHUNK = 256; // Pixels per chunk, there are at most two more cells than pixels
+	float upperCells[CHUNK + 2], lowerCells[CHUNK + 2];
+
+	float cellY = (y + 0.5f) / cellPixels - 0.5f;
+	int top = static_cast<int>(std::floor(cellY));
+	float blendY = cellY - top;
+	for (int start = 0; start < count; start += CHUNK)
+	{
+		int end = std::min(start + CHUNK, count);
+		int firstCell = static_cast<int>(std::floor((firstX + start   + 0.5f) / cellPixels - 0.5f));
+		int lastCell  = static_cast<int>(std::floor((firstX + end - 1 + 0.5f) / cellPixels - 0.5f)) + 1;
+		PixelNoiseRow(firstCell, top,     lastCell - firstCell + 1, key, upperCells, level);
+		PixelNoiseRow(firstCell, top + 1, lastCell - firstCell + 1, key, lowerCells, level);
+
+		for (int i = start; i < end; ++i)
+		{
+			float cellX = (firstX + i + 0.5f) / cellPixels - 0.5f;
+			int left = static_cast<int>(std::floor(cellX));
+			float blendX = cellX - left;
+			const float* upperPair = upperCells + (left - firstCell);
+			const float* lowerPair = lowerCells + (left - firstCell);
+			float upper = upperPair[0] + (upperPair[1] - upperPair[0]) * blendX;
+			float lower = lowerPair[0] + (lowerPair[1] - lowerPair[0]) * blendX;
+			out[i] = upper + (lower - upper) * blendY;
+		}
+	}
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------------
+// Stateless noise for the GreyNoise and Scanlines post-processes
+//--------------------------------------------------------------------------------------
+// Both effects want a new random value for each pixel every frame. GreyNoise used to read a noise
+// texture at a random offset and Scanlines used the frac(sin(dot(...))) hash, which repeats in bands
+// and depends on the GPU's sin. Here the value is a hash of the pixel's position in the render target
+// and a key for the frame: the PCG hash (one step of the PCG random number generator and its output
+// permutation, from Jarzynski and Olano, "Hash Functions for GPU Rendering"). It is integer arithmetic
+// only, so the GPU (Noise.hlsli) and the CPU give exactly the same values, and a frame can be drawn
+// again from its number.
+//
+// GreyNoise's grain setting makes the noise coarser: values are hashed for cells of several pixels and
+// blended bilinearly between them, as reading the 128x128 noise texture did. The row functions work
+// out the values for a row of pixels, hashing eight pixels per instruction with AVX2 and four with SSE2.
+// Every level gives exactly the same values
+
+#ifndef _NOISE_H_INCLUDED_
+#define _NOISE_H_INCLUDED_
+
+#include "CpuFeatures.h"
+
+#include <cstdint>
+
+
+// The effects reading noise, each has its own so they don't draw the same pattern
+enum class NoiseStream
+{
+	GreyNoise,
+	Scanlines,
+	Count,
+};
+
+// GreyNoise's grain setting is the size in pixels of this many cells, the size of the texture the effect used to read
+const float NOISE_GRAIN_CELLS = 128;
+
+
+// PCG hash of a value
+inline uint32_t PcgHash(uint32_t value)
+{
+	uint32_t state = value * 747796405u + 2891336453u;
+	uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+// Key for an effect's noise in one frame, sent to the shaders. The seed picks the sequence of frames
+uint32_t NoiseKey(uint32_t seed, uint32_t frame, NoiseStream stream);
+
+// Noise value (0->1) of a pixel, from its position in the render target and the frame's key
+inline float PixelNoise(int x, int y, uint32_t key)
+{
+	uint32_t hash = PcgHash(static_cast<uint32_t>(x) + PcgHash(static_cast<uint32_t>(y) + key));
+	return (hash >> 8) * (1.0f / 16777216.0f);
+}
+
+// Noise value (0->1) of a pixel with cells of the given size in pixels, blended between the values of the nearest four.
+// Cells of 1 pixel or less give PixelNoise
+float GrainNoise(int x, int y, float cellPixels, uint32_t key);
+
+
+// PixelNoise for count pixels of row y from firstX, written to out. Uses the given instruction set if the processor has it
+void PixelNoiseRow(int firstX, int y, int count, uint32_t key, float* out, SimdLevel level = BestSimdLevel());
+
+// GrainNoise for count pixels of row y from firstX, written to out
+void GrainNoiseRow(int firstX, int y, int count, float cellPixels, uint32_t key, float* out, SimdLevel level = BestSimdLevel());
+
+
+#endif //_NOISE_H_INCLUDED_
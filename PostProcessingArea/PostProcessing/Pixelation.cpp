@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------------------
+// Pixelation post-process
+//--------------------------------------------------------------------------------------
+
+#include "Pixelation.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Rows of blocks given to each task
+	const int BLOCK_ROWS_PER_TASK = 4;
+
+	int ClampBlockSize(int blockSize)  { return std::min(std::max(blockSize, 1), MAX_PIXELATION_BLOCK); }
+
+	// First source pixel of each block along one direction, plus one past the last pixel at the end. Pixels go to blocks in
+	// order so each block's are together
+	std::vector<int> BlockStarts(int sourceSize, int viewportSize, int blockSize)
+	{
+		const int blockCount = PixelationBlockCount(viewportSize, blockSize);
+		std::vector<int> starts(blockCount + 1, sourceSize);
+		starts[0] = 0;
+		int block = 0;
+		for (int pixel = 0; pixel < sourceSize; ++pixel)
+		{
+			// Blocks passed over have no pixels, they start and end here
+			int pixelBlock = PixelationBlock((pixel + 0.5f) / sourceSize, viewportSize, blockSize);
+			while (block < pixelBlock)  starts[++block] = pixel;
+		}
+		return starts;
+	}
+}
+
+
+// Blocks across a viewport width or height, the last one may be cut short
+int PixelationBlockCount(int viewportSize, int blockSize)
+{
+	blockSize = ClampBlockSize(blockSize);
+	return std::max((viewportSize + blockSize - 1) / blockSize, 1);
+}
+
+
+// The block a point lies in along one direction, given its position across the screen (0->1)
+int PixelationBlock(float u, int viewportSize, int blockSize)
+{
+	blockSize = ClampBlockSize(blockSize);
+	int block = static_cast<int>(std::floor(u * viewportSize / blockSize));
+	return std::min(std::max(block, 0), PixelationBlockCount(viewportSize, blockSize) - 1);
+}
+
+
+// A colour channel (0->1) posterised to the given number of levels, rounding down
+float Posterise(float value, int levels)
+{
+	levels = std::min(std::max(levels, 1), MAX_PIXELATION_LEVELS);
+	return std::floor(Saturate(value) * levels) / levels;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reduction
+//--------------------------------------------------------------------------------------
+
+// Reduce source into blocks: each pixel the posterised average of the source pixels in the block
+void PixelationReduce(const Image& source, int viewportWidth, int viewportHeight, int blockWidth, int blockHeight, int levels,
+                      Image& blocks, TaskPool* pool)
+{
+	const int blocksAcross = PixelationBlockCount(viewportWidth, blockWidth);
+	const int blocksDown   = PixelationBlockCount(viewportHeight, blockHeight);
+	blocks.Resize(blocksAcross, blocksDown);
+
+	const std::vector<int> columnStarts = BlockStarts(source.Width(),  viewportWidth,  blockWidth);
+	const std::vector<int> rowStarts    = BlockStarts(source.Height(), viewportHeight, blockHeight);
+
+	const int tasks = (blocksDown + BLOCK_ROWS_PER_TASK - 1) / BLOCK_ROWS_PER_TASK;
+	auto reduceRows = [&](int task)
+	{
+		std::vector<ColourRGBA> sums(blocksAcross);
+		const int lastBlockRow = std::min((task + 1) * BLOCK_ROWS_PER_TASK, blocksDown);
+		for (int blockY = task * BLOCK_ROWS_PER_TASK; blockY < lastBlockRow; ++blockY)
+		{
+			// Add up each source row of the blocks a block at a time
+			std::fill(sums.begin(), sums.end(), ColourRGBA(0, 0, 0, 0));
+			for (int y = rowStarts[blockY]; y < rowStarts[blockY + 1]; ++y)
+			{
+				const ColourRGBA* row = source.Row(y);
+				for (int blockX = 0; blockX < blocksAcross; ++blockX)
+				{
+					ColourRGBA& sum = sums[blockX];
+					for (int x = columnStarts[blockX]; x < columnStarts[blockX + 1]; ++x)
+					{
+						sum.r += row[x].r;
+						sum.g += row[x].g;
+						sum.b += row[x].b;
+					}
+				}
+			}
+
+			ColourRGBA* out = blocks.Row(blockY);
+			const int rows = rowStarts[blockY + 1] - rowStarts[blockY];
+			for (int blockX = 0; blockX < blocksAcross; ++blockX)
+			{
+				ColourRGBA colour;
+				const int count = rows * (columnStarts[blockX + 1] - columnStarts[blockX]);
+				if (count > 0)
+				{
+					colour = ColourRGBA(sums[blockX].r / count, sums[blockX].g / count, sums[blockX].b / count, 1);
+				}
+				else
+				{
+					// No source pixel has its centre in the block, take the one at the block's centre
+					colour = source.SamplePoint((blockX + 0.5f) * ClampBlockSize(blockWidth)  / viewportWidth,
+					                            (blockY + 0.5f) * ClampBlockSize(blockHeight) / viewportHeight);
+				}
+				out[blockX] = ColourRGBA(Posterise(colour.r, levels), Posterise(colour.g, levels), Posterise(colour.b, levels), 1);
+			}
+		}
+	};
+	if (pool)  pool->ParallelFor(tasks, reduceRows);
+	else       for (int task = 0; task < tasks; ++task)  reduceRows(task);
+}
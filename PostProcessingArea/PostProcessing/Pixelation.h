@@ -0,0 +1,49 @@
+//--------------------------------------------------------------------------------------
+// Pixelation post-process
+//--------------------------------------------------------------------------------------
+// The screen is cut into blocks of blockWidth x blockHeight pixels, each drawn in one flat colour
+// posterised to a few levels per channel. The shader used to read one pixel at the corner of each block,
+// so a thin bright line flickered in and out as it crossed the corners, and then posterised that pixel
+// again for every pixel of the block.
+//
+// Now the blocks are reduced first, into an image one pixel per block (PixelationBlockCount across and
+// down): each is the average of every pixel of the input in the block, posterised once. The pass itself
+// then only reads the block its pixel lies in. Posterising the average rather than each pixel is what
+// fuses the two steps, with one result per block there is nothing for a lookup table to save.
+//
+// A pixel belongs to the block its centre is in, in full size pixels, so an input drawn at a reduced
+// resolution averages its own pixels over the same blocks. Blocks smaller than the input's pixels can
+// have none, these take the pixel at their centre.
+//
+// This file has the CPU version, the GPU version is Pixelation.hlsli and the shaders that include it.
+// Both pick the same pixels for each block
+
+#ifndef _PIXELATION_H_INCLUDED_
+#define _PIXELATION_H_INCLUDED_
+
+#include "Image.h"
+
+class TaskPool;
+
+
+// Largest block width or height in pixels and most posterise levels. Must match Pixelation.hlsli
+const int MAX_PIXELATION_BLOCK  = 64;
+const int MAX_PIXELATION_LEVELS = 255;
+
+// Blocks across a viewport width or height, the last one may be cut short
+int PixelationBlockCount(int viewportSize, int blockSize);
+
+// The block a point lies in along one direction, given its position across the screen (0->1)
+int PixelationBlock(float u, int viewportSize, int blockSize);
+
+// A colour channel (0->1) posterised to the given number of levels, rounding down as the shader always has
+float Posterise(float value, int levels);
+
+// Reduce source into blocks (resized to the block count across and down): each pixel the average of the source pixels in
+// the block, posterised, with an alpha of 1. Source covers the whole viewport at any resolution. Rows of blocks are shared
+// out to the pool's threads if one is given
+void PixelationReduce(const Image& source, int viewportWidth, int viewportHeight, int blockWidth, int blockHeight, int levels,
+                      Image& blocks, TaskPool* pool = nullptr);
+
+
+#endif //_PIXELATION_H_INCLUDED_
@@ -0,0 +1,643 @@
+//--------------------------------------------------------------------------------------
+// Post-processing render graph
+//--------------------------------------------------------------------------------------
+
+#include "PostProcessGraph.h"
+#include "ColourEffects.h"
+#include "Bloom.h"
+#include "VariableBlur.h"
+#include "SeeingWorlds.h"
+
+#include <algorithm>
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+
+const char* PPNames[] = {
+	"None",
+	"Copy",
+	"Tint",
+	"TintHue",
+	"GreyNoise",
+	"Burn",
+	"Distort",
+	"Spiral",
+	"Blur",
+	"SecondBlur",
+	"Underwater",
+	"HeatHaze",
+	"NightVision",
+	"Pixelation",
+	"Scanlines",
+	"Inverse",
+	"BlackAndWhite",
+	"SeeingWorlds",
+	"SecondSeeingWorlds",
+	"Bloom",
+	"Merge",
+	"Sigmoid",
+	"VariableBlur",
+	"Upsample",
+};
+
+const char* ModeNames[] = {
+	"FullScreen",
+	"Area",
+	"Polygon",
+	"ModelPolygon"
+};
+
+
+// Return the nodes that make up the given effect, e.g. Blur is a vertical and a horizontal blur node
+std::vector<PostProcessNode> DeclarePostProcessNodes(PostProcess process)
+{
+	if (process == PostProcess::Blur)
+	{
+		return { { PostProcess::Blur,       { "" }, "" },
+		         { PostProcess::SecondBlur, { "" }, "" } };
+	}
+	else if (process == PostProcess::SeeingWorlds)
+	{
+		return { { PostProcess::SeeingWorlds,       { "" }, "" },
+		         { PostProcess::SecondSeeingWorlds, { "" }, "" } };
+	}
+
+	return { { process, { "" }, "" } };
+}
+
+
+// Settings an effect starts with when added from the menu (or read from a chain file without them)
+PostProcessData DefaultPostProcessData(PostProcess process)
+{
+	PostProcessData data = {};
+	if (process == PostProcess::Tint || process == PostProcess::TintHue)
+	{
+		float top[3] = { 0.3f, 0.8f, 0.0f };
+		float mid[3] = { 0.1f, 0.5f, 1.0f };
+		if (process == PostProcess::Tint)  data.tint.tint(top, mid);
+		else                               data.Hue.Hue(top, mid);
+	}
+	else if (process == PostProcess::Blur)          data.Blur.Blur(5);
+	else if (process == PostProcess::Sigmoid)       data.Sigmoid.Gamma = 0.25f;
+	else if (process == PostProcess::Bloom)         data.Bloom.Bloom(0.7f, 1.0f, MAX_BLOOM_LEVELS);
+	else if (process == PostProcess::VariableBlur)  data.VariableBlur.VariableBlur(0.0f, 16.0f, 0.3f, MAX_STACKED_BOXES);
+	else if (process == PostProcess::Burn)          data.Burn.burnSpeed = 1.0f;
+	else if (process == PostProcess::GreyNoise)     data.Noise.grainSize = 140.0f;
+	else if (process == PostProcess::SeeingWorlds)
+	{
+		data.SeeingWorlds.offset = 0.05f;
+		data.SeeingWorlds.taps = SEEING_WORLDS_TAPS;
+	}
+	else if (process == PostProcess::Underwater)    data.Water.waterSpeed = 1.0f;
+	else if (process == PostProcess::Pixelation)    data.Pixelation.Pixelation(15, 10, 20);
+	return data;
+}
+
+
+// Returns true if two effects of the given kind would draw the same with these settings
+bool SamePostProcessSettings(PostProcess process, const PostProcessData& a, const PostProcessData& b)
+{
+	auto same3 = [](const float* x, const float* y)  { return x[0] == y[0] && x[1] == y[1] && x[2] == y[2]; };
+	switch (process)
+	{
+	case PostProcess::Tint:
+		return same3(a.tint.rgbTop, b.tint.rgbTop) && same3(a.tint.rgbMid, b.tint.rgbMid);
+	case PostProcess::TintHue:
+		return same3(a.Hue.Hue1, b.Hue.Hue1) && same3(a.Hue.Hue2, b.Hue.Hue2);
+	case PostProcess::GreyNoise:
+		return a.Noise.grainSize == b.Noise.grainSize;
+	case PostProcess::Burn:
+		return a.Burn.burnSpeed == b.Burn.burnSpeed;
+	case PostProcess::Blur:
+	case PostProcess::SecondBlur:
+		return a.Blur.blur == b.Blur.blur && a.Blur.sigma == b.Blur.sigma;
+	case PostProcess::Bloom:
+		return a.Bloom.threshold == b.Bloom.threshold && a.Bloom.intensity == b.Bloom.intensity && a.Bloom.levels == b.Bloom.levels;
+	case PostProcess::Sigmoid:
+		return a.Sigmoid.Gamma == b.Sigmoid.Gamma;
+	case PostProcess::VariableBlur:
+		return a.VariableBlur.innerRadius == b.VariableBlur.innerRadius && a.VariableBlur.outerRadius == b.VariableBlur.outerRadius &&
+		       a.VariableBlur.focus == b.VariableBlur.focus && a.VariableBlur.boxes == b.VariableBlur.boxes;
+	case PostProcess::Pixelation:
+		return a.Pixelation.blockWidth == b.Pixelation.blockWidth && a.Pixelation.blockHeight == b.Pixelation.blockHeight &&
+		       a.Pixelation.levels == b.Pixelation.levels;
+	case PostProcess::Underwater:
+		return a.Water.waterSpeed == b.Water.waterSpeed;
+	case PostProcess::SeeingWorlds:
+	case PostProcess::SecondSeeingWorlds:
+		return a.SeeingWorlds.offset == b.SeeingWorlds.offset && a.SeeingWorlds.taps == b.SeeingWorlds.taps &&
+		       a.SeeingWorlds.stochastic == b.SeeingWorlds.stochastic;
+	default:
+		return true; // No settings
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Chain editing
+//--------------------------------------------------------------------------------------
+
+// Add an effect to the end of the chain, returns its index
+int PostProcessGraph::AddEffect(PostProcess process, PostProcessMode mode, int region, const std::string& name, const PostProcessData& data)
+{
+	PostProcessEffect effect;
+	effect.Process = process;
+	effect.Mode    = mode;
+	effect.Region  = region;
+	effect.Name    = name;
+	effect.Data    = data;
+	effect.Nodes   = DeclarePostProcessNodes(process);
+	mEffects.push_back(effect);
+
+	mDirty = true;
+	return static_cast<int>(mEffects.size()) - 1;
+}
+
+// Move an effect one place up (direction -1) or down (direction +1) the chain. Returns false if it can't move
+bool PostProcessGraph::MoveEffect(int index, int direction)
+{
+	int newIndex = index + direction;
+	if (index < 0 || index >= EffectCount() || newIndex < 0 || newIndex >= EffectCount())  return false;
+
+	std::swap(mEffects[index], mEffects[newIndex]);
+	mDirty = true;
+	return true;
+}
+
+void PostProcessGraph::RemoveEffect(int index)
+{
+	if (index < 0 || index >= EffectCount())  return;
+
+	mEffects.erase(mEffects.begin() + index);
+	mDirty = true;
+}
+
+void PostProcessGraph::Clear()
+{
+	mEffects.clear();
+	mDirty = true;
+}
+
+// Change the resolution an effect is drawn at (1, 2 or 4, see PostProcessEffect::Downscale). Area and polygon effects stay at full
+// resolution. Returns false if the value isn't allowed
+bool PostProcessGraph::SetEffectDownscale(int index, int downscale)
+{
+	if (index < 0 || index >= EffectCount())  return false;
+	if (downscale != 1 && downscale != 2 && downscale != 4)  return false;
+	if (downscale != 1 && mEffects[index].Mode != PostProcessMode::Fullscreen)  return false;
+
+	if (mEffects[index].Downscale != downscale)
+	{
+		mEffects[index].Downscale = downscale;
+		mDirty = true;
+	}
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Compilation
+//--------------------------------------------------------------------------------------
+
+// Return the compiled chain, compiling it first if the chain has changed since the last call
+const CompiledPostProcessGraph& PostProcessGraph::Compile()
+{
+	if (!mDirty && BatchSettingsChanged())  mDirty = true;
+	if (mDirty)
+	{
+		CompileChain();
+		mDirty = false;
+		++mCompileCount;
+	}
+	return mCompiled;
+}
+
+
+// Returns true if the effects of a batched ModelPolygon pass in the compiled chain no longer have the same settings. Settings are
+// edited in place without marking the chain for recompilation, but a batch is only drawn with the settings of its first effect
+bool PostProcessGraph::BatchSettingsChanged() const
+{
+	for (const PostProcessPass& pass : mCompiled.Passes)
+	{
+		for (size_t i = 1; i < pass.BatchedEffects.size(); ++i)
+		{
+			if (!SamePostProcessSettings(pass.Process, mEffects[pass.BatchedEffects[0]].Data, mEffects[pass.BatchedEffects[i]].Data))  return true;
+		}
+	}
+	return false;
+}
+
+
+// Return the index of the named image in the compiled graph, or -1 if there isn't one
+int PostProcessGraph::FindImage(const std::string& name) const
+{
+	for (int i = 0; i < static_cast<int>(mCompiled.Images.size()); ++i)
+	{
+		if (!name.empty() && mCompiled.Images[i].Name == name)  return i;
+	}
+	return -1;
+}
+
+
+// Flatten the effects into passes, work out how long each image is needed and assign render targets
+void PostProcessGraph::CompileChain()
+{
+	mCompiled = CompiledPostProcessGraph();
+	mCompiled.Valid = true;
+	mCompiled.TargetCount = 1;
+	mCompiled.TargetDownscales = { 1 };
+
+	auto& passes = mCompiled.Passes;
+	auto& images = mCompiled.Images;
+
+	// Image 0 is the scene as rendered, it lives in target 0 before the chain starts
+	images.push_back({ PostProcessSceneImage, -1, -1, 0, 1 });
+	int previous = 0;
+
+	// The last image drawn at each resolution, to guide upsampling back to that resolution
+	int latestAtScale[MAX_DOWNSCALE + 1] = {};
+
+	// Add a pass enlarging an image to the given resolution, returns the new image
+	auto addUpsample = [&](int image, int downscale, int effect)
+	{
+		PostProcessPass upsample = {};
+		upsample.Effect     = effect;
+		upsample.Node       = -1;
+		upsample.Process    = PostProcess::Upsample;
+		upsample.Mode       = PostProcessMode::Fullscreen;
+		upsample.InputCount = 2;
+		upsample.Inputs[0]  = image;
+		upsample.Inputs[1]  = latestAtScale[downscale];
+		upsample.Downscale  = downscale;
+		upsample.FusedCount = 1;
+		upsample.FusedEffects[0] = effect;
+		upsample.Scratch = -1;
+
+		images.push_back({ "", -1, -1, -1, downscale });
+		upsample.Output = static_cast<int>(images.size()) - 1;
+		passes.push_back(upsample);
+		latestAtScale[downscale] = upsample.Output;
+		return upsample.Output;
+	};
+
+	auto fail = [&](const std::string& error)
+	{
+		mCompiled.Passes.clear();
+		mCompiled.Valid = false;
+		mCompiled.Error = error;
+	};
+
+
+	////--------------- Flatten effects into passes ---------------////
+
+	for (int e = 0; e < EffectCount(); ++e)
+	{
+		const PostProcessEffect& effect = mEffects[e];
+		const int downscale = (effect.Mode == PostProcessMode::Fullscreen) ? effect.Downscale : 1;
+		for (int n = 0; n < static_cast<int>(effect.Nodes.size()); ++n)
+		{
+			const PostProcessNode& node = effect.Nodes[n];
+
+			PostProcessPass pass = {};
+			pass.Effect  = e;
+			pass.Node    = n;
+			pass.Process = node.Process;
+			pass.Mode    = effect.Mode;
+			pass.Downscale = downscale;
+			pass.FusedCount = 1;
+			pass.FusedEffects[0] = e;
+			pass.Scratch = -1;
+			if (effect.Mode == PostProcessMode::ModelPolygon)  pass.BatchedEffects.push_back(e);
+
+			// Resolve input names to images
+			if (node.Inputs.size() > MAX_PASS_INPUTS)
+			{
+				fail(std::string(PPNames[(int)node.Process]) + " reads too many images");
+				return;
+			}
+			pass.InputCount = static_cast<int>(node.Inputs.size());
+			for (int i = 0; i < pass.InputCount; ++i)
+			{
+				const std::string& name = node.Inputs[i];
+				int image;
+				if (name.empty())
+				{
+					image = previous;
+				}
+				else
+				{
+					image = FindImage(name);
+				}
+				if (image < 0)
+				{
+					fail(std::string(PPNames[(int)node.Process]) + " reads unknown image \"" + name + "\"");
+					return;
+				}
+
+				// Images at a lower resolution than this node are enlarged first. Higher resolution ones are read as they are
+				if (images[image].Downscale > downscale)  image = addUpsample(image, downscale, e);
+				pass.Inputs[i] = image;
+			}
+
+			// Every node writes a new image, named ones can be read again by later nodes
+			if (!node.Output.empty() && FindImage(node.Output) >= 0)
+			{
+				fail("Image \"" + node.Output + "\" is written twice");
+				return;
+			}
+			images.push_back({ node.Output, -1, -1, -1, downscale });
+			pass.Output = static_cast<int>(images.size()) - 1;
+
+			// Area and polygon effects only cover part of the screen, so the rest of the
+			// input is copied to the output first
+			if (effect.Mode != PostProcessMode::Fullscreen)
+			{
+				PostProcessPass copy = pass;
+				copy.Node       = -1;
+				copy.Process    = PostProcess::Copy;
+				copy.Mode       = PostProcessMode::Fullscreen;
+				copy.InputCount = 1;
+				copy.BatchedEffects.clear();
+				passes.push_back(copy);
+			}
+
+			passes.push_back(pass);
+			previous = pass.Output;
+			latestAtScale[downscale] = pass.Output;
+		}
+	}
+
+	// The chain always ends at full resolution
+	if (images[previous].Downscale > 1)
+	{
+		previous = addUpsample(previous, 1, EffectCount() - 1);
+	}
+
+
+	////--------------- Fuse colour effects ---------------////
+
+	// Merge each full-screen colour effect into the pass before it if that is also a full-screen colour effect
+	// reading nothing else. The image between them is no longer needed - it is never assigned a target
+	if (mOptions.FuseColourEffects)
+	{
+		std::vector<PostProcessPass> fused;
+		for (const PostProcessPass& pass : passes)
+		{
+			if (!fused.empty())
+			{
+				PostProcessPass& previousPass = fused.back();
+				if (pass.Mode == PostProcessMode::Fullscreen && previousPass.Mode == PostProcessMode::Fullscreen &&
+				    IsColourEffect(pass.Process) && IsColourEffect(previousPass.Process) && pass.Downscale == previousPass.Downscale &&
+				    pass.InputCount == 1 && pass.Inputs[0] == previousPass.Output && images[previousPass.Output].Name.empty() &&
+				    previousPass.FusedCount < MAX_FUSED_EFFECTS)
+				{
+					previousPass.FusedEffects[previousPass.FusedCount++] = pass.Effect;
+					previousPass.Output = pass.Output;
+					continue;
+				}
+			}
+			fused.push_back(pass);
+		}
+		passes.swap(fused);
+	}
+
+
+	////--------------- Batch model polygons ---------------////
+
+	// Merge each ModelPolygon pass into the one before it if that is the same single-pass effect with the same settings on another
+	// model, reading nothing else - the batch is drawn with one set of settings. The copy under the merged pass goes too, the copy
+	// under the batch now writes the batch's output
+	if (mOptions.BatchModelPolygons)
+	{
+		std::vector<PostProcessPass> batched;
+		for (const PostProcessPass& pass : passes)
+		{
+			const int count = static_cast<int>(batched.size());
+			if (pass.Mode == PostProcessMode::ModelPolygon && pass.Node >= 0 && count >= 3)
+			{
+				PostProcessPass& copy      = batched[count - 1]; // Copy under this pass
+				PostProcessPass& batch     = batched[count - 2];
+				PostProcessPass& batchCopy = batched[count - 3];
+				if (copy.Node < 0 && copy.Output == pass.Output &&
+				    batch.Mode == PostProcessMode::ModelPolygon && batch.Node >= 0 && batch.Process == pass.Process &&
+				    SamePostProcessSettings(pass.Process, mEffects[batch.Effect].Data, mEffects[pass.Effect].Data) &&
+				    mEffects[batch.Effect].Nodes.size() == 1 && mEffects[pass.Effect].Nodes.size() == 1 &&
+				    pass.InputCount == 1 && pass.Inputs[0] == batch.Output && images[batch.Output].Name.empty() &&
+				    batchCopy.Node < 0 && batchCopy.Output == batch.Output)
+				{
+					batch.BatchedEffects.push_back(pass.Effect);
+					batch.Output     = pass.Output;
+					batchCopy.Output = pass.Output;
+					batched.pop_back();
+					continue;
+				}
+			}
+			batched.push_back(pass);
+		}
+		passes.swap(batched);
+	}
+
+
+	////--------------- Region passes in place ---------------////
+
+	// An area or polygon pass normally draws over a full-screen copy of its input. When no later pass reads that input and
+	// the pass isn't writing the final image, it can write to the input's own target instead - the backend copies just the
+	// region to a scratch target, draws it there and copies it back. The pixels outside the region are left as they are
+	if (mOptions.RegionsInPlace && !mOptions.EveryPassToOutput)
+	{
+		std::vector<PostProcessPass> inPlace;
+		for (int p = 0; p < static_cast<int>(passes.size()); ++p)
+		{
+			const PostProcessPass& pass = passes[p];
+			bool readLater = false;
+			for (int q = p + 1; q < static_cast<int>(passes.size()) && !readLater; ++q)
+			{
+				for (int i = 0; i < passes[q].InputCount; ++i)
+				{
+					if (passes[q].Inputs[i] == pass.Inputs[0])  readLater = true;
+				}
+			}
+
+			if (pass.Mode != PostProcessMode::Fullscreen && pass.Node >= 0 && !readLater && pass.Output != previous &&
+			    !inPlace.empty() && inPlace.back().Node < 0 && inPlace.back().Output == pass.Output)
+			{
+				inPlace.pop_back(); // The copy under the region isn't needed
+
+				// The scratch image only lives for this pass
+				int scratch = static_cast<int>(images.size());
+				int passIndex = static_cast<int>(inPlace.size());
+				images.push_back({ "", passIndex, passIndex, -1, 1 });
+
+				inPlace.push_back(pass);
+				inPlace.back().Scratch = scratch;
+				continue;
+			}
+			inPlace.push_back(pass);
+		}
+		passes.swap(inPlace);
+	}
+
+
+	////--------------- Image lifetimes ---------------////
+
+	const int numPasses = static_cast<int>(passes.size());
+	for (int p = 0; p < numPasses; ++p)
+	{
+		const PostProcessPass& pass = passes[p];
+		for (int i = 0; i < pass.InputCount; ++i)
+		{
+			images[pass.Inputs[i]].LastPass = std::max(images[pass.Inputs[i]].LastPass, p);
+		}
+		PostProcessImage& output = images[pass.Output];
+		if (output.FirstPass < 0)  output.FirstPass = p;
+		output.LastPass = std::max(output.LastPass, p);
+	}
+
+	// The final image is what ends up on screen, keep it to the end
+	images[previous].LastPass = std::max(images[previous].LastPass, numPasses);
+
+	// Write the final image straight to the output rather than to a render target that is then copied. When every
+	// pass is drawn to the output anyway, it stays in a render target like the others
+	if (mOptions.EveryPassToOutput)
+	{
+		for (PostProcessPass& pass : passes)  pass.DrawToOutput = true;
+	}
+	else if (previous != 0)
+	{
+		images[previous].Target = OUTPUT_TARGET;
+	}
+
+
+	////--------------- Render target assignment ---------------////
+
+	// Walk the passes in order giving each new image the lowest numbered target of the right size that holds
+	// nothing still needed. A target being read by the pass doesn't count as free - a pass can't write to
+	// the texture it is reading from
+	auto& targetDownscales = mCompiled.TargetDownscales;
+	auto assignTarget = [&](PostProcessImage& newImage, int p)
+	{
+		for (int target = 0; newImage.Target < 0; ++target)
+		{
+			if (target < static_cast<int>(targetDownscales.size()) && targetDownscales[target] != newImage.Downscale)  continue;
+
+			bool free = true;
+			for (const PostProcessImage& image : images)
+			{
+				if (&image != &newImage && image.Target == target && image.LastPass >= p)
+				{
+					free = false;
+					break;
+				}
+			}
+			if (free)  newImage.Target = target;
+		}
+		if (newImage.Target == static_cast<int>(targetDownscales.size()))  targetDownscales.push_back(newImage.Downscale);
+		mCompiled.TargetCount = static_cast<int>(targetDownscales.size());
+	};
+
+	for (int p = 0; p < numPasses; ++p)
+	{
+		PostProcessImage& output = images[passes[p].Output];
+		if (output.Target >= 0 || output.Target == OUTPUT_TARGET)  continue;
+
+		// A pass working in place writes to the target its input is in (no longer needed after this pass),
+		// the scratch target for its region is any other free one
+		if (passes[p].Scratch >= 0)
+		{
+			output.Target = images[passes[p].Inputs[0]].Target;
+			assignTarget(images[passes[p].Scratch], p);
+		}
+		else
+		{
+			assignTarget(output, p);
+		}
+	}
+
+	const int fullSizeTargets = static_cast<int>(std::count(targetDownscales.begin(), targetDownscales.end(), 1));
+	if (mOptions.MaxTargets > 0 && fullSizeTargets > mOptions.MaxTargets)
+	{
+		fail("Chain needs " + std::to_string(fullSizeTargets) + " render targets but only " +
+		     std::to_string(mOptions.MaxTargets) + " are available");
+		return;
+	}
+
+	for (PostProcessPass& pass : passes)
+	{
+		for (int i = 0; i < pass.InputCount; ++i)
+		{
+			pass.Sources[i] = images[pass.Inputs[i]].Target;
+		}
+		pass.Target = images[pass.Output].Target;
+		if (pass.Scratch >= 0)  pass.Scratch = images[pass.Scratch].Target;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Execution
+//--------------------------------------------------------------------------------------
+
+// Compile the graph if necessary and run all its passes through the given backend
+// Returns false if the chain failed to compile (nothing is run in that case)
+bool RunPostProcessGraph(PostProcessGraph& graph, PostProcessBackend& backend)
+{
+	const CompiledPostProcessGraph& compiled = graph.Compile();
+	if (!compiled.Valid)  return false;
+
+	backend.ResetStats();
+	backend.BeginChain(compiled);
+	for (const PostProcessPass& pass : compiled.Passes)
+	{
+		backend.RunPass(graph, pass);
+	}
+	backend.EndChain();
+	return true;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Null backend
+//--------------------------------------------------------------------------------------
+
+void NullPostProcessBackend::BeginChain(const CompiledPostProcessGraph& compiled)
+{
+	mPasses.clear();
+	mTargetCount = compiled.TargetCount;
+	mTargetWrites.assign(mTargetCount, 0);
+	mTargetReads.assign(mTargetCount, 0);
+}
+
+void NullPostProcessBackend::EndChain()
+{
+	++mChainsRun;
+}
+
+void NullPostProcessBackend::RunPass(const PostProcessGraph& /*graph*/, const PostProcessPass& pass)
+{
+	mPasses.push_back(pass);
+	++mStats.Passes;
+	for (int i = 0; i < pass.InputCount; ++i)
+	{
+		++mTargetReads[pass.Sources[i]];
+	}
+
+	double pixels = static_cast<double>(mViewportWidth) * mViewportHeight / (pass.Downscale * pass.Downscale);
+	if (pass.Mode == PostProcessMode::ModelPolygon)     pixels *= mRegionFraction * pass.BatchedEffects.size();
+	else if (pass.Mode != PostProcessMode::Fullscreen)  pixels *= mRegionFraction;
+
+	if (pass.Target != OUTPUT_TARGET)  ++mTargetWrites[pass.Target];
+	if (pass.Scratch >= 0)
+	{
+		// Region copied to the scratch target, drawn there and copied back
+		++mTargetWrites[pass.Scratch];
+		CountCopy(2 * pixels);
+		CountDraw(pass.Scratch, pixels);
+	}
+	else
+	{
+		CountDraw(pass.Target, pixels);
+	}
+	if (pass.DrawToOutput)  CountDraw(OUTPUT_TARGET, pixels);
+}
@@ -0,0 +1,480 @@
+//--------------------------------------------------------------------------------------
+// Post-processing render graph
+//--------------------------------------------------------------------------------------
+// The post-process chain is a list of effects picked from the menu. Each effect declares one or more
+// nodes (e.g. Blur is a vertical then a horizontal node) and each node names the images it reads and
+// writes. The graph is compiled once into a flat list of passes with explicit image lifetimes and
+// render target assignments, then only recompiled when the chain itself changes.
+//
+// Compiled passes are run through a backend - the Direct3D backend in Scene.cpp or the null backend
+// below, which only records what would have been drawn. Nothing in this file depends on DirectX so
+// the graph can be built, compiled and inspected on any platform.
+
+#ifndef _POST_PROCESS_GRAPH_H_INCLUDED_
+#define _POST_PROCESS_GRAPH_H_INCLUDED_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Effects
+//--------------------------------------------------------------------------------------
+
+// Available post-processes
+enum class PostProcess
+{
+	None,
+	Copy,
+	Tint,
+	TintHue,
+	GreyNoise,
+	Burn,
+	Distort,
+	Spiral,
+	Blur,
+	SecondBlur,
+	Underwater,
+	HeatHaze,
+	NightVision,
+	Pixelation,
+	Scanlines,
+	Inverse,
+	BlackAndWhite,
+	SeeingWorlds,
+	SecondSeeingWorlds,
+	Bloom,
+	Merge,
+	Sigmoid,
+	VariableBlur,
+	Upsample, // Added by the graph compiler when a reduced resolution image is read at a higher resolution (see PostProcessEffect::Downscale)
+};
+
+// Where on screen a post-process is applied
+enum class PostProcessMode
+{
+	Fullscreen,
+	Area,
+	Polygon,
+	ModelPolygon
+};
+
+// Display names for the enums above, in the same order
+extern const char* PPNames[];
+extern const char* ModeNames[];
+
+
+// Settings for a single effect in the chain, only the member matching the effect is used
+struct PostProcessData
+{
+	union
+	{
+		struct
+		{
+			float rgbTop[3];
+			float rgbMid[3];
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+			void tint(float Top[], float Mid[])
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					rgbTop[i] = Top[i];
+					rgbMid[i] = Mid[i];
+				}
+			}
+		}tint;
+		struct
+		{
+			float Hue1[3];
+			float Hue2[3];
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+			void Hue(float Top[], float Mid[])
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					Hue1[i] = Top[i];
+					Hue2[i] = Mid[i];
+				}
+			}
+		}Hue;
+		struct
+		{
+			float grainSize;
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+		}Noise;
+		struct
+		{
+			float burnSpeed;
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+
+
+		}Burn;
+		struct
+		{
+			int blur;    // Number of pixels across the kernel
+			float sigma; // Standard deviation of the Gaussian in pixels
+			void Blur(int B, float S = 40.0f)
+			{
+				blur = B;
+				sigma = S;
+			}
+
+		}Blur;
+		struct
+		{
+			float threshold; // Brightness (0->1) above which colours glow
+			float intensity; // Strength of the glow
+			int   levels;    // Levels in the bloom pyramid (1->MAX_BLOOM_LEVELS), each one doubles the spread
+			float padding;
+			void Bloom(float T, float I, int L)
+			{
+				threshold = T;
+				intensity = I;
+				levels = L;
+			}
+		}Bloom;
+		struct
+		{
+			float Gamma;
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+
+		}Sigmoid;
+		struct
+		{
+			float innerRadius; // Blur radius in pixels in the middle of the area, out to the focus distance
+			float outerRadius; // Blur radius in pixels at the edge of the area's circle
+			float focus;       // Distance from the middle (0->1, 1 at the edge) where the radius starts to grow
+			int   boxes;       // Boxes stacked for each pixel (1->MAX_STACKED_BOXES), more are closer to a Gaussian
+			void VariableBlur(float I, float O, float F, int B)
+			{
+				innerRadius = I;
+				outerRadius = O;
+				focus = F;
+				boxes = B;
+			}
+		}VariableBlur;
+		struct
+		{
+			int blockWidth;  // Size of each block in pixels (1->MAX_PIXELATION_BLOCK)
+			int blockHeight;
+			int levels;      // Levels each colour channel is posterised to (1->MAX_PIXELATION_LEVELS)
+			void Pixelation(int W, int H, int L)
+			{
+				blockWidth = W;
+				blockHeight = H;
+				levels = L;
+			}
+		}Pixelation;
+		struct
+		{
+			float waterSpeed;
+			float padding; // As the GPU only allows padding of 4,8,16, not 12
+		}Water;
+		struct
+		{
+			float offset;
+			int   taps;       // Scene samples per pixel for the swirl (1->SEEING_WORLDS_TAPS), fewer are quicker but grainier
+			bool  stochastic; // Take a different set of the taps each frame rather than always the same ones
+		}SeeingWorlds;
+	};
+};
+
+
+//--------------------------------------------------------------------------------------
+// Declared chain
+//--------------------------------------------------------------------------------------
+
+// Image names with a special meaning in node inputs. An empty name means "the output of the previous node"
+// The scene is only rendered once. A node reading it keeps it alive in its render target until then, so the chain
+// uses an extra target instead of the scene being rendered again (or copied) just to keep an unprocessed version
+const std::string PostProcessSceneImage = "Scene"; // The scene as rendered, before any post-processing
+
+// One shader pass as declared by an effect
+struct PostProcessNode
+{
+	PostProcess              Process;
+	std::vector<std::string> Inputs; // Images read, slot 0 is the main input. Empty name = output of the previous node
+	std::string              Output; // Name for this node's output so later nodes can read it. Empty = anonymous
+};
+
+// One entry in the chain as the user sees it
+struct PostProcessEffect
+{
+	PostProcess     Process;
+	PostProcessMode Mode;
+	int             Region; // Index of the model/area the effect is applied to (the graph doesn't interpret this)
+	std::string     Name;   // Name of the region for display
+	PostProcessData Data;   // Settings shared by all the nodes of the effect
+
+	// The nodes of a full-screen effect draw at 1/Downscale of the viewport width and height - 1, 2 or 4. Low frequency
+	// effects (blurs, heat haze...) look much the same for a fraction of the pixels. Area and polygon effects are always 1
+	int Downscale = 1;
+
+	std::vector<PostProcessNode> Nodes;
+};
+
+// Return the nodes that make up the given effect, e.g. Blur is a vertical and a horizontal blur node
+std::vector<PostProcessNode> DeclarePostProcessNodes(PostProcess process);
+
+// Settings an effect starts with when added from the menu (or read from a chain file without them)
+PostProcessData DefaultPostProcessData(PostProcess process);
+
+// Returns true if two effects of the given kind would draw the same with these settings. Only the settings the effect uses
+// are compared, so padding and the other members of the union don't matter
+bool SamePostProcessSettings(PostProcess process, const PostProcessData& a, const PostProcessData& b);
+
+
+//--------------------------------------------------------------------------------------
+// Compiled graph
+//--------------------------------------------------------------------------------------
+
+// Maximum number of images a single pass can read (t0, t1...)
+const int MAX_PASS_INPUTS = 2;
+
+// Target index for the backend's final output (the back buffer). The last image of the chain is written here
+const int OUTPUT_TARGET = -2;
+
+// Target index for draws to textures a backend keeps for itself, e.g. the bloom pyramid (for statistics only)
+const int INTERNAL_TARGET = -3;
+
+// Maximum number of colour effects merged into a single pass (see ColourEffects.h)
+const int MAX_FUSED_EFFECTS = 8;
+
+// Largest PostProcessEffect::Downscale
+const int MAX_DOWNSCALE = 4;
+
+// Width or height of a render target at the given resolution (see PostProcessEffect::Downscale), never less than one pixel
+inline int DownscaledSize(int size, int downscale)  { return std::max(size / downscale, 1); }
+
+// An image flowing through the chain and the range of passes it is alive for
+struct PostProcessImage
+{
+	std::string Name;
+	int         FirstPass; // First pass writing the image, -1 for images that exist before the chain runs
+	int         LastPass;  // Last pass reading (or writing) the image
+	int         Target;    // Render target holding the image, or OUTPUT_TARGET
+	int         Downscale; // Image is 1/Downscale of the viewport width and height
+};
+
+// A single draw in the compiled chain
+struct PostProcessPass
+{
+	int             Effect;  // Index of the effect in the chain this pass came from
+	int             Node;    // Index of the node within that effect, -1 for passes added by the compiler
+	PostProcess     Process;
+	PostProcessMode Mode;
+
+	int InputCount;
+	int Inputs[MAX_PASS_INPUTS];  // Images read
+	int Sources[MAX_PASS_INPUTS]; // Render targets holding the images read
+	int Output;                   // Image written
+	int Target;                   // Render target written, OUTPUT_TARGET for the last image of the chain
+	int Downscale;                // Size of the output (and so the viewport for the draw), see PostProcessEffect::Downscale
+
+	// Upsample passes read the reduced resolution image in slot 0 and a full resolution image to guide it in slot 1 (the last
+	// image drawn at the pass's own resolution), so edges in the guide stay sharp rather than being blurred by the enlargement
+
+	// A run of full-screen colour effects is merged into one pass. Process is then the first effect of
+	// the run and FusedEffects lists the effect index of each one in order. FusedCount is 1 for other passes
+	int FusedCount;
+	int FusedEffects[MAX_FUSED_EFFECTS];
+
+	// ModelPolygon passes: the effect index of each model's polygon drawn by the pass. A run of ModelPolygon effects of the same
+	// kind with the same settings is batched into one pass (see BatchModelPolygons), drawn with the settings of the first
+	std::vector<int> BatchedEffects;
+
+	bool DrawToOutput; // Also draw this pass to the final output (only in EveryPassToOutput mode)
+
+	// Area and polygon passes that work in place (see RegionsInPlace) write to the render target they read, Target is
+	// then the same as Sources[0]. The region is copied to this scratch target, drawn to there and copied back. -1 otherwise
+	int Scratch;
+};
+
+// Settings for compilation
+struct PostProcessCompileOptions
+{
+	int  MaxTargets = 0;             // Number of full size render targets the backend can provide, including the one the scene is rendered
+	                                 // to, or 0 for no limit. The app and CPU backend create targets as needed (see RenderTargetPool), so
+	                                 // only a backend with a fixed set of targets sets this. Reduced resolution targets don't count
+	bool FuseColourEffects = true;   // Merge runs of full-screen colour effects into single passes
+
+	// Area and polygon effects are drawn over a full-screen copy of their input. Set this to work on the input's own render
+	// target instead where nothing later needs the input, so only the pixels around the region are touched
+	bool RegionsInPlace = true;
+
+	// Draw a run of ModelPolygon effects of the same kind and settings (e.g. a row of windows) as a single pass. All the
+	// polygons of the run read the image from before the run, which only makes a difference where they overlap
+	bool BatchModelPolygons = true;
+
+	// Normally the passes ping-pong between the render targets and only the last one writes the final output.
+	// Set this to draw every pass to the output as well, as the chain originally did - for comparing the cost only
+	bool EveryPassToOutput = false;
+};
+
+// Result of compiling the chain
+struct CompiledPostProcessGraph
+{
+	std::vector<PostProcessPass>  Passes;
+	std::vector<PostProcessImage> Images;      // Image 0 is the rendered scene the chain starts from (PostProcessSceneImage)
+	int                           TargetCount; // Render targets actually used (target 0 always holds the rendered scene), not including the output
+	std::vector<int>              TargetDownscales; // Size of each of those render targets, see PostProcessEffect::Downscale
+	bool                          Valid;
+	std::string                   Error;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Graph
+//--------------------------------------------------------------------------------------
+
+class PostProcessGraph
+{
+public:
+	//-------------------------------------
+	// Chain editing
+	//-------------------------------------
+	// Any change to the chain structure marks it for recompilation. Changing the settings of an
+	// existing effect (its Data) does not, passes look the settings up when they are run - except
+	// that a batch of model polygons whose settings no longer match is recompiled unbatched
+
+	// Add an effect to the end of the chain, returns its index
+	int AddEffect(PostProcess process, PostProcessMode mode, int region, const std::string& name, const PostProcessData& data);
+
+	// Move an effect one place up (direction -1) or down (direction +1) the chain. Returns false if it can't move
+	bool MoveEffect(int index, int direction);
+
+	void RemoveEffect(int index);
+	void Clear();
+
+	// Change the resolution an effect is drawn at (1, 2 or 4, see PostProcessEffect::Downscale). Area and polygon effects stay at full
+	// resolution. Returns false if the value isn't allowed
+	bool SetEffectDownscale(int index, int downscale);
+
+	int                EffectCount() const  { return static_cast<int>(mEffects.size()); }
+	PostProcessEffect& Effect(int index)    { return mEffects[index]; }
+	const PostProcessEffect& Effect(int index) const  { return mEffects[index]; }
+
+	void SetCompileOptions(const PostProcessCompileOptions& options)  { mOptions = options;  mDirty = true; }
+	const PostProcessCompileOptions& CompileOptions() const  { return mOptions; }
+
+
+	//-------------------------------------
+	// Compilation
+	//-------------------------------------
+
+	// Return the compiled chain, compiling it first if the chain has changed since the last call (or a batch of model
+	// polygons has had its settings changed, see BatchModelPolygons)
+	const CompiledPostProcessGraph& Compile();
+
+	// Number of times the chain has actually been compiled - for checking recompiles only happen on change
+	int CompileCount() const  { return mCompileCount; }
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	void CompileChain();
+
+	// Returns true if the effects of a batched ModelPolygon pass in the compiled chain no longer have the same settings
+	bool BatchSettingsChanged() const;
+
+	// Return the index of the named image in the compiled graph, or -1 if there isn't one
+	int FindImage(const std::string& name) const;
+
+	std::vector<PostProcessEffect> mEffects;
+	PostProcessCompileOptions      mOptions;
+
+	CompiledPostProcessGraph mCompiled;
+	bool mDirty = true;
+	int  mCompileCount = 0;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Execution
+//--------------------------------------------------------------------------------------
+
+// Work done by the last chain run, to show the cost of the chain and so it can be checked without a GPU
+struct PostProcessStats
+{
+	int    Passes       = 0; // Passes run
+	int    Draws        = 0; // Draw calls, more than Passes when passes are also drawn to the output
+	int    OutputWrites = 0; // Draws to the final output (back buffer). 1 per chain (2 if the last effect is an area one, with
+	                         // the copy under it) unless in EveryPassToOutput mode
+	double PixelsFilled = 0; // Pixels written by all the draws
+	double PixelsCopied = 0; // Pixels copied between render targets without drawing (regions of passes working in place)
+};
+
+// Interface to something that can run compiled passes
+class PostProcessBackend
+{
+public:
+	virtual ~PostProcessBackend() {}
+
+	// Statistics for the last chain run. Backends fill in the draw counts as they run passes
+	const PostProcessStats& Stats() const  { return mStats; }
+	void ResetStats()                      { mStats = PostProcessStats(); }
+
+	// Called before the first and after the last pass of the chain each frame
+	virtual void BeginChain(const CompiledPostProcessGraph& compiled) = 0;
+	virtual void EndChain() = 0;
+
+	// Run a single pass. The effect settings are found from pass.Effect
+	virtual void RunPass(const PostProcessGraph& graph, const PostProcessPass& pass) = 0;
+
+protected:
+	// Record a draw to the given target covering the given number of pixels
+	void CountDraw(int target, double pixels)
+	{
+		++mStats.Draws;
+		if (target == OUTPUT_TARGET)  ++mStats.OutputWrites;
+		mStats.PixelsFilled += pixels;
+	}
+
+	// Record a copy of the given number of pixels from one target to another
+	void CountCopy(double pixels)  { mStats.PixelsCopied += pixels; }
+
+	PostProcessStats mStats;
+};
+
+// Compile the graph if necessary and run all its passes through the given backend
+// Returns false if the chain failed to compile (nothing is run in that case)
+bool RunPostProcessGraph(PostProcessGraph& graph, PostProcessBackend& backend);
+
+
+// Backend that draws nothing, it records the passes it is given so pass counts and render
+// target use can be checked without a GPU. Full-screen draws are counted as filling the whole viewport
+// (less for reduced resolution passes) and each area/polygon as filling the given fraction of it
+class NullPostProcessBackend : public PostProcessBackend
+{
+public:
+	NullPostProcessBackend(int viewportWidth = 1, int viewportHeight = 1, float regionFraction = 1.0f)
+		: mViewportWidth(viewportWidth), mViewportHeight(viewportHeight), mRegionFraction(regionFraction) {}
+
+	void BeginChain(const CompiledPostProcessGraph& compiled) override;
+	void EndChain() override;
+	void RunPass(const PostProcessGraph& graph, const PostProcessPass& pass) override;
+
+	// Results of the last chain run
+	const std::vector<PostProcessPass>& Passes() const  { return mPasses; }
+	int PassCount() const       { return static_cast<int>(mPasses.size()); }
+	int TargetCount() const     { return mTargetCount; }  // Render targets used by the chain
+	int TargetWrites(int target) const  { return (target == OUTPUT_TARGET) ? mStats.OutputWrites : mTargetWrites[target]; }
+	int TargetReads(int target) const   { return mTargetReads[target]; }
+	int ChainsRun() const       { return mChainsRun; }
+
+private:
+	std::vector<PostProcessPass> mPasses;
+	std::vector<int> mTargetWrites;
+	std::vector<int> mTargetReads;
+	int mViewportWidth;
+	int mViewportHeight;
+	float mRegionFraction;
+	int mTargetCount = 0;
+	int mChainsRun = 0;
+};
+
+
+#endif //_POST_PROCESS_GRAPH_H_INCLUDED_
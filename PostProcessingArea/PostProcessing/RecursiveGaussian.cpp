@@ -0,0 +1,343 @@
+//--------------------------------------------------------------------------------------
+// Recursive (IIR) Gaussian blur
+//--------------------------------------------------------------------------------------
+
+#include "RecursiveGaussian.h"
+#include "SeparableBlur.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Coefficients
+//--------------------------------------------------------------------------------------
+
+// Work out the filter for the given sigma (at least 0.5, the least the approximation is good for)
+RecursiveGaussian MakeRecursiveGaussian(float sigma)
+{
+	RecursiveGaussian filter;
+	filter.Sigma = std::max(sigma, 0.5f);
+
+	// Young & van Vliet, "Recursive implementation of the Gaussian filter" (1995)
+	const double s = filter.Sigma;
+	const double q = (s >= 2.5) ? 0.98711 * s - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1 - 0.26891 * s);
+	const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+	const double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+	const double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+	const double b3 = 0.422205 * q * q * q;
+	const double a[3] = { b1 / b0, b2 / b0, b3 / b0 };
+	const double B = 1 - (a[0] + a[1] + a[2]);
+
+	filter.B = B;
+	for (int i = 0; i < 3; ++i)  filter.A[i] = a[i];
+
+	// Past the end of a row the input stays at the edge pixel, so the forward results less the edge pixel just carry on
+	// decaying from the last three. Run that out for each of the three on its own, far enough for it to die away, then
+	// run the backward pass back to the end of the row - giving the three results the backward pass starts from
+	const int length = static_cast<int>(20 * s) + 100;
+	for (int j = 0; j < 3; ++j)
+	{
+		std::vector<double> forward(length + 3, 0.0);
+		forward[2 - j] = 1; // forward[3 + n] is the nth result past the end
+		for (int n = 3; n < length + 3; ++n)
+		{
+			forward[n] = a[0] * forward[n - 1] + a[1] * forward[n - 2] + a[2] * forward[n - 3];
+		}
+
+		std::vector<double> backward(length + 3, 0.0);
+		for (int n = length - 1; n >= 0; --n)
+		{
+			backward[n] = B * forward[3 + n] + a[0] * backward[n + 1] + a[1] * backward[n + 2] + a[2] * backward[n + 3];
+		}
+		for (int k = 0; k < 3; ++k)  filter.End[k][j] = backward[k];
+	}
+
+	return filter;
+}
+
+
+// Work out the filter with the same spread (standard deviation) as the kernel, allowing for its cut-off at its radius
+RecursiveGaussian MakeRecursiveGaussian(const GaussianKernel& kernel)
+{
+	double total = kernel.Weights[0], spread = 0;
+	for (int x = 1; x <= kernel.Radius; ++x)
+	{
+		total  += 2.0 * kernel.Weights[x];
+		spread += 2.0 * kernel.Weights[x] * x * x;
+	}
+	return MakeRecursiveGaussian(static_cast<float>(std::sqrt(spread / total)));
+}
+
+
+// Whether the recursive filter is close enough to the kernel to be used in its place
+bool RecursiveGaussianFits(const GaussianKernel& kernel)
+{
+	return kernel.Radius >= RECURSIVE_GAUSSIAN_MIN_REACH * kernel.Sigma;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Steps
+//--------------------------------------------------------------------------------------
+// The filter runs along a strip, one step at a time: a row of the image for the vertical blur, or a column of a block of
+// rows for the horizontal. Each step is count pixels side by side, all filtered at once, so the work vectorises across
+// them however the filter runs. The last three results are kept as doubles, each new one is written out as a float and
+// replaces the oldest. Every version works out B*in + A0*p1 + A1*p2 + A2*p3 in that order, with no FMA
+
+namespace
+{
+	// Rows of the image in a block for the horizontal blur, and columns in a strip for the vertical
+	const int ROWS_PER_TASK    = 16;
+	const int COLUMNS_PER_TASK = 64;
+
+	using RecursiveStepFunction = void (*)(float* out, const float* in, const double* p1, const double* p2, double* p3,
+	                                       int count, const RecursiveGaussian& filter);
+
+	void RecursiveStepScalar(float* out, const float* in, const double* p1, const double* p2, double* p3, int count,
+	                         const RecursiveGaussian& filter)
+	{
+		for (int i = 0; i < count * 4; ++i)
+		{
+			double sum = filter.B * in[i];
+			sum = sum + filter.A[0] * p1[i];
+			sum = sum + filter.A[1] * p2[i];
+			sum = sum + filter.A[2] * p3[i];
+			p3[i]  = sum;
+			out[i] = static_cast<float>(sum);
+		}
+	}
+
+
+#if defined(POST_PROCESS_X86)
+	// Two channels per register
+	void RecursiveStepSSE2(float* out, const float* in, const double* p1, const double* p2, double* p3, int count,
+	                       const RecursiveGaussian& filter)
+	{
+		const __m128d b  = _mm_set1_pd(filter.B);
+		const __m128d a0 = _mm_set1_pd(filter.A[0]);
+		const __m128d a1 = _mm_set1_pd(filter.A[1]);
+		const __m128d a2 = _mm_set1_pd(filter.A[2]);
+		for (int i = 0; i < count * 4; i += 4)
+		{
+			__m128  input = _mm_loadu_ps(in + i);
+			__m128d low   = _mm_mul_pd(b, _mm_cvtps_pd(input));
+			__m128d high  = _mm_mul_pd(b, _mm_cvtps_pd(_mm_movehl_ps(input, input)));
+			low  = _mm_add_pd(low,  _mm_mul_pd(a0, _mm_loadu_pd(p1 + i)));
+			high = _mm_add_pd(high, _mm_mul_pd(a0, _mm_loadu_pd(p1 + i + 2)));
+			low  = _mm_add_pd(low,  _mm_mul_pd(a1, _mm_loadu_pd(p2 + i)));
+			high = _mm_add_pd(high, _mm_mul_pd(a1, _mm_loadu_pd(p2 + i + 2)));
+			low  = _mm_add_pd(low,  _mm_mul_pd(a2, _mm_loadu_pd(p3 + i)));
+			high = _mm_add_pd(high, _mm_mul_pd(a2, _mm_loadu_pd(p3 + i + 2)));
+			_mm_storeu_pd(p3 + i,     low);
+			_mm_storeu_pd(p3 + i + 2, high);
+			_mm_storeu_ps(out + i, _mm_movelh_ps(_mm_cvtpd_ps(low), _mm_cvtpd_ps(high)));
+		}
+	}
+
+
+	// A pixel (four channels) per register, two pixels at a time
+	AVX2_FUNCTION void RecursiveStepAVX2(float* out, const float* in, const double* p1, const double* p2, double* p3, int count,
+	                                     const RecursiveGaussian& filter)
+	{
+		const __m256d b  = _mm256_set1_pd(filter.B);
+		const __m256d a0 = _mm256_set1_pd(filter.A[0]);
+		const __m256d a1 = _mm256_set1_pd(filter.A[1]);
+		const __m256d a2 = _mm256_set1_pd(filter.A[2]);
+		int i = 0;
+		for (; i + 8 <= count * 4; i += 8)
+		{
+			__m256d first  = _mm256_mul_pd(b, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+			__m256d second = _mm256_mul_pd(b, _mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)));
+			first  = _mm256_add_pd(first,  _mm256_mul_pd(a0, _mm256_loadu_pd(p1 + i)));
+			second = _mm256_add_pd(second, _mm256_mul_pd(a0, _mm256_loadu_pd(p1 + i + 4)));
+			first  = _mm256_add_pd(first,  _mm256_mul_pd(a1, _mm256_loadu_pd(p2 + i)));
+			second = _mm256_add_pd(second, _mm256_mul_pd(a1, _mm256_loadu_pd(p2 + i + 4)));
+			first  = _mm256_add_pd(first,  _mm256_mul_pd(a2, _mm256_loadu_pd(p3 + i)));
+			second = _mm256_add_pd(second, _mm256_mul_pd(a2, _mm256_loadu_pd(p3 + i + 4)));
+			_mm256_storeu_pd(p3 + i,     first);
+			_mm256_storeu_pd(p3 + i + 4, second);
+			_mm_storeu_ps(out + i,     _mm256_cvtpd_ps(first));
+			_mm_storeu_ps(out + i + 4, _mm256_cvtpd_ps(second));
+		}
+		if (i < count * 4)  RecursiveStepSSE2(out + i, in + i, p1 + i, p2 + i, p3 + i, 1, filter);
+	}
+#endif
+
+
+	RecursiveStepFunction ChooseRecursiveStep(SimdLevel level)
+	{
+#if defined(POST_PROCESS_X86)
+		switch (SupportedSimdLevel(level))
+		{
+		case SimdLevel::AVX2:  return RecursiveStepAVX2;
+		case SimdLevel::SSE2:  return RecursiveStepSSE2;
+		default:               break;
+		}
+#endif
+		return RecursiveStepScalar;
+	}
+
+	float*       Floats(ColourRGBA* pixels)        { return &pixels->r; }
+	const float* Floats(const ColourRGBA* pixels)  { return &pixels->r; }
+
+
+	// Filter a strip of length steps, each of count pixels, forwards then backwards. in(i) and out(i) return the ith step
+	// of the input and of the result, which can be the same memory
+	template <typename In, typename Out>
+	void FilterStrip(In in, Out out, int length, int count, const RecursiveGaussian& filter, RecursiveStepFunction step)
+	{
+		const int floats = count * 4;
+		std::vector<double> state(3 * floats);
+		double* p1 = &state[0];
+		double* p2 = &state[floats];
+		double* p3 = &state[2 * floats];
+
+		// The last step of the input, kept as the results may overwrite it
+		std::vector<float> edge(Floats(in(length - 1)), Floats(in(length - 1)) + floats);
+
+		// Forwards, starting with the first step repeated before the start - the filter's steady state for that input
+		std::copy(Floats(in(0)), Floats(in(0)) + floats, p1);
+		std::copy(p1, p1 + floats, p2);
+		std::copy(p1, p1 + floats, p3);
+		for (int i = 0; i < length; ++i)
+		{
+			step(Floats(out(i)), Floats(in(i)), p1, p2, p3, count, filter);
+			std::swap(p2, p3);
+			std::swap(p1, p2);
+		}
+
+		// Backwards, starting from where the filter would be had the last step gone on forever
+		std::vector<double> end(3 * floats);
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int i = 0; i < floats; ++i)
+			{
+				double sum = edge[i];
+				sum = sum + filter.End[k][0] * (p1[i] - edge[i]);
+				sum = sum + filter.End[k][1] * (p2[i] - edge[i]);
+				sum = sum + filter.End[k][2] * (p3[i] - edge[i]);
+				end[k * floats + i] = sum;
+			}
+		}
+		std::copy(end.begin(), end.end(), state.begin());
+		p1 = &state[0];
+		p2 = &state[floats];
+		p3 = &state[2 * floats];
+		for (int i = length - 1; i >= 0; --i)
+		{
+			step(Floats(out(i)), Floats(out(i)), p1, p2, p3, count, filter);
+			std::swap(p2, p3);
+			std::swap(p1, p2);
+		}
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Images
+//--------------------------------------------------------------------------------------
+
+// Blur all four channels of source in one direction, writing to target (resized to match)
+void RecursiveBlurImage(const Image& source, Image& target, const RecursiveGaussian& filter, bool horizontal, SimdLevel level, TaskPool* pool)
+{
+	const int width  = source.Width();
+	const int height = source.Height();
+	target.Resize(width, height);
+	if (width == 0 || height == 0)  return;
+
+	RecursiveStepFunction step = ChooseRecursiveStep(level);
+
+	// Along rows: transpose a block of rows so each column of it is a step, filter that and transpose back
+	auto blurRows = [&](int task)
+	{
+		const int firstRow = task * ROWS_PER_TASK;
+		const int rows = std::min(ROWS_PER_TASK, height - firstRow);
+		std::vector<ColourRGBA> block(width * rows);
+		for (int row = 0; row < rows; ++row)
+		{
+			const ColourRGBA* pixels = source.Row(firstRow + row);
+			for (int x = 0; x < width; ++x)  block[x * rows + row] = pixels[x];
+		}
+
+		auto column = [&](int x) { return &block[x * rows]; };
+		FilterStrip(column, column, width, rows, filter, step);
+
+		for (int row = 0; row < rows; ++row)
+		{
+			ColourRGBA* pixels = target.Row(firstRow + row);
+			for (int x = 0; x < width; ++x)  pixels[x] = block[x * rows + row];
+		}
+	};
+
+	// Down columns: each row of a strip of columns is a step, filtered straight from the source to the target
+	auto blurColumns = [&](int task)
+	{
+		const int firstColumn = task * COLUMNS_PER_TASK;
+		const int columns = std::min(COLUMNS_PER_TASK, width - firstColumn);
+		FilterStrip([&](int y) { return source.Row(y) + firstColumn; }, [&](int y) { return target.Row(y) + firstColumn; },
+		            height, columns, filter, step);
+	};
+
+	const int tasks = horizontal ? (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK : (width + COLUMNS_PER_TASK - 1) / COLUMNS_PER_TASK;
+	std::function<void(int)> task = horizontal ? std::function<void(int)>(blurRows) : std::function<void(int)>(blurColumns);
+	if (pool)  pool->ParallelFor(tasks, task);
+	else       for (int i = 0; i < tasks; ++i)  task(i);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Accuracy
+//--------------------------------------------------------------------------------------
+
+// Compare the recursive filter standing in for the kernel with the kernel itself, on a single pixel and blurring the image both ways
+RecursiveGaussianError MeasureRecursiveGaussian(const GaussianKernel& kernel, const Image& image)
+{
+	RecursiveGaussianError error = {};
+	const RecursiveGaussian filter = MakeRecursiveGaussian(kernel);
+	error.KernelPeak = kernel.Weights[0];
+
+	// A single white pixel in the middle of a row long enough that the response has died away at the ends
+	const int half = kernel.Radius + static_cast<int>(std::ceil(8 * filter.Sigma)) + 8;
+	Image pixel(2 * half + 1, 1), response;
+	pixel.Pixel(half, 0) = ColourRGBA(1, 1, 1, 1);
+	RecursiveBlurImage(pixel, response, filter, true, SimdLevel::Scalar);
+	for (int x = 0; x < response.Width(); ++x)
+	{
+		int   distance   = std::abs(x - half);
+		float weight     = (distance <= kernel.Radius) ? kernel.Weights[distance] : 0.0f;
+		float difference = std::abs(response.Pixel(x, 0).r - weight);
+		error.KernelMax    = std::max(error.KernelMax, difference);
+		error.KernelTotal += difference;
+	}
+
+	// Both blurs of the image, as the Blur and SecondBlur passes
+	Image exact, recursive, temp;
+	SeparableBlurImage(image, temp, kernel, false);
+	SeparableBlurImage(temp, exact, kernel, true);
+	RecursiveBlurImage(image, temp, filter, false);
+	RecursiveBlurImage(temp, recursive, filter, true);
+	double sumSq = 0;
+	for (int y = 0; y < image.Height(); ++y)
+	{
+		const float* a = Floats(exact.Row(y));
+		const float* b = Floats(recursive.Row(y));
+		for (int i = 0; i < image.Width() * 4; ++i)
+		{
+			float difference = std::abs(a[i] - b[i]);
+			error.ImageMax = std::max(error.ImageMax, difference);
+			sumSq += static_cast<double>(difference) * difference;
+		}
+	}
+	const double values = 4.0 * image.Width() * image.Height();
+	error.ImageRms = (values > 0) ? static_cast<float>(std::sqrt(sumSq / values)) : 0.0f;
+
+	return error;
+}
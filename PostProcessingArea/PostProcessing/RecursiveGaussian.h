@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------
+// Recursive (IIR) Gaussian blur
+//--------------------------------------------------------------------------------------
+// A kernel blur costs more the wider the kernel. The Young - van Vliet recursive filter approximates a
+// Gaussian of any sigma with a fixed amount of work per pixel instead: a pass forwards along each
+// row, each result a weighted sum of the input pixel and the three results before it, then the same
+// pass backwards over those. Wide blurs cost the same as narrow ones.
+//
+// Edges are handled exactly as the clamp sampler would: the steady state of the edge pixel is used
+// before the start of a row, and the backward pass starts from the results the filter would have
+// reached had the row gone on with the edge pixel forever (Triggs & Sdika).
+//
+// It is only an approximation - a few percent of the kernel's peak at worst, and kernels cut short by
+// their radius (sigma large for the radius, as the Blur effect's defaults) come out as the Gaussian
+// of the same spread. MeasureRecursiveGaussian reports how far it is from the kernel it stands in for.
+// The CPU backend uses it for blurs wider than a radius it is given (SetRecursiveBlurRadius), when the
+// kernel reaches far enough from the centre to be close to a Gaussian (RecursiveGaussianFits).
+
+#ifndef _RECURSIVE_GAUSSIAN_H_INCLUDED_
+#define _RECURSIVE_GAUSSIAN_H_INCLUDED_
+
+#include "GaussianKernel.h"
+#include "CpuFeatures.h"
+#include "Image.h"
+
+class TaskPool;
+
+
+// Coefficients of the filter for one sigma. Each pass works out result = B * input + A[0] * result before + A[1] * the
+// one before that + A[2] * the one before that. For wide blurs B is tiny and the A's add up to nearly 1, so they and the
+// results fed back are kept as doubles - with floats the rounding builds up to a visible error by sigma 60
+struct RecursiveGaussian
+{
+	float  Sigma;
+	double B;
+	double A[3];
+
+	// The three results past the end of a row, before the backward pass, are the edge pixel plus End times the last three
+	// forward results less the edge pixel. End[k][j] is the weight of the jth from last result in the kth past the end
+	double End[3][3];
+};
+
+// Work out the filter for the given sigma (at least 0.5, the least the approximation is good for)
+RecursiveGaussian MakeRecursiveGaussian(float sigma);
+
+// Work out the filter with the same spread (standard deviation) as the kernel, allowing for its cut-off at its radius
+RecursiveGaussian MakeRecursiveGaussian(const GaussianKernel& kernel);
+
+
+// Kernels cut off closer to the centre than this many sigmas are too far from a Gaussian for the filter to stand in for
+// them. At 2.5 it is within about 4% of the kernel's peak, at 2 nearly 10%
+const float RECURSIVE_GAUSSIAN_MIN_REACH = 2.5f;
+
+// Whether the recursive filter is close enough to the kernel to be used in its place
+bool RecursiveGaussianFits(const GaussianKernel& kernel);
+
+
+// Blur all four channels of source in one direction, writing to target (resized to match). Uses the given instruction
+// set if the processor has it, and the pool's threads if one is given. Every level gives exactly the same result
+void RecursiveBlurImage(const Image& source, Image& target, const RecursiveGaussian& filter, bool horizontal,
+                        SimdLevel level = BestSimdLevel(), TaskPool* pool = nullptr);
+
+
+// How far the recursive filter is from the kernel it stands in for. Errors are absolute, in 0->1 colour units
+struct RecursiveGaussianError
+{
+	float KernelPeak;  // Centre weight of the kernel, for scale
+	float KernelMax;   // Largest difference between the kernel's weights and the filter's response to a single pixel
+	float KernelTotal; // Sum of the differences - the part of the blur in the wrong place
+
+	float ImageMax;    // Largest difference between the two blurs (both directions) of the given image
+	float ImageRms;    // Root mean square of the differences
+};
+
+// Compare the recursive filter standing in for the kernel (MakeRecursiveGaussian(kernel)) with the kernel itself, on a
+// single pixel and blurring the given image both ways
+RecursiveGaussianError MeasureRecursiveGaussian(const GaussianKernel& kernel, const Image& image);
+
+
+#endif //_RECURSIVE_GAUSSIAN_H_INCLUDED_
@@ -0,0 +1,262 @@
+//--------------------------------------------------------------------------------------
+// Pool of render targets for the post-process chain
+//--------------------------------------------------------------------------------------
+
+#include "RenderTargetPool.h"
+#include "Bloom.h"
+#include "Pixelation.h"
+
+#include <algorithm>
+
+
+//--------------------------------------------------------------------------------------
+// Targets
+//--------------------------------------------------------------------------------------
+
+// Bytes in a pixel of the given format
+int RenderTargetFormatBytes(RenderTargetFormat format)
+{
+	switch (format)
+	{
+	case RenderTargetFormat::RGBA8:        return 4;
+	case RenderTargetFormat::RGBA16Float:  return 8;
+	case RenderTargetFormat::RGBA32Uint:   return 16;
+	}
+	return 0;
+}
+
+
+// Memory used by a target of the given description
+size_t RenderTargetBytes(const RenderTargetDesc& desc)
+{
+	return static_cast<size_t>(desc.Width) * desc.Height * RenderTargetFormatBytes(desc.Format);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Null device
+//--------------------------------------------------------------------------------------
+
+void* NullRenderTargetDevice::CreateTarget(const RenderTargetDesc& desc)
+{
+	++mCreated;
+	return new RenderTargetDesc(desc);
+}
+
+void NullRenderTargetDevice::ReleaseTarget(void* target)
+{
+	++mReleased;
+	delete static_cast<RenderTargetDesc*>(target);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Pool
+//--------------------------------------------------------------------------------------
+
+// Return a target of the given description, reusing a released one if there is one
+void* RenderTargetPool::Acquire(const RenderTargetDesc& desc)
+{
+	auto entry = std::find_if(mTargets.begin(), mTargets.end(), [&](const Entry& e) { return !e.InUse && e.Desc == desc; });
+	if (entry == mTargets.end())
+	{
+		void* target = mDevice.CreateTarget(desc);
+		if (target == nullptr)  return nullptr;
+
+		++mCreated;
+		mHeldBytes += RenderTargetBytes(desc);
+		mTargets.push_back({ desc, target, false, false });
+		entry = mTargets.end() - 1;
+	}
+
+	entry->InUse = true;
+	entry->Used = true;
+	mBytesInUse += RenderTargetBytes(desc);
+	mPeakBytes = std::max(mPeakBytes, mBytesInUse);
+	return entry->Target;
+}
+
+
+// Give a target from Acquire back to the pool
+void RenderTargetPool::Release(void* target)
+{
+	for (Entry& entry : mTargets)
+	{
+		if (entry.Target == target && entry.InUse)
+		{
+			entry.InUse = false;
+			entry.Used = true;
+			mBytesInUse -= RenderTargetBytes(entry.Desc);
+			return;
+		}
+	}
+}
+
+
+// Destroy the targets that weren't acquired or held since the last call
+void RenderTargetPool::EndFrame()
+{
+	for (Entry& entry : mTargets)
+	{
+		if (!entry.Used && !entry.InUse)
+		{
+			mDevice.ReleaseTarget(entry.Target);
+			mHeldBytes -= RenderTargetBytes(entry.Desc);
+			entry.Target = nullptr;
+		}
+		entry.Used = false;
+	}
+	mTargets.erase(std::remove_if(mTargets.begin(), mTargets.end(), [](const Entry& entry) { return entry.Target == nullptr; }),
+	               mTargets.end());
+
+	mLastPeakBytes = mPeakBytes;
+	mPeakBytes = mBytesInUse;
+}
+
+
+// Destroy every target
+void RenderTargetPool::Clear()
+{
+	for (Entry& entry : mTargets)  mDevice.ReleaseTarget(entry.Target);
+	mTargets.clear();
+	mBytesInUse = 0;
+	mPeakBytes = 0;
+	mHeldBytes = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Chain schedule
+//--------------------------------------------------------------------------------------
+
+// Working textures some effects draw before their pass, sized as the app's backend draws them
+void PassWorkingTargets(const PostProcessGraph& graph, const CompiledPostProcessGraph& compiled, const PostProcessPass& pass,
+                        int viewportWidth, int viewportHeight, std::vector<RenderTargetDesc>& descs)
+{
+	descs.clear();
+	const PostProcessData& data = graph.Effect(pass.Effect).Data;
+	if (pass.Process == PostProcess::Bloom)
+	{
+		// The pyramid is always built from the whole image
+		const int levels = std::min(std::max(data.Bloom.levels, 1), MAX_BLOOM_LEVELS);
+		for (int level = 0; level < levels; ++level)
+		{
+			descs.push_back({ BloomLevelSize(viewportWidth, level + 1), BloomLevelSize(viewportHeight, level + 1),
+			                  RenderTargetFormat::RGBA16Float, RENDER_TARGET_BIND_BOTH });
+		}
+	}
+	else if (pass.Process == PostProcess::VariableBlur)
+	{
+		// Two tables the size of the input to ping-pong between
+		const int downscale = compiled.TargetDownscales[pass.Sources[0]];
+		const RenderTargetDesc table = { DownscaledSize(viewportWidth, downscale), DownscaledSize(viewportHeight, downscale),
+		                                 RenderTargetFormat::RGBA32Uint, RENDER_TARGET_BIND_BOTH };
+		descs.push_back(table);
+		descs.push_back(table);
+	}
+	else if (pass.Process == PostProcess::Pixelation)
+	{
+		// A pixel per block
+		descs.push_back({ PixelationBlockCount(viewportWidth,  data.Pixelation.blockWidth),
+		                  PixelationBlockCount(viewportHeight, data.Pixelation.blockHeight),
+		                  RenderTargetFormat::RGBA8, RENDER_TARGET_BIND_BOTH });
+	}
+}
+
+
+// Work out when each target of the compiled chain is used
+void PostProcessTargetSchedule::Begin(const CompiledPostProcessGraph& compiled, int viewportWidth, int viewportHeight,
+                                      void* sceneTarget)
+{
+	mCompiled = &compiled;
+	mViewportWidth = viewportWidth;
+	mViewportHeight = viewportHeight;
+	mWorking.clear();
+
+	const int targetCount = static_cast<int>(compiled.TargetDownscales.size());
+	mDescs.resize(targetCount);
+	mFirstPass.assign(targetCount, -1);
+	mLastPass.assign(targetCount, -1);
+	mTargets.assign(targetCount, nullptr);
+	for (int target = 0; target < targetCount; ++target)
+	{
+		const int downscale = compiled.TargetDownscales[target];
+		mDescs[target] = { DownscaledSize(viewportWidth, downscale), DownscaledSize(viewportHeight, downscale),
+		                   RenderTargetFormat::RGBA8, RENDER_TARGET_BIND_BOTH };
+	}
+
+	// Every target a pass reads, draws to or uses as scratch. The output isn't a render target of the chain
+	auto use = [&](int target, int pass)
+	{
+		if (target <= 0)  return;
+		if (mFirstPass[target] < 0)  mFirstPass[target] = pass;
+		mLastPass[target] = pass;
+	};
+	for (int pass = 0; pass < static_cast<int>(compiled.Passes.size()); ++pass)
+	{
+		const PostProcessPass& p = compiled.Passes[pass];
+		for (int i = 0; i < p.InputCount; ++i)  use(p.Sources[i], pass);
+		use(p.Target, pass);
+		use(p.Scratch, pass);
+	}
+
+	if (targetCount > 0)  mTargets[0] = sceneTarget;
+}
+
+
+// Acquire the targets first used by the given pass and its working textures
+bool PostProcessTargetSchedule::BeforePass(const PostProcessGraph& graph, int pass, RenderTargetPool& pool)
+{
+	bool ok = true;
+	for (int target = 1; target < static_cast<int>(mTargets.size()); ++target)
+	{
+		if (mFirstPass[target] != pass)  continue;
+		mTargets[target] = pool.Acquire(mDescs[target]);
+		ok = ok && mTargets[target] != nullptr;
+	}
+
+	PassWorkingTargets(graph, *mCompiled, mCompiled->Passes[pass], mViewportWidth, mViewportHeight, mWorkingDescs);
+	mWorking.clear();
+	for (const RenderTargetDesc& desc : mWorkingDescs)
+	{
+		mWorking.push_back(pool.Acquire(desc));
+		ok = ok && mWorking.back() != nullptr;
+	}
+	return ok;
+}
+
+
+// Release the pass's working textures and the targets last used by it
+void PostProcessTargetSchedule::AfterPass(int pass, RenderTargetPool& pool)
+{
+	for (void* target : mWorking)
+	{
+		if (target)  pool.Release(target);
+	}
+	mWorking.clear();
+
+	for (int target = 1; target < static_cast<int>(mTargets.size()); ++target)
+	{
+		if (mLastPass[target] != pass || mTargets[target] == nullptr)  continue;
+		pool.Release(mTargets[target]);
+		mTargets[target] = nullptr;
+	}
+}
+
+
+// Release any targets still held
+void PostProcessTargetSchedule::End(RenderTargetPool& pool)
+{
+	for (void* target : mWorking)
+	{
+		if (target)  pool.Release(target);
+	}
+	mWorking.clear();
+
+	for (int target = 1; target < static_cast<int>(mTargets.size()); ++target)
+	{
+		if (mTargets[target] == nullptr)  continue;
+		pool.Release(mTargets[target]);
+		mTargets[target] = nullptr;
+	}
+}
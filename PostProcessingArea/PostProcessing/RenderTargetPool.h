@@ -0,0 +1,222 @@
+//--------------------------------------------------------------------------------------
+// Pool of render targets for the post-process chain
+//--------------------------------------------------------------------------------------
+// The app used to create the back and extra textures, the bloom pyramid, both summed-area tables and the
+// pixelation blocks at start up, whatever effects were in the chain, and kept every reduced resolution
+// target a chain had ever used. A chain of colour effects paid for a full-screen float pyramid and two
+// full-screen tables of 32-bit integers it never drew to.
+//
+// Now the targets come from a pool, keyed by size, format and bind flags. A target is acquired for the
+// passes that use it and released after the last one, when the pool can hand the same texture to the next
+// target with the same key - targets whose lifetimes don't overlap share the memory. Direct3D 11 has no
+// placed resources to alias memory between textures of different sizes or formats, so sharing a texture
+// is as far as aliasing goes. Targets not acquired during a frame are destroyed at the end of it, so the
+// pool settles on what the current chain needs at its busiest.
+//
+// The pool creates and destroys textures through a RenderTargetDevice. The app's creates Direct3D textures
+// (see Scene.cpp), NullRenderTargetDevice creates nothing so the pool and a chain's schedule of targets
+// (PostProcessTargetSchedule) can be run without a GPU
+
+#ifndef _RENDER_TARGET_POOL_H_INCLUDED_
+#define _RENDER_TARGET_POOL_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+
+#include <cstddef>
+#include <vector>
+
+
+//--------------------------------------------------------------------------------------
+// Targets
+//--------------------------------------------------------------------------------------
+
+// Pixel formats of the post-process targets
+enum class RenderTargetFormat
+{
+	RGBA8,       // The scene and the images of the chain
+	RGBA16Float, // The bloom pyramid, so the glow can add up to more than 1
+	RGBA32Uint,  // Summed-area tables, so the sums are exact
+};
+
+// Bytes in a pixel of the given format
+int RenderTargetFormatBytes(RenderTargetFormat format);
+
+// How a target can be bound, combined with |
+const unsigned RENDER_TARGET_BIND_OUTPUT = 1; // Drawn to
+const unsigned RENDER_TARGET_BIND_INPUT  = 2; // Read by shaders
+const unsigned RENDER_TARGET_BIND_BOTH   = RENDER_TARGET_BIND_OUTPUT | RENDER_TARGET_BIND_INPUT;
+
+// A target's key in the pool, targets with the same description can stand in for each other
+struct RenderTargetDesc
+{
+	int                Width;
+	int                Height;
+	RenderTargetFormat Format;
+	unsigned           BindFlags;
+
+	bool operator==(const RenderTargetDesc& other) const
+	{
+		return Width == other.Width && Height == other.Height && Format == other.Format && BindFlags == other.BindFlags;
+	}
+};
+
+// Memory used by a target of the given description
+size_t RenderTargetBytes(const RenderTargetDesc& desc);
+
+
+//--------------------------------------------------------------------------------------
+// Devices
+//--------------------------------------------------------------------------------------
+
+// Creates and destroys the textures of the pool. A target is whatever the device uses for one, the pool only passes it around
+class RenderTargetDevice
+{
+public:
+	virtual ~RenderTargetDevice() {}
+
+	// Create a target of the given description, returns nullptr on failure
+	virtual void* CreateTarget(const RenderTargetDesc& desc) = 0;
+
+	// Destroy a target created above
+	virtual void ReleaseTarget(void* target) = 0;
+};
+
+// Device that creates no textures, each target is just its description. Counts the targets created and destroyed
+class NullRenderTargetDevice : public RenderTargetDevice
+{
+public:
+	void* CreateTarget(const RenderTargetDesc& desc) override;
+	void  ReleaseTarget(void* target) override;
+
+	// Description of a target created above
+	static const RenderTargetDesc& Desc(void* target)  { return *static_cast<RenderTargetDesc*>(target); }
+
+	int Created() const   { return mCreated; }
+	int Released() const  { return mReleased; }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	int mCreated = 0;
+	int mReleased = 0;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Pool
+//--------------------------------------------------------------------------------------
+
+class RenderTargetPool
+{
+public:
+	RenderTargetPool(RenderTargetDevice& device) : mDevice(device) {}
+	~RenderTargetPool()  { Clear(); }
+
+	// Return a target of the given description for the caller's use until Release. One released earlier is reused if there is
+	// one with the same description, otherwise one is created. Returns nullptr if the device can't create it
+	void* Acquire(const RenderTargetDesc& desc);
+
+	// Give a target from Acquire back to the pool. Its contents are kept only until it is acquired again
+	void Release(void* target);
+
+	// Destroy the targets that weren't acquired or held since the last call and start counting the next frame's peak. Call after
+	// the chain each frame, when all targets have been released
+	void EndFrame();
+
+	// Destroy every target, those still acquired too
+	void Clear();
+
+	// Memory of the targets acquired now, the most acquired at once during the last frame (up to EndFrame) and the memory held
+	// after the last frame - the steady state if the chain doesn't change
+	size_t BytesInUse() const  { return mBytesInUse; }
+	size_t PeakBytes() const   { return mLastPeakBytes; }
+	size_t HeldBytes() const   { return mHeldBytes; }
+
+	int TargetsHeld() const     { return static_cast<int>(mTargets.size()); }
+	int TargetsCreated() const  { return mCreated; } // Since the pool was made, lower than the acquires if targets are reused
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	struct Entry
+	{
+		RenderTargetDesc Desc;
+		void*            Target;
+		bool             InUse;
+		bool             Used;  // Acquired or released since the last EndFrame
+	};
+
+	RenderTargetDevice& mDevice;
+	std::vector<Entry>  mTargets;
+
+	size_t mBytesInUse = 0;
+	size_t mPeakBytes = 0;      // During the current frame
+	size_t mLastPeakBytes = 0;
+	size_t mHeldBytes = 0;
+	int    mCreated = 0;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Chain schedule
+//--------------------------------------------------------------------------------------
+
+// Working textures some effects draw before their pass, described for a pass of the given chain: the bloom pyramid's levels,
+// the variable blur's two summed-area tables and the pixelation blocks. Empty for other passes
+void PassWorkingTargets(const PostProcessGraph& graph, const CompiledPostProcessGraph& compiled, const PostProcessPass& pass,
+                        int viewportWidth, int viewportHeight, std::vector<RenderTargetDesc>& descs);
+
+// Hands out the render targets of a compiled chain from a pool: each target is acquired before the first pass that uses it
+// and released after the last, so targets in use at different times share textures. Each pass's working textures
+// (PassWorkingTargets) are held only for that pass. Target 0 holds the rendered scene, which is kept outside the pool as the
+// scene is drawn to it before the chain runs
+class PostProcessTargetSchedule
+{
+public:
+	// Work out when each target of the compiled chain is used. Targets are sized from the viewport as the backends size them.
+	// The compiled chain must stay unchanged until End
+	void Begin(const CompiledPostProcessGraph& compiled, int viewportWidth, int viewportHeight, void* sceneTarget);
+
+	// Acquire the targets first used by the given pass (an index into compiled.Passes) and the pass's working textures.
+	// Returns false if one couldn't be created, Target or WorkingTarget then returns nullptr for it
+	bool BeforePass(const PostProcessGraph& graph, int pass, RenderTargetPool& pool);
+
+	// Release the pass's working textures and the targets last used by it
+	void AfterPass(int pass, RenderTargetPool& pool);
+
+	// Release any targets still held, e.g. if the chain stopped early
+	void End(RenderTargetPool& pool);
+
+	// The target from the pool (or the scene's) for a graph target. nullptr if it isn't held now
+	void* Target(int target) const  { return mTargets[target]; }
+
+	// The current pass's working textures, in the order PassWorkingTargets gives them
+	int   WorkingTargetCount() const  { return static_cast<int>(mWorking.size()); }
+	void* WorkingTarget(int i) const  { return mWorking[i]; }
+
+	// Description of each graph target and the first and last passes that use it. Target 0's passes are -1
+	const RenderTargetDesc& Desc(int target) const  { return mDescs[target]; }
+	int FirstPass(int target) const  { return mFirstPass[target]; }
+	int LastPass(int target) const   { return mLastPass[target]; }
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	const CompiledPostProcessGraph* mCompiled = nullptr;
+	int mViewportWidth = 1;
+	int mViewportHeight = 1;
+
+	std::vector<RenderTargetDesc> mDescs;
+	std::vector<int>              mFirstPass;
+	std::vector<int>              mLastPass;
+	std::vector<void*>            mTargets;
+
+	std::vector<RenderTargetDesc> mWorkingDescs;
+	std::vector<void*>            mWorking;
+};
+
+
+#endif //_RENDER_TARGET_POOL_H_INCLUDED_
@@ -0,0 +1,142 @@
+//--------------------------------------------------------------------------------------
+// Scanlines post-process
+//--------------------------------------------------------------------------------------
+
+#include "Scanlines.h"
+
+#include <cmath>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+	// Lines down the screen for each pixel of the viewport's height, and how strongly the lines and noise brighten the colour.
+	// Must match Predator_pp.hlsl
+	const float SCANLINE_DENSITY = 1.6f;
+	const float SCANLINE_OPACITY = 0.9f;
+	const float FLICKER_AMOUNT   = 0.01f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Row weights and flicker
+//--------------------------------------------------------------------------------------
+
+// Weights of the row at the given height on the screen (0->1)
+ScanlineWeights ScanlineRowWeights(float sceneV, int viewportHeight)
+{
+	float count = viewportHeight * SCANLINE_DENSITY;
+	return { 1 + std::sin(sceneV * count) * SCANLINE_OPACITY, 1 + std::cos(sceneV * count) * SCANLINE_OPACITY };
+}
+
+
+// Weights for each row of a render target with the given number of rows
+void BuildScanlinesTable(int viewportHeight, int rows, std::vector<ScanlineWeights>& table)
+{
+	table.resize(rows);
+	for (int row = 0; row < rows; ++row)  table[row] = ScanlineRowWeights((row + 0.5f) / rows, viewportHeight);
+}
+
+
+// The frame's flicker, including the 1/3 that averages the channels
+float ScanlinesFlicker(float hueLevel)
+{
+	return (1 + std::sin(110.0f * hueLevel) * FLICKER_AMOUNT) / 3.0f;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Rows
+//--------------------------------------------------------------------------------------
+// Each pixel's colour is multiplied by the weights (alpha by 0) and the four products of four pixels transposed into
+// a register each, so adding the registers gives four dot products in the same order as ScanlinesGrey
+
+namespace
+{
+#if defined(POST_PROCESS_X86)
+	void ScanlinesRowSSE2(const ColourRGBA* colours, const float* noise, int count, const ScanlineWeights& weights,
+	                      float flicker, float* out)
+	{
+		const __m128 channelWeights = _mm_setr_ps(weights.Red, weights.Green, weights.Red, 0);
+		const __m128 opacity = _mm_set1_ps(0.9f);
+		const __m128 one = _mm_set1_ps(1);
+		const __m128 frame = _mm_set1_ps(flicker);
+		for (int i = 0; i + 4 <= count; i += 4)
+		{
+			const float* pixels = &colours[i].r;
+			__m128 red   = _mm_mul_ps(_mm_loadu_ps(pixels),      channelWeights);
+			__m128 green = _mm_mul_ps(_mm_loadu_ps(pixels + 4),  channelWeights);
+			__m128 blue  = _mm_mul_ps(_mm_loadu_ps(pixels + 8),  channelWeights);
+			__m128 alpha = _mm_mul_ps(_mm_loadu_ps(pixels + 12), channelWeights);
+			_MM_TRANSPOSE4_PS(red, green, blue, alpha);
+
+			__m128 sum = _mm_add_ps(_mm_add_ps(red, green), _mm_add_ps(blue, alpha));
+			__m128 scale = _mm_mul_ps(frame, _mm_add_ps(one, _mm_mul_ps(opacity, _mm_loadu_ps(noise + i))));
+			_mm_storeu_ps(out + i, _mm_mul_ps(sum, scale));
+		}
+	}
+
+	// Each 256-bit register holds two pixels, so the transpose within each half leaves the even pixels in the low half and
+	// the odd ones in the high half, put back in order at the end
+	AVX2_FUNCTION void ScanlinesRowAVX2(const ColourRGBA* colours, const float* noise, int count, const ScanlineWeights& weights,
+	                                    float flicker, float* out)
+	{
+		const __m256 channelWeights = _mm256_setr_ps(weights.Red, weights.Green, weights.Red, 0, weights.Red, weights.Green, weights.Red, 0);
+		const __m256 opacity = _mm256_set1_ps(0.9f);
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256 frame = _mm256_set1_ps(flicker);
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		for (int i = 0; i + 8 <= count; i += 8)
+		{
+			const float* pixels = &colours[i].r;
+			__m256 pixels01 = _mm256_mul_ps(_mm256_loadu_ps(pixels),      channelWeights);
+			__m256 pixels23 = _mm256_mul_ps(_mm256_loadu_ps(pixels + 8),  channelWeights);
+			__m256 pixels45 = _mm256_mul_ps(_mm256_loadu_ps(pixels + 16), channelWeights);
+			__m256 pixels67 = _mm256_mul_ps(_mm256_loadu_ps(pixels + 24), channelWeights);
+
+			__m256 redGreen0 = _mm256_unpacklo_ps(pixels01, pixels23);
+			__m256 blueAlpha0 = _mm256_unpackhi_ps(pixels01, pixels23);
+			__m256 redGreen1 = _mm256_unpacklo_ps(pixels45, pixels67);
+			__m256 blueAlpha1 = _mm256_unpackhi_ps(pixels45, pixels67);
+			__m256 red   = _mm256_shuffle_ps(redGreen0,  redGreen1,  _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 green = _mm256_shuffle_ps(redGreen0,  redGreen1,  _MM_SHUFFLE(3, 2, 3, 2));
+			__m256 blue  = _mm256_shuffle_ps(blueAlpha0, blueAlpha1, _MM_SHUFFLE(1, 0, 1, 0));
+			__m256 alpha = _mm256_shuffle_ps(blueAlpha0, blueAlpha1, _MM_SHUFFLE(3, 2, 3, 2));
+
+			__m256 sum = _mm256_add_ps(_mm256_add_ps(red, green), _mm256_add_ps(blue, alpha));
+			sum = _mm256_permutevar8x32_ps(sum, order);
+			__m256 scale = _mm256_mul_ps(frame, _mm256_add_ps(one, _mm256_mul_ps(opacity, _mm256_loadu_ps(noise + i))));
+			_mm256_storeu_ps(out + i, _mm256_mul_ps(sum, scale));
+		}
+	}
+#endif
+}
+
+
+// ScanlinesGrey for count pixels of one row
+void ScanlinesRow(const ColourRGBA* colours, const float* noise, int count, const ScanlineWeights& weights, float flicker,
+                  float* out, SimdLevel level)
+{
+	int done = 0;
+#if defined(POST_PROCESS_X86)
+	switch (SupportedSimdLevel(level))
+	{
+	case SimdLevel::AVX2:
+		done = count & ~7;
+		ScanlinesRowAVX2(colours, noise, done, weights, flicker, out);
+		break;
+	case SimdLevel::SSE2:
+		done = count & ~3;
+		ScanlinesRowSSE2(colours, noise, done, weights, flicker, out);
+		break;
+	default:
+		break;
+	}
+#endif
+
+	// What's left of the row, all of it for plain C++
+	for (int i = done; i < count; ++i)  out[i] = ScanlinesGrey(colours[i], weights, flicker, noise[i]);
+}
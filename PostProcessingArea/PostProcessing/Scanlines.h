@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------------------
+// Scanlines post-process
+//--------------------------------------------------------------------------------------
+// Each pixel's colour is brightened by a wave running down the screen - sin of the pixel's height on
+// red and blue, cos on green - then by its noise and a flicker for the frame, and made grey. Predator_pp.hlsl
+// used to work out the sin and cos for every pixel though they only depend on the row, and the flicker
+// (a sin of the animation's hue level) for every pixel though it only depends on the frame.
+//
+// Now the wave is a table with an entry for each row of the render target, worked out once for each
+// target height, and the flicker is one number for the frame that the 1/3 of the greyscale is folded into.
+// What's left for each pixel is a dot product of its colour with its row's weights, times its noise:
+//
+//   grey = (r * red + g * green + b * red) * flicker * (1 + 0.9 * noise)
+//
+// ScanlinesRow does that for a row of pixels, eight at a time with AVX2 and four with SSE2. The noise
+// is the integer hash of Noise.h. Every level gives exactly the same results as ScanlinesGrey.
+//
+// The GPU reads the same table from a texture (see Scene.cpp), so both work out the same weights
+
+#ifndef _SCANLINES_H_INCLUDED_
+#define _SCANLINES_H_INCLUDED_
+
+#include "CpuFeatures.h"
+#include "ColourRGBA.h"
+
+#include <vector>
+
+
+// Weights for the colour channels of one row's pixels, blue has the same weight as red
+struct ScanlineWeights
+{
+	float Red;   // 1 + 0.9 sin(height * lines)
+	float Green; // 1 + 0.9 cos(height * lines)
+};
+
+// Weights of the row at the given height on the screen (0->1) for a viewport of the given height in pixels
+ScanlineWeights ScanlineRowWeights(float sceneV, int viewportHeight);
+
+// Weights for each row of a render target with the given number of rows, the rows' centres at (row + 0.5) / rows
+void BuildScanlinesTable(int viewportHeight, int rows, std::vector<ScanlineWeights>& table);
+
+// The frame's flicker from the animation's hue level, including the 1/3 that averages the channels
+float ScanlinesFlicker(float hueLevel);
+
+// Grey that Scanlines draws for a colour, given its row's weights, the frame's flicker and the pixel's noise (0->1)
+inline float ScanlinesGrey(const ColourRGBA& colour, const ScanlineWeights& weights, float flicker, float noise)
+{
+	float sum = (colour.r * weights.Red + colour.g * weights.Green) + colour.b * weights.Red;
+	return sum * (flicker * (1 + 0.9f * noise));
+}
+
+// ScanlinesGrey for count pixels of one row, writing the greys to out. Uses the given instruction set if the processor has it
+void ScanlinesRow(const ColourRGBA* colours, const float* noise, int count, const ScanlineWeights& weights, float flicker,
+                  float* out, SimdLevel level = BestSimdLevel());
+
+
+#endif //_SCANLINES_H_INCLUDED_
@@ -0,0 +1,317 @@
+//--------------------------------------------------------------------------------------
+// SeeingWorlds post-process, a ray-marched field of cells
+//--------------------------------------------------------------------------------------
+
+#include "SeeingWorlds.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Port of the shader
+//--------------------------------------------------------------------------------------
+// The shader declares eps and far as global consts, the values written there are used here
+
+namespace
+{
+	const float SEEING_WORLDS_EPS = 0.005f;
+	const float SEEING_WORLDS_FAR = 20.0f;
+
+	// Minimal 3D vector for the ray-marcher
+	struct Vec3
+	{
+		float x, y, z;
+		Vec3 operator+(const Vec3& v) const  { return { x + v.x, y + v.y, z + v.z }; }
+		Vec3 operator-(const Vec3& v) const  { return { x - v.x, y - v.y, z - v.z }; }
+		Vec3 operator*(float s) const        { return { x * s, y * s, z * s }; }
+	};
+	float Dot(const Vec3& a, const Vec3& b)  { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	float Length(const Vec3& v)  { return std::sqrt(Dot(v, v)); }
+
+	// Normalise a vector. The GPU gives NaNs for a zero vector, which end up as 0 in the render target - so return zero here
+	Vec3 Normalise(const Vec3& v)
+	{
+		float length = Length(v);
+		return (length > 0) ? v * (1 / length) : Vec3{ 0, 0, 0 };
+	}
+
+	float SeeingWorldsMap(Vec3 p, float time)
+	{
+		p.z -= time;
+		Vec3 m = { std::trunc(p.x), std::trunc(p.y), std::trunc(p.z) }; // modf's whole part
+		return Length(m - Vec3{ 1, 1, 1 }) - 0.5f;
+	}
+
+	Vec3 SeeingWorldsNormal(const Vec3& p, float time)
+	{
+		const float e = SEEING_WORLDS_EPS;
+		return Normalise({ SeeingWorldsMap(p + Vec3{ e, 0, 0 }, time) - SeeingWorldsMap(p - Vec3{ e, 0, 0 }, time),
+		                   SeeingWorldsMap(p + Vec3{ 0, e, 0 }, time) - SeeingWorldsMap(p - Vec3{ 0, e, 0 }, time),
+		                   SeeingWorldsMap(p + Vec3{ 0, 0, e }, time) - SeeingWorldsMap(p - Vec3{ 0, 0, e }, time) });
+	}
+}
+
+
+// Colour the shader gives the pixel at the given screen position at the given time
+ColourRGBA SeeingWorldsPixel(float sceneU, float sceneV, float time, int iterations)
+{
+	const Vec3 ro = { 0, 0, 0 };
+	const Vec3 rd = Normalise({ sceneU, sceneV, -1 });
+	float t = 0;
+	for (int i = 0; i < iterations; i++)
+	{
+		float m = SeeingWorldsMap(ro + rd * t, time);
+		t += m;
+		if (m < SEEING_WORLDS_EPS || t > SEEING_WORLDS_FAR)  break;
+	}
+	Vec3 p = ro + rd * t;
+	Vec3 n = SeeingWorldsNormal(p, time);
+	Vec3 ld = Normalise(Vec3{ 1, 4, 5 } - p);
+	float diff = std::max(Dot(ld, n), 0.0f);
+	return ColourRGBA(diff, diff, diff, 1);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Packets
+//--------------------------------------------------------------------------------------
+// Each function shades one packet of adjacent pixels, working out what SeeingWorldsPixel does for each in the same order.
+// Adding the ray's origin (0, 0, 0) is left out, it can only change a -0 to a 0 which makes no difference to the cells
+
+namespace
+{
+#if defined(POST_PROCESS_X86)
+	// modf's whole part. The conversion is exact for the distances the rays reach
+	__m128 TruncateSSE2(__m128 x)  { return _mm_cvtepi32_ps(_mm_cvttps_epi32(x)); }
+
+	// The field at each point, the time already taken off z
+	__m128 MapSSE2(__m128 x, __m128 y, __m128 z)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		__m128 dx = _mm_sub_ps(TruncateSSE2(x), one);
+		__m128 dy = _mm_sub_ps(TruncateSSE2(y), one);
+		__m128 dz = _mm_sub_ps(TruncateSSE2(z), one);
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		return _mm_sub_ps(_mm_sqrt_ps(lengthSq), _mm_set1_ps(0.5f));
+	}
+
+	// Vector times 1 / its length, zero where the length is
+	void NormaliseSSE2(__m128& x, __m128& y, __m128& z)
+	{
+		__m128 length  = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		__m128 nonZero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+		__m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), length);
+		x = _mm_and_ps(nonZero, _mm_mul_ps(x, inverse));
+		y = _mm_and_ps(nonZero, _mm_mul_ps(y, inverse));
+		z = _mm_and_ps(nonZero, _mm_mul_ps(z, inverse));
+	}
+
+	void MarchPacketSSE2(const float* sceneU, float sceneV, float time, int iterations, ColourRGBA* out)
+	{
+		const __m128 zero  = _mm_setzero_ps();
+		const __m128 timeV = _mm_set1_ps(time);
+		const __m128 e     = _mm_set1_ps(SEEING_WORLDS_EPS);
+
+		__m128 rdx = _mm_loadu_ps(sceneU), rdy = _mm_set1_ps(sceneV), rdz = _mm_set1_ps(-1.0f);
+		NormaliseSSE2(rdx, rdy, rdz);
+
+		// March until every ray has stopped, rays that have keep their distance
+		__m128 t = zero;
+		__m128 active = _mm_cmpeq_ps(zero, zero);
+		for (int i = 0; i < iterations && _mm_movemask_ps(active) != 0; ++i)
+		{
+			__m128 m = MapSSE2(_mm_mul_ps(rdx, t), _mm_mul_ps(rdy, t), _mm_sub_ps(_mm_mul_ps(rdz, t), timeV));
+			t = _mm_or_ps(_mm_and_ps(active, _mm_add_ps(t, m)), _mm_andnot_ps(active, t));
+			active = _mm_andnot_ps(_mm_or_ps(_mm_cmplt_ps(m, e), _mm_cmpgt_ps(t, _mm_set1_ps(SEEING_WORLDS_FAR))), active);
+		}
+
+		// Normal, only sampled if a ray ended near a cell face
+		const __m128 px = _mm_mul_ps(rdx, t), py = _mm_mul_ps(rdy, t), pz = _mm_mul_ps(rdz, t);
+		const __m128 xPlus = _mm_add_ps(px, e), xMinus = _mm_sub_ps(px, e);
+		const __m128 yPlus = _mm_add_ps(py, e), yMinus = _mm_sub_ps(py, e);
+		const __m128 zPlus = _mm_sub_ps(_mm_add_ps(pz, e), timeV), zMinus = _mm_sub_ps(_mm_sub_ps(pz, e), timeV);
+		__m128 near = _mm_cmpneq_ps(TruncateSSE2(xPlus), TruncateSSE2(xMinus));
+		near = _mm_or_ps(near, _mm_cmpneq_ps(TruncateSSE2(yPlus), TruncateSSE2(yMinus)));
+		near = _mm_or_ps(near, _mm_cmpneq_ps(TruncateSSE2(zPlus), TruncateSSE2(zMinus)));
+		__m128 nx = zero, ny = zero, nz = zero;
+		if (_mm_movemask_ps(near) != 0)
+		{
+			const __m128 z = _mm_sub_ps(pz, timeV);
+			nx = _mm_sub_ps(MapSSE2(xPlus, py, z), MapSSE2(xMinus, py, z));
+			ny = _mm_sub_ps(MapSSE2(px, yPlus, z), MapSSE2(px, yMinus, z));
+			nz = _mm_sub_ps(MapSSE2(px, py, zPlus), MapSSE2(px, py, zMinus));
+			NormaliseSSE2(nx, ny, nz);
+		}
+
+		// Light from (1, 4, 5). max(0, x) rather than max(x, 0) keeps a -0 as std::max does
+		__m128 ldx = _mm_sub_ps(_mm_set1_ps(1.0f), px), ldy = _mm_sub_ps(_mm_set1_ps(4.0f), py), ldz = _mm_sub_ps(_mm_set1_ps(5.0f), pz);
+		NormaliseSSE2(ldx, ldy, ldz);
+		__m128 diff = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ldx, nx), _mm_mul_ps(ldy, ny)), _mm_mul_ps(ldz, nz));
+		diff = _mm_max_ps(zero, diff);
+
+		float lit[4];
+		_mm_storeu_ps(lit, diff);
+		for (int i = 0; i < 4; ++i)  out[i] = ColourRGBA(lit[i], lit[i], lit[i], 1);
+	}
+
+
+	// The same eight rays at a time. Multiply and add are kept separate (no FMA) to round as the other versions do
+	AVX2_FUNCTION __m256 TruncateAVX2(__m256 x)  { return _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC); }
+
+	AVX2_FUNCTION __m256 MapAVX2(__m256 x, __m256 y, __m256 z)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		__m256 dx = _mm256_sub_ps(TruncateAVX2(x), one);
+		__m256 dy = _mm256_sub_ps(TruncateAVX2(y), one);
+		__m256 dz = _mm256_sub_ps(TruncateAVX2(z), one);
+		__m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		return _mm256_sub_ps(_mm256_sqrt_ps(lengthSq), _mm256_set1_ps(0.5f));
+	}
+
+	AVX2_FUNCTION void NormaliseAVX2(__m256& x, __m256& y, __m256& z)
+	{
+		__m256 length  = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+		__m256 nonZero = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ);
+		__m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), length);
+		x = _mm256_and_ps(nonZero, _mm256_mul_ps(x, inverse));
+		y = _mm256_and_ps(nonZero, _mm256_mul_ps(y, inverse));
+		z = _mm256_and_ps(nonZero, _mm256_mul_ps(z, inverse));
+	}
+
+	AVX2_FUNCTION void MarchPacketAVX2(const float* sceneU, float sceneV, float time, int iterations, ColourRGBA* out)
+	{
+		const __m256 zero  = _mm256_setzero_ps();
+		const __m256 timeV = _mm256_set1_ps(time);
+		const __m256 e     = _mm256_set1_ps(SEEING_WORLDS_EPS);
+
+		__m256 rdx = _mm256_loadu_ps(sceneU), rdy = _mm256_set1_ps(sceneV), rdz = _mm256_set1_ps(-1.0f);
+		NormaliseAVX2(rdx, rdy, rdz);
+
+		__m256 t = zero;
+		__m256 active = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+		for (int i = 0; i < iterations && _mm256_movemask_ps(active) != 0; ++i)
+		{
+			__m256 m = MapAVX2(_mm256_mul_ps(rdx, t), _mm256_mul_ps(rdy, t), _mm256_sub_ps(_mm256_mul_ps(rdz, t), timeV));
+			t = _mm256_blendv_ps(t, _mm256_add_ps(t, m), active);
+			__m256 stop = _mm256_or_ps(_mm256_cmp_ps(m, e, _CMP_LT_OQ), _mm256_cmp_ps(t, _mm256_set1_ps(SEEING_WORLDS_FAR), _CMP_GT_OQ));
+			active = _mm256_andnot_ps(stop, active);
+		}
+
+		const __m256 px = _mm256_mul_ps(rdx, t), py = _mm256_mul_ps(rdy, t), pz = _mm256_mul_ps(rdz, t);
+		const __m256 xPlus = _mm256_add_ps(px, e), xMinus = _mm256_sub_ps(px, e);
+		const __m256 yPlus = _mm256_add_ps(py, e), yMinus = _mm256_sub_ps(py, e);
+		const __m256 zPlus = _mm256_sub_ps(_mm256_add_ps(pz, e), timeV), zMinus = _mm256_sub_ps(_mm256_sub_ps(pz, e), timeV);
+		__m256 near = _mm256_cmp_ps(TruncateAVX2(xPlus), TruncateAVX2(xMinus), _CMP_NEQ_UQ);
+		near = _mm256_or_ps(near, _mm256_cmp_ps(TruncateAVX2(yPlus), TruncateAVX2(yMinus), _CMP_NEQ_UQ));
+		near = _mm256_or_ps(near, _mm256_cmp_ps(TruncateAVX2(zPlus), TruncateAVX2(zMinus), _CMP_NEQ_UQ));
+		__m256 nx = zero, ny = zero, nz = zero;
+		if (_mm256_movemask_ps(near) != 0)
+		{
+			const __m256 z = _mm256_sub_ps(pz, timeV);
+			nx = _mm256_sub_ps(MapAVX2(xPlus, py, z), MapAVX2(xMinus, py, z));
+			ny = _mm256_sub_ps(MapAVX2(px, yPlus, z), MapAVX2(px, yMinus, z));
+			nz = _mm256_sub_ps(MapAVX2(px, py, zPlus), MapAVX2(px, py, zMinus));
+			NormaliseAVX2(nx, ny, nz);
+		}
+
+		__m256 ldx = _mm256_sub_ps(_mm256_set1_ps(1.0f), px), ldy = _mm256_sub_ps(_mm256_set1_ps(4.0f), py), ldz = _mm256_sub_ps(_mm256_set1_ps(5.0f), pz);
+		NormaliseAVX2(ldx, ldy, ldz);
+		__m256 diff = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ldx, nx), _mm256_mul_ps(ldy, ny)), _mm256_mul_ps(ldz, nz));
+		diff = _mm256_max_ps(zero, diff);
+
+		float lit[8];
+		_mm256_storeu_ps(lit, diff);
+		for (int i = 0; i < 8; ++i)  out[i] = ColourRGBA(lit[i], lit[i], lit[i], 1);
+	}
+#endif
+}
+
+
+// SeeingWorldsPixel for count pixels of a row, a packet at a time
+void MarchSeeingWorlds(const float* sceneU, float sceneV, float time, int iterations, ColourRGBA* out, int count, SimdLevel level)
+{
+	int x = 0;
+#if defined(POST_PROCESS_X86)
+	switch (SupportedSimdLevel(level))
+	{
+	case SimdLevel::AVX2:
+		for (; x + 8 <= count; x += 8)  MarchPacketAVX2(sceneU + x, sceneV, time, iterations, out + x);
+		break;
+	case SimdLevel::SSE2:
+		for (; x + 4 <= count; x += 4)  MarchPacketSSE2(sceneU + x, sceneV, time, iterations, out + x);
+		break;
+	default:
+		break;
+	}
+#endif
+
+	// What's left of the row, all of it for plain C++
+	for (; x < count; ++x)  out[x] = SeeingWorldsPixel(sceneU[x], sceneV, time, iterations);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Swirl (SeeingWorlds2_pp.hlsl)
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	float HsvChannel(float h, float third)
+	{
+		float x = std::fabs((h + third - std::floor(h + third)) * 6 - 3) - 1;
+		return Saturate(x);
+	}
+}
+
+
+// Work out the taps for a frame with the given time and offset setting
+void MakeSeeingWorldsTaps(float time, float offset, int tapCount, bool stochastic, int frame, SeeingWorldsTaps& taps)
+{
+	taps.Count = std::min(std::max(tapCount, 1), SEEING_WORLDS_TAPS);
+	taps.Weight = 0.3f * 5 * SEEING_WORLDS_TAPS / taps.Count;
+
+	// Tap k of the set is the shader's tap (k + phase) * 100 / count, rounded down. The golden ratio moves the phase by
+	// a different amount each frame so the sets don't repeat in a short cycle
+	float phase = 0;
+	if (stochastic)
+	{
+		double turns = frame * 0.6180339887498949;
+		phase = static_cast<float>(turns - std::floor(turns));
+	}
+	for (int k = 0; k < taps.Count; ++k)
+	{
+		int i = std::min(static_cast<int>((k + phase) * SEEING_WORLDS_TAPS / taps.Count), SEEING_WORLDS_TAPS - 1);
+		float angle = 0.1f * i + time;
+		taps.Offsets[k][0] = offset * std::cos(angle);
+		taps.Offsets[k][1] = offset * std::sin(angle);
+		taps.Offsets[k][2] = offset * std::cos(angle + 0.1f);
+		taps.Offsets[k][3] = offset * std::sin(angle + 0.1f);
+	}
+}
+
+
+// Colour the swirl gives the pixel at the given screen position reading the scene with the given taps
+ColourRGBA SeeingWorldsSwirlPixel(const Image& scene, float sceneU, float sceneV, float time, const SeeingWorldsTaps& taps)
+{
+	float psd = std::pow(std::fabs(scene.SamplePoint(0.5f, 0).r), 2.0f);
+	float turnCos = std::cos(psd), turnSin = -std::sin(psd);
+	float baseU = sceneU * 0.8f + 0.1f;
+	float baseV = sceneV * 0.8f;
+
+	float red = 0;
+	for (int k = 0; k < taps.Count; ++k)
+	{
+		const float* tap = taps.Offsets[k];
+		red += scene.SamplePoint(baseU + (tap[0] * turnCos + tap[1] * turnSin), baseV + (tap[2] * turnCos + tap[3] * turnSin)).r;
+	}
+	red *= taps.Weight;
+
+	// Only the red total is used, as the hue. Saturation and value are 1 so the colour is the pure hue
+	float hue = red * 0.1f + time * 0.5f + psd;
+	return ColourRGBA(HsvChannel(hue, 1.0f), HsvChannel(hue, 2.0f / 3), HsvChannel(hue, 1.0f / 3), 1);
+}
@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------
+// SeeingWorlds post-process, a ray-marched field of cells
+//--------------------------------------------------------------------------------------
+// SeeingWorlds1_pp.hlsl marches a ray from the camera through each pixel, up to 100 steps, each step
+// as far as the distance the field gives at the current point, stopping when it is close to a surface
+// or has gone too far. The field's normal at the end, from six more samples of it (central differences),
+// lights the pixel. The field takes modf's whole part of the point, so it is constant across each unit
+// cell of space - the distance from the cell's corner to (1, 1, 1) less 0.5 - rather than a smooth
+// field of spheres. Its differences are zero unless the point is within the sampling distance of a
+// cell's face, which is where the lit lines come from.
+//
+// SeeingWorldsPixel is a straight port of the shader. MarchSeeingWorlds gives the same results for a row
+// of pixels, marching a packet of rays side by side - eight with AVX2, four with SSE2. Each ray stops
+// on its own step, the packet stops when all of them have. The normal comes from which cell faces the
+// end point is near: along an axis with no face within the sampling distance both samples are in the
+// same cell and their difference is exactly zero, so for the many packets with no ray near a face the
+// six samples aren't taken at all.
+//
+// The number of steps can be cut below the shader's 100 (CpuPostProcessBackend::SetSeeingWorldsIterations).
+// Rays that would have gone on then stop short, lighting differently. In this field the cells a ray
+// passes are soon far from (1, 1, 1), so its steps grow and nearly every ray has stopped within a few -
+// PostProcessBench --march shows how the image changes with fewer
+//
+// The effect's second node (SeeingWorlds2_pp.hlsl) swirls the hue by adding up the scene's red at 100
+// points around the pixel. Tap i is offset by offset * cos(0.1 * i + time + psd), with 0.1 added to the
+// angle for V, where psd is from the scene pixel at (0.5, 0). Only psd is read on the GPU, so the taps for
+// the frame are worked out once here: the sin and cos of each angle without psd, times the offset. For
+// each pixel the shader turns them by psd (cos(a + psd) = cos a cos psd - sin a sin psd), leaving two
+// multiply-adds a tap in place of two cos. Fewer taps can be used, spread evenly over the 100 and weighted
+// so the total stays the same. With stochastic taps the set moves each frame, so over a few frames every
+// one of the 100 is visited rather than the same ones being missed each frame
+
+#ifndef _SEEING_WORLDS_H_INCLUDED_
+#define _SEEING_WORLDS_H_INCLUDED_
+
+#include "CpuFeatures.h"
+#include "ColourRGBA.h"
+#include "Image.h"
+
+
+// Most steps along each ray, as in the shader
+const int SEEING_WORLDS_ITERATIONS = 100;
+
+// Colour the shader gives the pixel at the given screen position (0->1) at the given time, marching at most the given number
+// of steps. Alpha is 1
+ColourRGBA SeeingWorldsPixel(float sceneU, float sceneV, float time, int iterations = SEEING_WORLDS_ITERATIONS);
+
+// SeeingWorldsPixel for count pixels of a row, at screen positions sceneU[i], sceneV, written to out. Uses the given
+// instruction set if the processor has it, every level gives exactly the same results as SeeingWorldsPixel
+void MarchSeeingWorlds(const float* sceneU, float sceneV, float time, int iterations, ColourRGBA* out, int count,
+                       SimdLevel level = BestSimdLevel());
+
+
+// Most taps in the swirl, as in the shader
+const int SEEING_WORLDS_TAPS = 100;
+
+// The swirl's taps for one frame, see above. Sent to the GPU as they are (SeeingWorldsTapConstants in Common.h)
+struct SeeingWorldsTaps
+{
+	int   Count  = 0;
+	float Weight = 0; // Red of each tap is multiplied by this, the shader's 0.3 * 5 scaled up for fewer taps
+	float Offsets[SEEING_WORLDS_TAPS][4]; // offset * (cos a, sin a, cos(a + 0.1), sin(a + 0.1)), a = 0.1 * i + time
+};
+
+// Work out the taps for a frame with the given time and offset setting. tapCount (clamped to 1->SEEING_WORLDS_TAPS) are
+// spread over the shader's taps. If stochastic the frame number (any count that goes up by one a frame) moves them
+void MakeSeeingWorldsTaps(float time, float offset, int tapCount, bool stochastic, int frame, SeeingWorldsTaps& taps);
+
+// Colour the swirl gives the pixel at the given screen position (0->1) reading the scene with the given taps. Alpha is 1
+ColourRGBA SeeingWorldsSwirlPixel(const Image& scene, float sceneU, float sceneV, float time, const SeeingWorldsTaps& taps);
+
+
+#endif //_SEEING_WORLDS_H_INCLUDED_
@@ -0,0 +1,214 @@
+//--------------------------------------------------------------------------------------
+// Vectorised CPU Gaussian blur
+//--------------------------------------------------------------------------------------
+
+#include "SeparableBlur.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+//--------------------------------------------------------------------------------------
+// Rows
+//--------------------------------------------------------------------------------------
+// Each function blurs count pixels from a padded row: in points at the first pixel, with radius pixels readable before it
+// and after the last. Pixels are four floats. Every version works out w0*p + w1*(p-1 + p+1) + w2*(p-2 + p+2)... in
+// that order, so their results are identical
+
+namespace
+{
+	// Rows or columns handed to a thread at a time. A column strip is transposed into this many rows
+	const int ROWS_PER_TASK = 16;
+
+	using BlurRowFunction = void (*)(const float* in, float* out, int count, const float* weights, int radius);
+
+	void BlurRowScalar(const float* in, float* out, int count, const float* weights, int radius)
+	{
+		for (int i = 0; i < count * 4; ++i)
+		{
+			float sum = in[i] * weights[0];
+			for (int tap = 1; tap <= radius; ++tap)
+			{
+				sum = sum + (in[i - tap * 4] + in[i + tap * 4]) * weights[tap];
+			}
+			out[i] = sum;
+		}
+	}
+
+
+#if defined(POST_PROCESS_X86)
+	// One pixel per register, four pixels at a time to keep several additions in flight
+	void BlurRowSSE2(const float* in, float* out, int count, const float* weights, int radius)
+	{
+		int x = 0;
+		for (; x + 4 <= count; x += 4)
+		{
+			const float* p = in + x * 4;
+			__m128 w = _mm_set1_ps(weights[0]);
+			__m128 sum0 = _mm_mul_ps(_mm_loadu_ps(p),      w);
+			__m128 sum1 = _mm_mul_ps(_mm_loadu_ps(p + 4),  w);
+			__m128 sum2 = _mm_mul_ps(_mm_loadu_ps(p + 8),  w);
+			__m128 sum3 = _mm_mul_ps(_mm_loadu_ps(p + 12), w);
+			for (int tap = 1; tap <= radius; ++tap)
+			{
+				const float* before = p - tap * 4;
+				const float* after  = p + tap * 4;
+				w = _mm_set1_ps(weights[tap]);
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(before),      _mm_loadu_ps(after)),      w));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(before + 4),  _mm_loadu_ps(after + 4)),  w));
+				sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(before + 8),  _mm_loadu_ps(after + 8)),  w));
+				sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(before + 12), _mm_loadu_ps(after + 12)), w));
+			}
+			_mm_storeu_ps(out + x * 4,      sum0);
+			_mm_storeu_ps(out + x * 4 + 4,  sum1);
+			_mm_storeu_ps(out + x * 4 + 8,  sum2);
+			_mm_storeu_ps(out + x * 4 + 12, sum3);
+		}
+		for (; x < count; ++x)
+		{
+			const float* p = in + x * 4;
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(p), _mm_set1_ps(weights[0]));
+			for (int tap = 1; tap <= radius; ++tap)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p - tap * 4), _mm_loadu_ps(p + tap * 4)), _mm_set1_ps(weights[tap])));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+
+
+	// Two pixels per register, eight at a time. Multiply and add are kept separate (no FMA) to round as the other versions do
+	AVX2_FUNCTION void BlurRowAVX2(const float* in, float* out, int count, const float* weights, int radius)
+	{
+		int x = 0;
+		for (; x + 8 <= count; x += 8)
+		{
+			const float* p = in + x * 4;
+			__m256 w = _mm256_set1_ps(weights[0]);
+			__m256 sum0 = _mm256_mul_ps(_mm256_loadu_ps(p),      w);
+			__m256 sum1 = _mm256_mul_ps(_mm256_loadu_ps(p + 8),  w);
+			__m256 sum2 = _mm256_mul_ps(_mm256_loadu_ps(p + 16), w);
+			__m256 sum3 = _mm256_mul_ps(_mm256_loadu_ps(p + 24), w);
+			for (int tap = 1; tap <= radius; ++tap)
+			{
+				const float* before = p - tap * 4;
+				const float* after  = p + tap * 4;
+				w = _mm256_set1_ps(weights[tap]);
+				sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(before),      _mm256_loadu_ps(after)),      w));
+				sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(before + 8),  _mm256_loadu_ps(after + 8)),  w));
+				sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(before + 16), _mm256_loadu_ps(after + 16)), w));
+				sum3 = _mm256_add_ps(sum3, _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(before + 24), _mm256_loadu_ps(after + 24)), w));
+			}
+			_mm256_storeu_ps(out + x * 4,      sum0);
+			_mm256_storeu_ps(out + x * 4 + 8,  sum1);
+			_mm256_storeu_ps(out + x * 4 + 16, sum2);
+			_mm256_storeu_ps(out + x * 4 + 24, sum3);
+		}
+		for (; x < count; ++x)
+		{
+			const float* p = in + x * 4;
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(p), _mm_set1_ps(weights[0]));
+			for (int tap = 1; tap <= radius; ++tap)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(p - tap * 4), _mm_loadu_ps(p + tap * 4)), _mm_set1_ps(weights[tap])));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+#endif
+
+
+	BlurRowFunction ChooseBlurRow(SimdLevel level)
+	{
+#if defined(POST_PROCESS_X86)
+		switch (SupportedSimdLevel(level))
+		{
+		case SimdLevel::AVX2:  return BlurRowAVX2;
+		case SimdLevel::SSE2:  return BlurRowSSE2;
+		default:               break;
+		}
+#endif
+		return BlurRowScalar;
+	}
+
+
+	// Fill the radius pixels each side of a padded row with copies of its end pixels, as the clamp sampler reads
+	void PadRow(std::vector<ColourRGBA>& padded, int count, int radius)
+	{
+		std::fill(padded.begin(), padded.begin() + radius, padded[radius]);
+		std::fill(padded.begin() + radius + count, padded.end(), padded[radius + count - 1]);
+	}
+
+	float* Floats(ColourRGBA* pixels)  { return &pixels->r; }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Images
+//--------------------------------------------------------------------------------------
+
+// Blur all four channels of source in one direction with the kernel, writing to target (resized to match)
+void SeparableBlurImage(const Image& source, Image& target, const GaussianKernel& kernel, bool horizontal, SimdLevel level, TaskPool* pool)
+{
+	const int width  = source.Width();
+	const int height = source.Height();
+	target.Resize(width, height);
+	if (width == 0 || height == 0)  return;
+
+	BlurRowFunction blurRow = ChooseBlurRow(level);
+	const float* weights = kernel.Weights.data();
+	const int    radius  = kernel.Radius;
+
+	// Along rows: copy each row into a padded buffer and blur straight into the target
+	auto blurRows = [&](int task)
+	{
+		std::vector<ColourRGBA> padded(width + 2 * radius);
+		for (int y = task * ROWS_PER_TASK; y < std::min((task + 1) * ROWS_PER_TASK, height); ++y)
+		{
+			std::copy(source.Row(y), source.Row(y) + width, padded.begin() + radius);
+			PadRow(padded, width, radius);
+			blurRow(Floats(&padded[radius]), Floats(target.Row(y)), width, weights, radius);
+		}
+	};
+
+	// Down columns: transpose a strip of columns into padded rows, blur those and transpose the results back. Reading a
+	// strip row by row touches a few neighbouring cache lines at a time rather than one pixel from each row
+	auto blurColumns = [&](int task)
+	{
+		const int firstColumn = task * ROWS_PER_TASK;
+		const int columns = std::min(ROWS_PER_TASK, width - firstColumn);
+		std::vector<ColourRGBA> padded[ROWS_PER_TASK];
+		std::vector<ColourRGBA> blurred(height);
+		for (int column = 0; column < columns; ++column)  padded[column].resize(height + 2 * radius);
+
+		for (int y = 0; y < height; ++y)
+		{
+			const ColourRGBA* row = source.Row(y) + firstColumn;
+			for (int column = 0; column < columns; ++column)  padded[column][radius + y] = row[column];
+		}
+		for (int column = 0; column < columns; ++column)
+		{
+			PadRow(padded[column], height, radius);
+			blurRow(Floats(&padded[column][radius]), Floats(blurred.data()), height, weights, radius);
+
+			// Reuse the padded row to hold the result until the strip is written back
+			std::copy(blurred.begin(), blurred.end(), padded[column].begin());
+		}
+		for (int y = 0; y < height; ++y)
+		{
+			ColourRGBA* row = target.Row(y) + firstColumn;
+			for (int column = 0; column < columns; ++column)  row[column] = padded[column][y];
+		}
+	};
+
+	const int tasks = ((horizontal ? height : width) + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	std::function<void(int)> task = horizontal ? std::function<void(int)>(blurRows) : std::function<void(int)>(blurColumns);
+	if (pool)  pool->ParallelFor(tasks, task);
+	else       for (int i = 0; i < tasks; ++i)  task(i);
+}
@@ -0,0 +1,31 @@
+//--------------------------------------------------------------------------------------
+// Vectorised CPU Gaussian blur
+//--------------------------------------------------------------------------------------
+// The same blur as the Blur (vertical) and SecondBlur (horizontal) post-processes, but working on
+// whole rows rather than one pixel at a time, for CPU runs of the chain. A row is copied with the
+// edge pixels repeated beyond each end (as the clamp sampler), then every output pixel is the kernel's
+// weighted sum of its neighbours along the row - with SSE2 one pixel (four floats) per instruction,
+// with AVX2 two. The vertical blur transposes the image in small blocks that fit the L1 cache, blurs
+// the rows of that and transposes back, so it never strides down columns.
+//
+// The discrete kernel is used (each pixel weighted on its own), which matches the GPU's merged taps
+// to within rounding. Each instruction set adds up the same products in the same order, so every
+// level gives exactly the same result.
+
+#ifndef _SEPARABLE_BLUR_H_INCLUDED_
+#define _SEPARABLE_BLUR_H_INCLUDED_
+
+#include "GaussianKernel.h"
+#include "CpuFeatures.h"
+#include "Image.h"
+
+class TaskPool;
+
+
+// Blur all four channels of source in one direction with the kernel, writing to target (resized to match). Uses the
+// given instruction set if the processor has it, and the pool's threads if one is given
+void SeparableBlurImage(const Image& source, Image& target, const GaussianKernel& kernel, bool horizontal,
+                        SimdLevel level = BestSimdLevel(), TaskPool* pool = nullptr);
+
+
+#endif //_SEPARABLE_BLUR_H_INCLUDED_
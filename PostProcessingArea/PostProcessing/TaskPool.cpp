@@ -0,0 +1,125 @@
+//--------------------------------------------------------------------------------------
+// Pool of threads sharing out the work of a loop
+//--------------------------------------------------------------------------------------
+
+#include "TaskPool.h"
+
+#include <algorithm>
+
+
+// Pool of the given number of threads, including the one calling ParallelFor. 0 uses one for each core
+TaskPool::TaskPool(int threadCount)
+{
+	if (threadCount <= 0)  threadCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+	for (int thread = 0; thread < threadCount; ++thread)  mQueues.emplace_back(new TaskQueue);
+	for (int thread = 1; thread < threadCount; ++thread)  mThreads.emplace_back(&TaskPool::WorkerThread, this, thread);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+	for (std::thread& thread : mThreads)  thread.join();
+}
+
+
+// Call task(i) for i from 0 to count-1, spread over the threads. Returns when every call has finished
+void TaskPool::ParallelFor(int count, const std::function<void(int)>& task)
+{
+	if (count <= 0)  return;
+	if (mThreads.empty() || count == 1)
+	{
+		for (int i = 0; i < count; ++i)  task(i);
+		return;
+	}
+
+	// Deal the indexes out in runs, so each thread starts on neighbouring indexes
+	std::atomic<int> remaining(count);
+	const int threadCount = ThreadCount();
+	for (int thread = 0; thread < threadCount; ++thread)
+	{
+		int first = static_cast<int>(static_cast<long long>(count) * thread / threadCount);
+		int last  = static_cast<int>(static_cast<long long>(count) * (thread + 1) / threadCount);
+		std::lock_guard<std::mutex> lock(mQueues[thread]->Mutex);
+		for (int i = first; i < last; ++i)  mQueues[thread]->Indexes.push_back({ &task, &remaining, i });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		++mLoop;
+	}
+	mWake.notify_all();
+
+	RunTasks(0);
+
+	// Other threads may still be finishing indexes they took
+	std::unique_lock<std::mutex> lock(mDoneMutex);
+	mDone.wait(lock, [&remaining]() { return remaining.load() == 0; });
+}
+
+
+// Run indexes from the given thread's queue, then from the others', until all queues are empty
+void TaskPool::RunTasks(int thread)
+{
+	TaskIndex task;
+	while (TakeTask(thread, task))
+	{
+		(*task.Task)(task.Index);
+		if (task.Remaining->fetch_sub(1) == 1)
+		{
+			// Lock so the calling thread can't miss the notification between checking the count and waiting
+			std::lock_guard<std::mutex> lock(mDoneMutex);
+			mDone.notify_all();
+		}
+	}
+}
+
+bool TaskPool::TakeTask(int thread, TaskIndex& task)
+{
+	// Own queue from the back - the most recently added, so the most likely to be in cache
+	{
+		TaskQueue& own = *mQueues[thread];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Indexes.empty())
+		{
+			task = own.Indexes.back();
+			own.Indexes.pop_back();
+			return true;
+		}
+	}
+
+	// Steal from the front of the other queues, starting with the next thread along to spread the thieves out
+	const int threadCount = ThreadCount();
+	for (int i = 1; i < threadCount; ++i)
+	{
+		TaskQueue& other = *mQueues[(thread + i) % threadCount];
+		std::lock_guard<std::mutex> lock(other.Mutex);
+		if (!other.Indexes.empty())
+		{
+			task = other.Indexes.front();
+			other.Indexes.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void TaskPool::WorkerThread(int thread)
+{
+	unsigned loop = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWake.wait(lock, [this, loop]() { return mStopping || mLoop != loop; });
+			if (mStopping)  return;
+			loop = mLoop;
+		}
+		RunTasks(thread);
+	}
+}
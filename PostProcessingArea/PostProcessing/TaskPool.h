@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------------------
+// Pool of threads sharing out the work of a loop
+//--------------------------------------------------------------------------------------
+// Used by the CPU backend to draw the tiles of a pass on every core. ParallelFor runs a function for
+// each index of a range, the calling thread joins in and it returns when all are done.
+//
+// The indexes are shared out in turn to a queue for each thread. A thread works from the back of its
+// own queue, and when that is empty takes from the front of the others' - work stealing. Neighbouring
+// indexes (e.g. neighbouring tiles) mostly stay on one thread, while threads that finish early (tiles
+// with less to do, or cores busy with other work) take on the rest rather than waiting.
+
+#ifndef _TASK_POOL_H_INCLUDED_
+#define _TASK_POOL_H_INCLUDED_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class TaskPool
+{
+public:
+	// Pool of the given number of threads, including the one calling ParallelFor - so 1 runs everything on the calling
+	// thread. 0 uses one for each core
+	explicit TaskPool(int threadCount = 0);
+	~TaskPool();
+
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	int ThreadCount() const  { return static_cast<int>(mQueues.size()); }
+
+	// Call task(i) for i from 0 to count-1, spread over the threads. Returns when every call has finished. The order of the
+	// calls isn't defined. Only one thread should use the pool at a time, and task should not call ParallelFor
+	void ParallelFor(int count, const std::function<void(int)>& task);
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	// One call of a task. The task and its counter are carried with each index, so a thread never runs an index against
+	// the wrong loop
+	struct TaskIndex
+	{
+		const std::function<void(int)>* Task;
+		std::atomic<int>*               Remaining;
+		int                             Index;
+	};
+
+	struct TaskQueue
+	{
+		std::mutex            Mutex;
+		std::deque<TaskIndex> Indexes;
+	};
+
+	// Run indexes from the given thread's queue, then from the others', until all queues are empty
+	void RunTasks(int thread);
+	bool TakeTask(int thread, TaskIndex& task);
+
+	void WorkerThread(int thread);
+
+	std::vector<std::unique_ptr<TaskQueue>> mQueues; // One for each thread, the calling thread's first
+	std::vector<std::thread>                mThreads;
+
+	// Workers sleep until the loop number changes
+	std::mutex              mWakeMutex;
+	std::condition_variable mWake;
+	unsigned                mLoop = 0;
+	bool                    mStopping = false;
+
+	// The calling thread sleeps until the last index of a loop is finished
+	std::mutex              mDoneMutex;
+	std::condition_variable mDone;
+};
+
+
+#endif //_TASK_POOL_H_INCLUDED_
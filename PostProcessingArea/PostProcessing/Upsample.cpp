@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------
+// Edge-aware upsampling
+//--------------------------------------------------------------------------------------
+
+#include "Upsample.h"
+
+#include <cmath>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	float ColourDistanceSq(const ColourRGBA& a, const ColourRGBA& b)
+	{
+		float r = a.r - b.r;
+		float g = a.g - b.g;
+		float bl = a.b - b.b;
+		return r * r + g * g + bl * bl;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Upsampling
+//--------------------------------------------------------------------------------------
+
+// One full resolution pixel at texture coordinate u, v enlarged from source, see EdgeAwareUpsample
+ColourRGBA EdgeAwareUpsamplePixel(const Image& source, const Image& guide, float u, float v, bool edgeAware /*= true*/)
+{
+	edgeAware = edgeAware && guide.Width() > 0 && guide.Height() > 0;
+
+	// The four source pixels around this one and their bilinear weights
+	float sx = u * source.Width()  - 0.5f;
+	float sy = v * source.Height() - 0.5f;
+	int   x0 = static_cast<int>(std::floor(sx));
+	int   y0 = static_cast<int>(std::floor(sy));
+	float fx = sx - x0;
+	float fy = sy - y0;
+	const int   offsetsX[4] = { 0, 1, 0, 1 };
+	const int   offsetsY[4] = { 0, 0, 1, 1 };
+	const float bilinear[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+
+	// Weight each by how well the guide at that pixel matches the guide here
+	const ColourRGBA* here = edgeAware ? &guide.SamplePoint(u, v) : nullptr;
+	float weights[4];
+	float total = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		weights[i] = bilinear[i];
+		if (edgeAware)
+		{
+			const ColourRGBA& there = guide.SamplePoint((x0 + offsetsX[i] + 0.5f) / source.Width(), (y0 + offsetsY[i] + 0.5f) / source.Height());
+			weights[i] *= std::exp(-ColourDistanceSq(*here, there) * UPSAMPLE_EDGE_SHARPNESS);
+		}
+		total += weights[i];
+	}
+
+	// A pixel matching none of its neighbours (e.g. a thin line missing from the source) falls back to bilinear
+	const float* used = (total > 0.0001f) ? weights : bilinear;
+	if (used == bilinear)  total = 1;
+
+	ColourRGBA sum(0, 0, 0, 0);
+	for (int i = 0; i < 4; ++i)
+	{
+		const ColourRGBA& pixel = source.ClampedPixel(x0 + offsetsX[i], y0 + offsetsY[i]);
+		float w = used[i] / total;
+		sum.r += pixel.r * w;
+		sum.g += pixel.g * w;
+		sum.b += pixel.b * w;
+		sum.a += pixel.a * w;
+	}
+	return sum;
+}
+
+
+// Enlarge source to width x height, writing to target (resized to match). The guide can be any size, it is
+// point sampled. With no guide (or edgeAware false) this is plain bilinear enlargement, for comparison
+void EdgeAwareUpsample(const Image& source, const Image& guide, Image& target, int width, int height, bool edgeAware /*= true*/)
+{
+	target.Resize(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		ColourRGBA* out = target.Row(y);
+		for (int x = 0; x < width; ++x)
+		{
+			out[x] = EdgeAwareUpsamplePixel(source, guide, target.U(x), target.V(y), edgeAware);
+		}
+	}
+}
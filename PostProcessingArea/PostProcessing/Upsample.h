@@ -0,0 +1,31 @@
+//--------------------------------------------------------------------------------------
+// Edge-aware upsampling
+//--------------------------------------------------------------------------------------
+// Effects can be drawn at half or quarter resolution (see PostProcessEffect::Downscale), the graph then
+// adds an upsample pass to get back to full resolution. Plain bilinear enlargement smears the result
+// across the edges of objects, so each pixel instead blends the four nearest low resolution pixels
+// weighted both by distance (as bilinear) and by how closely a full resolution guide image matches
+// at that pixel and at each of the four. Low resolution pixels from the other side of an edge in the
+// guide get almost no weight, so the edge stays where it is in the guide.
+//
+// This file has the CPU version, Upsample_pp.hlsl is the GPU version
+
+#ifndef _UPSAMPLE_H_INCLUDED_
+#define _UPSAMPLE_H_INCLUDED_
+
+#include "Image.h"
+
+
+// How quickly the weight of a low resolution pixel falls as the guide colours differ. A difference of 0.1 in
+// each channel keeps about 40% of the weight, 0.25 less than 1%. Must match the value in Upsample_pp.hlsl
+const float UPSAMPLE_EDGE_SHARPNESS = 50.0f;
+
+// Enlarge source to width x height, writing to target (resized to match). The guide can be any size, it is
+// point sampled. With no guide (or edgeAware false) this is plain bilinear enlargement, for comparison
+void EdgeAwareUpsample(const Image& source, const Image& guide, Image& target, int width, int height, bool edgeAware = true);
+
+// One full resolution pixel at texture coordinate u, v enlarged from source, as above
+ColourRGBA EdgeAwareUpsamplePixel(const Image& source, const Image& guide, float u, float v, bool edgeAware = true);
+
+
+#endif //_UPSAMPLE_H_INCLUDED_
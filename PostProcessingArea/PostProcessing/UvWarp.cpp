@@ -0,0 +1,494 @@
+//--------------------------------------------------------------------------------------
+// Vectorised CPU version of the UV warp post-processes
+//--------------------------------------------------------------------------------------
+
+#include "UvWarp.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(POST_PROCESS_X86)
+#include <immintrin.h>
+#endif
+
+
+// Everything the first stage reads and writes for one row, see UvWarp
+struct UvWarpRow
+{
+	// Each column
+	const float* SceneU;
+	const float* AreaXX;
+	const float* ColumnTerm;
+
+	// The row: scene V coordinate, (areaV - 0.5)^2 and sin along y (waves) or the V offset from the centre (Spiral)
+	float SceneV;
+	float AreaYY;
+	float RowTerm;
+
+	// The pass
+	float SoftEdge;
+	float Scale[2];  // Waves: scale of the offset in U and V
+	float Centre[2]; // Spiral: centre of the area
+	float Level;     // Spiral: SpiralLevel
+	bool  FadeAlpha; // HeatHaze: alpha fades with the waves
+
+	// Results: coordinates to read and alpha
+	float* U;
+	float* V;
+	float* Alpha;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	const float PI = 3.14159265358979323846f;
+
+	// Pixels in an AVX2 register, rows are padded to a multiple of this
+	const int ROW_ALIGNMENT = 8;
+
+	// sin and cos: the angle less the nearest multiple of pi/2 (taken off in three parts so the first products are exact),
+	// then minimax polynomials over -pi/4->pi/4 (Cephes' sinf/cosf) chosen and negated by which multiple it was
+	const float TWO_OVER_PI = 0.636619772367581343f;
+	const float HALF_PI_1   = 1.5703125f;
+	const float HALF_PI_2   = 4.837512969970703125e-4f;
+	const float HALF_PI_3   = 7.54978995489188216e-8f;
+	const float SIN_1 = -1.6666654611e-1f, SIN_2 = 8.3321608736e-3f,  SIN_3 = -1.9515295891e-4f;
+	const float COS_1 =  4.166664568298827e-2f, COS_2 = -1.388731625493765e-3f, COS_3 = 2.443315711809948e-5f;
+
+	// The same alpha as SoftCircleAlpha from the two squares making up the distance
+	float SoftAlpha(float xx, float yy, float softEdge)  { return 1.0f - Saturate((xx + yy - 0.25f + softEdge) / softEdge); }
+
+	void SinCos(float angle, float& s, float& c)
+	{
+		const float quadrant = std::nearbyint(angle * TWO_OVER_PI);
+		const int   q = static_cast<int>(quadrant);
+		const float r  = angle - quadrant * HALF_PI_1 - quadrant * HALF_PI_2 - quadrant * HALF_PI_3;
+		const float r2 = r * r;
+		float ps = (SIN_3 * r2 + SIN_2) * r2 + SIN_1;
+		float pc = (COS_3 * r2 + COS_2) * r2 + COS_1;
+		ps = ps * r2 * r + r;
+		pc = pc * r2 * r2 - r2 * 0.5f + 1.0f;
+		s = (q & 1) ? pc : ps;
+		c = (q & 1) ? ps : pc;
+		if (q & 2)        s = -s;
+		if ((q + 1) & 2)  c = -c;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Coordinates
+//--------------------------------------------------------------------------------------
+// Each function works out the coordinates to read and the alpha for count pixels of a row (a multiple of ROW_ALIGNMENT).
+// The waves are Underwater and HeatHaze, offsetting each axis by a sin along the other. Every version works out the same
+// operations in the same order as the scalar one, which does so as ShadeEffectPixel
+
+namespace
+{
+	using FieldFunction = void (*)(const UvWarpRow& row, int count);
+
+	void WaveFieldScalar(const UvWarpRow& row, int count)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			float alpha = SoftAlpha(row.AreaXX[i], row.AreaYY, row.SoftEdge);
+			row.U[i] = row.SceneU[i] + row.RowTerm * 0.01f * alpha * row.Scale[0];
+			row.V[i] = row.SceneV + row.ColumnTerm[i] * 0.01f * alpha * row.Scale[1];
+			row.Alpha[i] = row.FadeAlpha ? alpha * Saturate(row.ColumnTerm[i] * row.RowTerm * 0.33f + 0.66f) : alpha;
+		}
+	}
+
+	void SpiralFieldScalar(const UvWarpRow& row, int count)
+	{
+		const float offsetV = row.RowTerm;
+		for (int i = 0; i < count; ++i)
+		{
+			const float offsetU = row.ColumnTerm[i];
+			float s, c;
+			SinCos(std::sqrt(offsetU * offsetU + offsetV * offsetV) * row.Level * row.Level, s, c);
+			row.U[i] = row.Centre[0] + offsetU * c - offsetV * s;
+			row.V[i] = row.Centre[1] + offsetU * s + offsetV * c;
+			row.Alpha[i] = SoftAlpha(row.AreaXX[i], row.AreaYY, row.SoftEdge);
+		}
+	}
+
+
+#if defined(POST_PROCESS_X86)
+	__m128 SaturateSSE2(__m128 x)  { return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+
+	__m128 SoftAlphaSSE2(__m128 xx, __m128 yy, __m128 softEdge)
+	{
+		__m128 t = _mm_add_ps(_mm_sub_ps(_mm_add_ps(xx, yy), _mm_set1_ps(0.25f)), softEdge);
+		return _mm_sub_ps(_mm_set1_ps(1.0f), SaturateSSE2(_mm_div_ps(t, softEdge)));
+	}
+
+	void SinCosSSE2(__m128 angle, __m128& s, __m128& c)
+	{
+		const __m128i q = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TWO_OVER_PI))); // Rounds to nearest, as nearbyint
+		const __m128  quadrant = _mm_cvtepi32_ps(q);
+		__m128 r = _mm_sub_ps(angle, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_1)));
+		r = _mm_sub_ps(r, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_2)));
+		r = _mm_sub_ps(r, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_3)));
+		const __m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 ps = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_3), r2), _mm_set1_ps(SIN_2)), r2), _mm_set1_ps(SIN_1));
+		__m128 pc = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_3), r2), _mm_set1_ps(COS_2)), r2), _mm_set1_ps(COS_1));
+		ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+		pc = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(pc, r2), r2), _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+		// Swap for odd quadrants, then flip the sign bits
+		const __m128  swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		const __m128i one  = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+		s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+		c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+		s = _mm_xor_ps(s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)));
+		c = _mm_xor_ps(c, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30)));
+	}
+
+	void WaveFieldSSE2(const UvWarpRow& row, int count)
+	{
+		const __m128 yy        = _mm_set1_ps(row.AreaYY);
+		const __m128 softEdge  = _mm_set1_ps(row.SoftEdge);
+		const __m128 sceneV    = _mm_set1_ps(row.SceneV);
+		const __m128 rowTerm   = _mm_set1_ps(row.RowTerm);
+		const __m128 rowOffset = _mm_set1_ps(row.RowTerm * 0.01f);
+		const __m128 scaleU    = _mm_set1_ps(row.Scale[0]);
+		const __m128 scaleV    = _mm_set1_ps(row.Scale[1]);
+		const __m128 hundredth = _mm_set1_ps(0.01f);
+		for (int i = 0; i < count; i += 4)
+		{
+			const __m128 column = _mm_loadu_ps(row.ColumnTerm + i);
+			__m128 alpha = SoftAlphaSSE2(_mm_loadu_ps(row.AreaXX + i), yy, softEdge);
+			_mm_storeu_ps(row.U + i, _mm_add_ps(_mm_loadu_ps(row.SceneU + i), _mm_mul_ps(_mm_mul_ps(rowOffset, alpha), scaleU)));
+			_mm_storeu_ps(row.V + i, _mm_add_ps(sceneV, _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(column, hundredth), alpha), scaleV)));
+			if (row.FadeAlpha)
+			{
+				__m128 wave = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(column, rowTerm), _mm_set1_ps(0.33f)), _mm_set1_ps(0.66f));
+				alpha = _mm_mul_ps(alpha, SaturateSSE2(wave));
+			}
+			_mm_storeu_ps(row.Alpha + i, alpha);
+		}
+	}
+
+	void SpiralFieldSSE2(const UvWarpRow& row, int count)
+	{
+		const __m128 yy       = _mm_set1_ps(row.AreaYY);
+		const __m128 softEdge = _mm_set1_ps(row.SoftEdge);
+		const __m128 offsetV  = _mm_set1_ps(row.RowTerm);
+		const __m128 offsetVV = _mm_set1_ps(row.RowTerm * row.RowTerm);
+		const __m128 level    = _mm_set1_ps(row.Level);
+		const __m128 centreU  = _mm_set1_ps(row.Centre[0]);
+		const __m128 centreV  = _mm_set1_ps(row.Centre[1]);
+		for (int i = 0; i < count; i += 4)
+		{
+			const __m128 offsetU = _mm_loadu_ps(row.ColumnTerm + i);
+			__m128 angle = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(offsetU, offsetU), offsetVV));
+			__m128 s, c;
+			SinCosSSE2(_mm_mul_ps(_mm_mul_ps(angle, level), level), s, c);
+			_mm_storeu_ps(row.U + i, _mm_sub_ps(_mm_add_ps(centreU, _mm_mul_ps(offsetU, c)), _mm_mul_ps(offsetV, s)));
+			_mm_storeu_ps(row.V + i, _mm_add_ps(_mm_add_ps(centreV, _mm_mul_ps(offsetU, s)), _mm_mul_ps(offsetV, c)));
+			_mm_storeu_ps(row.Alpha + i, SoftAlphaSSE2(_mm_loadu_ps(row.AreaXX + i), yy, softEdge));
+		}
+	}
+
+
+	// The same eight pixels at a time. Multiply and add are kept separate (no FMA) to round as the other versions do
+	AVX2_FUNCTION __m256 SaturateAVX2(__m256 x)  { return _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), _mm256_set1_ps(1.0f)); }
+
+	AVX2_FUNCTION __m256 SoftAlphaAVX2(__m256 xx, __m256 yy, __m256 softEdge)
+	{
+		__m256 t = _mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(xx, yy), _mm256_set1_ps(0.25f)), softEdge);
+		return _mm256_sub_ps(_mm256_set1_ps(1.0f), SaturateAVX2(_mm256_div_ps(t, softEdge)));
+	}
+
+	AVX2_FUNCTION void SinCosAVX2(__m256 angle, __m256& s, __m256& c)
+	{
+		const __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(TWO_OVER_PI)));
+		const __m256  quadrant = _mm256_cvtepi32_ps(q);
+		__m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(quadrant, _mm256_set1_ps(HALF_PI_1)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(quadrant, _mm256_set1_ps(HALF_PI_2)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(quadrant, _mm256_set1_ps(HALF_PI_3)));
+		const __m256 r2 = _mm256_mul_ps(r, r);
+
+		__m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_3), r2), _mm256_set1_ps(SIN_2)), r2), _mm256_set1_ps(SIN_1));
+		__m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_3), r2), _mm256_set1_ps(COS_2)), r2), _mm256_set1_ps(COS_1));
+		ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, r2), r), r);
+		pc = _mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(pc, r2), r2), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_set1_ps(1.0f));
+
+		const __m256  swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+		const __m256i one  = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+		s = _mm256_blendv_ps(ps, pc, swap);
+		c = _mm256_blendv_ps(pc, ps, swap);
+		s = _mm256_xor_ps(s, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(q, two), 30)));
+		c = _mm256_xor_ps(c, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(q, one), two), 30)));
+	}
+
+	AVX2_FUNCTION void WaveFieldAVX2(const UvWarpRow& row, int count)
+	{
+		const __m256 yy        = _mm256_set1_ps(row.AreaYY);
+		const __m256 softEdge  = _mm256_set1_ps(row.SoftEdge);
+		const __m256 sceneV    = _mm256_set1_ps(row.SceneV);
+		const __m256 rowTerm   = _mm256_set1_ps(row.RowTerm);
+		const __m256 rowOffset = _mm256_set1_ps(row.RowTerm * 0.01f);
+		const __m256 scaleU    = _mm256_set1_ps(row.Scale[0]);
+		const __m256 scaleV    = _mm256_set1_ps(row.Scale[1]);
+		const __m256 hundredth = _mm256_set1_ps(0.01f);
+		for (int i = 0; i < count; i += 8)
+		{
+			const __m256 column = _mm256_loadu_ps(row.ColumnTerm + i);
+			__m256 alpha = SoftAlphaAVX2(_mm256_loadu_ps(row.AreaXX + i), yy, softEdge);
+			_mm256_storeu_ps(row.U + i, _mm256_add_ps(_mm256_loadu_ps(row.SceneU + i), _mm256_mul_ps(_mm256_mul_ps(rowOffset, alpha), scaleU)));
+			_mm256_storeu_ps(row.V + i, _mm256_add_ps(sceneV, _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(column, hundredth), alpha), scaleV)));
+			if (row.FadeAlpha)
+			{
+				__m256 wave = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(column, rowTerm), _mm256_set1_ps(0.33f)), _mm256_set1_ps(0.66f));
+				alpha = _mm256_mul_ps(alpha, SaturateAVX2(wave));
+			}
+			_mm256_storeu_ps(row.Alpha + i, alpha);
+		}
+	}
+
+	AVX2_FUNCTION void SpiralFieldAVX2(const UvWarpRow& row, int count)
+	{
+		const __m256 yy       = _mm256_set1_ps(row.AreaYY);
+		const __m256 softEdge = _mm256_set1_ps(row.SoftEdge);
+		const __m256 offsetV  = _mm256_set1_ps(row.RowTerm);
+		const __m256 offsetVV = _mm256_set1_ps(row.RowTerm * row.RowTerm);
+		const __m256 level    = _mm256_set1_ps(row.Level);
+		const __m256 centreU  = _mm256_set1_ps(row.Centre[0]);
+		const __m256 centreV  = _mm256_set1_ps(row.Centre[1]);
+		for (int i = 0; i < count; i += 8)
+		{
+			const __m256 offsetU = _mm256_loadu_ps(row.ColumnTerm + i);
+			__m256 angle = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(offsetU, offsetU), offsetVV));
+			__m256 s, c;
+			SinCosAVX2(_mm256_mul_ps(_mm256_mul_ps(angle, level), level), s, c);
+			_mm256_storeu_ps(row.U + i, _mm256_sub_ps(_mm256_add_ps(centreU, _mm256_mul_ps(offsetU, c)), _mm256_mul_ps(offsetV, s)));
+			_mm256_storeu_ps(row.V + i, _mm256_add_ps(_mm256_add_ps(centreV, _mm256_mul_ps(offsetU, s)), _mm256_mul_ps(offsetV, c)));
+			_mm256_storeu_ps(row.Alpha + i, SoftAlphaAVX2(_mm256_loadu_ps(row.AreaXX + i), yy, softEdge));
+		}
+	}
+#endif
+
+
+	FieldFunction ChooseField(PostProcess process, SimdLevel level)
+	{
+		const bool spiral = (process == PostProcess::Spiral);
+#if defined(POST_PROCESS_X86)
+		switch (SupportedSimdLevel(level))
+		{
+		case SimdLevel::AVX2:  return spiral ? SpiralFieldAVX2 : WaveFieldAVX2;
+		case SimdLevel::SSE2:  return spiral ? SpiralFieldSSE2 : WaveFieldSSE2;
+		default:               break;
+		}
+#endif
+		return spiral ? SpiralFieldScalar : WaveFieldScalar;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reading the scene
+//--------------------------------------------------------------------------------------
+// Each function works out the pixel of the image the point sampler reads at each coordinate, as Image::SamplePoint:
+// floor(coordinate * size) clamped to the pixels held. count is a multiple of ROW_ALIGNMENT
+
+namespace
+{
+	using PixelFunction = void (*)(const Image& image, const float* u, const float* v, int* x, int* y, int count);
+
+	void PixelsScalar(const Image& image, const float* u, const float* v, int* x, int* y, int count)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			x[i] = std::min(std::max(static_cast<int>(std::floor(u[i] * image.FullWidth()))  - image.OriginX(), 0), image.Width()  - 1);
+			y[i] = std::min(std::max(static_cast<int>(std::floor(v[i] * image.FullHeight())) - image.OriginY(), 0), image.Height() - 1);
+		}
+	}
+
+
+#if defined(POST_PROCESS_X86)
+	// Clamped in floating point, where SSE2 has min and max. Outside the range of an int the conversion gives INT_MIN as the
+	// scalar cast does, which clamps to the first pixel either way
+	__m128i ClampedPixelSSE2(__m128 coordinate, float size, int origin, int count)
+	{
+		__m128 position = _mm_mul_ps(coordinate, _mm_set1_ps(size));
+		__m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(position));
+		whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, position), _mm_set1_ps(1.0f))); // floor
+		whole = _mm_min_ps(_mm_max_ps(whole, _mm_set1_ps(static_cast<float>(origin))), _mm_set1_ps(static_cast<float>(origin + count - 1)));
+		return _mm_sub_epi32(_mm_cvttps_epi32(whole), _mm_set1_epi32(origin));
+	}
+
+	void PixelsSSE2(const Image& image, const float* u, const float* v, int* x, int* y, int count)
+	{
+		const float width  = static_cast<float>(image.FullWidth());
+		const float height = static_cast<float>(image.FullHeight());
+		for (int i = 0; i < count; i += 4)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(x + i), ClampedPixelSSE2(_mm_loadu_ps(u + i), width,  image.OriginX(), image.Width()));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), ClampedPixelSSE2(_mm_loadu_ps(v + i), height, image.OriginY(), image.Height()));
+		}
+	}
+
+
+	AVX2_FUNCTION __m256i ClampedPixelAVX2(__m256 coordinate, float size, int origin, int count)
+	{
+		__m256 whole = _mm256_floor_ps(_mm256_mul_ps(coordinate, _mm256_set1_ps(size)));
+		whole = _mm256_min_ps(_mm256_max_ps(whole, _mm256_set1_ps(static_cast<float>(origin))), _mm256_set1_ps(static_cast<float>(origin + count - 1)));
+		return _mm256_sub_epi32(_mm256_cvttps_epi32(whole), _mm256_set1_epi32(origin));
+	}
+
+	AVX2_FUNCTION void PixelsAVX2(const Image& image, const float* u, const float* v, int* x, int* y, int count)
+	{
+		const float width  = static_cast<float>(image.FullWidth());
+		const float height = static_cast<float>(image.FullHeight());
+		for (int i = 0; i < count; i += 8)
+		{
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(x + i), ClampedPixelAVX2(_mm256_loadu_ps(u + i), width,  image.OriginX(), image.Width()));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), ClampedPixelAVX2(_mm256_loadu_ps(v + i), height, image.OriginY(), image.Height()));
+		}
+	}
+#endif
+
+
+	PixelFunction ChoosePixels(SimdLevel level)
+	{
+#if defined(POST_PROCESS_X86)
+		switch (SupportedSimdLevel(level))
+		{
+		case SimdLevel::AVX2:  return PixelsAVX2;
+		case SimdLevel::SSE2:  return PixelsSSE2;
+		default:               break;
+		}
+#endif
+		return PixelsScalar;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Drawing
+//--------------------------------------------------------------------------------------
+
+// Whether the post-process is one of the warps drawn here
+bool IsUvWarpEffect(PostProcess process)
+{
+	return process == PostProcess::Distort || process == PostProcess::Spiral ||
+	       process == PostProcess::Underwater || process == PostProcess::HeatHaze;
+}
+
+
+// Set up to draw pixels firstX to firstX + count - 1 of the target's rows with the effect, working out the column terms
+void UvWarp::Begin(PostProcess process, const CpuEffectInputs& inputs, const Image& target, int firstX, int count,
+                   float areaLeft, float areaWidth, SimdLevel level)
+{
+	const PostProcessAnimation& animation = *inputs.Animation;
+	mProcess = process;
+	mInputs  = &inputs;
+	mCount   = std::max(count, 0);
+	mPadded  = (mCount + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+	mField   = ChooseField(process, level);
+	mPixels  = ChoosePixels(level);
+
+	// Soft edges and scales as in each shader
+	mSoftEdge  = (process == PostProcess::Distort) ? 0.2f : (process == PostProcess::Spiral) ? 0.1f : 0.15f;
+	mScale[0]  = (process == PostProcess::HeatHaze) ? inputs.AreaSize[0] : 1.0f;
+	mScale[1]  = (process == PostProcess::HeatHaze) ? inputs.AreaSize[1] : 1.0f;
+	mCentre[0] = inputs.AreaTopLeft[0] + inputs.AreaSize[0] * 0.5f;
+	mCentre[1] = inputs.AreaTopLeft[1] + inputs.AreaSize[1] * 0.5f;
+	mLevel     = animation.SpiralLevel;
+	mFadeAlpha = (process == PostProcess::HeatHaze);
+
+	// The map's mip-map depends on the area's size alone, see TexelsPerPixel in CpuEffects.cpp
+	const MipMappedImage* map = inputs.DistortMap;
+	if (map && !map->Empty())
+	{
+		mMapTexels = std::max(map->Level(0).Width()  / std::max(inputs.AreaPixels[0], 1.0f),
+		                      map->Level(0).Height() / std::max(inputs.AreaPixels[1], 1.0f));
+	}
+
+	// Padding columns are drawn along with the others but never read
+	for (std::vector<float>* column : { &mSceneU, &mAreaU, &mAreaXX, &mColumnTerm, &mU, &mV, &mAlpha, &mLight })
+	{
+		column->assign(mPadded, 0.0f);
+	}
+	mX.assign(mPadded, 0);
+	mY.assign(mPadded, 0);
+
+	for (int i = 0; i < mCount; ++i)
+	{
+		const float sceneU = target.U(firstX + i);
+		const float areaU  = (sceneU - areaLeft) / areaWidth;
+		const float x = areaU - 0.5f;
+		mSceneU[i] = sceneU;
+		mAreaU[i]  = areaU;
+		mAreaXX[i] = x * x;
+		switch (process)
+		{
+		case PostProcess::Underwater: mColumnTerm[i] = std::sin(areaU * 2 * PI + animation.WaterLevel);            break;
+		case PostProcess::HeatHaze:   mColumnTerm[i] = std::sin(areaU * 8 * PI + animation.HeatHazeTimer * 3.0f);  break;
+		case PostProcess::Spiral:     mColumnTerm[i] = sceneU - mCentre[0];                                        break;
+		default:                      break;
+		}
+	}
+}
+
+
+// Shade the pixels of the row at the given scene and area V coordinates
+void UvWarp::ShadeRow(float sceneV, float areaV, ColourRGBA* out)
+{
+	const PostProcessAnimation& animation = *mInputs->Animation;
+	const Image& scene = *mInputs->Sources[0];
+	const float y = areaV - 0.5f;
+
+	// Coordinates to read. Distort's come from its map a pixel at a time
+	if (mProcess == PostProcess::Distort)
+	{
+		const MipMappedImage* map = mInputs->DistortMap;
+		for (int i = 0; i < mCount; ++i)
+		{
+			ColourRGBA distort = (map && !map->Empty()) ? map->Sample(mAreaU[i], areaV, mMapTexels) : ColourRGBA(0.5f, 0.5f, 0.5f, 1);
+			float vectorU = distort.g - 0.5f;
+			float vectorV = distort.b - 0.5f;
+			float length = std::sqrt(vectorU * vectorU + vectorV * vectorV);
+			mLight[i] = (length > 0) ? (vectorU + vectorV) / length * 0.707f * 0.015f : 0.0f;
+			mU[i] = mSceneU[i] + animation.DistortLevel * vectorU;
+			mV[i] = sceneV + animation.DistortLevel * vectorV;
+			mAlpha[i] = SoftAlpha(mAreaXX[i], y * y, mSoftEdge);
+		}
+	}
+	else
+	{
+		float rowTerm = 0;
+		if      (mProcess == PostProcess::Underwater)  rowTerm = std::sin(areaV * 2 * PI + animation.WaterLevel * 0.7f);
+		else if (mProcess == PostProcess::HeatHaze)    rowTerm = std::sin(areaV * 20 * PI + animation.HeatHazeTimer * 3.7f);
+		else                                           rowTerm = sceneV - mCentre[1];
+
+		UvWarpRow row = { mSceneU.data(), mAreaXX.data(), mColumnTerm.data(), sceneV, y * y, rowTerm, mSoftEdge,
+		                  { mScale[0], mScale[1] }, { mCentre[0], mCentre[1] }, mLevel, mFadeAlpha, mU.data(), mV.data(), mAlpha.data() };
+		mField(row, mPadded);
+	}
+
+	// Read the scene, then finish each pixel as its shader does
+	mPixels(scene, mU.data(), mV.data(), mX.data(), mY.data(), mPadded);
+	for (int i = 0; i < mCount; ++i)
+	{
+		const ColourRGBA& colour = scene.Pixel(mX[i], mY[i]);
+		switch (mProcess)
+		{
+		case PostProcess::Distort:
+			out[i] = ColourRGBA(mLight[i] + colour.r * 0.8f, mLight[i] + colour.g * 0.8f, mLight[i] + colour.b * 0.8f, mAlpha[i]);
+			break;
+		case PostProcess::Underwater:
+			out[i] = ColourRGBA(0.0f, colour.b * 0.3f, colour.g, mAlpha[i]); // .rbg * (0, 0.3, 1)
+			break;
+		default:
+			out[i] = ColourRGBA(colour.r, colour.g, colour.b, mAlpha[i]);
+			break;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// Vectorised CPU version of the UV warp post-processes
+//--------------------------------------------------------------------------------------
+// Distort, Spiral, Underwater and HeatHaze all work out a texture coordinate offset from the pixel's
+// position and read the scene there with the point sampler. Shading them a pixel at a time repeats
+// work that only depends on the pixel's column or row: Underwater's and HeatHaze's two waves are a sin
+// of areaU and a sin of areaV, and the soft circle and Spiral's offset from the centre are a sum of
+// a column term and a row term. Here a rectangle is drawn a row at a time: everything depending only
+// on the column is worked out once in Begin, only on the row once per row, then each row is drawn in
+// two stages. The first works out the coordinates to read (and the alpha) for the whole row, eight
+// pixels per instruction with AVX2 and four with SSE2. The second reads the scene at those coordinates
+// (one gather of the point sampler's pixel per coordinate) and finishes the colour for the effect.
+//
+// Spiral's rotation can't be split into row and column terms, so its sin and cos are a polynomial
+// rather than std::sin/cos, within about 1e-7 of them. Very rarely that moves a coordinate sitting on the
+// boundary between two pixels to the other one. The other effects work out exactly what ShadeEffectPixel
+// does in the same order, so give the same results. Each instruction set gives the same results as the
+// others. Distort's map is read with the trilinear sampler a pixel at a time, as ShadeEffectPixel does.
+
+#ifndef _UV_WARP_H_INCLUDED_
+#define _UV_WARP_H_INCLUDED_
+
+#include "CpuEffects.h"
+#include "CpuFeatures.h"
+#include "Image.h"
+
+#include <vector>
+
+struct UvWarpRow;
+
+
+// Whether the post-process is one of the warps drawn here
+bool IsUvWarpEffect(PostProcess process);
+
+
+// Draws the rows of a rectangle of pixels with one of the warp effects, see above
+class UvWarp
+{
+public:
+	// Set up to draw pixels firstX to firstX + count - 1 of the target's rows (pixels held, for a window) with the effect,
+	// reading inputs.Sources[0]. Area U coordinates run 0->1 across a rectangle whose left and width are given in 0->1
+	// coordinates of the whole target, as the area UVs of CpuPostProcessBackend::DrawRectangle. The inputs must stay as
+	// they are until the last row is drawn
+	void Begin(PostProcess process, const CpuEffectInputs& inputs, const Image& target, int firstX, int count,
+	           float areaLeft, float areaWidth, SimdLevel level = BestSimdLevel());
+
+	// Shade the pixels of the row at the given scene and area V coordinates, writing what ShadeEffectPixel returns for each
+	// (alpha included) to out
+	void ShadeRow(float sceneV, float areaV, ColourRGBA* out);
+
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	using FieldFunction  = void (*)(const UvWarpRow& row, int count);
+	using PixelFunction  = void (*)(const Image& image, const float* u, const float* v, int* x, int* y, int count);
+
+	PostProcess            mProcess = PostProcess::Copy;
+	const CpuEffectInputs* mInputs  = nullptr;
+	int                    mCount   = 0;
+	int                    mPadded  = 0; // Count rounded up to a whole number of AVX2 registers, the rows are this long
+	FieldFunction          mField   = nullptr;
+	PixelFunction          mPixels  = nullptr;
+
+	// Settings for the whole pass, see UvWarpRow
+	float mSoftEdge  = 0;
+	float mScale[2]  = { 0, 0 };
+	float mCentre[2] = { 0, 0 };
+	float mLevel     = 0;
+	bool  mFadeAlpha = false;
+	float mMapTexels = 1; // Distort: texels of the map per pixel, to choose its mip-map
+
+	// Each column
+	std::vector<float> mSceneU;
+	std::vector<float> mAreaU;
+	std::vector<float> mAreaXX;     // (areaU - 0.5)^2 for the soft circle
+	std::vector<float> mColumnTerm; // Waves: sin along x. Spiral: U offset from the centre
+
+	// Coordinates to read for each pixel of the row, its alpha and Distort's light, then the pixel the point sampler reads
+	std::vector<float> mU;
+	std::vector<float> mV;
+	std::vector<float> mAlpha;
+	std::vector<float> mLight;
+	std::vector<int>   mX;
+	std::vector<int>   mY;
+};
+
+
+#endif //_UV_WARP_H_INCLUDED_
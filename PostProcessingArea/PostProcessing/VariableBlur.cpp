@@ -0,0 +1,162 @@
+//--------------------------------------------------------------------------------------
+// Variable radius blur post-process
+//--------------------------------------------------------------------------------------
+
+#include "VariableBlur.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Rows given to each task for the running sums along rows, and columns for the sums down columns. A strip of columns
+	// is a few cache lines wide so each row of it is read in one go
+	const int ROWS_PER_TASK    = 16;
+	const int COLUMNS_PER_TASK = 64;
+
+	// 0->1 colour channel as an 8-bit level, as the GPU reads it from an 8-bit target
+	uint32_t Level(float x)  { return static_cast<uint32_t>(Saturate(x) * 255 + 0.5f); }
+
+	void AddScaled(ColourRGBA& sum, const ColourRGBA& colour, float weight)
+	{
+		sum.r += colour.r * weight;
+		sum.g += colour.g * weight;
+		sum.b += colour.b * weight;
+	}
+}
+
+
+//--------------------------------------------------------------------------------------
+// Summed-area table
+//--------------------------------------------------------------------------------------
+
+// Build the table from the image's colours, rounded to 8 bits
+void SummedAreaTable::Build(const Image& image, TaskPool* pool)
+{
+	mWidth  = image.Width();
+	mHeight = image.Height();
+	mSums.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+	if (mWidth == 0 || mHeight == 0)  return;
+
+	// Running sum along each row
+	auto sumRows = [&](int task)
+	{
+		const int lastRow = std::min((task + 1) * ROWS_PER_TASK, mHeight);
+		for (int y = task * ROWS_PER_TASK; y < lastRow; ++y)
+		{
+			const ColourRGBA* pixels = image.Row(y);
+			uint32_t* sums = &mSums[static_cast<size_t>(y) * mWidth * 4];
+			uint32_t r = 0, g = 0, b = 0, a = 0;
+			for (int x = 0; x < mWidth; ++x, sums += 4)
+			{
+				sums[0] = r += Level(pixels[x].r);
+				sums[1] = g += Level(pixels[x].g);
+				sums[2] = b += Level(pixels[x].b);
+				sums[3] = a += Level(pixels[x].a);
+			}
+		}
+	};
+
+	// Then add each row's sums to the row below, down a strip of columns. Sums wrap around past 2^32, see the header
+	auto sumColumns = [&](int task)
+	{
+		const int first = task * COLUMNS_PER_TASK * 4;
+		const int last  = std::min((task + 1) * COLUMNS_PER_TASK, mWidth) * 4;
+		for (int y = 1; y < mHeight; ++y)
+		{
+			const uint32_t* above = &mSums[static_cast<size_t>(y - 1) * mWidth * 4];
+			uint32_t*       sums  = &mSums[static_cast<size_t>(y) * mWidth * 4];
+			for (int i = first; i < last; ++i)  sums[i] += above[i];
+		}
+	};
+
+	const int rowTasks    = (mHeight + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+	const int columnTasks = (mWidth + COLUMNS_PER_TASK - 1) / COLUMNS_PER_TASK;
+	if (pool)
+	{
+		pool->ParallelFor(rowTasks, sumRows);
+		pool->ParallelFor(columnTasks, sumColumns);
+	}
+	else
+	{
+		for (int i = 0; i < rowTasks; ++i)  sumRows(i);
+		for (int i = 0; i < columnTasks; ++i)  sumColumns(i);
+	}
+}
+
+
+// Average colour of the pixels within radius of (x, y), the box clipped to the image
+ColourRGBA SummedAreaTable::BoxAverage(int x, int y, int radius) const
+{
+	// Corners of the box, the top-left one just outside it. -1 is outside the image, where the sums are all zero
+	const int left   = std::max(x - radius, 0) - 1;
+	const int top    = std::max(y - radius, 0) - 1;
+	const int right  = std::min(x + radius, mWidth - 1);
+	const int bottom = std::min(y + radius, mHeight - 1);
+
+	uint32_t sum[3];
+	const uint32_t* bottomRight = Entry(right, bottom);
+	for (int channel = 0; channel < 3; ++channel)  sum[channel] = bottomRight[channel];
+	if (left >= 0)
+	{
+		const uint32_t* bottomLeft = Entry(left, bottom);
+		for (int channel = 0; channel < 3; ++channel)  sum[channel] -= bottomLeft[channel];
+	}
+	if (top >= 0)
+	{
+		const uint32_t* topRight = Entry(right, top);
+		for (int channel = 0; channel < 3; ++channel)  sum[channel] -= topRight[channel];
+	}
+	if (left >= 0 && top >= 0)
+	{
+		const uint32_t* topLeft = Entry(left, top);
+		for (int channel = 0; channel < 3; ++channel)  sum[channel] += topLeft[channel];
+	}
+
+	// Sums are below 2^24 for any box up to MAX_VARIABLE_BLUR_RADIUS, so are exact as floats
+	const float scale = 1.0f / (255.0f * (right - left) * (bottom - top));
+	return ColourRGBA(sum[0] * scale, sum[1] * scale, sum[2] * scale, 1);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Effect
+//--------------------------------------------------------------------------------------
+
+// Blur radius at a point in the area, in full size pixels
+float VariableBlurRadius(const PostProcessData& data, float areaU, float areaV)
+{
+	// Distance from the middle of the area, 1 at the edge of its circle. The radius grows from the focus distance out
+	const float u = areaU - 0.5f, v = areaV - 0.5f;
+	const float distance = 2 * std::sqrt(u * u + v * v);
+	const float focus = data.VariableBlur.focus;
+	const float t = Saturate((distance - focus) / std::max(1 - focus, 0.0001f));
+	return data.VariableBlur.innerRadius + (data.VariableBlur.outerRadius - data.VariableBlur.innerRadius) * t;
+}
+
+
+// Blurred colour at pixel (x, y): the average of a stack of boxes out to radius
+ColourRGBA StackedBoxBlur(const SummedAreaTable& table, int x, int y, float radius, int boxes)
+{
+	radius = std::min(std::max(radius, 0.0f), static_cast<float>(MAX_VARIABLE_BLUR_RADIUS));
+	boxes  = std::min(std::max(boxes, 1), MAX_STACKED_BOXES);
+
+	ColourRGBA colour(0, 0, 0, 1);
+	for (int box = 1; box <= boxes; ++box)
+	{
+		// Blend the boxes either side of a fractional radius
+		const float boxRadius = radius * box / boxes;
+		const int   inner = static_cast<int>(boxRadius);
+		const float blend = boxRadius - inner;
+		AddScaled(colour, table.BoxAverage(x, y, inner), (1 - blend) / boxes);
+		if (blend > 0)  AddScaled(colour, table.BoxAverage(x, y, inner + 1), blend / boxes);
+	}
+	return colour;
+}
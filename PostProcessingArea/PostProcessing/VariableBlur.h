@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------------
+// Variable radius blur post-process
+//--------------------------------------------------------------------------------------
+// A blur whose radius changes across the area: the inner radius in the middle, out to a focus distance,
+// then growing to the outer radius at the edge of the area's circle (for the full screen, from the middle
+// of the screen out). A kernel blur costs more the wider it is, and a different kernel at every pixel
+// can't be split into a vertical and a horizontal pass, so instead a summed-area table of the input is
+// built first: each entry is the sum of every pixel above and to the left of it, found with a running
+// sum along each row then down each column. The sum over any box is then four reads from the table
+// whatever its size. Each pixel averages a stack of up to three boxes centred on it - a third, two
+// thirds and all of its radius - which weights the middle more, like a Gaussian. A fractional radius
+// blends the boxes a pixel smaller and a pixel larger, so the blur grows smoothly.
+//
+// The table holds each colour as 8-bit levels (0->255) in unsigned 32-bit integers, as the GPU reads them
+// from its R8G8B8A8 targets. Sums over a large image overflow, but they wrap around and the sum over a box
+// still comes out exact - every box is far smaller than 2^32 / 255 pixels.
+//
+// This file has the CPU version, the GPU version is VariableBlur.hlsli and the shaders that include it.
+// Both work out the same integer sums
+
+#ifndef _VARIABLE_BLUR_H_INCLUDED_
+#define _VARIABLE_BLUR_H_INCLUDED_
+
+#include "PostProcessGraph.h"
+#include "Image.h"
+
+#include <cstdint>
+#include <vector>
+
+class TaskPool;
+
+
+// Most boxes stacked for one pixel, and the largest radius in pixels. Must match VariableBlur.hlsli
+const int MAX_STACKED_BOXES        = 3;
+const int MAX_VARIABLE_BLUR_RADIUS = 100;
+
+
+// Sums of an image's colours over any box, see above
+class SummedAreaTable
+{
+public:
+	// Build the table from the image's colours, rounded to 8 bits. Rows then columns are shared out to the pool's threads
+	// if one is given
+	void Build(const Image& image, TaskPool* pool = nullptr);
+
+	int Width() const   { return mWidth; }
+	int Height() const  { return mHeight; }
+
+	// Average colour of the pixels within radius of (x, y) horizontally and vertically, the box clipped to the image.
+	// Alpha is 1
+	ColourRGBA BoxAverage(int x, int y, int radius) const;
+
+//-------------------------------------
+// Private members
+//-------------------------------------
+private:
+	// Sum of the pixels from (0, 0) to (x, y) inclusive, four channels. Zero for x or y of -1
+	const uint32_t* Entry(int x, int y) const  { return &mSums[(static_cast<size_t>(y) * mWidth + x) * 4]; }
+
+	int                   mWidth  = 0;
+	int                   mHeight = 0;
+	std::vector<uint32_t> mSums;
+};
+
+
+// Blur radius at a point in the area (0->1 area UVs), in full size pixels
+float VariableBlurRadius(const PostProcessData& data, float areaU, float areaV);
+
+// Blurred colour at pixel (x, y) of the table's image: the average of the given number of boxes stacked out to radius
+// (in pixels of the table's image, clamped to MAX_VARIABLE_BLUR_RADIUS). Alpha is 1
+ColourRGBA StackedBoxBlur(const SummedAreaTable& table, int x, int y, float radius, int boxes);
+
+
+#endif //_VARIABLE_BLUR_H_INCLUDED_
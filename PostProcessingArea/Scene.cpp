@@ -18,6 +18,16 @@
 #include "MathHelpers.h"     // Helper functions for maths
 #include "GraphicsHelpers.h" // Helper functions to unclutter the code here
 #include "ColourRGBA.h" 
+#include "PostProcessGraph.h"
+#include "ColourEffects.h"
+#include "GaussianKernel.h"
+#include "Bloom.h"
+#include "VariableBlur.h"
+#include "Pixelation.h"
+#include "Scanlines.h"
+#include "Upsample.h"
+#include "RenderTargetPool.h"
+#include "ChainFile.h"
 
 #include "imgui.h"
 #include "imgui_impl_win32.h"
@@ -30,188 +40,14 @@
 #include <iomanip> 
 #include <iostream>
 #include <memory>
+#include <map>
+#include <algorithm>
 
 
 //--------------------------------------------------------------------------------------
 // Scene Data
 //--------------------------------------------------------------------------------------
 
-//********************
-// Available post-processes
-enum class PostProcess
-{
-	None,
-	Copy,
-	Tint,
-	TintHue,
-	GreyNoise,
-	Burn,
-	Distort,
-	Spiral,
-	Blur,
-	SecondBlur,
-	Underwater,
-	HeatHaze,
-	NightVision,
-	Pixelation,
-	Scanlines,
-	Inverse,
-	BlackAndWhite,
-	SeeingWorlds,
-	SecondSeeingWorlds,
-	Bloom,
-	Merge,
-	Sigmoid,
-};
-
-// Function to create Gaussian filter 
-void FilterCreation(float GKernel[301], int& SampleAmount)
-{
-	// intialising standard deviation to 1.0 
-	float sigma = 40;
-	float r, s = 2.0 * sigma * sigma;
-	int HalfSampleAmount = (((SampleAmount - 1)) / 2 + 1);
-	// sum is for normalization 
-	float sum = 0.0;
-	// generating 5x5 kernel 
-	for (int x = -HalfSampleAmount; x <= HalfSampleAmount; x++) {
-
-		r = sqrt(x * x);
-		GKernel[x + HalfSampleAmount] = (exp(-(r * r) / s)) / (3.14 * s);
-		sum += GKernel[x + HalfSampleAmount];
-
-	}
-
-	// normalising the Kernel 
-	for (int i = 0; i < SampleAmount; ++i) {
-
-		GKernel[i] /= sum;
-	}
-
-	if (SampleAmount % 2 == 0)
-	{
-		SampleAmount--;
-	}
-}
-
-
-struct PostProcessData
-{
-	union
-	{
-		struct
-		{
-			float rgbTop[3];
-			float rgbMid[3];
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-			void tint(float Top[], float Mid[])
-			{
-				for (int i = 0; i < 3; i++)
-				{
-					rgbTop[i] = Top[i];
-					rgbMid[i] = Mid[i];
-				}
-			}
-		}tint;
-		struct
-		{
-			float Hue1[3];
-			float Hue2[3];
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-			void Hue(float Top[], float Mid[])
-			{
-				for (int i = 0; i < 3; i++)
-				{
-					Hue1[i] = Top[i];
-					Hue2[i] = Mid[i];
-				}
-			}
-		}Hue;
-		struct
-		{
-			float grainSize;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-		}Noise;
-		struct
-		{
-			float burnSpeed;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-
-
-		}Burn;
-		struct
-		{
-			int blur;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-			void Blur(int B)
-			{
-				blur = B;
-			}
-
-		}Blur;
-		struct
-		{
-			float Gamma;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-
-		}Sigmoid;
-		struct
-		{
-			float waterSpeed;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-		}Water;
-		struct
-		{
-			float offset;
-			float padding; // As the GPU only allows padding of 4,8,16, not 12
-		}SeeingWorlds;
-	};
-};
-
-const char* PPNames[] = {
-
-
-	"None",
-	"Copy",
-	"Tint",
-	"TintHue",
-	"GreyNoise",
-	"Burn",
-	"Distort",
-	"Spiral",
-	"Blur",
-	"SecondBlur",
-	"Underwater",
-	"HeatHaze",
-	"NightVision",
-	"Pixelation",
-	"Scanlines",
-	"Inverse",
-	"BlackAndWhite",
-	"SeeingWorlds",
-	"SecondSeeingWorlds",
-	"Bloom",
-	"Merge",
-	"Sigmoid",
-
-};
-
-const char* ModeNames[] = {
-	"FullScreen",
-	"Area",
-	"Polygon",
-	"ModelPolygon"
-};
-
-
-enum class PostProcessMode
-{
-	Fullscreen,
-	Area,
-	Polygon,
-	ModelPolygon
-};
-
 struct ModelStruct
 {
 	Model* Mod;
@@ -223,30 +59,12 @@ struct ModelStruct
 	}
 };
 
-struct PostProcessingData2
-{
-	Model* Mod;
-	std::string Name;
-	int NumberOfProcessors;
-	PostProcess PP;
-	PostProcessMode PostProcessingMode;
-	void Set(PostProcess P, PostProcessMode PM, Model* M, std::string N, int i)
-	{
-		Name = N;
-		Mod = M;
-		PP = P;
-		PostProcessingMode = PM;
-		NumberOfProcessors = i;
-
-	}
-};
-
-
 auto gCurrentPostProcess = PostProcess::None;
 auto gCurrentPostProcessMode = PostProcessMode::Fullscreen;
-std::vector<PostProcessingData2> PostProcessingVector;
 std::vector<ModelStruct> ModelVector;
-std::vector<PostProcessData> PostProcessingDataVector;
+
+// The post-process chain, compiled into passes when it changes and run each frame by the D3D backend below
+PostProcessGraph gPostProcessGraph;
 //********************
 
 
@@ -295,9 +113,11 @@ struct Light
 };
 Light gLights[NUM_LIGHTS];
 
-static int Counter = 0;
 static float burnSpeed = 2.0f;
 static float WaterSpeed = 1.0f;
+static float HueLevel = 0.0f; // Timer for the hue shifting post-processes
+static int SeeingWorldsFrame = 0; // SeeingWorlds effects drawn so far, moves the swirl's stochastic taps
+static uint32_t NoiseFrame = 0; // Frames drawn, the GreyNoise and Scanlines noise is different each frame (see Noise.h)
 static int Selected_Item = 0;
 static int Selected_Screen = 0;
 
@@ -327,8 +147,35 @@ PerModelConstants gPerModelConstants;      // As above, but constants (settings)
 ID3D11Buffer* gPerModelConstantBuffer; // --"--
 
 //**************************
-PostProcessingConstants gPostProcessingConstants;       // As above, but constants (settings) for each post-process
-ID3D11Buffer* gPostProcessingConstantBuffer; // --"--
+// Post-processing constants are only sent to the GPU when they change (see CachedConstantBuffer in GraphicsHelpers.h)
+CachedConstantBuffer<PostProcessingConstants> gPostProcessingConstants; // Where on screen the post-process goes
+DynamicStructuredBuffer<CVector4>             gPolygonPointsBuffer;     // Points of the polygons for polygon post-processes, four each
+
+// Settings for each kind of post-process, each sized to what its shader reads (see Common.h)
+CachedConstantBuffer<TintConstants>         gTintConstants;
+CachedConstantBuffer<TintHueConstants>      gTintHueConstants;
+CachedConstantBuffer<ScanlinesConstants>    gScanlinesConstants;
+CachedConstantBuffer<SeeingWorldsConstants> gSeeingWorldsConstants;
+CachedConstantBuffer<SeeingWorldsTapConstants> gSeeingWorldsTapConstants;
+CachedConstantBuffer<SigmoidConstants>      gSigmoidConstants;
+CachedConstantBuffer<BlurConstants>         gBlurConstants;
+GaussianKernelCache                         gBlurKernels; // Blur kernels worked out so far, by radius and sigma
+CachedConstantBuffer<BloomConstants>        gBloomConstants;
+CachedConstantBuffer<VariableBlurConstants> gVariableBlurConstants;
+CachedConstantBuffer<PixelationConstants>   gPixelationConstants;
+CachedConstantBuffer<BurnConstants>         gBurnConstants;
+CachedConstantBuffer<DistortConstants>      gDistortConstants;
+CachedConstantBuffer<SpiralConstants>       gSpiralConstants;
+CachedConstantBuffer<HeatHazeConstants>     gHeatHazeConstants;
+CachedConstantBuffer<UnderwaterConstants>   gUnderwaterConstants;
+CachedConstantBuffer<GreyNoiseConstants>    gGreyNoiseConstants;
+CachedConstantBuffer<ColourEffectConstants> gColourEffectConstants; // Settings for each effect in a fused colour pass (see FusedColourPostProcess)
+
+// Constant bytes sent to the GPU last frame (see gConstantBytesUploaded)
+size_t gConstantBytesLastFrame = 0;
+
+// Fused colour shaders are generated and compiled the first time a sequence of effects is seen, keyed by ColourShaderKey
+std::map<std::string, ID3D11PixelShader*> gColourShaders;
 //**************************
 
 
@@ -364,20 +211,80 @@ ID3D11Texture2D* gSceneTexture = nullptr; // This object represents the memory u
 ID3D11RenderTargetView* gSceneRenderTarget = nullptr; // This object is used when we want to render to the texture above
 ID3D11ShaderResourceView* gSceneTextureSRV = nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
 
-// This texture will have the scene renderered on it. Then the texture is then used for post-processing
-ID3D11Texture2D* gBackTexture = nullptr; // This object represents the memory used by the texture on the GPU
-ID3D11RenderTargetView* gBackRenderTarget = nullptr; // This object is used when we want to render to the texture above
-ID3D11ShaderResourceView* gBackTextureSRV = nullptr; // This object is used to give shaders access to the texture above (SRV = shader resource view)
+// The chain's other render targets and the working textures of bloom, the variable blur and pixelation come from a pool
+// (see RenderTargetPool.h) as each pass needs them, created by gRenderTargetDevice below
+
+// Views of the working textures read by the pass being drawn: the finished bloom glow, summed-area table and pixelation
+// blocks. Set by the backend as it builds them (see D3DPostProcessBackend)
+ID3D11ShaderResourceView* gBloomGlowSRV = nullptr;
+ID3D11ShaderResourceView* gSummedAreaTableSRV = nullptr;
+ID3D11ShaderResourceView* gPixelationBlocksSRV = nullptr;
+
+// The scanlines' weights for each row of a render target (see Scanlines.h), one texel per row. One for each resolution a
+// post-process can be drawn at (1, 2 and 4, see PostProcessEffect::Downscale)
+const int SCANLINES_TABLES = 3;
+ID3D11Texture2D*          gScanlinesTable[SCANLINES_TABLES] = {};
+ID3D11ShaderResourceView* gScanlinesTableSRV[SCANLINES_TABLES] = {};
 
-ID3D11Texture2D* gMergeTexture = nullptr; // This object represents the memory used by the texture on the GPU
-ID3D11RenderTargetView* gMergeTarget = nullptr;
-ID3D11ShaderResourceView* gMergeMapSRV = nullptr;
+// A render target for the post-process chain, the scene texture or one created by the pool
+struct PostProcessTarget
+{
+	ID3D11Texture2D*          Texture;
+	ID3D11RenderTargetView*   RenderTarget;
+	ID3D11ShaderResourceView* SRV;
+};
+
+// Creates the pool's render targets as Direct3D textures, each a PostProcessTarget
+class D3DRenderTargetDevice : public RenderTargetDevice
+{
+public:
+	void* CreateTarget(const RenderTargetDesc& desc) override
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+		textureDesc.Width  = desc.Width;
+		textureDesc.Height = desc.Height;
+		textureDesc.MipLevels = 1;
+		textureDesc.ArraySize = 1;
+		textureDesc.Format = desc.Format == RenderTargetFormat::RGBA16Float ? DXGI_FORMAT_R16G16B16A16_FLOAT :
+		                     desc.Format == RenderTargetFormat::RGBA32Uint  ? DXGI_FORMAT_R32G32B32A32_UINT  :
+		                                                                      DXGI_FORMAT_R8G8B8A8_UNORM; // Same as the scene texture
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		if (desc.BindFlags & RENDER_TARGET_BIND_OUTPUT)  textureDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+		if (desc.BindFlags & RENDER_TARGET_BIND_INPUT)   textureDesc.BindFlags |= D3D11_BIND_SHADER_RESOURCE;
+
+		// Null descriptions for the views use the whole texture
+		PostProcessTarget* target = new PostProcessTarget{ nullptr, nullptr, nullptr };
+		if (FAILED(gD3DDevice->CreateTexture2D(&textureDesc, NULL, &target->Texture)) ||
+		    ((desc.BindFlags & RENDER_TARGET_BIND_OUTPUT) && FAILED(gD3DDevice->CreateRenderTargetView(target->Texture, NULL, &target->RenderTarget))) ||
+		    ((desc.BindFlags & RENDER_TARGET_BIND_INPUT)  && FAILED(gD3DDevice->CreateShaderResourceView(target->Texture, NULL, &target->SRV))))
+		{
+			ReleaseTarget(target);
+			gLastError = "Error creating post-process render target";
+			return nullptr;
+		}
+		return target;
+	}
+
+	void ReleaseTarget(void* target) override
+	{
+		PostProcessTarget* postProcessTarget = static_cast<PostProcessTarget*>(target);
+		if (postProcessTarget->SRV)           postProcessTarget->SRV->Release();
+		if (postProcessTarget->RenderTarget)  postProcessTarget->RenderTarget->Release();
+		if (postProcessTarget->Texture)       postProcessTarget->Texture->Release();
+		delete postProcessTarget;
+	}
+};
+
+D3DRenderTargetDevice gRenderTargetDevice;
+RenderTargetPool      gRenderTargetPool(gRenderTargetDevice);
+
+// Resolution of the post-process being drawn, see SelectPostProcessViewport
+int gPostProcessDownscale = 1;
 
 
 // Additional textures used for specific post-processes
 
-ID3D11Resource* gNoiseMap = nullptr;
-ID3D11ShaderResourceView* gNoiseMapSRV = nullptr;
 ID3D11Resource* gBurnMap = nullptr;
 ID3D11ShaderResourceView* gBurnMapSRV = nullptr;
 ID3D11Resource* gDistortMap = nullptr;
@@ -427,7 +334,6 @@ bool InitGeometry()
 		!LoadTexture("StoneDiffuseSpecular.dds", &gCubeDiffuseSpecularMap, &gCubeDiffuseSpecularMapSRV) ||
 		!LoadTexture("CargoA.dds", &gCrateDiffuseSpecularMap, &gCrateDiffuseSpecularMapSRV) ||
 		!LoadTexture("Flare.jpg", &gLightDiffuseMap, &gLightDiffuseMapSRV) ||
-		!LoadTexture("Noise.png", &gNoiseMap, &gNoiseMapSRV) ||
 		!LoadTexture("Burn.png", &gBurnMap, &gBurnMapSRV) ||
 		!LoadTexture("Distort.png", &gDistortMap, &gDistortMapSRV) ||
 		!LoadTexture("Brick_35.jpg", &gWallOneDiffuseSpecularMap, &gWallOneDiffuseSpecularMapSRV) ||
@@ -460,8 +366,13 @@ bool InitGeometry()
 	// See the comments above where these variable are declared and also the UpdateScene function
 	gPerFrameConstantBuffer = CreateConstantBuffer(sizeof(gPerFrameConstants));
 	gPerModelConstantBuffer = CreateConstantBuffer(sizeof(gPerModelConstants));
-	gPostProcessingConstantBuffer = CreateConstantBuffer(sizeof(gPostProcessingConstants));
-	if (gPerFrameConstantBuffer == nullptr || gPerModelConstantBuffer == nullptr || gPostProcessingConstantBuffer == nullptr)
+	if (gPerFrameConstantBuffer == nullptr || gPerModelConstantBuffer == nullptr ||
+	    !gPostProcessingConstants.Create() || !gColourEffectConstants.Create() ||
+	    !gTintConstants.Create()    || !gTintHueConstants.Create()  || !gScanlinesConstants.Create() || !gSeeingWorldsConstants.Create() ||
+	    !gSigmoidConstants.Create() || !gBlurConstants.Create()     || !gBurnConstants.Create()      || !gDistortConstants.Create()      ||
+	    !gSpiralConstants.Create()  || !gHeatHazeConstants.Create() || !gUnderwaterConstants.Create() || !gGreyNoiseConstants.Create() ||
+	    !gBloomConstants.Create()   || !gVariableBlurConstants.Create() || !gSeeingWorldsTapConstants.Create() ||
+	    !gPixelationConstants.Create())
 	{
 		gLastError = "Error creating constant buffers";
 		return false;
@@ -495,16 +406,6 @@ bool InitGeometry()
 		return false;
 	}
 
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gBackTexture)))
-	{
-		gLastError = "Error creating scene texture";
-		return false;
-	}
-	if (FAILED(gD3DDevice->CreateTexture2D(&sceneTextureDesc, NULL, &gMergeTexture)))
-	{
-		gLastError = "Error creating scene texture";
-		return false;
-	}
 
 	// We created the scene texture above, now we get a "view" of it as a render target, i.e. get a special pointer to the texture that
 	// we use when rendering to it (see RenderScene function below)
@@ -513,16 +414,6 @@ bool InitGeometry()
 		gLastError = "Error creating scene render target view";
 		return false;
 	}
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gBackTexture, NULL, &gBackRenderTarget)))
-	{
-		gLastError = "Error creating scene render target view";
-		return false;
-	}
-	if (FAILED(gD3DDevice->CreateRenderTargetView(gMergeTexture, NULL, &gMergeTarget)))
-	{
-		gLastError = "Error creating scene render target view";
-		return false;
-	}
 
 	// We also need to send this texture (resource) to the shaders. To do that we must create a shader-resource "view"
 	D3D11_SHADER_RESOURCE_VIEW_DESC srDesc = {};
@@ -535,15 +426,29 @@ bool InitGeometry()
 		gLastError = "Error creating scene shader resource view";
 		return false;
 	}
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gMergeTexture, &srDesc, &gMergeMapSRV)))
-	{
-		gLastError = "Error creating scene shader resource view";
-		return false;
-	}
-	if (FAILED(gD3DDevice->CreateShaderResourceView(gBackTexture, &srDesc, &gBackTextureSRV)))
+
+	// Scanlines tables, they only depend on the viewport so are filled in here and never change
+	for (int table = 0; table < SCANLINES_TABLES; ++table)
 	{
-		gLastError = "Error creating scene shader resource view";
-		return false;
+		std::vector<ScanlineWeights> weights;
+		BuildScanlinesTable(gViewportHeight, DownscaledSize(gViewportHeight, 1 << table), weights);
+
+		D3D11_TEXTURE2D_DESC tableDesc = {};
+		tableDesc.Width = static_cast<UINT>(weights.size());
+		tableDesc.Height = 1;
+		tableDesc.MipLevels = 1;
+		tableDesc.ArraySize = 1;
+		tableDesc.Format = DXGI_FORMAT_R32G32_FLOAT; // Matches ScanlineWeights
+		tableDesc.SampleDesc.Count = 1;
+		tableDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		tableDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		D3D11_SUBRESOURCE_DATA tableData = { weights.data(), static_cast<UINT>(weights.size() * sizeof(ScanlineWeights)), 0 };
+		if (FAILED(gD3DDevice->CreateTexture2D(&tableDesc, &tableData, &gScanlinesTable[table])) ||
+		    FAILED(gD3DDevice->CreateShaderResourceView(gScanlinesTable[table], NULL, &gScanlinesTableSRV[table])))
+		{
+			gLastError = "Error creating scanlines tables";
+			return false;
+		}
 	}
 
 
@@ -552,37 +457,14 @@ bool InitGeometry()
 
 void WindowPostProcessSetUp()
 {
-	PostProcessingData2 PPNM;
-	PostProcessData PPD;
-	gCurrentPostProcess = PostProcess::BlackAndWhite;
-	PostProcessingDataVector.push_back(PPD);
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gLargeWindow, "LargeWindow", 1);
-	PostProcessingVector.push_back(PPNM);
-
-	gCurrentPostProcess = PostProcess::Inverse;
-	PostProcessingDataVector.push_back({});
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gSmallWindow1, "SmallWindow1", 1);
-	PostProcessingVector.push_back(PPNM);
-
-
-	gCurrentPostProcess = PostProcess::NightVision;
-	PostProcessingDataVector.push_back({});
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gSmallWindow2, "SmallWindow2", 1);
-	PostProcessingVector.push_back(PPNM);
-
-	gCurrentPostProcess = PostProcess::Scanlines;
-	PostProcessingDataVector.push_back({});
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gSmallWindow3, "SmallWindow3", 1);
-	PostProcessingVector.push_back(PPNM);
-
-	gCurrentPostProcess = PostProcess::SeeingWorlds;
-	PostProcessingDataVector.push_back({ 0.05f });
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gSmallWindow4, "SmallWindow4", 2);
-	PostProcessingVector.push_back(PPNM);
-	gCurrentPostProcess = PostProcess::SecondSeeingWorlds;
-	PostProcessingDataVector.push_back({ 0.05f });
-	PPNM.Set(gCurrentPostProcess, PostProcessMode::ModelPolygon, gSmallWindow4, "SmallWindow4", 2);
-	PostProcessingVector.push_back(PPNM);
+	// Each window has its own effect, the region is the window's index in ModelVector
+	PostProcessData PPD = {};
+	gPostProcessGraph.AddEffect(PostProcess::BlackAndWhite, PostProcessMode::ModelPolygon, 3, "LargeWindow", PPD);
+	gPostProcessGraph.AddEffect(PostProcess::Inverse, PostProcessMode::ModelPolygon, 4, "SmallWindow1", PPD);
+	gPostProcessGraph.AddEffect(PostProcess::NightVision, PostProcessMode::ModelPolygon, 5, "SmallWindow2", PPD);
+	gPostProcessGraph.AddEffect(PostProcess::Scanlines, PostProcessMode::ModelPolygon, 6, "SmallWindow3", PPD);
+
+	gPostProcessGraph.AddEffect(PostProcess::SeeingWorlds, PostProcessMode::ModelPolygon, 7, "SmallWindow4", DefaultPostProcessData(PostProcess::SeeingWorlds));
 }
 
 
@@ -680,20 +562,17 @@ void ReleaseResources()
 	if (gSceneRenderTarget)            gSceneRenderTarget->Release();
 	if (gSceneTexture)                 gSceneTexture->Release();
 
-	if (gMergeMapSRV)                  gMergeMapSRV->Release();
-	if (gMergeTarget)                  gMergeTarget->Release();
-	if (gMergeTexture)                 gMergeTexture->Release();
-
-	if (gBackTextureSRV)			   gBackTextureSRV->Release();
-	if (gBackRenderTarget)			   gBackRenderTarget->Release();
-	if (gBackTexture)				   gBackTexture->Release();
+	gRenderTargetPool.Clear();
+	for (int table = 0; table < SCANLINES_TABLES; ++table)
+	{
+		if (gScanlinesTableSRV[table])  gScanlinesTableSRV[table]->Release();
+		if (gScanlinesTable[table])     gScanlinesTable[table]->Release();
+	}
 
 	if (gDistortMapSRV)                gDistortMapSRV->Release();
 	if (gDistortMap)                   gDistortMap->Release();
 	if (gBurnMapSRV)                   gBurnMapSRV->Release();
 	if (gBurnMap)                      gBurnMap->Release();
-	if (gNoiseMapSRV)                  gNoiseMapSRV->Release();
-	if (gNoiseMap)                     gNoiseMap->Release();
 
 	if (gLightDiffuseMapSRV)           gLightDiffuseMapSRV->Release();
 	if (gLightDiffuseMap)              gLightDiffuseMap->Release();
@@ -710,11 +589,31 @@ void ReleaseResources()
 	if (gWallOneDiffuseSpecularMapSRV) gWallOneDiffuseSpecularMapSRV->Release();
 	if (gWallOneDiffuseSpecularMap)    gWallOneDiffuseSpecularMap->Release();
 
-	if (gPostProcessingConstantBuffer)  gPostProcessingConstantBuffer->Release();
+	gGreyNoiseConstants.Release();
+	gUnderwaterConstants.Release();
+	gHeatHazeConstants.Release();
+	gSpiralConstants.Release();
+	gDistortConstants.Release();
+	gBurnConstants.Release();
+	gPixelationConstants.Release();
+	gVariableBlurConstants.Release();
+	gBloomConstants.Release();
+	gBlurConstants.Release();
+	gSigmoidConstants.Release();
+	gSeeingWorldsTapConstants.Release();
+	gSeeingWorldsConstants.Release();
+	gScanlinesConstants.Release();
+	gTintHueConstants.Release();
+	gTintConstants.Release();
+	gColourEffectConstants.Release();
+	gPostProcessingConstants.Release();
+	gPolygonPointsBuffer.Release();
 	if (gPerModelConstantBuffer)        gPerModelConstantBuffer->Release();
 	if (gPerFrameConstantBuffer)        gPerFrameConstantBuffer->Release();
 
 	ReleaseShaders();
+	for (auto& colourShader : gColourShaders)  colourShader.second->Release();
+	gColourShaders.clear();
 
 	// See note in InitGeometry about why we're not using unique_ptr and having to manually delete
 	for (int i = 0; i < NUM_LIGHTS; ++i)
@@ -842,7 +741,23 @@ void RenderSceneFromCamera(Camera* camera)
 
 // Select the appropriate shader plus any additional textures required for a given post-process
 // Helper function shared by full-screen, area and polygon post-processing functions below
-void SelectPostProcessShaderAndTextures(PostProcess postProcess)
+// Send the position of the post-process to the GPU if it has changed and select it for the vertex and pixel shaders (register b1)
+void SelectPostProcessingConstants()
+{
+	ID3D11Buffer* buffer = gPostProcessingConstants.Upload();
+	gD3DContext->VSSetConstantBuffers(1, 1, &buffer);
+	gD3DContext->PSSetConstantBuffers(1, 1, &buffer);
+}
+
+// Send an effect's settings to the GPU if they have changed and select them for the pixel shader (register b2)
+template <class T>
+void SelectEffectConstants(CachedConstantBuffer<T>& constants)
+{
+	ID3D11Buffer* buffer = constants.Upload();
+	gD3DContext->PSSetConstantBuffers(2, 1, &buffer);
+}
+
+void SelectPostProcessShaderAndTextures(PostProcess postProcess, const PostProcessData& data)
 {
 
 
@@ -853,12 +768,35 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 	}
 	else if (postProcess == PostProcess::Bloom)
 	{
-		gD3DContext->PSSetShader(gBloomPostProcess, nullptr, 0);
-
+		// The backend has already built the bloom pyramid from the input (see BuildBloomPyramid), add its first level over the image
+		BloomConstants& constants = gBloomConstants.Data();
+		constants.threshold = data.Bloom.threshold;
+		constants.glowScale = data.Bloom.intensity / std::min(std::max(data.Bloom.levels, 1), MAX_BLOOM_LEVELS);
+		SelectEffectConstants(gBloomConstants);
+		gD3DContext->PSSetShaderResources(1, 1, &gBloomGlowSRV);
+		gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+		gD3DContext->PSSetShader(gBloomCompositePostProcess, nullptr, 0);
+	}
+	else if (postProcess == PostProcess::VariableBlur)
+	{
+		// The backend has already built the summed-area table of the input and set its size (see BuildSummedAreaTable)
+		VariableBlurConstants& constants = gVariableBlurConstants.Data();
+		constants.innerRadius = data.VariableBlur.innerRadius;
+		constants.outerRadius = data.VariableBlur.outerRadius;
+		constants.focus       = data.VariableBlur.focus;
+		constants.boxes       = data.VariableBlur.boxes;
+		SelectEffectConstants(gVariableBlurConstants);
+		gD3DContext->PSSetShaderResources(1, 1, &gSummedAreaTableSRV);
+		gD3DContext->PSSetShader(gVariableBlurPostProcess, nullptr, 0);
+	}
+	else if (postProcess == PostProcess::Upsample)
+	{
+		// The full size guide image has been bound to t1 by the backend as the pass's second input
+		gD3DContext->PSSetShader(gUpsamplePostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::Merge)
 	{
-		gD3DContext->PSSetShaderResources(1, 1, &gMergeMapSRV);
+		// The unprocessed scene has been bound to t1 by the backend as the pass's second input
 		gD3DContext->PSSetShader(gMergePostProcess, nullptr, 0);
 		gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
 
@@ -869,27 +807,38 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 	}
 	else if (postProcess == PostProcess::Scanlines)
 	{
+		// The flicker is the same for every pixel of the frame, the lines the same for every pixel of a row of the render target
+		gScanlinesConstants.Data().flicker = ScanlinesFlicker(HueLevel);
+		gScanlinesConstants.Data().noiseKey = NoiseKey(0, NoiseFrame, NoiseStream::Scanlines);
+		SelectEffectConstants(gScanlinesConstants);
+		int table = (gPostProcessDownscale >= 4) ? 2 : gPostProcessDownscale / 2;
+		gD3DContext->PSSetShaderResources(1, 1, &gScanlinesTableSRV[table]);
 		gD3DContext->PSSetShader(gPredatorPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::NightVision)
 	{
 		gD3DContext->PSSetShader(gNightVisionPostProcess, nullptr, 0);
 	}
-	else if (postProcess == PostProcess::Blur)
+	else if (postProcess == PostProcess::Blur || postProcess == PostProcess::SecondBlur)
 	{
-		float GKernel[302];
-		FilterCreation(GKernel, PostProcessingDataVector[Counter].Blur.blur);
-		int HalfSampleAmount = (((PostProcessingDataVector[Counter].Blur.blur - 1)) / 2 + 1);
-		gPostProcessingConstants.blurStrength = PostProcessingDataVector[Counter].Blur.blur;
-		for (int i = 0; i < HalfSampleAmount; i++)
+		// Both blur directions use the same kernel. Kernels are cached, and the constants only go to the GPU when they change
+		// At reduced resolution the kernel shrinks to match so the blur covers the same distance on screen
+		int radius = std::max(((data.Blur.blur - 1) / 2 + 1) / gPostProcessDownscale, 1);
+		const GaussianKernel& kernel = gBlurKernels.Get(std::min(radius, (MAX_BLUR_TAPS - 1) * 2), data.Blur.sigma / gPostProcessDownscale);
+
+		BlurConstants& constants = gBlurConstants.Data();
+		constants.tapCount = static_cast<int>(kernel.TapWeights.size());
+		constants.stepScale = static_cast<float>(gPostProcessDownscale);
+		float* taps = &constants.taps[0].x;
+		for (int i = 0; i < constants.tapCount; i++)
 		{
-			gPostProcessingConstants.WeightArray[i].x = GKernel[i];
+			taps[i * 2]     = kernel.TapOffsets[i];
+			taps[i * 2 + 1] = kernel.TapWeights[i];
 		}
-		gD3DContext->PSSetShader(gBlurPostProcess, nullptr, 0);
-	}
-	else if (postProcess == PostProcess::SecondBlur)
-	{
-		gD3DContext->PSSetShader(gSecondBlurPostProcess, nullptr, 0);
+		SelectEffectConstants(gBlurConstants);
+		gD3DContext->PSSetSamplers(1, 1, &gBilinearClampSampler);
+
+		gD3DContext->PSSetShader(postProcess == PostProcess::Blur ? gBlurPostProcess : gSecondBlurPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::BlackAndWhite)
 	{
@@ -897,50 +846,81 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 	}
 	else if (postProcess == PostProcess::SeeingWorlds)
 	{
-		gPostProcessingConstants.ITime += FrameTime;
-		gPostProcessingConstants.OffSet = PostProcessingDataVector[Counter].SeeingWorlds.offset;
+		// The effect's two nodes: the ray-marched background then the swirl over it. Time moves on once per effect
+		SeeingWorldsConstants& constants = gSeeingWorldsConstants.Data();
+		constants.time += FrameTime;
+		constants.offset = data.SeeingWorlds.offset;
+		++SeeingWorldsFrame;
+		SelectEffectConstants(gSeeingWorldsConstants);
 		gD3DContext->PSSetShader(gSeeingWorldsPostProcess, nullptr, 0);
+	}
+	else if (postProcess == PostProcess::SecondSeeingWorlds)
+	{
+		// The swirl's tap offsets only depend on the frame, work them out here rather than in every pixel
+		SeeingWorldsTaps taps;
+		float time = gSeeingWorldsConstants.Data().time;
+		MakeSeeingWorldsTaps(time, data.SeeingWorlds.offset, data.SeeingWorlds.taps, data.SeeingWorlds.stochastic, SeeingWorldsFrame, taps);
+
+		SeeingWorldsTapConstants& constants = gSeeingWorldsTapConstants.Data();
+		constants.time = time;
+		constants.tapCount = taps.Count;
+		constants.tapWeight = taps.Weight;
+		for (int i = 0; i < taps.Count; i++)  constants.taps[i] = CVector4(taps.Offsets[i]);
+		SelectEffectConstants(gSeeingWorldsTapConstants);
 		gD3DContext->PSSetShader(gSecondSeeingWorldsPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::Underwater)
 	{
-		WaterSpeed = PostProcessingDataVector[Counter].Water.waterSpeed;
+		WaterSpeed = data.Water.waterSpeed;
+		SelectEffectConstants(gUnderwaterConstants);
 		gD3DContext->PSSetShader(gUnderwaterPostProcess, nullptr, 0);
 
 	}
 	else if (postProcess == PostProcess::Pixelation)
 	{
+		// The backend has already reduced the input to a pixel per block (see BuildPixelationBlocks), each pixel reads its block's
+		PixelationConstants& constants = gPixelationConstants.Data();
+		constants.blockWidth  = std::min(std::max(data.Pixelation.blockWidth,  1), MAX_PIXELATION_BLOCK);
+		constants.blockHeight = std::min(std::max(data.Pixelation.blockHeight, 1), MAX_PIXELATION_BLOCK);
+		constants.levels      = std::min(std::max(data.Pixelation.levels, 1), MAX_PIXELATION_LEVELS);
+		SelectEffectConstants(gPixelationConstants);
+		gD3DContext->PSSetShaderResources(1, 1, &gPixelationBlocksSRV);
 		gD3DContext->PSSetShader(gPixelationPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::Tint)
 	{
 
-		gPostProcessingConstants.tintColour1 = { PostProcessingDataVector[Counter].tint.rgbTop[0] ,PostProcessingDataVector[Counter].tint.rgbTop[1] ,PostProcessingDataVector[Counter].tint.rgbTop[2] };
-		gPostProcessingConstants.tintColour2 = { PostProcessingDataVector[Counter].tint.rgbMid[0] ,PostProcessingDataVector[Counter].tint.rgbMid[1] ,PostProcessingDataVector[Counter].tint.rgbMid[2] };
+		TintConstants& constants = gTintConstants.Data();
+		constants.tintColour1 = { data.tint.rgbTop[0] ,data.tint.rgbTop[1] ,data.tint.rgbTop[2] };
+		constants.tintColour2 = { data.tint.rgbMid[0] ,data.tint.rgbMid[1] ,data.tint.rgbMid[2] };
+		SelectEffectConstants(gTintConstants);
 		gD3DContext->PSSetShader(gTintPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::Sigmoid)
 	{
-		gPostProcessingConstants.Gamma = PostProcessingDataVector[Counter].Sigmoid.Gamma;
+		gSigmoidConstants.Data().gamma = data.Sigmoid.Gamma;
+		SelectEffectConstants(gSigmoidConstants);
 		gD3DContext->PSSetShader(gSigmoidPostProcess, nullptr, 0);
 	}
 	else if (postProcess == PostProcess::TintHue)
 	{
 
-		gPostProcessingConstants.tintColour1 = { PostProcessingDataVector[Counter].Hue.Hue1[0], PostProcessingDataVector[Counter].Hue.Hue1[1], PostProcessingDataVector[Counter].Hue.Hue1[2] };
-		gPostProcessingConstants.tintColour2 = { PostProcessingDataVector[Counter].Hue.Hue2[0], PostProcessingDataVector[Counter].Hue.Hue2[1], PostProcessingDataVector[Counter].Hue.Hue2[2] };
+		TintHueConstants& constants = gTintHueConstants.Data();
+		constants.tintColour1 = { data.Hue.Hue1[0], data.Hue.Hue1[1], data.Hue.Hue1[2] };
+		constants.tintColour2 = { data.Hue.Hue2[0], data.Hue.Hue2[1], data.Hue.Hue2[2] };
+		constants.hueLevel = HueLevel;
+		SelectEffectConstants(gTintHueConstants);
 		gD3DContext->PSSetShader(gTintHuePostProcess, nullptr, 0);
 	}
 
 	else if (postProcess == PostProcess::GreyNoise)
 	{
 		gD3DContext->PSSetShader(gGreyNoisePostProcess, nullptr, 0);
-		float grainSize; // Fineness of the noise grain
-		grainSize = PostProcessingDataVector[Counter].Noise.grainSize;
-		gPostProcessingConstants.noiseScale = { gViewportWidth / grainSize, gViewportHeight / grainSize };
-		// Give pixel shader access to the noise texture
-		gD3DContext->PSSetShaderResources(1, 1, &gNoiseMapSRV);
-		gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
+		// The grain setting is the size of NOISE_GRAIN_CELLS noise cells in full size pixels, the cells shrink with the resolution
+		GreyNoiseConstants& constants = gGreyNoiseConstants.Data();
+		constants.grainCell = std::max(data.Noise.grainSize / NOISE_GRAIN_CELLS / gPostProcessDownscale, 1.0f);
+		constants.noiseKey = NoiseKey(0, NoiseFrame, NoiseStream::GreyNoise);
+		SelectEffectConstants(gGreyNoiseConstants);
 	}
 
 	else if (postProcess == PostProcess::Burn)
@@ -948,7 +928,8 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 
 		gD3DContext->PSSetShader(gBurnPostProcess, nullptr, 0);
 
-		burnSpeed = PostProcessingDataVector[Counter].Burn.burnSpeed;
+		burnSpeed = data.Burn.burnSpeed;
+		SelectEffectConstants(gBurnConstants);
 		// Give pixel shader access to the burn texture (basically a height map that the burn level ascends)
 		gD3DContext->PSSetShaderResources(1, 1, &gBurnMapSRV);
 		gD3DContext->PSSetSamplers(1, 1, &gTrilinearSampler);
@@ -957,6 +938,7 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 	else if (postProcess == PostProcess::Distort)
 	{
 		gD3DContext->PSSetShader(gDistortPostProcess, nullptr, 0);
+		SelectEffectConstants(gDistortConstants);
 
 		// Give pixel shader access to the distortion texture (containts 2D vectors (in R & G) to shift the texture UVs to give a cut-glass impression)
 		gD3DContext->PSSetShaderResources(1, 1, &gDistortMapSRV);
@@ -966,23 +948,51 @@ void SelectPostProcessShaderAndTextures(PostProcess postProcess)
 	else if (postProcess == PostProcess::Spiral)
 	{
 		gD3DContext->PSSetShader(gSpiralPostProcess, nullptr, 0);
+		SelectEffectConstants(gSpiralConstants);
 	}
 
 	else if (postProcess == PostProcess::HeatHaze)
 	{
 		gD3DContext->PSSetShader(gHeatHazePostProcess, nullptr, 0);
+		SelectEffectConstants(gHeatHazeConstants);
 	}
 
 }
 
 
 
-// Perform a full-screen post process from "scene texture" to back buffer
-void FullScreenPostProcess(PostProcess postProcess)
+// Unbind the previous pass's input, then select the render target to draw to and the texture to read from
+// Helper function shared by full-screen, area and polygon post-processing functions below
+void SelectPostProcessTargets(ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target)
 {
+	ID3D11ShaderResourceView* nullSRV = nullptr;
+	gD3DContext->PSSetShaderResources(0, 1, &nullSRV);
 
+	// Not going to clear the target because we're going to overwrite it all. Reduced resolution targets are smaller than the
+	// depth buffer so are drawn without it - only area effects use it and they are always full size
+	gD3DContext->OMSetRenderTargets(1, &target, (gPostProcessDownscale == 1) ? gDepthStencil : nullptr);
 
+	// Give the pixel shader (post-processing shader) access to the input texture
+	gD3DContext->PSSetShaderResources(0, 1, &source);
+	gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
+}
+
+
+// Set the viewport to cover a render target at the given resolution, draws after this are at that resolution
+void SelectPostProcessViewport(int downscale)
+{
+	gPostProcessDownscale = downscale;
+
+	D3D11_VIEWPORT vp = { 0, 0, static_cast<FLOAT>(DownscaledSize(gViewportWidth,  downscale)),
+	                            static_cast<FLOAT>(DownscaledSize(gViewportHeight, downscale)), 0, 1 };
+	gD3DContext->RSSetViewports(1, &vp);
+}
 
+
+// Select the states and shaders shared by all post-process draws. Area and polygon post-processes change a few of these after
+// Helper function shared by full-screen, area and polygon post-processing functions below
+void SelectPostProcessStates()
+{
 	// Using special vertex shader that creates its own data for a 2D screen quad
 	gD3DContext->VSSetShader(g2DQuadVertexShader, nullptr, 0);
 	gD3DContext->GSSetShader(nullptr, nullptr, 0);  // Switch off geometry shader when not using it (pass nullptr for first parameter)
@@ -997,114 +1007,69 @@ void FullScreenPostProcess(PostProcess postProcess)
 	// No need to set vertex/index buffer (see 2D quad vertex shader), just indicate that the quad will be created as a triangle strip
 	gD3DContext->IASetInputLayout(NULL); // No vertex data
 	gD3DContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+}
 
-	ID3D11ShaderResourceView* nullSRV = nullptr;
-	gD3DContext->PSSetShaderResources(0, 1, &nullSRV);
-	if (Counter % 2 == 0)
-	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gBackRenderTarget, gDepthStencil);
-
-
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gSceneTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
 
-	}
-	else
-	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gDepthStencil);
+// Perform a full-screen post process from the source texture to the target
+void FullScreenPostProcess(PostProcess postProcess, const PostProcessData& data,
+                           ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target)
+{
+	SelectPostProcessStates();
 
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gBackTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
-	}
+	// Select the render target to draw to and the texture to read from
+	SelectPostProcessTargets(source, target);
 
 	// Select shader and textures needed for the required post-processes (helper function above)
-	SelectPostProcessShaderAndTextures(postProcess);
+	SelectPostProcessShaderAndTextures(postProcess, data);
 
 
 	// Set 2D area for full-screen post-processing (coordinates in 0->1 range)
-	gPostProcessingConstants.area2DTopLeft = { 0, 0 }; // Top-left of entire screen
-	gPostProcessingConstants.area2DSize = { 1, 1 }; // Full size of screen
-	gPostProcessingConstants.area2DDepth = 0;        // Depth buffer value for full screen is as close as possible
+	gPostProcessingConstants.Data().area2DTopLeft = { 0, 0 }; // Top-left of entire screen
+	gPostProcessingConstants.Data().area2DSize = { 1, 1 }; // Full size of screen
+	gPostProcessingConstants.Data().area2DDepth = 0;        // Depth buffer value for full screen is as close as possible
 
 
-	// Pass over the above post-processing settings (also the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
+	// Pass over the above post-processing settings (the effect's own settings were selected above)
+	SelectPostProcessingConstants();
 
 
 	// Draw a quad
 	gD3DContext->Draw(4, 0);
-
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
-
-	gD3DContext->Draw(4, 0);
-
-
-
-
-
 }
 
 
-// Perform an area post process from "scene texture" to back buffer at a given point in the world, with a given size (world units)
-void AreaPostProcess(PostProcess postProcess, CVector3 worldPoint, CVector2 areaSize, float ZShift)
+// Number of pixels in a rectangle, 0 if it is empty
+float RectPixels(const D3D11_RECT& rect)
 {
-	//// First perform a full-screen copy of the scene to back-buffer
-	FullScreenPostProcess(PostProcess::Copy);
-	//
-	//// Now perform a post-process of a portion of the scene to the back-buffer (overwriting some of the copy above)
-	//// Note: The following code relies on many of the settings that were prepared in the FullScreenPostProcess call above, it only
-	////       updates a few things that need to be changed for an area process. If you tinker with the code structure you need to be
-	////       aware of all the work that the above function did that was also preparation for this post-process area step
-	//
-	//// Select shader/textures needed for required post-process
-
-	ID3D11ShaderResourceView* nullSRV = nullptr;
-	gD3DContext->PSSetShaderResources(0, 1, &nullSRV);
-	if (Counter % 2 == 0)
-	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gBackRenderTarget, gDepthStencil);
-
-
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gSceneTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
-
-	}
-	else
-	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gDepthStencil);
-
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gBackTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
-	}
-
-	SelectPostProcessShaderAndTextures(postProcess);
-
-	// Enable alpha blending - area effects need to fade out at the edges or the hard edge of the area is visible
-	// A couple of the shaders have been updated to put the effect into a soft circle
-	// Alpha blending isn't enabled for fullscreen and polygon effects so it doesn't affect those (except heat-haze, which works a bit differently)
-
-
+	if (rect.right <= rect.left || rect.bottom <= rect.top)  return 0.0f;
+	return static_cast<float>(rect.right - rect.left) * static_cast<float>(rect.bottom - rect.top);
+}
 
-	gD3DContext->OMSetBlendState(gAlphaBlendingState, nullptr, 0xffffff);
+// Rectangle of pixels covering the given 0->1 screen coordinates, rounded outwards and clipped to the viewport
+D3D11_RECT ScreenRect(CVector2 topLeft, CVector2 bottomRight)
+{
+	auto clampPixel = [](float pixel, int size) { return std::min(std::max(static_cast<int>(pixel), 0), size); };
+
+	D3D11_RECT rect;
+	rect.left   = clampPixel(std::floor(topLeft.x     * gViewportWidth),  gViewportWidth);
+	rect.top    = clampPixel(std::floor(topLeft.y     * gViewportHeight), gViewportHeight);
+	rect.right  = clampPixel(std::ceil (bottomRight.x * gViewportWidth),  gViewportWidth);
+	rect.bottom = clampPixel(std::ceil (bottomRight.y * gViewportHeight), gViewportHeight);
+	return rect;
+}
 
 
+// Work out where on screen an area post process at a given point in the world, with a given size (world units) goes and pass
+// it to the shaders. Returns the rectangle of pixels it covers, empty if it isn't visible
+D3D11_RECT PlaceAreaPostProcess(CVector3 worldPoint, CVector2 areaSize, float ZShift)
+{
 	// Use picking methods to find the 2D position of the 3D point at the centre of the area effect
 	auto worldPointTo2D = gCamera->PixelFromWorldPt(worldPoint, gViewportWidth, gViewportHeight);
 	CVector2 area2DCentre = { worldPointTo2D.x, worldPointTo2D.y };
 	float areaDistance = worldPointTo2D.z / ZShift;
 
 	// Nothing to do if given 3D point is behind the camera
-	if (areaDistance < gCamera->NearClip())  return;
+	if (areaDistance < gCamera->NearClip())  return D3D11_RECT{ 0, 0, 0, 0 };
 
 	// Convert pixel coordinates to 0->1 coordinates as used by the shader
 	area2DCentre.x /= gViewportWidth;
@@ -1124,94 +1089,577 @@ void AreaPostProcess(PostProcess postProcess, CVector3 worldPoint, CVector2 area
 
 
 	// Send the area top-left and size into the constant buffer - the 2DQuad vertex shader will use this to create a quad in the right place
-	gPostProcessingConstants.area2DTopLeft = area2DCentre - 0.5f * area2DSize; // Top-left of area is centre - half the size
-	gPostProcessingConstants.area2DSize = area2DSize;
+	gPostProcessingConstants.Data().area2DTopLeft = area2DCentre - 0.5f * area2DSize; // Top-left of area is centre - half the size
+	gPostProcessingConstants.Data().area2DSize = area2DSize;
 
 	// Manually calculate depth buffer value from Z distance to the 3D point and camera near/far clip values. Result is 0->1 depth value
 	// We've never seen this full calculation before, it's occasionally useful. It is derived from the material in the Picking lecture
 	// Having the depth allows us to have area effects behind normal objects
-	gPostProcessingConstants.area2DDepth = gCamera->FarClip() * (areaDistance - gCamera->NearClip()) / (gCamera->FarClip() - gCamera->NearClip());
-	gPostProcessingConstants.area2DDepth /= areaDistance;
+	gPostProcessingConstants.Data().area2DDepth = gCamera->FarClip() * (areaDistance - gCamera->NearClip()) / (gCamera->FarClip() - gCamera->NearClip());
+	gPostProcessingConstants.Data().area2DDepth /= areaDistance;
+
+	// Part of the area may be off-screen
+	CVector2 areaTopLeft = gPostProcessingConstants.Data().area2DTopLeft;
+	return ScreenRect(areaTopLeft, areaTopLeft + area2DSize);
+}
+
+
+// Work out where on screen a four-point polygon goes given a world matrix to position/rotate/scale it. The transformed points are
+// added to polygonPoints, ready for PolygonPostProcess. Returns the on-screen bounding rectangle of the polygon in pixels
+D3D11_RECT PlacePolygonPostProcess(const std::array<CVector3, 4>& points, const CMatrix4x4& worldMatrix, std::vector<CVector4>& polygonPoints)
+{
+	// Loop through the given points, transform each to 2D (this is what the vertex shader normally does in most labs)
+	CVector2 screenMin = {  1,  1 };
+	CVector2 screenMax = { -1, -1 };
+	bool behindCamera = false;
+	for (unsigned int i = 0; i < points.size(); ++i)
+	{
+		CVector4 modelPosition = CVector4(points[i], 1);
+		CVector4 worldPosition = modelPosition * worldMatrix;
+		CVector4 viewportPosition = worldPosition * gCamera->ViewProjectionMatrix();
+
+		polygonPoints.push_back(viewportPosition);
+
+		if (viewportPosition.w <= 0)
+		{
+			behindCamera = true;
+			continue;
+		}
+		CVector2 screenPosition = { viewportPosition.x / viewportPosition.w, viewportPosition.y / viewportPosition.w };
+		screenMin = { std::min(screenMin.x, screenPosition.x), std::min(screenMin.y, screenPosition.y) };
+		screenMax = { std::max(screenMax.x, screenPosition.x), std::max(screenMax.y, screenPosition.y) };
+	}
+
+	// If a point is behind the camera the polygon is clipped by the GPU in ways not worth reproducing here, so use the whole screen
+	if (behindCamera)  return ScreenRect({ 0, 0 }, { 1, 1 });
+
+	// Bounding box from -1 -> 1 (y up) to 0 -> 1 (y down) coordinates
+	return ScreenRect({ (screenMin.x + 1) * 0.5f, (1 - screenMax.y) * 0.5f }, { (screenMax.x + 1) * 0.5f, (1 - screenMin.y) * 0.5f });
+}
+
+
+// Perform an area post process from the source texture to the target, placed by PlaceAreaPostProcess. Only the pixels within
+// the given rectangle are touched
+void AreaPostProcess(PostProcess postProcess, const PostProcessData& data,
+                     ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target, const D3D11_RECT& region)
+{
+	// The target already holds the source outside the area, either from a copy just before this pass or because the
+	// pass is working in place (see PostProcessPass::Scratch). Only the area itself is drawn
+	SelectPostProcessStates();
+	gD3DContext->RSSetState(gCullNoneScissorState);
+	gD3DContext->RSSetScissorRects(1, &region);
+
+	// Select the render target to draw to and the texture to read from
+	SelectPostProcessTargets(source, target);
+
+	SelectPostProcessShaderAndTextures(postProcess, data);
 
-	// Pass over this post-processing area to shaders (also sends the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
+	// Enable alpha blending - area effects need to fade out at the edges or the hard edge of the area is visible
+	// A couple of the shaders have been updated to put the effect into a soft circle
+	// Alpha blending isn't enabled for fullscreen and polygon effects so it doesn't affect those (except heat-haze, which works a bit differently)
+	gD3DContext->OMSetBlendState(gAlphaBlendingState, nullptr, 0xffffff);
+
+	// Pass over this post-processing area to shaders (the effect's own settings were selected above)
+	SelectPostProcessingConstants();
 
 	// Draw a quad
 	gD3DContext->Draw(4, 0);
+}
 
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
 
-	gD3DContext->Draw(4, 0);
+// Perform a post process from the source texture to the target within the polygons placed by PlacePolygonPostProcess (four points
+// each). All the polygons are drawn with one instanced draw call. Only the pixels within the given rectangle are touched
+void PolygonPostProcess(PostProcess postProcess, const PostProcessData& data,
+                        ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target, const D3D11_RECT& region,
+                        const std::vector<CVector4>& polygonPoints)
+{
+	// As for the area post-process, the target already holds the source outside the polygon
+	SelectPostProcessStates();
+	gD3DContext->RSSetState(gCullNoneScissorState);
+	gD3DContext->RSSetScissorRects(1, &region);
 
+	// Select the render target to draw to and the texture to read from
+	SelectPostProcessTargets(source, target);
+
+	SelectPostProcessShaderAndTextures(postProcess, data);
+
+	// Pass over the polygon points to the vertex shader in one go (the effect's own settings were selected above)
+	ID3D11ShaderResourceView* pointsSRV = gPolygonPointsBuffer.Upload(polygonPoints.data(), static_cast<int>(polygonPoints.size()));
+	if (pointsSRV == nullptr)  return;
+	gD3DContext->VSSetShaderResources(0, 1, &pointsSRV);
+	SelectPostProcessingConstants();
+
+	// Select the special 2D polygon post-processing vertex shader and draw the polygons, one instance each
+	gD3DContext->VSSetShader(g2DPolygonVertexShader, nullptr, 0);
+	gD3DContext->DrawInstanced(4, static_cast<UINT>(polygonPoints.size() / 4), 0, 0);
 }
 
 
-// Perform an post process from "scene texture" to back buffer within the given four-point polygon and a world matrix to position/rotate/scale the polygon
-void PolygonPostProcess(PostProcess postProcess, const std::array<CVector3, 4>& points, const CMatrix4x4& worldMatrix)
+// Copy a rectangle of pixels from one render target texture to the same place in another
+void CopyRegion(ID3D11Texture2D* from, ID3D11Texture2D* to, const D3D11_RECT& region)
 {
-	// First perform a full-screen copy of the scene to back-buffer
-	FullScreenPostProcess(PostProcess::Copy);
+	D3D11_BOX box = { static_cast<UINT>(region.left), static_cast<UINT>(region.top), 0,
+	                  static_cast<UINT>(region.right), static_cast<UINT>(region.bottom), 1 };
+	gD3DContext->CopySubresourceRegion(to, 0, region.left, region.top, 0, from, 0, &box);
+}
 
 
-	// Now perform a post-process of a portion of the scene to the back-buffer (overwriting some of the copy above)
-	// Note: The following code relies on many of the settings that were prepared in the FullScreenPostProcess call above, it only
-	//       updates a few things that need to be changed for an area process. If you tinker with the code structure you need to be
-	//       aware of all the work that the above function did that was also preparation for this post-process area step
 
-	// Select shader/textures needed for required post-process
 
-	ID3D11ShaderResourceView* nullSRV = nullptr;
-	gD3DContext->PSSetShaderResources(0, 1, &nullSRV);
-	if (Counter % 2 == 0)
+//--------------------------------------------------------------------------------------
+// Post-process backend
+//--------------------------------------------------------------------------------------
+
+// Draw a fused run of colour effects as a single full screen pass. The pixel shader for the run is generated and
+// compiled the first time the sequence is used. Returns false if the shader couldn't be compiled (see gLastError)
+bool FusedColourPostProcess(const PostProcessGraph& graph, const PostProcessPass& pass,
+                            ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target)
+{
+	ColourStage stages[MAX_FUSED_EFFECTS];
+	for (int i = 0; i < pass.FusedCount; ++i)
+	{
+		const PostProcessEffect& effect = graph.Effect(pass.FusedEffects[i]);
+		stages[i] = MakeColourStage(effect.Process, effect.Data, HueLevel);
+		gColourEffectConstants.Data().stageParams[i * 2]     = CVector4(stages[i].Params);
+		gColourEffectConstants.Data().stageParams[i * 2 + 1] = CVector4(stages[i].Params + 4);
+	}
+
+	// Find the shader for this sequence of effects, compiling it if it's new
+	std::string key = ColourShaderKey(stages, pass.FusedCount);
+	auto cached = gColourShaders.find(key);
+	if (cached == gColourShaders.end())
 	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gBackRenderTarget, gDepthStencil);
+		ID3D11PixelShader* shader = CompilePixelShader(GenerateColourShader(stages, pass.FusedCount), key);
+		if (shader == nullptr)  return false;
+		cached = gColourShaders.emplace(key, shader).first;
+	}
+
+	SelectEffectConstants(gColourEffectConstants);
+	gD3DContext->PSSetShader(cached->second, nullptr, 0);
 
+	// PostProcess::None doesn't select a shader of its own, so the fused shader set above is used
+	FullScreenPostProcess(PostProcess::None, graph.Effect(pass.Effect).Data, source, target);
+	return true;
+}
 
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gSceneTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
 
+// Runs the passes of the compiled post-process graph using the functions above. Graph target 0 is the scene
+// texture, the others and the passes' working textures come from gRenderTargetPool as the passes need them
+class D3DPostProcessBackend : public PostProcessBackend
+{
+public:
+	void BeginChain(const CompiledPostProcessGraph& compiled) override
+	{
+		mFusionFailed = false;
+
+		mCompiled = &compiled;
+		mNextPass = 0;
+		mSceneTarget = { gSceneTexture, gSceneRenderTarget, gSceneTextureSRV };
+		mSchedule.Begin(compiled, gViewportWidth, gViewportHeight, &mSceneTarget);
 	}
-	else
+
+	void EndChain() override
 	{
-		// Select the back buffer to use for rendering. Not going to clear the back-buffer because we're going to overwrite it all
-		gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gDepthStencil);
+		// These lines unbind the inputs from the pixel shader to stop DirectX issuing a warning when we try to render to them again next frame
+		ID3D11ShaderResourceView* nullSRVs[MAX_PASS_INPUTS] = {};
+		gD3DContext->PSSetShaderResources(0, MAX_PASS_INPUTS, nullSRVs);
 
-		// Give the pixel shader (post-processing shader) access to the scene texture 
-		gD3DContext->PSSetShaderResources(0, 1, &gBackTextureSRV/* MISSING select the scene texture shader resource view (note: needs an &)*/);
-		gD3DContext->PSSetSamplers(0, 1, &gPointSampler); // Use point sampling (no bilinear, trilinear, mip-mapping etc. for most post-processes)
+		SelectPostProcessViewport(1);
+		mSchedule.End(gRenderTargetPool);
 	}
 
-	SelectPostProcessShaderAndTextures(postProcess);
+	void RunPass(const PostProcessGraph& graph, const PostProcessPass& pass) override
+	{
+		++mStats.Passes;
+
+		// Passes drawing to a target that couldn't be created draw nothing
+		const int passIndex = mNextPass++;
+		mSchedule.BeforePass(graph, passIndex, gRenderTargetPool);
+		DrawPassToTargets(graph, pass);
 
-	// Loop through the given points, transform each to 2D (this is what the vertex shader normally does in most labs)
-	for (unsigned int i = 0; i < points.size(); ++i)
+		// The working textures go back to the pool, unbind the one the pass read so it can be drawn to again
+		if (mSchedule.WorkingTargetCount() > 0)
+		{
+			ID3D11ShaderResourceView* nullSRV = nullptr;
+			gD3DContext->PSSetShaderResources(1, 1, &nullSRV);
+		}
+		mSchedule.AfterPass(passIndex, gRenderTargetPool);
+	}
+
+	// True if a fused colour pass couldn't be drawn during the last chain
+	bool FusionFailed() const  { return mFusionFailed; }
+
+private:
+	// Draw a pass with its targets from the pool, building its working textures first
+	void DrawPassToTargets(const PostProcessGraph& graph, const PostProcessPass& pass)
 	{
-		CVector4 modelPosition = CVector4(points[i], 1);
-		CVector4 worldPosition = modelPosition * worldMatrix;
-		CVector4 viewportPosition = worldPosition * gCamera->ViewProjectionMatrix();
 
-		gPostProcessingConstants.polygon2DPoints[i] = viewportPosition;
+		// Any inputs after the first go in t1 onwards (e.g. the unprocessed scene for a merge)
+		for (int i = 1; i < pass.InputCount; ++i)
+		{
+			ID3D11ShaderResourceView* srv = TargetSRV(pass.Sources[i]);
+			gD3DContext->PSSetShaderResources(i, 1, &srv);
+		}
+
+		// The polygon effect rotates a little every pass
+		if (pass.Mode == PostProcessMode::Polygon)
+		{
+			mPolygonMatrix = MatrixRotationY(ToRadians(1)) * mPolygonMatrix;
+		}
+
+		ID3D11ShaderResourceView* source = TargetSRV(pass.Sources[0]);
+
+		// Bloom reads its own smaller textures built from the input, they are ready before the pass draws
+		if (pass.Process == PostProcess::Bloom)
+		{
+			BuildBloomPyramid(source, graph.Effect(pass.Effect).Data);
+		}
+
+		// As does the variable blur, from the summed-area table of its input
+		if (pass.Process == PostProcess::VariableBlur)
+		{
+			const int downscale = mCompiled->TargetDownscales[pass.Sources[0]];
+			BuildSummedAreaTable(source, DownscaledSize(gViewportWidth, downscale), DownscaledSize(gViewportHeight, downscale));
+		}
+
+		// And pixelation, from the blocks averaged from its input
+		if (pass.Process == PostProcess::Pixelation)
+		{
+			BuildPixelationBlocks(source, graph.Effect(pass.Effect).Data);
+		}
+
+		// Draw at the pass's own resolution
+		SelectPostProcessViewport(pass.Downscale);
+
+		// Working in place - copy the region to the scratch target, draw it there then copy it back. The rest of the target
+		// already holds the input so is left alone
+		if (pass.Scratch >= 0)
+		{
+			D3D11_RECT bounds = PlaceRegions(graph, pass);
+			float pixels = RegionPixels();
+			if (pixels > 0)
+			{
+				for (const D3D11_RECT& region : mRegions)  CopyRegion(TargetTexture(pass.Target), TargetTexture(pass.Scratch), region);
+				DrawRegions(graph, pass, bounds, source, TargetRTV(pass.Scratch));
+				for (const D3D11_RECT& region : mRegions)  CopyRegion(TargetTexture(pass.Scratch), TargetTexture(pass.Target), region);
+			}
+			CountCopy(2 * pixels);
+			CountDraw(pass.Scratch, pixels);
+			return;
+		}
+
+		CountDraw(pass.Target, DrawPass(graph, pass, source, TargetRTV(pass.Target)));
+
+		// Only when comparing against the original behaviour of drawing everything to the screen twice
+		if (pass.DrawToOutput)
+		{
+			SelectPostProcessViewport(1);
+			CountDraw(OUTPUT_TARGET, DrawPass(graph, pass, source, gBackBufferRenderTarget));
+		}
 	}
 
-	// Pass over the polygon points to the shaders (also sends the per-process settings prepared in UpdateScene function below)
-	UpdateConstantBuffer(gPostProcessingConstantBuffer, gPostProcessingConstants);
-	gD3DContext->VSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
-	gD3DContext->PSSetConstantBuffers(1, 1, &gPostProcessingConstantBuffer);
+	// Draw a pass from the source to the target, returns the number of pixels drawn
+	float DrawPass(const PostProcessGraph& graph, const PostProcessPass& pass,
+	               ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target)
+	{
+		const PostProcessEffect& effect = graph.Effect(pass.Effect);
+		const float viewportPixels = static_cast<float>(DownscaledSize(gViewportWidth,  gPostProcessDownscale) *
+		                                                DownscaledSize(gViewportHeight, gPostProcessDownscale));
 
-	// Select the special 2D polygon post-processing vertex shader and draw the polygon
-	gD3DContext->VSSetShader(g2DPolygonVertexShader, nullptr, 0);
-	gD3DContext->Draw(4, 0);
-	gD3DContext->OMSetRenderTargets(1, &gBackBufferRenderTarget, gDepthStencil);
+		if (pass.FusedCount > 1)
+		{
+			// A run of colour effects merged by the graph compiler. If the shader fails to compile, recompile the graph unfused
+			if (FusedColourPostProcess(graph, pass, source, target))  return viewportPixels;
+			mFusionFailed = true;
+			return 0.0f;
+		}
+		else if (pass.Mode == PostProcessMode::Fullscreen)
+		{
+			FullScreenPostProcess(pass.Process, effect.Data, source, target);
+			return viewportPixels;
+		}
 
-	gD3DContext->Draw(4, 0);
+		D3D11_RECT bounds = PlaceRegions(graph, pass);
+		float pixels = RegionPixels();
+		if (pixels > 0)  DrawRegions(graph, pass, bounds, source, target);
+		return pixels;
+	}
 
-}
+	// Work out where an area or polygon pass goes on screen. Fills in mRegions with the rectangle of pixels covered by each
+	// area/polygon the pass draws (several for a batch of model polygons) and returns a rectangle around all of them
+	D3D11_RECT PlaceRegions(const PostProcessGraph& graph, const PostProcessPass& pass)
+	{
+		mRegions.clear();
+		mPolygonPoints.clear();
+
+		if (pass.Mode == PostProcessMode::Area)
+		{
+			// Pass a 3D point for the centre of the affected area and the size of the (rectangular) area in world units
+			mRegions.push_back(PlaceAreaPostProcess(ModelVector[graph.Effect(pass.Effect).Region].Mod->Position(), { 10, 10 }, 3.2f));
+		}
+		else if (pass.Mode == PostProcessMode::Polygon)
+		{
+			// An array of four points in world space - a tapered square centred at the origin
+			const std::array<CVector3, 4> points = { { {-5, 5,0}, {-5,-5,0}, {5,5,0},{5,-5,0} } }; // C++ strangely needs an extra pair of {} here... only for std:array...
+
+			// Pass an array of 4 points and a matrix (rotating, see RunPass). Only supports 4 points.
+			mRegions.push_back(PlacePolygonPostProcess(points, mPolygonMatrix, mPolygonPoints));
+		}
+		else
+		{
+			// A square around each model the effect is attached to
+			for (int effect : pass.BatchedEffects)
+			{
+				CVector3 position = ModelVector[graph.Effect(effect).Region].Mod->Position();
+				const std::array<CVector3, 4> points = { { {position.x - 7, position.y + 7, position.z},
+				                                           {position.x - 7, position.y - 7, position.z},
+				                                           {position.x + 7, position.y + 7, position.z},
+				                                           {position.x + 7, position.y - 7, position.z} } };
+
+				// Pass an array of 4 points and a matrix. Only supports 4 points.
+				mRegions.push_back(PlacePolygonPostProcess(points, mModelPolygonMatrix, mPolygonPoints));
+			}
+		}
+
+		// Empty if nothing is visible
+		D3D11_RECT bounds = { gViewportWidth, gViewportHeight, 0, 0 };
+		for (const D3D11_RECT& region : mRegions)
+		{
+			if (RectPixels(region) == 0)  continue;
+			bounds.left   = std::min(bounds.left,   region.left);
+			bounds.top    = std::min(bounds.top,    region.top);
+			bounds.right  = std::max(bounds.right,  region.right);
+			bounds.bottom = std::max(bounds.bottom, region.bottom);
+		}
+		return bounds;
+	}
+
+	// Pixels covered by the regions placed by PlaceRegions (overlapping regions are counted twice)
+	float RegionPixels() const
+	{
+		float pixels = 0;
+		for (const D3D11_RECT& region : mRegions)  pixels += RectPixels(region);
+		return pixels;
+	}
+
+	// Draw an area or polygon pass placed by PlaceRegions, bounds is the rectangle around all its regions
+	void DrawRegions(const PostProcessGraph& graph, const PostProcessPass& pass, const D3D11_RECT& bounds,
+	                 ID3D11ShaderResourceView* source, ID3D11RenderTargetView* target)
+	{
+		const PostProcessEffect& effect = graph.Effect(pass.Effect);
+		if (pass.Mode == PostProcessMode::Area)
+		{
+			AreaPostProcess(pass.Process, effect.Data, source, target, bounds);
+		}
+		else
+		{
+			PolygonPostProcess(pass.Process, effect.Data, source, target, bounds, mPolygonPoints);
+		}
+	}
+
+	// Shrink the bright parts of the source into the bloom pyramid then add the levels back up, leaving the glow in the
+	// first level (see Bloom.h). The pyramid is always built from the whole image, area and polygon blooms only draw part of it.
+	// The levels are the pass's working textures
+	void BuildBloomPyramid(ID3D11ShaderResourceView* source, const PostProcessData& data)
+	{
+		gBloomGlowSRV = nullptr;
+		if (!WorkingTargetsCreated())  return;
+		const int levels = mSchedule.WorkingTargetCount();
+
+		SelectPostProcessStates();
+		SelectPostProcessShaderAndTextures(PostProcess::Bloom, data); // For the constants and sampler, shaders are chosen below
+		ID3D11ShaderResourceView* nullSRVs[2] = {};
+		gD3DContext->PSSetShaderResources(0, 2, nullSRVs);
+
+		gPostProcessingConstants.Data().area2DTopLeft = { 0, 0 };
+		gPostProcessingConstants.Data().area2DSize = { 1, 1 };
+		gPostProcessingConstants.Data().area2DDepth = 0;
+		SelectPostProcessingConstants();
+
+		// Draw one level of the pyramid from a texture. The levels are smaller than the depth buffer so it isn't used
+		auto drawLevel = [&](ID3D11ShaderResourceView* from, int level, ID3D11PixelShader* shader)
+		{
+			gD3DContext->PSSetShaderResources(0, 1, nullSRVs);
+			gD3DContext->OMSetRenderTargets(1, &WorkingTarget(level)->RenderTarget, nullptr);
+			gD3DContext->PSSetShaderResources(0, 1, &from);
+
+			int width  = BloomLevelSize(gViewportWidth,  level + 1);
+			int height = BloomLevelSize(gViewportHeight, level + 1);
+			D3D11_VIEWPORT vp = { 0, 0, static_cast<FLOAT>(width), static_cast<FLOAT>(height), 0, 1 };
+			gD3DContext->RSSetViewports(1, &vp);
+
+			gD3DContext->PSSetShader(shader, nullptr, 0);
+			gD3DContext->Draw(4, 0);
+			CountDraw(INTERNAL_TARGET, static_cast<float>(width) * height);
+		};
+
+		// Down the pyramid, picking out the bright parts on the way into the first level
+		drawLevel(source, 0, gBloomPostProcess);
+		for (int level = 1; level < levels; ++level)  drawLevel(WorkingTarget(level - 1)->SRV, level, gBloomDownsamplePostProcess);
+
+		// Back up, each level is enlarged and added to the one above
+		gD3DContext->OMSetBlendState(gAdditiveBlendingState, nullptr, 0xffffff);
+		for (int level = levels - 2; level >= 0; --level)  drawLevel(WorkingTarget(level + 1)->SRV, level, gBloomUpsamplePostProcess);
+		gBloomGlowSRV = WorkingTarget(0)->SRV;
+
+		// Back to the full viewport for the rest of the chain
+		gD3DContext->PSSetShaderResources(0, 1, nullSRVs);
+		SelectPostProcessViewport(1);
+	}
+
+	// Build the summed-area table of the source (of the given size) for the variable blur: convert it to integers then
+	// add up along rows then down columns. Each pass adds the entry 1, 2, 4... before, so a row of n pixels takes log2(n)
+	// passes (see SummedAreaTable_pp.hlsl) between the pass's two working textures. Leaves gSummedAreaTableSRV as the view of
+	// the one holding the table
+	void BuildSummedAreaTable(ID3D11ShaderResourceView* source, int width, int height)
+	{
+		gSummedAreaTableSRV = nullptr;
+		if (!WorkingTargetsCreated())  return;
+
+		SelectPostProcessStates();
+		ID3D11ShaderResourceView* nullSRVs[2] = {};
+		gD3DContext->PSSetShaderResources(0, 2, nullSRVs);
+
+		gPostProcessingConstants.Data().area2DTopLeft = { 0, 0 };
+		gPostProcessingConstants.Data().area2DSize = { 1, 1 };
+		gPostProcessingConstants.Data().area2DDepth = 0;
+		SelectPostProcessingConstants();
+
+		VariableBlurConstants& constants = gVariableBlurConstants.Data();
+		constants.tableWidth  = width;
+		constants.tableHeight = height;
+		D3D11_VIEWPORT vp = { 0, 0, static_cast<FLOAT>(width), static_cast<FLOAT>(height), 0, 1 };
+		gD3DContext->RSSetViewports(1, &vp);
+
+		// Draw one pass into the other table from the given texture. The tables are integers, never blended
+		int table = 0;
+		auto drawPass = [&](ID3D11ShaderResourceView* from, ID3D11PixelShader* shader, int stepX, int stepY)
+		{
+			constants.stepX = stepX;
+			constants.stepY = stepY;
+			SelectEffectConstants(gVariableBlurConstants);
+
+			gD3DContext->PSSetShaderResources(0, 1, nullSRVs);
+			gD3DContext->OMSetRenderTargets(1, &WorkingTarget(table)->RenderTarget, nullptr);
+			gD3DContext->PSSetShaderResources(0, 1, &from);
+			gD3DContext->PSSetShader(shader, nullptr, 0);
+			gD3DContext->Draw(4, 0);
+			CountDraw(INTERNAL_TARGET, static_cast<float>(width) * height);
+			table = 1 - table;
+		};
+
+		drawPass(source, gSummedAreaTableStartPostProcess, 0, 0);
+		for (int step = 1; step < width;  step *= 2)  drawPass(WorkingTarget(1 - table)->SRV, gSummedAreaTablePostProcess, step, 0);
+		for (int step = 1; step < height; step *= 2)  drawPass(WorkingTarget(1 - table)->SRV, gSummedAreaTablePostProcess, 0, step);
+		gSummedAreaTableSRV = WorkingTarget(1 - table)->SRV;
+
+		// Back to the full viewport for the rest of the chain
+		gD3DContext->PSSetShaderResources(0, 1, nullSRVs);
+		SelectPostProcessViewport(1);
+	}
 
+	// Reduce the source to one pixel per block for pixelation, each the posterised average of the block (see Pixelation.h).
+	// Always from the whole image, area and polygon pixelation only draw part of it. The pass's working texture is a pixel per block
+	void BuildPixelationBlocks(ID3D11ShaderResourceView* source, const PostProcessData& data)
+	{
+		gPixelationBlocksSRV = nullptr;
+		if (!WorkingTargetsCreated())  return;
+
+		SelectPostProcessStates();
+		SelectPostProcessShaderAndTextures(PostProcess::Pixelation, data); // For the constants, the shader is chosen below
+		ID3D11ShaderResourceView* nullSRVs[2] = {};
+		gD3DContext->PSSetShaderResources(0, 2, nullSRVs);
+
+		gPostProcessingConstants.Data().area2DTopLeft = { 0, 0 };
+		gPostProcessingConstants.Data().area2DSize = { 1, 1 };
+		gPostProcessingConstants.Data().area2DDepth = 0;
+		SelectPostProcessingConstants();
+
+		// Without the depth buffer
+		gD3DContext->OMSetRenderTargets(1, &WorkingTarget(0)->RenderTarget, nullptr);
+		gD3DContext->PSSetShaderResources(0, 1, &source);
+		int width  = PixelationBlockCount(gViewportWidth,  data.Pixelation.blockWidth);
+		int height = PixelationBlockCount(gViewportHeight, data.Pixelation.blockHeight);
+		D3D11_VIEWPORT vp = { 0, 0, static_cast<FLOAT>(width), static_cast<FLOAT>(height), 0, 1 };
+		gD3DContext->RSSetViewports(1, &vp);
+
+		gD3DContext->PSSetShader(gPixelationReducePostProcess, nullptr, 0);
+		gD3DContext->Draw(4, 0);
+		CountDraw(INTERNAL_TARGET, static_cast<float>(width) * height);
+		gPixelationBlocksSRV = WorkingTarget(0)->SRV;
+
+		// Back to the full viewport for the rest of the chain
+		gD3DContext->PSSetShaderResources(0, 1, nullSRVs);
+		SelectPostProcessViewport(1);
+	}
+
+	// Target 0 holds the rendered scene, the others are for the chain (see BeginChain). Null if the pool couldn't create them
+	ID3D11RenderTargetView* TargetRTV(int target)
+	{
+		if (target == OUTPUT_TARGET)  return gBackBufferRenderTarget;
+		PostProcessTarget* postProcessTarget = static_cast<PostProcessTarget*>(mSchedule.Target(target));
+		return postProcessTarget ? postProcessTarget->RenderTarget : nullptr;
+	}
+
+	ID3D11ShaderResourceView* TargetSRV(int target)
+	{
+		PostProcessTarget* postProcessTarget = static_cast<PostProcessTarget*>(mSchedule.Target(target));
+		return postProcessTarget ? postProcessTarget->SRV : nullptr;
+	}
+
+	ID3D11Texture2D* TargetTexture(int target)
+	{
+		PostProcessTarget* postProcessTarget = static_cast<PostProcessTarget*>(mSchedule.Target(target));
+		return postProcessTarget ? postProcessTarget->Texture : nullptr;
+	}
+
+	// The current pass's working textures (see PassWorkingTargets), building them is skipped if any couldn't be created
+	PostProcessTarget* WorkingTarget(int i)  { return static_cast<PostProcessTarget*>(mSchedule.WorkingTarget(i)); }
+	bool WorkingTargetsCreated()
+	{
+		for (int i = 0; i < mSchedule.WorkingTargetCount(); ++i)
+		{
+			if (WorkingTarget(i) == nullptr)  return false;
+		}
+		return mSchedule.WorkingTargetCount() > 0;
+	}
+
+	// A matrix placing the polygon effect in the scene
+	CMatrix4x4 mPolygonMatrix = MatrixTranslation({ 20, 15, 0 });
+	CMatrix4x4 mModelPolygonMatrix = MatrixTranslation({ 20, 15, 0 });
+
+	// The chain being run and the pool's targets for it
+	const CompiledPostProcessGraph* mCompiled = nullptr;
+	PostProcessTargetSchedule       mSchedule;
+	PostProcessTarget               mSceneTarget = {};
+	int                             mNextPass = 0;
+
+	// Regions of the current area/polygon pass
+	std::vector<D3D11_RECT> mRegions;
+	std::vector<CVector4>   mPolygonPoints;
+
+	bool mFusionFailed = false;
+};
+
+D3DPostProcessBackend gPostProcessBackend;
+
+
+
+// Add an effect from the menu to the end of the chain, applied with the currently selected model and screen mode
+void AddPostProcess(PostProcess postProcess, const PostProcessData& data)
+{
+	auto mode = gCurrentPostProcessMode;
+	Model* model = ModelVector[Selected_Item].Mod;
+
+	// The windows are always processed in the shape of the window unless full screen is selected
+	if (model == gLargeWindow || model == gSmallWindow1 || model == gSmallWindow2 || model == gSmallWindow3 || model == gSmallWindow4)
+	{
+		if (mode != PostProcessMode::Fullscreen)  mode = PostProcessMode::ModelPolygon;
+	}
 
+	gCurrentPostProcess = postProcess;
+	gPostProcessGraph.AddEffect(postProcess, mode, Selected_Item, ModelVector[Selected_Item].Name, data);
+}
 
 
 // Rendering the scene
@@ -1228,6 +1676,10 @@ void RenderScene()
 
 	//*******************************
 
+	// Start counting constant buffer traffic for this frame
+	gConstantBytesLastFrame = gConstantBytesUploaded;
+	gConstantBytesUploaded = 0;
+
 	//// Common settings ////
 
 	// Set up the light information in the constant buffer
@@ -1244,27 +1696,6 @@ void RenderScene()
 	gPerFrameConstants.viewportWidth = static_cast<float>(gViewportWidth);
 	gPerFrameConstants.viewportHeight = static_cast<float>(gViewportHeight);
 
-	if (PostProcessingVector.size() != 0)
-	{
-		gD3DContext->OMSetRenderTargets(1, &gMergeTarget, gDepthStencil);
-		gD3DContext->ClearRenderTargetView(gMergeTarget, &gBackgroundColor.r);
-		gD3DContext->ClearDepthStencilView(gDepthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
-	}
-
-	// Setup the viewport to the size of the main window
-	D3D11_VIEWPORT vp;
-	vp.Width = static_cast<FLOAT>(gViewportWidth);
-	vp.Height = static_cast<FLOAT>(gViewportHeight);
-	vp.MinDepth = 0.0f;
-	vp.MaxDepth = 1.0f;
-	vp.TopLeftX = 0;
-	vp.TopLeftY = 0;
-	gD3DContext->RSSetViewports(1, &vp);
-
-
-	// Render the scene from the main camera
-	RenderSceneFromCamera(gCamera);
-	
 
 	////--------------- Main scene rendering ---------------////
 
@@ -1272,7 +1703,7 @@ void RenderScene()
 	// If using post-processing then render to the scene texture, otherwise to the usual back buffer
 	// Also clear the render target to a fixed colour and the depth buffer to the far distance
 
-	if (PostProcessingVector.size() != 0)
+	if (gPostProcessGraph.EffectCount() != 0)
 	{
 		gD3DContext->OMSetRenderTargets(1, &gSceneRenderTarget, gDepthStencil);
 		gD3DContext->ClearRenderTargetView(gSceneRenderTarget, &gBackgroundColor.r);
@@ -1285,7 +1716,7 @@ void RenderScene()
 	gD3DContext->ClearDepthStencilView(gDepthStencil, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	// Setup the viewport to the size of the main window
-	//D3D11_VIEWPORT vp;
+	D3D11_VIEWPORT vp;
 	vp.Width = static_cast<FLOAT>(gViewportWidth);
 	vp.Height = static_cast<FLOAT>(gViewportHeight);
 	vp.MinDepth = 0.0f;
@@ -1301,76 +1732,33 @@ void RenderScene()
 	////--------------- Scene completion ---------------////
 
 	// Run any post-processing steps
-	if (PostProcessingVector.size() != 0)
+	if (gPostProcessGraph.EffectCount() != 0)
 	{
-		for (int i = 0; i < PostProcessingVector.size(); i++)
+		if (!RunPostProcessGraph(gPostProcessGraph, gPostProcessBackend))
 		{
-			if (PostProcessingVector[i].Mod == gLargeWindow || PostProcessingVector[i].Mod == gSmallWindow1 || PostProcessingVector[i].Mod == gSmallWindow2 ||
-				PostProcessingVector[i].Mod == gSmallWindow3 || PostProcessingVector[i].Mod == gSmallWindow4)
-			{
-				if (PostProcessingVector[i].PostProcessingMode != PostProcessMode::Fullscreen)
-				{
-					PostProcessingVector[i].PostProcessingMode = PostProcessMode::ModelPolygon;
-				}
-			}
-			if (PostProcessingVector[i].PostProcessingMode == PostProcessMode::Fullscreen)
-			{
-				FullScreenPostProcess(PostProcessingVector[i].PP);
-				Counter++;
-			}
-
-
-			if (PostProcessingVector[i].PostProcessingMode == PostProcessMode::Area)
-			{
-				// Pass a 3D point for the centre of the affected area and the size of the (rectangular) area in world units
-				AreaPostProcess(PostProcessingVector[i].PP, PostProcessingVector[i].Mod->Position(), { 10, 10 }, 3.2f);
-				Counter++;
-			}
-
-			else if (PostProcessingVector[i].PostProcessingMode == PostProcessMode::Polygon)
-			{
-				// An array of four points in world space - a tapered square centred at the origin
-				const std::array<CVector3, 4> points = { { {-5, 5,0}, {-5,-5,0}, {5,5,0},{5,-5,0} } }; // C++ strangely needs an extra pair of {} here... only for std:array...
-
-				// A rotating matrix placing the model above in the scene
-				static CMatrix4x4 polyMatrix = MatrixTranslation({ 20, 15, 0 });
-				polyMatrix = MatrixRotationY(ToRadians(1)) * polyMatrix;
-
-				// Pass an array of 4 points and a matrix. Only supports 4 points.
-				PolygonPostProcess(PostProcessingVector[i].PP, points, polyMatrix);
-				Counter++;
-
-
-			}
-
-			else if (PostProcessingVector[i].PostProcessingMode == PostProcessMode::ModelPolygon)
-			{
-				// An array of four points in world space - a tapered square centred at the origin
-				const std::array<CVector3, 4> points = { { {PostProcessingVector[i].Mod->Position().x - 7, PostProcessingVector[i].Mod->Position().y + 7,PostProcessingVector[i].Mod->Position().z},
-														   {PostProcessingVector[i].Mod->Position().x - 7,PostProcessingVector[i].Mod->Position().y - 7,PostProcessingVector[i].Mod->Position().z},
-														   {PostProcessingVector[i].Mod->Position().x + 7,PostProcessingVector[i].Mod->Position().y + 7,PostProcessingVector[i].Mod->Position().z},
-														   {PostProcessingVector[i].Mod->Position().x + 7, PostProcessingVector[i].Mod->Position().y - 7,PostProcessingVector[i].Mod->Position().z} } }; // C++ strangely needs an extra pair of {} here... only for std:array...
-
-				// A rotating matrix placing the model above in the scene
-				static CMatrix4x4 polyMatrix = MatrixTranslation({ 20, 15, 0 });
-				//polyMatrix = MatrixRotationY(ToRadians(1)) * polyMatrix;
-
-				// Pass an array of 4 points and a matrix. Only supports 4 points.
-				PolygonPostProcess(PostProcessingVector[i].PP, points, polyMatrix);
-				Counter++;
-
-
-			}
+			// Show the scene without post-processing rather than leave the back buffer unwritten. Both are screen size RGBA8
+			gLastError = gPostProcessGraph.Compile().Error;
+			ID3D11Resource* backBuffer = nullptr;
+			gBackBufferRenderTarget->GetResource(&backBuffer);
+			gD3DContext->CopyResource(backBuffer, gSceneTexture);
+			backBuffer->Release();
 		}
-		Counter = 0;
-
-
-
-		// These lines unbind the scene texture from the pixel shader to stop DirectX issuing a warning when we try to render to it again next frame
-		ID3D11ShaderResourceView* nullSRV = nullptr;
-		gD3DContext->PSSetShaderResources(0, 1, &nullSRV);
+		else if (gPostProcessBackend.FusionFailed())
+		{
+			// Fall back to drawing each colour effect separately from next frame
+			PostProcessCompileOptions options = gPostProcessGraph.CompileOptions();
+			options.FuseColourEffects = false;
+			gPostProcessGraph.SetCompileOptions(options);
+		}
+	}
+	else
+	{
+		gPostProcessBackend.ResetStats();
 	}
 
+	// Free the render targets the chain no longer needs, all of them if there is no chain
+	gRenderTargetPool.EndFrame();
+
 	//IMGUI
 	//*******************************
 	// Draw ImGUI interface
@@ -1431,171 +1819,78 @@ void RenderScene()
 	ImGui::Begin("PostProcessingWindow", 0, ImGuiWindowFlags_AlwaysAutoResize);
 	if (ImGui::BeginMenu("Add A Post Process"))
 	{
-		if (ImGui::Button("Tint", ImVec2(100, 20))) {
-			gCurrentPostProcess = PostProcess::Tint;
-			PostProcessData PPD;
-			float tempTop[3] = { 0.3f,0.8f,0.0f };
-			float tempMid[3] = { 0.1f,0.5f,1.0f };
-			PPD.tint.tint(tempTop, tempMid);
-			PostProcessingDataVector.push_back(PPD);
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+		// Each effect starts with the settings from DefaultPostProcessData, they can be changed in the list of active effects below
+		if (ImGui::Button("Tint", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::Tint, DefaultPostProcessData(PostProcess::Tint));
 		}
 		if (ImGui::Button("TintHue", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::TintHue;
-			PostProcessData PPD;
-			float tempHue1[3] = { 0.3f,0.8f,0.0f };
-			float tempHue2[3] = { 0.1f,0.5f,1.0f };
-			PPD.Hue.Hue(tempHue1, tempHue2);
-			PostProcessingDataVector.push_back({ PPD });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::TintHue, DefaultPostProcessData(PostProcess::TintHue));
 		}
 		if (ImGui::Button("Blur", ImVec2(100, 20)))
 		{
-
-			PostProcessData Blur;
-			PostProcessingData2 PPNM;
-			Blur.Blur.Blur(5);
-			gCurrentPostProcess = PostProcess::Blur;
-			PostProcessingDataVector.push_back(Blur);
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 2);
-			PostProcessingVector.push_back(PPNM);
-			gCurrentPostProcess = PostProcess::SecondBlur;
-			PostProcessingDataVector.push_back({});
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 2);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Blur, DefaultPostProcessData(PostProcess::Blur));
 		}
 		if (ImGui::Button("Sigmoid", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Sigmoid;
-			PostProcessingDataVector.push_back({ 0.25 });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Sigmoid, DefaultPostProcessData(PostProcess::Sigmoid));
 		}
 		if (ImGui::Button("Bloom", ImVec2(100, 20)))
 		{
-			PostProcessingData2 PPNM;
-			PostProcessData PPD;
-			gCurrentPostProcess = PostProcess::Bloom;
-			PostProcessingDataVector.push_back({});
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 4);
-			PostProcessingVector.push_back(PPNM);
-			gCurrentPostProcess = PostProcess::Blur;
-			PostProcessData Blur;
-			Blur.Blur.Blur(30);
-			PostProcessingDataVector.push_back(Blur);
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 4);
-			PostProcessingVector.push_back(PPNM);
-			gCurrentPostProcess = PostProcess::SecondBlur;
-			PostProcessingDataVector.push_back({});
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 4);
-			PostProcessingVector.push_back(PPNM);
-			gCurrentPostProcess = PostProcess::Merge;
-			PostProcessingDataVector.push_back({});
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 4);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Bloom, DefaultPostProcessData(PostProcess::Bloom));
+		}
+		if (ImGui::Button("VariableBlur", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::VariableBlur, DefaultPostProcessData(PostProcess::VariableBlur));
 		}
 		if (ImGui::Button("Burn", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Burn;
-			PostProcessingDataVector.push_back({ 1.0f });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Burn, DefaultPostProcessData(PostProcess::Burn));
 		}
 		if (ImGui::Button("Inverse", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Inverse;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Inverse, DefaultPostProcessData(PostProcess::Inverse));
 		}
 		if (ImGui::Button("Distort", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Distort;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Distort, DefaultPostProcessData(PostProcess::Distort));
 		}
 		if (ImGui::Button("Spiral", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Spiral;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Spiral, DefaultPostProcessData(PostProcess::Spiral));
 		}
 		if (ImGui::Button("HeatHaze", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::HeatHaze;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::HeatHaze, DefaultPostProcessData(PostProcess::HeatHaze));
 		}
 		if (ImGui::Button("GreyNoise", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::GreyNoise;
-			PostProcessingDataVector.push_back({ 140.0f });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
-
+			AddPostProcess(PostProcess::GreyNoise, DefaultPostProcessData(PostProcess::GreyNoise));
 		}
 		if (ImGui::Button("SeeingWorlds", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::SeeingWorlds;
-			PostProcessingDataVector.push_back({ 0.05 });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 2);
-			PostProcessingVector.push_back(PPNM);
-			gCurrentPostProcess = PostProcess::SecondSeeingWorlds;
-			PostProcessingDataVector.push_back({ 0.05 });
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 2);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::SeeingWorlds, DefaultPostProcessData(PostProcess::SeeingWorlds));
 		}
 		if (ImGui::Button("Underwater", ImVec2(100, 20)))
 		{
-			gCurrentPostProcess = PostProcess::Underwater;
-			PostProcessingDataVector.push_back({ 1.0f });
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+			AddPostProcess(PostProcess::Underwater, DefaultPostProcessData(PostProcess::Underwater));
 		}
-		if (ImGui::Button("NightVision", ImVec2(100, 20))) {
-			gCurrentPostProcess = PostProcess::NightVision;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+		if (ImGui::Button("NightVision", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::NightVision, DefaultPostProcessData(PostProcess::NightVision));
 		}
-		if (ImGui::Button("Pixelation", ImVec2(100, 20))) {
-			gCurrentPostProcess = PostProcess::Pixelation;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+		if (ImGui::Button("Pixelation", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::Pixelation, DefaultPostProcessData(PostProcess::Pixelation));
 		}
-		if (ImGui::Button("Scanlines", ImVec2(100, 20))) {
-			gCurrentPostProcess = PostProcess::Scanlines;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+		if (ImGui::Button("Scanlines", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::Scanlines, DefaultPostProcessData(PostProcess::Scanlines));
 		}
-		if (ImGui::Button("Black&White", ImVec2(100, 20))) {
-			gCurrentPostProcess = PostProcess::BlackAndWhite;
-			PostProcessingDataVector.push_back({});
-			PostProcessingData2 PPNM;
-			PPNM.Set(gCurrentPostProcess, gCurrentPostProcessMode, ModelVector[Selected_Item].Mod, ModelVector[Selected_Item].Name, 1);
-			PostProcessingVector.push_back(PPNM);
+		if (ImGui::Button("Black&White", ImVec2(100, 20)))
+		{
+			AddPostProcess(PostProcess::BlackAndWhite, DefaultPostProcessData(PostProcess::BlackAndWhite));
 		}
 		ImGui::SameLine();
 		ImGui::EndMenu();
@@ -1603,378 +1898,223 @@ void RenderScene()
 	if (ImGui::Button("Clear Screen", ImVec2(100, 20)))
 	{
 		gCurrentPostProcess = PostProcess::None;
-		PostProcessingVector.clear();
-		PostProcessingDataVector.clear();
+		gPostProcessGraph.Clear();
 	}
 
-	bool Gloom = false;
-	ImGui::Text("Active Postprocessers");
-	for (int i = 0; i < PostProcessingVector.size(); i++)
+	// Save the chain for the batch tool (PostProcessBatch) to run over recorded frames, or load it back
+	static std::string chainFileMessage;
+	const std::string chainFileName = "PostProcessChain.txt";
+	if (ImGui::Button("Save Chain", ImVec2(100, 20)))
 	{
-
-		ImGui::PushID(i);
-		if (PPNames[(int)PostProcessingVector[i].PP] != "SecondBlur") //)
+		std::string error;
+		chainFileMessage = SavePostProcessChain(chainFileName, gPostProcessGraph, error) ? "Saved " + chainFileName : error;
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Load Chain", ImVec2(100, 20)))
+	{
+		PostProcessGraph loaded;
+		loaded.SetCompileOptions(gPostProcessGraph.CompileOptions());
+		std::string error;
+		bool ok = LoadPostProcessChain(chainFileName, loaded, error);
+		for (int i = 0; ok && i < loaded.EffectCount(); ++i)
 		{
-			if (PPNames[(int)PostProcessingVector[i].PP] != "SecondSeeingWorlds")
+			// Regions are indexes into ModelVector, a hand-edited file could name a model that isn't there
+			const PostProcessEffect& effect = loaded.Effect(i);
+			if (effect.Mode != PostProcessMode::Fullscreen && (effect.Region < 0 || effect.Region >= static_cast<int>(ModelVector.size())))
 			{
-				if (PPNames[(int)PostProcessingVector[i].PP] != "Merge")
-				{
-					if (!Gloom)
-					{
-						if (ImGui::Button("Up", ImVec2(20, 20)))
-						{
-
-							if (PPNames[(int)PostProcessingVector[i].PP] == "Blur" || PPNames[(int)PostProcessingVector[i].PP] == "SeeingWorlds")
-							{
-								if (i - 1 >= 0)
-								{
-									if (PostProcessingVector[i - 1].NumberOfProcessors == 1)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 1]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 2]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i - 1]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i - 4], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i - 4], PostProcessingDataVector[i]);
-										std::swap(PostProcessingVector[i - 3], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i - 3], PostProcessingDataVector[i + 1]);
-										std::swap(PostProcessingVector[i - 2], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i - 2], PostProcessingDataVector[i]);
-										std::swap(PostProcessingVector[i - 1], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i - 1], PostProcessingDataVector[i + 1]);
-									}
-								}
-							}
-							else if (PPNames[(int)PostProcessingVector[i].PP] == "Bloom")
-							{
-								if (i - 1 >= 0)
-								{
-									if (PostProcessingVector[i - 1].NumberOfProcessors == 1)
-									{
-
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 1]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i + 1]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i + 2]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 2]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i - 1]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i + 1]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 4]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i - 3]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i - 3]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i - 2]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i - 2]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i - 1]);
-									}
-								}
-							}
-							else
-							{
-								if (i - 1 >= 0)
-								{
-									if (PostProcessingVector[i - 1].NumberOfProcessors == 1)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 1]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 2]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 1]);
-									}
-									else if (PostProcessingVector[i - 1].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 4]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 3]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 3]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 2]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i - 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i - 1]);
-									}
-								}
-							}
-						}
-						ImGui::SameLine();
-						if (ImGui::Button("Down", ImVec2(35, 20)))
-						{
-
-							if (PPNames[(int)PostProcessingVector[i].PP] == "Blur" || PPNames[(int)PostProcessingVector[i].PP] == "SeeingWorlds")
-							{
-								if (i + PostProcessingVector[i].NumberOfProcessors < PostProcessingVector.size())
-								{
-									if (PostProcessingVector[i + 2].NumberOfProcessors == 1)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 1]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 2]);
-									}
-									else if (PostProcessingVector[i + 2].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 2]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 3]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 3]);
-									}
-									else if (PostProcessingVector[i + 2].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 5]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 3]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i + 1]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i]);
-									}
-								}
-							}
-							else if (PPNames[(int)PostProcessingVector[i].PP] == "Bloom")
-							{
-								if (i + PostProcessingVector[i].NumberOfProcessors < PostProcessingVector.size())
-								{
-									if (PostProcessingVector[i + 4].NumberOfProcessors == 1)
-									{
-
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i + 4]);
-									}
-									else if (PostProcessingVector[i + 4].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 2]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 3]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 3]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 5]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 5]);
-									}
-									else if (PostProcessingVector[i + 4].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i + 1], PostProcessingVector[i + 5]);
-										std::swap(PostProcessingDataVector[i + 1], PostProcessingDataVector[i + 5]);
-										std::swap(PostProcessingVector[i + 2], PostProcessingVector[i + 6]);
-										std::swap(PostProcessingDataVector[i + 2], PostProcessingDataVector[i + 6]);
-										std::swap(PostProcessingVector[i + 3], PostProcessingVector[i + 7]);
-										std::swap(PostProcessingDataVector[i + 3], PostProcessingDataVector[i + 7]);
-									}
-								}
-							}
-							else
-							{
-								if (i + PostProcessingVector[i].NumberOfProcessors < PostProcessingVector.size())
-								{
-									if (PostProcessingVector[i + 1].NumberOfProcessors == 1)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 1]);
-									}
-									else if (PostProcessingVector[i + 1].NumberOfProcessors == 2)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 2]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 1]);
-									}
-									else if (PostProcessingVector[i + 1].NumberOfProcessors == 4)
-									{
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 4]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 4]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 3]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 3]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 2]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 2]);
-										std::swap(PostProcessingVector[i], PostProcessingVector[i + 1]);
-										std::swap(PostProcessingDataVector[i], PostProcessingDataVector[i + 1]);
-									}
-								}
-							}
-						}
-						ImGui::SameLine();
-						if (ImGui::Button("x", ImVec2(15, 20)))
-						{
-
-							if (PPNames[(int)PostProcessingVector[i].PP] == "Blur" || PPNames[(int)PostProcessingVector[i].PP] == "SeeingWorlds")
-							{
-								PostProcessingVector.erase(PostProcessingVector.begin() + i);
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + i);
-								PostProcessingVector.erase(PostProcessingVector.begin() + (i));
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + (i));
-								ImGui::PopID();
-							}
-							else if (PPNames[(int)PostProcessingVector[i].PP] == "Bloom")
-							{
-								PostProcessingVector.erase(PostProcessingVector.begin() + i);
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + i);
-								PostProcessingVector.erase(PostProcessingVector.begin() + (i));
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + (i));
-								PostProcessingVector.erase(PostProcessingVector.begin() + i);
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + i);
-								PostProcessingVector.erase(PostProcessingVector.begin() + (i));
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + (i));
-
-								ImGui::PopID();
-							}
-							else
-							{
-								PostProcessingVector.erase(PostProcessingVector.begin() + i);
-								PostProcessingDataVector.erase(PostProcessingDataVector.begin() + i);
-								ImGui::PopID();
-
-							}
-							break;
-						}
-						ImGui::SameLine();
-
-
-					}
-					else
-					{
-						Gloom = false;
-					}
-				}
-
+				error = chainFileName + ": no model for region " + std::to_string(effect.Region);
+				ok = false;
 			}
 		}
+		if (ok)
+		{
+			gCurrentPostProcess = PostProcess::None;
+			gPostProcessGraph = loaded;
+			chainFileMessage = "Loaded " + chainFileName;
+		}
+		else
+		{
+			chainFileMessage = error;
+		}
+	}
+	if (!chainFileMessage.empty())  ImGui::Text("%s", chainFileMessage.c_str());
+
+	// Cost of the chain last frame. Fill and copy are in full screens, so a chain of N full-screen passes fills N
+	const PostProcessStats& stats = gPostProcessBackend.Stats();
+	const float screenPixels = static_cast<float>(gViewportWidth * gViewportHeight);
+	ImGui::Text("Passes: %d  Draws: %d  Screen writes: %d  Fill: %.2f  Copy: %.2f", stats.Passes, stats.Draws, stats.OutputWrites,
+	            stats.PixelsFilled / screenPixels, stats.PixelsCopied / screenPixels);
+	ImGui::Text("Pixels touched: %d", static_cast<int>(stats.PixelsFilled + stats.PixelsCopied));
+	ImGui::Text("Constant buffer uploads: %d bytes", static_cast<int>(gConstantBytesLastFrame));
+	const float megabyte = 1024.0f * 1024.0f;
+	ImGui::Text("Pooled render targets: %d  Peak: %.1f MB  Held: %.1f MB", gRenderTargetPool.TargetsHeld(),
+	            gRenderTargetPool.PeakBytes() / megabyte, gRenderTargetPool.HeldBytes() / megabyte);
+	PostProcessCompileOptions options = gPostProcessGraph.CompileOptions();
+	bool optionsChanged = ImGui::Checkbox("Draw every pass to screen (old behaviour)", &options.EveryPassToOutput);
+	optionsChanged |= ImGui::Checkbox("Process area/polygon effects in place", &options.RegionsInPlace);
+	optionsChanged |= ImGui::Checkbox("Batch model polygons of the same effect", &options.BatchModelPolygons);
+	if (optionsChanged)
+	{
+		gPostProcessGraph.SetCompileOptions(options);
+	}
+
+	// Each effect is listed once however many passes it has, moving or removing it takes all its passes with it
+	ImGui::Text("Active Postprocessers");
+	for (int i = 0; i < gPostProcessGraph.EffectCount(); i++)
+	{
+		ImGui::PushID(i);
+		if (ImGui::Button("Up", ImVec2(20, 20)))
+		{
+			gPostProcessGraph.MoveEffect(i, -1);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Down", ImVec2(35, 20)))
+		{
+			gPostProcessGraph.MoveEffect(i, 1);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("x", ImVec2(15, 20)))
+		{
+			gPostProcessGraph.RemoveEffect(i);
+			ImGui::PopID();
+			break;
+		}
+		ImGui::SameLine();
 
-		ImGui::Text(PPNames[(int)PostProcessingVector[i].PP]);
+		PostProcessEffect& effect = gPostProcessGraph.Effect(i);
+		ImGui::Text(PPNames[(int)effect.Process]);
 		ImGui::SameLine();
 		ImGui::Text("(");
 		ImGui::SameLine();
-		ImGui::Text(ModeNames[(int)PostProcessingVector[i].PostProcessingMode]);
+		ImGui::Text(ModeNames[(int)effect.Mode]);
 		ImGui::SameLine();
-		if (ModeNames[(int)PostProcessingVector[i].PostProcessingMode] == "FullScreen")
+		if (effect.Mode == PostProcessMode::Fullscreen)
 		{
 			ImGui::Text("");
 
 		}
 		else
 		{
-			ImGui::Text(PostProcessingVector[i].Name.c_str());
+			ImGui::Text(effect.Name.c_str());
 		}
 		ImGui::SameLine();
 		ImGui::Text(")");
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Tint")
+
+		// Full-screen effects can be drawn at reduced resolution, the graph enlarges the result again afterwards
+		if (effect.Mode == PostProcessMode::Fullscreen)
+		{
+			ImGui::SameLine();
+			ImGui::PushItemWidth(70);
+			int resolution = (effect.Downscale == 4) ? 2 : effect.Downscale - 1;
+			if (ImGui::Combo("##Resolution", &resolution, "Full\0Half\0Quarter\0"))
+			{
+				gPostProcessGraph.SetEffectDownscale(i, 1 << resolution);
+			}
+			ImGui::PopItemWidth();
+		}
+		if (effect.Process == PostProcess::Tint)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("ColourPicker"))
 			{
-				float tintG0[3] = { 0.0f, 0.0f, 0.0f };
-				ImGui::ColorEdit3("Tint Editor - Gradiant 1", PostProcessingDataVector[i].tint.rgbTop, ImGuiColorEditFlags_PickerHueWheel);
-				float tintG1[3] = { 0.0f, 0.0f, 0.0f };
-				ImGui::ColorEdit3("Tint Editor - Gradiant 2", PostProcessingDataVector[i].tint.rgbMid, ImGuiColorEditFlags_PickerHueWheel);
+				ImGui::ColorEdit3("Tint Editor - Gradiant 1", effect.Data.tint.rgbTop, ImGuiColorEditFlags_PickerHueWheel);
+				ImGui::ColorEdit3("Tint Editor - Gradiant 2", effect.Data.tint.rgbMid, ImGuiColorEditFlags_PickerHueWheel);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Underwater")
+		if (effect.Process == PostProcess::Underwater)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("Water Properties"))
 			{
-				ImGui::SliderFloat("WaterSpeed", &PostProcessingDataVector[i].Noise.grainSize, 0.0f, 2.0f);
+				ImGui::SliderFloat("WaterSpeed", &effect.Data.Water.waterSpeed, 0.0f, 2.0f);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "SeeingWorlds")
+		if (effect.Process == PostProcess::SeeingWorlds)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("SeeingWorlds Properties"))
 			{
-				ImGui::SliderFloat("Offset", &PostProcessingDataVector[i].SeeingWorlds.offset, 0.01f, 0.09f);
+				ImGui::SliderFloat("Offset", &effect.Data.SeeingWorlds.offset, 0.01f, 0.09f);
+				ImGui::SliderInt("Taps", &effect.Data.SeeingWorlds.taps, 1, SEEING_WORLDS_TAPS);
+				ImGui::Checkbox("Stochastic", &effect.Data.SeeingWorlds.stochastic);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Blur")
+		if (effect.Process == PostProcess::Blur)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("Blur Properties"))
 			{
 
-				ImGui::SliderInt("BlurStrength", &PostProcessingDataVector[i].Blur.blur, 1, 151);
+				ImGui::SliderInt("BlurStrength", &effect.Data.Blur.blur, 1, 151);
+				ImGui::SliderFloat("Sigma", &effect.Data.Blur.sigma, 0.5f, 60.0f);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Sigmoid")
+		if (effect.Process == PostProcess::Bloom)
+		{
+			ImGui::SameLine();
+			if (ImGui::BeginMenu("Bloom Properties"))
+			{
+				ImGui::SliderFloat("Threshold", &effect.Data.Bloom.threshold, 0.0f, 1.0f);
+				ImGui::SliderFloat("Intensity", &effect.Data.Bloom.intensity, 0.0f, 4.0f);
+				ImGui::SliderInt("Levels", &effect.Data.Bloom.levels, 1, MAX_BLOOM_LEVELS);
+				ImGui::EndMenu();
+			}
+		}
+		if (effect.Process == PostProcess::Pixelation)
+		{
+			ImGui::SameLine();
+			if (ImGui::BeginMenu("Pixelation Properties"))
+			{
+				ImGui::SliderInt("BlockWidth", &effect.Data.Pixelation.blockWidth, 1, MAX_PIXELATION_BLOCK);
+				ImGui::SliderInt("BlockHeight", &effect.Data.Pixelation.blockHeight, 1, MAX_PIXELATION_BLOCK);
+				ImGui::SliderInt("Levels", &effect.Data.Pixelation.levels, 1, MAX_PIXELATION_LEVELS);
+				ImGui::EndMenu();
+			}
+		}
+		if (effect.Process == PostProcess::VariableBlur)
+		{
+			ImGui::SameLine();
+			if (ImGui::BeginMenu("VariableBlur Properties"))
+			{
+				ImGui::SliderFloat("InnerRadius", &effect.Data.VariableBlur.innerRadius, 0.0f, static_cast<float>(MAX_VARIABLE_BLUR_RADIUS));
+				ImGui::SliderFloat("OuterRadius", &effect.Data.VariableBlur.outerRadius, 0.0f, static_cast<float>(MAX_VARIABLE_BLUR_RADIUS));
+				ImGui::SliderFloat("Focus", &effect.Data.VariableBlur.focus, 0.0f, 1.0f);
+				ImGui::SliderInt("Boxes", &effect.Data.VariableBlur.boxes, 1, MAX_STACKED_BOXES);
+				ImGui::EndMenu();
+			}
+		}
+		if (effect.Process == PostProcess::Sigmoid)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("Sigmoid Properties"))
 			{
 
-				ImGui::SliderFloat("Gamma", &PostProcessingDataVector[i].Sigmoid.Gamma, 0.01, 0.4);
+				ImGui::SliderFloat("Gamma", &effect.Data.Sigmoid.Gamma, 0.01, 0.4);
 				ImGui::EndMenu();
 			}
 		}
-		//if (PPNames[(int)PostProcessingVector[i].PP] == "SecondBlur")
-		//{
-		//	ImGui::SameLine();
-		//	if (ImGui::BeginMenu("SecondBlur Properties"))
-		//	{
-		//		ImGui::SliderInt("BlurStrength", &PostProcessingDataVector[i].Blur.blur, 0, 20);
-		//		ImGui::EndMenu();
-		//	}
-		//}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "GreyNoise")
+		if (effect.Process == PostProcess::GreyNoise)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("Noise Properties"))
 			{
-				ImGui::SliderFloat("GrainSize", &PostProcessingDataVector[i].Noise.grainSize, 0.0f, 380.0f);
+				ImGui::SliderFloat("GrainSize", &effect.Data.Noise.grainSize, 0.0f, 380.0f);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Burn")
+		if (effect.Process == PostProcess::Burn)
 		{
 			ImGui::SameLine();
 			if (ImGui::BeginMenu("Burn Properties"))
 			{
-				ImGui::SliderFloat("BurnSpeed", &PostProcessingDataVector[i].Burn.burnSpeed, 0.0f, 2.0f);
+				ImGui::SliderFloat("BurnSpeed", &effect.Data.Burn.burnSpeed, 0.0f, 2.0f);
 				ImGui::EndMenu();
 			}
 		}
-		if (PPNames[(int)PostProcessingVector[i].PP] == "Bloom")
-		{
-			Gloom = true;
-		}
 		ImGui::PopID();
 
 	}
@@ -2015,32 +2155,30 @@ void UpdateScene(float frameTime)
 
 	// Colour for tint shader
 
-	// Noise scaling adjusts how fine the grey noise is.
-
-	// The noise offset is randomised to give a constantly changing noise effect (like tv static)
-	gPostProcessingConstants.noiseOffset = { Random(0.0f, 1.0f),Random(0.0f, 1.0f) };
+	// The noise effects hash each pixel with the frame number, giving a constantly changing noise effect (like tv static)
+	++NoiseFrame;
 
 	// Set and increase the burn level (cycling back to 0 when it reaches 1.0f)
-	gPostProcessingConstants.burnHeight = fmod(gPostProcessingConstants.burnHeight + (burnSpeed * FrameTime), 1.0f);
+	gBurnConstants.Data().burnHeight = fmod(gBurnConstants.Data().burnHeight + (burnSpeed * FrameTime), 1.0f);
 	static float HueSpeed = 0.5f;
 
-	gPostProcessingConstants.HueLevel += frameTime;
+	HueLevel += frameTime;
 
-	gPostProcessingConstants.WaterLevel += WaterSpeed * frameTime;
+	gUnderwaterConstants.Data().waterLevel += WaterSpeed * frameTime;
 
 
 
 	// Set the level of distortion
-	gPostProcessingConstants.distortLevel = 0.03f;
+	gDistortConstants.Data().distortLevel = 0.03f;
 
 	static float wiggle = 0.0f;
 	static float wiggleSpeed = 1.0f;
 	// Set and increase the amount of spiral - use a tweaked cos wave to animate
-	gPostProcessingConstants.spiralLevel = ((1.0f - cos(wiggle)) * 4.0f);
+	gSpiralConstants.Data().spiralLevel = ((1.0f - cos(wiggle)) * 4.0f);
 	wiggle += wiggleSpeed * frameTime;
 
 	// Update heat haze timer
-	gPostProcessingConstants.heatHazeTimer += frameTime;
+	gHeatHazeConstants.Data().heatHazeTimer += frameTime;
 
 	//***********
 
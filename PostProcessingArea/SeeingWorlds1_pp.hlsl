@@ -16,6 +16,19 @@ SamplerState PointSample : register(s0); // We don't usually want to filter (bil
 										  // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match SeeingWorldsConstants in Common.h
+cbuffer SeeingWorldsConstants : register(b2)
+{
+    float  gITime;
+    float  gOffSet;
+    float2 paddingSW;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
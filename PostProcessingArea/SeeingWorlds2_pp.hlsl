@@ -1,7 +1,8 @@
 //--------------------------------------------------------------------------------------
-// Colour Tint Post-Processing Pixel Shader
+// SeeingWorlds Swirl Post-Processing Pixel Shader
 //--------------------------------------------------------------------------------------
-// Just samples a pixel from the scene texture and multiplies it by a fixed colour to tint the scene
+// Second node of the SeeingWorlds effect. Adds up the scene's red at points circling each pixel and uses the total as
+// the hue
 
 #include "Common.hlsli"
 
@@ -16,6 +17,23 @@ SamplerState PointSample : register(s0); // We don't usually want to filter (bil
 										  // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match SeeingWorldsTapConstants in Common.h. The offset of each tap only
+// depends on the frame, so the CPU works them out once: the cos and sin of tap i's angle 0.1 * i + gITime (and of
+// that + 0.1 for V) times the offset setting. gTapCount of them are used, each red sample weighted by gTapWeight
+cbuffer SeeingWorldsTapConstants : register(b2)
+{
+    float  gITime;
+    int    gTapCount;
+    float  gTapWeight;
+    float  paddingSW;
+    float4 gTaps[100];
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -26,20 +44,25 @@ float3 hsv(float h, float s, float v)
     h + float3(3.0, 2.0, 1.0) / 3.0) * 6.0 - 3.0) - 1.0), 0.0, 1.0), s) * v;
 }
 
-// Post-processing shader that tints the scene texture to a given colour
+// Post-processing shader that swirls the hue by the scene's red around each pixel
 float4 main(PostProcessingInput input) : SV_Target
 {
-    float4 col = float4(0.0, 0.0, 0.0, 0.0);
     float PSD = pow(abs(SceneTexture.Sample(PointSample, float2(0.5, 0.0)).r), 2.0);
-    for (int i = 0; i < 100; i++)
+
+    // Each tap's offset is offset * cos(angle + PSD), using cos(a + b) = cos a cos b - sin a sin b
+    float2 turn = float2(cos(PSD), -sin(PSD));
+    float2 uv = input.sceneUV * .8 + float2(.1, .0);
+
+    // adapted from by iq https://www.shadertoy.com/view/MsKGWR
+    // Only the red total is used (as the hue)
+    float red = 0.0;
+    for (int i = 0; i < gTapCount; i++)
     {
-        // adapted from by iq https://www.shadertoy.com/view/MsKGWR
-        float2 offset = gOffSet * cos(0.1 * float(i) + PSD + gITime + float2(0, .1));
-        float4 t = SceneTexture.Sample(PointSample, input.sceneUV * .8 + offset + float2(.1, .0)) * 0.3;
-        col += t * 5.;
+        float4 tap = gTaps[i];
+        red += SceneTexture.Sample(PointSample, uv + float2(dot(tap.xy, turn), dot(tap.zw, turn))).r;
     }
-    
-    col.rgb = hsv(col.x * .1 + gITime * .5 + PSD, 1., 1.);
-    //float3 SceneColour = SceneTexture.Sample(PointSample, input.sceneUV) * col;
-    return float4(col.rgb, 1.0f);
-}
\ No newline at end of file
+    red *= gTapWeight;
+
+    float3 colour = hsv(red * .1 + gITime * .5 + PSD, 1., 1.);
+    return float4(colour, 1.0f);
+}
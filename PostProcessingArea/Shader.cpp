@@ -44,8 +44,16 @@ ID3D11PixelShader* gSeeingWorldsPostProcess = nullptr;
 ID3D11PixelShader* gSecondSeeingWorldsPostProcess = nullptr;
 ID3D11PixelShader* gBlurPostProcess = nullptr;
 ID3D11PixelShader* gPixelationPostProcess = nullptr;
+ID3D11PixelShader* gPixelationReducePostProcess = nullptr;
 ID3D11PixelShader* gSecondBlurPostProcess = nullptr;
 ID3D11PixelShader* gBloomPostProcess = nullptr;
+ID3D11PixelShader* gBloomDownsamplePostProcess = nullptr;
+ID3D11PixelShader* gBloomUpsamplePostProcess = nullptr;
+ID3D11PixelShader* gBloomCompositePostProcess = nullptr;
+ID3D11PixelShader* gUpsamplePostProcess = nullptr;
+ID3D11PixelShader* gSummedAreaTableStartPostProcess = nullptr;
+ID3D11PixelShader* gSummedAreaTablePostProcess = nullptr;
+ID3D11PixelShader* gVariableBlurPostProcess = nullptr;
 ID3D11PixelShader* gMergePostProcess = nullptr;
 ID3D11PixelShader* gSigmoidPostProcess = nullptr;
 
@@ -87,10 +95,18 @@ bool LoadShaders()
 	gUnderwaterPostProcess = LoadPixelShader("Underwater_pp");
 	gBlackAndWhitePostProcess = LoadPixelShader("BlackNWhite_pp");
 	gPixelationPostProcess = LoadPixelShader("PixelationShader_pp");
+	gPixelationReducePostProcess = LoadPixelShader("PixelationReduce_pp");
 	gPredatorPostProcess = LoadPixelShader("Predator_pp");
 	gSeeingWorldsPostProcess = LoadPixelShader("SeeingWorlds1_pp");
 	gSecondSeeingWorldsPostProcess = LoadPixelShader("SeeingWorlds2_pp");
 	gBloomPostProcess = LoadPixelShader("Bloom_pp");
+	gBloomDownsamplePostProcess = LoadPixelShader("BloomDownsample_pp");
+	gBloomUpsamplePostProcess = LoadPixelShader("BloomUpsample_pp");
+	gBloomCompositePostProcess = LoadPixelShader("BloomComposite_pp");
+	gUpsamplePostProcess = LoadPixelShader("Upsample_pp");
+	gSummedAreaTableStartPostProcess = LoadPixelShader("SummedAreaTableStart_pp");
+	gSummedAreaTablePostProcess = LoadPixelShader("SummedAreaTable_pp");
+	gVariableBlurPostProcess = LoadPixelShader("VariableBlur_pp");
 	gMergePostProcess = LoadPixelShader("Merge");
 	gSigmoidPostProcess = LoadPixelShader("Sigmoid_pp");
 
@@ -107,7 +123,11 @@ bool LoadShaders()
 		gPredatorPostProcess        == nullptr || gInversePostProcess        == nullptr ||
 		gBlackAndWhitePostProcess   == nullptr || gSeeingWorldsPostProcess   == nullptr ||
 		gSecondSeeingWorldsPostProcess == nullptr || gBloomPostProcess       == nullptr ||
-		gMergePostProcess           == nullptr || gSigmoidPostProcess == nullptr)
+		gMergePostProcess           == nullptr || gSigmoidPostProcess == nullptr ||
+		gBloomDownsamplePostProcess == nullptr || gBloomUpsamplePostProcess  == nullptr ||
+		gBloomCompositePostProcess  == nullptr || gUpsamplePostProcess       == nullptr ||
+		gSummedAreaTableStartPostProcess == nullptr || gSummedAreaTablePostProcess == nullptr ||
+		gVariableBlurPostProcess    == nullptr || gPixelationReducePostProcess == nullptr)
 	{
 		gLastError = "Error loading shaders";
 		return false;
@@ -139,11 +159,19 @@ void ReleaseShaders()
 	if (gPixelLightingVertexShader)   gPixelLightingVertexShader ->Release();
 	if (gBasicTransformVertexShader)  gBasicTransformVertexShader->Release();
 	if (gPixelationPostProcess)       gPixelationPostProcess     ->Release();
+	if (gPixelationReducePostProcess) gPixelationReducePostProcess->Release();
 	if (gInversePostProcess)          gInversePostProcess        ->Release();
 	if (gBlackAndWhitePostProcess)    gBlackAndWhitePostProcess  ->Release();
 	if (gSeeingWorldsPostProcess)     gSeeingWorldsPostProcess   ->Release();
 	if (gSecondSeeingWorldsPostProcess) gSecondSeeingWorldsPostProcess->Release();
 	if (gBloomPostProcess)            gBloomPostProcess          ->Release();
+	if (gBloomDownsamplePostProcess)  gBloomDownsamplePostProcess->Release();
+	if (gBloomUpsamplePostProcess)    gBloomUpsamplePostProcess  ->Release();
+	if (gBloomCompositePostProcess)   gBloomCompositePostProcess ->Release();
+	if (gUpsamplePostProcess)         gUpsamplePostProcess       ->Release();
+	if (gSummedAreaTableStartPostProcess) gSummedAreaTableStartPostProcess->Release();
+	if (gSummedAreaTablePostProcess)  gSummedAreaTablePostProcess->Release();
+	if (gVariableBlurPostProcess)     gVariableBlurPostProcess   ->Release();
 	if (gMergePostProcess)            gMergePostProcess          ->Release();
 	if (gSigmoidPostProcess)          gSigmoidPostProcess        ->Release();
 	
@@ -290,6 +318,41 @@ ID3D11PixelShader* LoadPixelShader(std::string shaderName)
 
 
 
+// Compile a pixel shader from HLSL source held in memory, e.g. a shader generated at run-time. Any #include files are
+// looked for in the working folder, which is where the other shaders are. The name is used in error messages.
+// The returned pointer needs to be released before quitting. Returns nullptr on failure (gLastError has the compiler output)
+ID3D11PixelShader* CompilePixelShader(const std::string& shaderSource, std::string shaderName)
+{
+	ID3DBlob* compiledShader = nullptr;
+	ID3DBlob* errors = nullptr;
+	HRESULT hr = D3DCompile(shaderSource.c_str(), shaderSource.length(), shaderName.c_str(), NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+	                        "main", "ps_5_0", D3DCOMPILE_OPTIMIZATION_LEVEL3, 0, &compiledShader, &errors);
+	if (FAILED(hr))
+	{
+		gLastError = "Error compiling shader " + shaderName;
+		if (errors != nullptr)
+		{
+			gLastError += std::string(": ") + static_cast<const char*>(errors->GetBufferPointer());
+			errors->Release();
+		}
+		return nullptr;
+	}
+	if (errors != nullptr)  errors->Release(); // Warnings only
+
+	ID3D11PixelShader* shader;
+	hr = gD3DDevice->CreatePixelShader(compiledShader->GetBufferPointer(), compiledShader->GetBufferSize(), nullptr, &shader);
+	compiledShader->Release();
+	if (FAILED(hr))
+	{
+		gLastError = "Error creating shader " + shaderName;
+		return nullptr;
+	}
+
+	return shader;
+}
+
+
+
 // Very advanced topic: When creating a vertex layout for geometry (see Scene.cpp), you need the signature
 // (bytecode) of a shader that uses that vertex layout. This is an annoying requirement and tends to create
 // unnecessary coupling between shaders and vertex buffers.
@@ -32,6 +32,7 @@ extern ID3D11PixelShader* gPredatorPostProcess;
 extern ID3D11PixelShader*  gTintHuePostProcess;
 extern ID3D11PixelShader* gInversePostProcess;
 extern ID3D11PixelShader*  gPixelationPostProcess;
+extern ID3D11PixelShader*  gPixelationReducePostProcess;
 extern ID3D11PixelShader*  gGreyNoisePostProcess;
 extern ID3D11PixelShader*  gBurnPostProcess;
 extern ID3D11PixelShader*  gDistortPostProcess;
@@ -44,6 +45,13 @@ extern ID3D11PixelShader* gBlackAndWhitePostProcess;
 extern ID3D11PixelShader* gSeeingWorldsPostProcess;
 extern ID3D11PixelShader* gSecondSeeingWorldsPostProcess;
 extern ID3D11PixelShader* gBloomPostProcess;
+extern ID3D11PixelShader* gBloomDownsamplePostProcess;
+extern ID3D11PixelShader* gBloomUpsamplePostProcess;
+extern ID3D11PixelShader* gBloomCompositePostProcess;
+extern ID3D11PixelShader* gUpsamplePostProcess;
+extern ID3D11PixelShader* gSummedAreaTableStartPostProcess;
+extern ID3D11PixelShader* gSummedAreaTablePostProcess;
+extern ID3D11PixelShader* gVariableBlurPostProcess;
 extern ID3D11PixelShader* gMergePostProcess;
 extern ID3D11PixelShader* gSigmoidPostProcess;
 
@@ -80,6 +88,10 @@ ID3D11VertexShader*   LoadVertexShader  (std::string shaderName);
 ID3D11GeometryShader* LoadGeometryShader(std::string shaderName);
 ID3D11PixelShader*    LoadPixelShader   (std::string shaderName);
 
+// Compile a pixel shader from HLSL source held in memory, e.g. a shader generated at run-time. Any #include files are
+// looked for in the working folder. The returned pointer needs to be released before quitting. Returns nullptr on failure
+ID3D11PixelShader*    CompilePixelShader(const std::string& shaderSource, std::string shaderName);
+
 // Special method to load a geometry shader that can use the stream-out stage, Use like the other functions in this file except
 // also pass the stream out declaration, number of entries in the declaration and the size of each output element. 
 // The returned pointer needs to be released before quitting. Returns nullptr on failure. 
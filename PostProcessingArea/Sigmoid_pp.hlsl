@@ -14,6 +14,18 @@ SamplerState PointSample : register(s0); // We don't usually want to filter (bil
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match SigmoidConstants in Common.h
+cbuffer SigmoidConstants : register(b2)
+{
+    float  gGamma;
+    float3 paddingS;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -16,6 +16,18 @@ SamplerState PointSample  : register(s0); // We don't usually want to filter (bi
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match SpiralConstants in Common.h
+cbuffer SpiralConstants : register(b2)
+{
+    float  gSpiralLevel;
+    float3 paddingS;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
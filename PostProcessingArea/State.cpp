@@ -22,6 +22,7 @@
 ID3D11SamplerState* gPointSampler         = nullptr;
 ID3D11SamplerState* gTrilinearSampler     = nullptr;
 ID3D11SamplerState* gAnisotropic4xSampler = nullptr;
+ID3D11SamplerState* gBilinearClampSampler = nullptr;
 
 // Blend states allow us to switch between blending modes (none, additive, multiplicative etc.)
 ID3D11BlendState* gNoBlendingState       = nullptr;
@@ -33,6 +34,7 @@ ID3D11BlendState* gAlphaBlendingState    = nullptr;
 ID3D11RasterizerState* gCullBackState  = nullptr;
 ID3D11RasterizerState* gCullFrontState = nullptr;
 ID3D11RasterizerState* gCullNoneState  = nullptr;
+ID3D11RasterizerState* gCullNoneScissorState = nullptr;
 
 // Depth-stencil states allow us change how the depth buffer is used
 ID3D11DepthStencilState* gUseDepthBufferState = nullptr;
@@ -90,6 +92,24 @@ bool CreateStates()
 	}
 
 
+	////-------- Bilinear Sampling, clamped (merged blur taps) --------////
+	samplerDesc.Filter = D3D11_FILTER_MIN_MAG_LINEAR_MIP_POINT; // Bilinear filtering
+	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;        // Clamp addressing mode for texture coordinates outside 0->1
+	samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;        // --"--
+	samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;        // --"--
+	samplerDesc.MaxAnisotropy = 1;                             // Number of samples used if using anisotropic filtering, more is better but max value depends on GPU
+
+	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX; // Controls how much mip-mapping can be used. These settings are full mip-mapping, the usual values
+	samplerDesc.MinLOD = 0;                 // --"--
+
+	// Then create a DirectX object for your description that can be used by a shader
+	if (FAILED(gD3DDevice->CreateSamplerState(&samplerDesc, &gBilinearClampSampler)))
+	{
+		gLastError = "Error creating bilinear clamp sampler";
+		return false;
+	}
+
+
 	////-------- Anisotropic filtering --------////
 	samplerDesc.Filter = D3D11_FILTER_ANISOTROPIC; // Trilinear filtering
 	samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;    // Wrap addressing mode for texture coordinates outside 0->1
@@ -156,6 +176,21 @@ bool CreateStates()
         gLastError = "Error creating cull-none state";
         return false;
     }
+
+
+    ////-------- No culling, scissored --------////
+    // Used by area and polygon post-processes so they only touch the pixels within their bounding rectangle
+    rasterizerDesc.FillMode              = D3D11_FILL_SOLID;
+    rasterizerDesc.CullMode              = D3D11_CULL_NONE;  // Don't cull any faces
+    rasterizerDesc.ScissorEnable         = TRUE; // Pixels outside the rectangle set with RSSetScissorRects are not drawn
+    rasterizerDesc.DepthClipEnable       = TRUE; // Advanced setting - only used in rare cases
+
+    // Create a DirectX object for the description above that can be used by a shader
+    if (FAILED(gD3DDevice->CreateRasterizerState(&rasterizerDesc, &gCullNoneScissorState)))
+    {
+        gLastError = "Error creating cull-none scissor state";
+        return false;
+    }
 	
 	
     //--------------------------------------------------------------------------------------
@@ -289,10 +324,12 @@ void ReleaseStates()
     if (gNoDepthBufferState)     gNoDepthBufferState->Release();
     if (gCullBackState)          gCullBackState->Release();
     if (gCullFrontState)         gCullFrontState->Release();
+    if (gCullNoneScissorState)   gCullNoneScissorState->Release();
     if (gCullNoneState)          gCullNoneState->Release();
     if (gNoBlendingState)        gNoBlendingState->Release();
     if (gAlphaBlendingState)     gAlphaBlendingState->Release();
     if (gAdditiveBlendingState)  gAdditiveBlendingState->Release();
+    if (gBilinearClampSampler)   gBilinearClampSampler->Release();
     if (gAnisotropic4xSampler)   gAnisotropic4xSampler->Release();
     if (gTrilinearSampler)       gTrilinearSampler->Release();
     if (gPointSampler)           gPointSampler->Release();
@@ -0,0 +1,27 @@
+//--------------------------------------------------------------------------------------
+// Summed-area table - first pass
+//--------------------------------------------------------------------------------------
+// Converts the image to 8-bit levels in unsigned integers, the start of the running sums built up by
+// SummedAreaTable_pp.hlsl
+
+#include "VariableBlur.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The image the table is built from, its pixels are read directly
+Texture2D SceneTexture : register(t0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+uint4 main(PostProcessingInput input) : SV_Target
+{
+    // Rounded as the CPU version does, so both sum exactly the same levels
+    float4 colour = SceneTexture.Load(int3(input.projectedPosition.xy, 0));
+    return uint4(saturate(colour) * 255 + 0.5f);
+}
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------------------------
+// Summed-area table - running sums
+//--------------------------------------------------------------------------------------
+// One step of the running sums along rows, then down columns: each entry adds the entry gSumStep before it.
+// With steps of 1, 2, 4... each entry ends up with the sum of every entry before it, in a pass for each
+// doubling rather than a pass for each pixel. Sums wrap around past 2^32, see PostProcessing/VariableBlur.h
+
+#include "VariableBlur.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The sums so far
+Texture2D<uint4> SumTexture : register(t0);
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+uint4 main(PostProcessingInput input) : SV_Target
+{
+    int2 pixel = int2(input.projectedPosition.xy);
+    int2 before = pixel - gSumStep;
+
+    uint4 sum = SumTexture.Load(int3(pixel, 0));
+    if (before.x >= 0 && before.y >= 0)
+    {
+        sum += SumTexture.Load(int3(before, 0));
+    }
+    return sum;
+}
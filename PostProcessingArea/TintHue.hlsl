@@ -16,11 +16,25 @@ SamplerState PointSample : register(s0); // We don't usually want to filter (bil
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match TintHueConstants in Common.h
+cbuffer TintHueConstants : register(b2)
+{
+    float3 gTintColour1;
+    float  gHueLevel;
+    float3 gTintColour2;
+    float  paddingT;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
 
-float Epsilon = 1e-10;
+static const float Epsilon = 1e-10;
 
 float3 RGBtoHCV(in float3 RGB)
 {
@@ -59,7 +73,7 @@ float3 RGBtoHSL(in float3 RGB)
 float4 main(PostProcessingInput input) : SV_Target
 {
     
-	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from a constant buffer defined in Common.hlsli)
+	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from the constant buffer above)
 
 	//float3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rgb * gTintColour;
     float softEdge = 0; // Softness of the edge of the circle - range 0.001 (hard edge) to 0.25 (very soft)
@@ -91,7 +105,7 @@ float4 main(PostProcessingInput input) : SV_Target
     NewColour.r = lerp(FinalresultTop.r, FinalresultBot.r, input.areaUV.y);
     NewColour.b = lerp(FinalresultTop.b, FinalresultBot.b, input.areaUV.y);
     NewColour.g = lerp(FinalresultTop.g, FinalresultBot.g, input.areaUV.y);
-	//// Sample a pixel from the scene texture and multiply it with the tint colour (comes from a constant buffer defined in Common.hlsli)
+	//// Sample a pixel from the scene texture and multiply it with the tint colour (comes from the constant buffer above)
     float3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rbg * NewColour;
 
     float alpha = 1.0f - saturate((centreLengthSq - 0.25f + softEdge) / softEdge); // Soft circle calculation based on fact that this circle has a radius of 0.5 (as area UVs go from 0->1)
@@ -16,6 +16,20 @@ SamplerState PointSample  : register(s0); // We don't usually want to filter (bi
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match TintConstants in Common.h
+cbuffer TintConstants : register(b2)
+{
+    float3 gTintColour1; // Colour at the top of the area
+    float  paddingT1;
+    float3 gTintColour2; // Colour at the bottom
+    float  paddingT2;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -23,7 +37,7 @@ SamplerState PointSample  : register(s0); // We don't usually want to filter (bi
 // Post-processing shader that tints the scene texture to a given colour
 float4 main(PostProcessingInput input) : SV_Target
 {
-	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from a constant buffer defined in Common.hlsli)
+	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from the constant buffer above)
 
 	//float3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rgb * gTintColour;
     float softEdge = 0; // Softness of the edge of the circle - range 0.001 (hard edge) to 0.25 (very soft)
@@ -35,7 +49,7 @@ float4 main(PostProcessingInput input) : SV_Target
     NewColour.r = lerp(gTintColour1.r, gTintColour2.r, input.areaUV.y);
     NewColour.b = lerp(gTintColour1.b, gTintColour2.b, input.areaUV.y);
     NewColour.g = lerp(gTintColour1.g, gTintColour2.g, input.areaUV.y);
-	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from a constant buffer defined in Common.hlsli)
+	// Sample a pixel from the scene texture and multiply it with the tint colour (comes from the constant buffer above)
     float3 colour = SceneTexture.Sample(PointSample, input.sceneUV).rbg * NewColour;
 
     float alpha = 1.0f - saturate((centreLengthSq - 0.25f + softEdge) / softEdge); // Soft circle calculation based on fact that this circle has a radius of 0.5 (as area UVs go from 0->1)
@@ -16,6 +16,18 @@ SamplerState PointSample : register(s0); // We don't usually want to filter (bil
                                           // post-processing so this sampler will use "point sampling" - no filtering
 
 
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Settings for this post-process, must match UnderwaterConstants in Common.h
+cbuffer UnderwaterConstants : register(b2)
+{
+    float  gWaterLevel;
+    float3 paddingW;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Shader code
 //--------------------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------------------
+// Edge-aware upsample
+//--------------------------------------------------------------------------------------
+// Enlarges a reduced resolution image, keeping the edges of a full resolution guide image sharp.
+// See PostProcessing/Upsample.h for how it works and the matching CPU version
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// The reduced resolution image, its pixels are read directly
+Texture2D SourceTexture : register(t0);
+
+// The last image drawn at the resolution being returned to, the guide for the edges
+Texture2D GuideTexture : register(t1);
+SamplerState PointSample : register(s0);
+
+// Must match UPSAMPLE_EDGE_SHARPNESS in Upsample.h
+static const float EDGE_SHARPNESS = 50.0f;
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    float width, height;
+    SourceTexture.GetDimensions(width, height);
+    int2 size = int2(width, height);
+
+    // The four source pixels around this one and their bilinear weights
+    float2 sourceCoord = input.sceneUV * size - 0.5f;
+    int2   corner = floor(sourceCoord);
+    float2 f = sourceCoord - corner;
+    const int2 offsets[4] = { int2(0, 0), int2(1, 0), int2(0, 1), int2(1, 1) };
+    float bilinear[4] = { (1 - f.x) * (1 - f.y), f.x * (1 - f.y), (1 - f.x) * f.y, f.x * f.y };
+
+    // Weight each by how well the guide at that pixel matches the guide here
+    float3 guide = GuideTexture.Sample(PointSample, input.sceneUV).rgb;
+    float weights[4];
+    float total = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        float3 difference = GuideTexture.Sample(PointSample, (corner + offsets[i] + 0.5f) / size).rgb - guide;
+        weights[i] = bilinear[i] * exp(-dot(difference, difference) * EDGE_SHARPNESS);
+        total += weights[i];
+    }
+
+    // A pixel matching none of its neighbours (e.g. a thin line missing from the source) falls back to bilinear
+    bool useBilinear = (total <= 0.0001f);
+    float4 colour = 0;
+    for (int j = 0; j < 4; j++)
+    {
+        int2 pixel = clamp(corner + offsets[j], int2(0, 0), size - 1);
+        float weight = useBilinear ? bilinear[j] : weights[j] / total;
+        colour += SourceTexture.Load(int3(pixel, 0)) * weight;
+    }
+    return float4(colour.rgb, 1.0f);
+}
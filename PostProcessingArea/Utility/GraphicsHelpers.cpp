@@ -12,6 +12,13 @@
 #include <cctype>
 #include <atlbase.h> // C-string to unicode conversion function CA2CT
 
+//--------------------------------------------------------------------------------------
+// Constant buffers
+//--------------------------------------------------------------------------------------
+
+size_t gConstantBytesUploaded = 0;
+
+
 //--------------------------------------------------------------------------------------
 // Texture Loading
 //--------------------------------------------------------------------------------------
@@ -8,6 +8,7 @@
 
 #include "CMatrix4x4.h"
 #include "../Common.h"
+#include "../Shader.h"
 #include <d3d11.h>
 
 
@@ -15,6 +16,9 @@
 // Constant buffers
 //--------------------------------------------------------------------------------------
 
+// Total bytes sent to constant buffers by UpdateConstantBuffer. Reset it at the start of a frame to see the traffic per frame
+extern size_t gConstantBytesUploaded;
+
 // Template function to update a constant buffer. Pass the DirectX constant buffer object and the C++ data structure
 // you want to update it with. The structure will be copied in full over to the GPU constant buffer, where it will
 // be available to shaders. This is used to update model and camera positions, lighting data etc.
@@ -25,9 +29,122 @@ void UpdateConstantBuffer(ID3D11Buffer* buffer, const T& bufferData)
     gD3DContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &cb);
     memcpy(cb.pData, &bufferData, sizeof(T));
     gD3DContext->Unmap(buffer, 0);
+    gConstantBytesUploaded += sizeof(T);
 }
 
 
+// A constant buffer together with the C++ structure it holds. Change the structure through Data(), then call Upload
+// before using the buffer - the structure is only sent to the GPU if it is different from the last time it was sent.
+// Use for settings that often stay the same from one draw (or frame) to the next
+template <class T>
+class CachedConstantBuffer
+{
+public:
+    // Create the GPU buffer, returns false on failure
+    bool Create()
+    {
+        mBuffer = CreateConstantBuffer(sizeof(T));
+        return mBuffer != nullptr;
+    }
+
+    void Release()
+    {
+        if (mBuffer)  mBuffer->Release();
+        mBuffer = nullptr;
+        mUploaded = false;
+    }
+
+    T&       Data()        { return mData; }
+    const T& Data() const  { return mData; }
+
+    // Send the structure to the GPU if it has changed since it was last sent. Returns the buffer, ready to be selected
+    ID3D11Buffer* Upload()
+    {
+        if (!mUploaded || memcmp(&mData, &mLastUploaded, sizeof(T)) != 0)
+        {
+            UpdateConstantBuffer(mBuffer, mData);
+            mLastUploaded = mData;
+            mUploaded = true;
+        }
+        return mBuffer;
+    }
+
+private:
+    ID3D11Buffer* mBuffer = nullptr;
+    T    mData = {};
+    T    mLastUploaded = {};
+    bool mUploaded = false;
+};
+
+
+//--------------------------------------------------------------------------------------
+// Structured buffers
+//--------------------------------------------------------------------------------------
+
+// An array of structures that shaders read as a StructuredBuffer. Each Upload replaces the whole array, and the buffer
+// grows (at least doubling) when it is given more elements than it can hold. Use for arrays whose length varies per draw
+template <class T>
+class DynamicStructuredBuffer
+{
+public:
+    void Release()
+    {
+        if (mSRV)     mSRV->Release();
+        if (mBuffer)  mBuffer->Release();
+        mSRV = nullptr;
+        mBuffer = nullptr;
+        mCapacity = 0;
+    }
+
+    // Send the elements to the GPU. Returns the view to select for the shader, nullptr on failure (see gLastError)
+    ID3D11ShaderResourceView* Upload(const T* elements, int count)
+    {
+        if (count > mCapacity)
+        {
+            int capacity = (count > mCapacity * 2) ? count : mCapacity * 2;
+            Release();
+
+            D3D11_BUFFER_DESC bufferDesc = {};
+            bufferDesc.ByteWidth           = static_cast<UINT>(sizeof(T) * capacity);
+            bufferDesc.Usage               = D3D11_USAGE_DYNAMIC;          // Rewritten by the CPU every upload
+            bufferDesc.BindFlags           = D3D11_BIND_SHADER_RESOURCE;
+            bufferDesc.CPUAccessFlags      = D3D11_CPU_ACCESS_WRITE;
+            bufferDesc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+            bufferDesc.StructureByteStride = sizeof(T);
+            if (FAILED(gD3DDevice->CreateBuffer(&bufferDesc, nullptr, &mBuffer)))
+            {
+                gLastError = "Error creating structured buffer";
+                return nullptr;
+            }
+
+            D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+            srvDesc.Format              = DXGI_FORMAT_UNKNOWN; // Structured buffers have no format
+            srvDesc.ViewDimension       = D3D11_SRV_DIMENSION_BUFFER;
+            srvDesc.Buffer.FirstElement = 0;
+            srvDesc.Buffer.NumElements  = capacity;
+            if (FAILED(gD3DDevice->CreateShaderResourceView(mBuffer, &srvDesc, &mSRV)))
+            {
+                gLastError = "Error creating structured buffer view";
+                Release();
+                return nullptr;
+            }
+            mCapacity = capacity;
+        }
+
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        gD3DContext->Map(mBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+        memcpy(mapped.pData, elements, sizeof(T) * count);
+        gD3DContext->Unmap(mBuffer, 0);
+        return mSRV;
+    }
+
+private:
+    ID3D11Buffer*             mBuffer = nullptr;
+    ID3D11ShaderResourceView* mSRV = nullptr;
+    int                       mCapacity = 0;
+};
+
+
 //--------------------------------------------------------------------------------------
 // Texture Loading
 //--------------------------------------------------------------------------------------
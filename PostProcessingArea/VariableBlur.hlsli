@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------
+// Settings and helpers for the variable radius blur post-process
+//--------------------------------------------------------------------------------------
+// Shared by the shaders that build the summed-area table (SummedAreaTableStart_pp.hlsl, SummedAreaTable_pp.hlsl)
+// and the one that blurs from it (VariableBlur_pp.hlsl). See PostProcessing/VariableBlur.h for the CPU version
+
+#include "Common.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Constant Buffers
+//--------------------------------------------------------------------------------------
+
+// Must match MAX_STACKED_BOXES and MAX_VARIABLE_BLUR_RADIUS in VariableBlur.h
+static const int MAX_STACKED_BOXES = 3;
+static const int MAX_VARIABLE_BLUR_RADIUS = 100;
+
+// Must match VariableBlurConstants in Common.h
+cbuffer VariableBlurConstants : register(b2)
+{
+    float gInnerRadius; // Blur radius in full size pixels in the middle of the area, out to the focus distance
+    float gOuterRadius; // Blur radius at the edge of the area's circle
+    float gFocus;       // Distance from the middle (0->1) where the radius starts to grow
+    int   gBoxes;       // Boxes stacked for each pixel
+    int2  gTableSize;   // Size of the image the table is built from, in pixels
+    int2  gSumStep;     // Building the table: offset of the sum added to each entry, along a row or down a column
+}
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Blur radius at a point in the area, in full size pixels. Grows from the focus distance out to the edge of the circle
+float VariableBlurRadius(float2 areaUV)
+{
+    float distance = 2 * length(areaUV - 0.5f);
+    float t = saturate((distance - gFocus) / max(1 - gFocus, 0.0001f));
+    return lerp(gInnerRadius, gOuterRadius, t);
+}
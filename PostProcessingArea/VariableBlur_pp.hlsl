@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+// Variable radius blur
+//--------------------------------------------------------------------------------------
+// Averages a stack of boxes around each pixel from the summed-area table of the image, the radius
+// growing out from the middle of the area. See PostProcessing/VariableBlur.h
+
+#include "VariableBlur.hlsli"
+
+
+//--------------------------------------------------------------------------------------
+// Textures (texture maps)
+//--------------------------------------------------------------------------------------
+
+// Summed-area table built from the image by the backend before this pass
+Texture2D<uint4> SumTexture : register(t1);
+
+
+//--------------------------------------------------------------------------------------
+// Helpers
+//--------------------------------------------------------------------------------------
+
+// Sum of the pixels from (0, 0) to the given pixel inclusive, zero outside the image
+uint3 TableSum(int2 pixel)
+{
+    return (pixel.x < 0 || pixel.y < 0) ? uint3(0, 0, 0) : SumTexture.Load(int3(pixel, 0)).rgb;
+}
+
+// Average colour of the pixels within radius of the given pixel, the box clipped to the image
+float3 BoxAverage(int2 pixel, int radius)
+{
+    // Corners of the box, the top-left one just outside it
+    int2 topLeft     = max(pixel - radius, 0) - 1;
+    int2 bottomRight = min(pixel + radius, gTableSize - 1);
+
+    uint3 sum = TableSum(bottomRight) - TableSum(int2(topLeft.x, bottomRight.y))
+              - TableSum(int2(bottomRight.x, topLeft.y)) + TableSum(topLeft);
+    int2 size = bottomRight - topLeft;
+    return float3(sum) / (255.0f * size.x * size.y);
+}
+
+
+//--------------------------------------------------------------------------------------
+// Shader code
+//--------------------------------------------------------------------------------------
+
+float4 main(PostProcessingInput input) : SV_Target
+{
+    // Radius in full size pixels, scaled to the table's
+    float radius = VariableBlurRadius(input.areaUV) * gTableSize.x / gViewportWidth;
+    radius = clamp(radius, 0, MAX_VARIABLE_BLUR_RADIUS);
+    int2 pixel = min(int2(input.sceneUV * gTableSize), gTableSize - 1);
+
+    // Average of the stacked boxes, blending the boxes either side of a fractional radius
+    int boxes = clamp(gBoxes, 1, MAX_STACKED_BOXES);
+    float3 colour = 0;
+    for (int box = 1; box <= boxes; box++)
+    {
+        float boxRadius = radius * box / boxes;
+        int   inner = int(boxRadius);
+        float blend = boxRadius - inner;
+        colour += BoxAverage(pixel, inner) * (1 - blend);
+        if (blend > 0)  colour += BoxAverage(pixel, inner + 1) * blend;
+    }
+    colour /= boxes;
+
+    // Circle inside an area, a hard edge (SoftCircleAlpha with no soft edge in the CPU version)
+    float2 centreVector = input.areaUV - float2(0.5f, 0.5f);
+    float alpha = (dot(centreVector, centreVector) <= 0.25f) ? 1.0f : 0.0f;
+    return float4(colour, alpha);
+}